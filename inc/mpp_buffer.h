@@ -180,6 +180,32 @@ typedef struct MppBufferInfo_t {
     int             index;
 } MppBufferInfo;
 
+/*
+ * MppMemUsage - per mpp context memory usage for MPP_GET_MEM_USAGE
+ *
+ * All sizes are in bytes and count the internal buffers allocated by the
+ * context only. External frame group is reported in frame but not in total.
+ *
+ * budget       - buffer budget set by MPP_SET_MEM_BUDGET, 0 for unlimited
+ * total        - all internal buffers of the context
+ * total_max    - peak of total
+ * frame        - frame buffer group
+ * packet       - packet buffer group
+ * scratch      - hal and codec internal buffers
+ * refused      - buffer allocations refused by budget
+ */
+typedef struct MppMemUsage_t {
+    RK_S64  budget;
+    RK_S64  total;
+    RK_S64  total_max;
+    RK_S64  frame;
+    RK_S64  packet;
+    RK_S64  scratch;
+    RK_S32  group_count;
+    RK_S32  buffer_count;
+    RK_S32  refused;
+} MppMemUsage;
+
 #define BUFFER_GROUP_SIZE_DEFAULT           (SZ_1M*80)
 
 /*
@@ -336,6 +336,12 @@ RK_S64  mpp_frame_get_dts(const MppFrame frame);
 void    mpp_frame_set_dts(MppFrame frame, RK_S64 dts);
 RK_U32  mpp_frame_get_errinfo(const MppFrame frame);
 void    mpp_frame_set_errinfo(MppFrame frame, RK_U32 errinfo);
+/*
+ * damage - count of lost or damaged reference frames used by this frame
+ * 0 means the frame is decoded from intact references
+ */
+RK_U32  mpp_frame_get_damage(const MppFrame frame);
+void    mpp_frame_set_damage(MppFrame frame, RK_U32 damage);
 size_t  mpp_frame_get_buf_size(const MppFrame frame);
 void    mpp_frame_set_buf_size(MppFrame frame, size_t buf_size);
 /*
@@ -129,6 +129,12 @@ typedef enum MppMetaKey_e {
     /* MLVEC specified encoder feature  */
     KEY_ENC_FRAME_QP            = FOURCC_META('f', 'r', 'm', 'q'),
     KEY_ENC_BASE_LAYER_PID      = FOURCC_META('b', 'p', 'i', 'd'),
+
+    /*
+     * Low delay output slice done time in us (mpp_time) for latency tracking.
+     * Set on every partition packet when MPP_ENC_SPLIT_OUT_LOWDELAY is on.
+     */
+    KEY_ENC_SLICE_TIME          = FOURCC_META('s', 'l', 't', 'm'),
 } MppMetaKey;
 
 #define mpp_meta_get(meta) mpp_meta_get_with_tag(meta, MODULE_TAG, __FUNCTION__)
@@ -241,6 +241,19 @@ typedef struct RcApiQueryType_t {
     RK_S32          count;
 } RcApiQueryType;
 
+/*
+ * Rate control runtime statistic for MPP_ENC_GET_RC_API_STAT
+ *
+ * frm_cnt      - frame count finished by rate control
+ * reenc_cnt    - hardware reencode count requested by rate control
+ * reenc_rate   - reencode count per 1000 frames
+ */
+typedef struct RcApiStat_t {
+    RK_S64          frm_cnt;
+    RK_S64          reenc_cnt;
+    RK_S32          reenc_rate;
+} RcApiStat;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -266,6 +266,14 @@ MPP_RET mpp_check_support_format(MppCtxType type, MppCodingType coding);
  */
 void    mpp_show_support_format(void);
 void    mpp_show_color_format(void);
+/**
+ * @ingroup rk_mpi
+ * @brief Load the cached platform capability or probe and cache it.
+ *        Optional, call it at process startup to take the device probing
+ *        out of the first mpp_init().
+ * @return 0 for success, others for failure.
+ */
+MPP_RET mpp_preload_capability(void);
 
 #ifdef __cplusplus
 }
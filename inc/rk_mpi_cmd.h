@@ -75,6 +75,12 @@ typedef enum {
     MPP_SET_INPUT_TIMEOUT,              /* parameter type RK_S64 */
     MPP_SET_OUTPUT_TIMEOUT,             /* parameter type RK_S64 */
     MPP_SET_DISABLE_THREAD,             /* MPP no thread mode and use external thread to decode */
+    /*
+     * per context buffer budget in bytes, zero for unlimited
+     * set before init to also reduce in-flight tasks and packet buffer size
+     */
+    MPP_SET_MEM_BUDGET,                 /* parameter type RK_S64 */
+    MPP_GET_MEM_USAGE,                  /* parameter type MppMemUsage * */
 
     MPP_STATE_CMD_BASE                  = CMD_MODULE_MPP | CMD_STATE_OPS,
     MPP_START,
@@ -171,6 +177,11 @@ typedef enum {
      * Set current used rate control stategy brief information (type and name)
      */
     MPP_ENC_SET_RC_API_CURRENT          = MPP_ENC_CFG_RC_API + 5,
+    /*
+     * Get RcApiStat structure
+     * Get current rate control runtime statistic like reencode rate
+     */
+    MPP_ENC_GET_RC_API_STAT             = MPP_ENC_CFG_RC_API + 6,
 
     MPP_ENC_CFG_MISC                    = CMD_MODULE_CODEC | CMD_CTX_ID_ENC | CMD_ENC_CFG_MISC,
     MPP_ENC_SET_HEADER_MODE,            /* set MppEncHeaderMode */
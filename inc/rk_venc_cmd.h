@@ -197,6 +197,10 @@ typedef struct MppEncQueryCfg_t {
  */
 typedef enum MppEncBaseCfgChange_e {
     MPP_ENC_BASE_CFG_CHANGE_LOW_DELAY   = (1 << 0),
+    MPP_ENC_BASE_CFG_CHANGE_THREAD      = (1 << 1),
+    MPP_ENC_BASE_CFG_CHANGE_PKT_RING    = (1 << 2),
+    MPP_ENC_BASE_CFG_CHANGE_STATIC      = (1 << 3),
+    MPP_ENC_BASE_CFG_CHANGE_PIPE_DEPTH  = (1 << 4),
     MPP_ENC_BASE_CFG_CHANGE_ALL         = (0xFFFFFFFF),
 } MppEncBaseCfgChange;
 
@@ -204,6 +208,52 @@ typedef struct MppEncBaseCfg_t {
     RK_U32  change;
 
     RK_S32  low_delay;
+
+    /*
+     * encoder thread placement
+     * thread_cpu   - cpu affinity bit mask
+     * thread_nice  - nice value -20 ~ 19
+     * thread_fifo  - SCHED_FIFO priority 1 ~ 99
+     * zero value keeps the env default of mpp_thread_enc_*
+     * thread_time  - encoder thread cpu time in us, get only
+     */
+    RK_U32  thread_cpu;
+    RK_S32  thread_nice;
+    RK_S32  thread_fifo;
+    RK_S64  thread_time;
+
+    /*
+     * output packet ring buffer
+     * 0 - disable, each output packet has its own full size buffer
+     * 1 - enable with ring size of one full size packet buffer
+     * other - enable with ring size in byte
+     * Packets are carved from one ring buffer of the encoder with size
+     * predicted by rate control and go back to the ring on release.
+     * The hardware without ring output support ignores it.
+     */
+    RK_U32  pkt_ring;
+
+    /*
+     * static scene software skip for h264 / h265
+     * static_skip  - max continuous skip frames, 0 - disable
+     * static_thd   - luma mean absolute difference of 16x16 tile to mark
+     *                the tile changed, 0 - default 4
+     * When no tile of input frame changes from the last frame encoded by
+     * hardware the frame is encoded as non-reference P-skip frame by software.
+     * Only luma is compared, a change on chroma planes alone is not detected.
+     */
+    RK_U32  static_skip;
+    RK_U32  static_thd;
+
+    /*
+     * max frames in hardware at the same time for non-block input encoder
+     * 0 - default 2, frame N + 1 is prepared while frame N is encoding
+     * other - 1 ~ 4, limited by encoder task count
+     * Deeper pipeline keeps hardware busy on high frame rate but the rate
+     * control feedback of the frames in hardware is delayed. The pipeline is
+     * drained to the default depth before an intra frame.
+     */
+    RK_S32  pipe_depth;
 } MppEncBaseCfg;
 
 /*
@@ -112,6 +112,8 @@ extern "C" {
  * setup         - called by parser when slot information changed
  * is_changed    - called by mpp to detect whether info change flow is needed
  * ready         - called by mpp when info changed is done
+ * reset_info    - drop the current frame info then next frame will trigger
+ *                 info change again, used when the context is recycled
  *
  * typical info change flow:
  *
@@ -128,6 +130,7 @@ MPP_RET mpp_buf_slot_deinit(MppBufSlots slots);
 MPP_RET mpp_buf_slot_setup(MppBufSlots slots, RK_S32 count);
 RK_U32  mpp_buf_slot_is_changed(MppBufSlots slots);
 MPP_RET mpp_buf_slot_ready(MppBufSlots slots);
+MPP_RET mpp_buf_slot_reset_info(MppBufSlots slots);
 size_t  mpp_buf_slot_get_size(MppBufSlots slots);
 RK_S32  mpp_buf_slot_get_count(MppBufSlots slots);
 /*
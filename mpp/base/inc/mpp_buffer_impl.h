@@ -76,6 +76,26 @@ typedef struct MppBufferImpl_t          MppBufferImpl;
 typedef struct MppBufferGroupImpl_t     MppBufferGroupImpl;
 typedef void (*MppBufCallback)(void *, void *);
 
+/*
+ * Per mpp context buffer accounting
+ *
+ * The internal groups created by a thread attached to an account are charged
+ * to the account. Each charged group holds one reference so the account lives
+ * until its last orphan group is destroyed.
+ */
+typedef struct MppBufAccount_t {
+    char                tag[MPP_TAG_SIZE];
+    RK_S32              ref_count;
+    // 0 - no budget, other - max total internal buffer size in bytes
+    size_t              budget;
+    size_t              usage;
+    size_t              usage_max;
+    RK_S32              group_count;
+    RK_S32              buffer_count;
+    // buffer allocation refused by budget
+    RK_S32              refused;
+} MppBufAccount;
+
 // use index instead of pointer to avoid invalid pointer
 struct MppBufferImpl_t {
     char                tag[MPP_TAG_SIZE];
@@ -144,6 +164,9 @@ struct MppBufferGroupImpl_t {
     MppBufCallback      callback;
     void                *arg;
 
+    // context account charged by internal buffers of this group
+    MppBufAccount       *account;
+
     // link to list_status in MppBufferImpl
     pthread_mutex_t     buf_lock;
     struct hlist_node   hlist;
@@ -208,6 +231,14 @@ void mpp_buffer_group_dump(MppBufferGroupImpl *p);
 void mpp_buffer_service_dump(const char *info);
 MppBufferGroupImpl *mpp_buffer_get_misc_group(MppBufferMode mode, MppBufferType type);
 
+/*
+ * mpp_buf_account_attach binds the account to the calling thread and returns
+ * the previous one for restore. Pass NULL to detach.
+ */
+MPP_RET mpp_buf_account_init(MppBufAccount **account, const char *tag);
+MPP_RET mpp_buf_account_deinit(MppBufAccount *account);
+MppBufAccount *mpp_buf_account_attach(MppBufAccount *account);
+
 #ifdef __cplusplus
 }
 #endif
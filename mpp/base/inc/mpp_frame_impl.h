@@ -77,6 +77,10 @@ struct MppFrameImpl_t {
     RK_U32  eos;
     RK_U32  info_change;
     RK_U32  errinfo;
+    /*
+     * damage - count of lost or damaged reference frames used by this frame
+     */
+    RK_U32  damage;
     MppFrameColorRange color_range;
     MppFrameColorPrimaries color_primaries;
     MppFrameColorTransferCharacteristic color_trc;
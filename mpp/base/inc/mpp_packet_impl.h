@@ -41,6 +41,12 @@ typedef union MppPacketStatus_t {
     };
 } MppPacketStatus;
 
+/*
+ * reference callback for packet data owned by an external allocator
+ * delta is 1 when the packet is copied and -1 when the packet is released
+ */
+typedef void (*MppPacketRefCb)(void *ctx, RK_S32 delta);
+
 /*
  * mpp_packet_imp structure
  *
@@ -74,6 +80,9 @@ typedef struct MppPacketImpl_t {
     MppPktSeg       segments_def[MPP_PKT_SEG_CNT_DEFAULT];
     MppPktSeg       *segments_ext;
     MppPktSeg       *segments;
+
+    MppPacketRefCb  ref_cb;
+    void            *ref_ctx;
 } MppPacketImpl;
 
 #ifdef __cplusplus
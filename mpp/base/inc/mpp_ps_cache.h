@@ -0,0 +1,49 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_PS_CACHE_H__
+#define __MPP_PS_CACHE_H__
+
+#include "rk_type.h"
+
+/*
+ * Process-wide parameter set cache
+ *
+ * Decoders in one process share the parse result of VPS / SPS / PPS. An entry
+ * is keyed by coding type, nal type, a salt for the decoder options which the
+ * parser depends on and the raw nal bytes. Entries are read only after they
+ * are added, a hit copies the parse result out to the caller. The least
+ * recently used entry is dropped when the cache is full.
+ *
+ * env mpp_ps_cache_size sets the max entry count, 0 disables the cache.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* copy parse result of same nal to dst and return 1, return 0 on miss */
+RK_S32 mpp_ps_cache_get(MppCodingType coding, RK_U32 type, RK_U32 salt,
+                        const RK_U8 *nal, RK_S32 len, void *dst, RK_S32 size);
+/* add parse result of nal, it should only be called on successful parse */
+void   mpp_ps_cache_put(MppCodingType coding, RK_U32 type, RK_U32 salt,
+                        const RK_U8 *nal, RK_S32 len, const void *src, RK_S32 size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MPP_PS_CACHE_H__ */
@@ -783,6 +783,35 @@ MPP_RET mpp_buf_slot_ready(MppBufSlots slots)
     return MPP_OK;
 }
 
+MPP_RET mpp_buf_slot_reset_info(MppBufSlots slots)
+{
+    if (NULL == slots) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    buf_slot_dbg(BUF_SLOT_DBG_SETUP, "slot %p reset info\n", slots);
+
+    MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
+    AutoMutex auto_lock(impl->lock);
+
+    if (impl->used_count) {
+        mpp_err_f("slot %p still has %d slots in use\n", slots, impl->used_count);
+        return MPP_NOK;
+    }
+
+    mpp_frame_deinit(&impl->info);
+    mpp_frame_deinit(&impl->info_set);
+    mpp_frame_init(&impl->info);
+    mpp_frame_init(&impl->info_set);
+
+    impl->info_changed  = 0;
+    impl->eos           = 0;
+    impl->buf_size      = 0;
+
+    return MPP_OK;
+}
+
 size_t mpp_buf_slot_get_size(MppBufSlots slots)
 {
     if (NULL == slots) {
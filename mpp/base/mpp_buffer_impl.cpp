@@ -19,6 +19,7 @@
 #include <string.h>
 
 #include "mpp_env.h"
+#include "mpp_mem.h"
 #include "mpp_hash.h"
 #include "mpp_lock.h"
 #include "mpp_debug.h"
@@ -126,6 +127,57 @@ static MppMemPool mpp_buf_grp_pool = mpp_mem_pool_init_f("mpp_buf_grp", sizeof(M
 
 RK_U32 mpp_buffer_debug = 0;
 
+static pthread_once_t buf_account_once = PTHREAD_ONCE_INIT;
+static pthread_key_t buf_account_key;
+
+static void buf_account_key_init(void)
+{
+    pthread_key_create(&buf_account_key, NULL);
+}
+
+static MppBufAccount *buf_account_current(void)
+{
+    pthread_once(&buf_account_once, buf_account_key_init);
+    return (MppBufAccount *)pthread_getspecific(buf_account_key);
+}
+
+static void buf_account_put(MppBufAccount *account)
+{
+    if (!MPP_SUB_FETCH(&account->ref_count, 1))
+        mpp_free(account);
+}
+
+/*
+ * reserve size before allocation so concurrent creation can not exceed the
+ * budget together, return MPP_NOK and roll back when it is over budget
+ */
+static MPP_RET buf_account_inc(MppBufAccount *account, size_t size)
+{
+    size_t usage = MPP_ADD_FETCH(&account->usage, size);
+    size_t old_max;
+
+    if (account->budget && usage > account->budget) {
+        MPP_FETCH_SUB(&account->usage, size);
+        return MPP_NOK;
+    }
+
+    MPP_FETCH_ADD(&account->buffer_count, 1);
+
+    do {
+        old_max = account->usage_max;
+        if (usage <= old_max)
+            break;
+    } while (!MPP_BOOL_CAS(&account->usage_max, old_max, usage));
+
+    return MPP_OK;
+}
+
+static void buf_account_dec(MppBufAccount *account, size_t size)
+{
+    MPP_FETCH_SUB(&account->usage, size);
+    MPP_FETCH_SUB(&account->buffer_count, 1);
+}
+
 static MppBufLogs *buf_logs_init(RK_U32 max_count)
 {
     MppBufLogs *logs = NULL;
@@ -276,8 +328,11 @@ static MPP_RET put_buffer(MppBufferGroupImpl *group, MppBufferImpl *buffer,
         group->usage -= buffer->info.size;
         group->buffer_count--;
 
-        if (group->mode == MPP_BUFFER_INTERNAL)
+        if (group->mode == MPP_BUFFER_INTERNAL) {
             MppBufferService::get_instance()->dec_total(buffer->info.size);
+            if (group->account)
+                buf_account_dec(group->account, buffer->info.size);
+        }
 
         buf_add_log(buffer, BUF_DESTROY, caller);
 
@@ -345,6 +400,7 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
     MPP_RET ret = MPP_OK;
     BufferOp func = NULL;
     MppBufferImpl *p = NULL;
+    RK_S32 account_rsv = 0;
 
     if (NULL == group) {
         mpp_err_f("can not create buffer without group\n");
@@ -365,6 +421,19 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
         goto RET;
     }
 
+    if (group->account && group->mode == MPP_BUFFER_INTERNAL) {
+        MppBufAccount *account = group->account;
+
+        if (buf_account_inc(account, info->size)) {
+            MPP_FETCH_ADD(&account->refused, 1);
+            mpp_err_f("%s size %zu exceed %s budget %zu with usage %zu\n", group->tag,
+                      info->size, account->tag, account->budget, account->usage);
+            ret = MPP_NOK;
+            goto RET;
+        }
+        account_rsv = 1;
+    }
+
     p = (MppBufferImpl *)mpp_mem_pool_get_f(caller, mpp_buffer_pool);
     if (NULL == p) {
         mpp_err_f("failed to allocate context\n");
@@ -381,6 +450,7 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
         ret = MPP_ERR_MALLOC;
         goto RET;
     }
+    account_rsv = 0;
 
     if (NULL == tag)
         tag = group->tag;
@@ -429,6 +499,8 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
     if (group->callback)
         group->callback(group->arg, group);
 RET:
+    if (account_rsv)
+        buf_account_dec(group->account, info->size);
     MPP_BUF_FUNCTION_LEAVE();
     return ret;
 }
@@ -713,6 +785,54 @@ void MppBufferService::dec_total(RK_U32 size)
     MPP_FETCH_SUB(&total_size, size);
 }
 
+MPP_RET mpp_buf_account_init(MppBufAccount **account, const char *tag)
+{
+    MppBufAccount *p = NULL;
+
+    if (NULL == account) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    p = mpp_calloc(MppBufAccount, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc account\n");
+        *account = NULL;
+        return MPP_ERR_MALLOC;
+    }
+
+    snprintf(p->tag, sizeof(p->tag) - 1, "%s", tag ? tag : "unknown");
+    p->ref_count = 1;
+    *account = p;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_buf_account_deinit(MppBufAccount *account)
+{
+    if (NULL == account) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    /* groups still alive keep the account until they are destroyed */
+    if (buf_account_current() == account)
+        mpp_buf_account_attach(NULL);
+
+    buf_account_put(account);
+
+    return MPP_OK;
+}
+
+MppBufAccount *mpp_buf_account_attach(MppBufAccount *account)
+{
+    MppBufAccount *prev = buf_account_current();
+
+    pthread_setspecific(buf_account_key, account);
+
+    return prev;
+}
+
 RK_U32 mpp_buffer_total_now()
 {
     return MppBufferService::get_instance()->get_total_now();
@@ -927,6 +1047,15 @@ MppBufferGroupImpl *MppBufferService::get_group(const char *tag, const char *cal
         misc[mode][buffer_type] = id;
         p->is_misc = 1;
         misc_count++;
+    } else {
+        /* misc group is shared by all context and never charged */
+        MppBufAccount *account = buf_account_current();
+
+        if (account) {
+            MPP_FETCH_ADD(&account->ref_count, 1);
+            MPP_FETCH_ADD(&account->group_count, 1);
+            p->account = account;
+        }
     }
 
     return p;
@@ -1021,6 +1150,12 @@ void MppBufferService::destroy_group(MppBufferGroupImpl *group)
 
     buf_grp_add_log(group, GRP_DESTROY, __FUNCTION__);
 
+    if (group->account) {
+        MPP_FETCH_SUB(&group->account->group_count, 1);
+        buf_account_put(group->account);
+        group->account = NULL;
+    }
+
     list_del_init(&group->list_group);
     hash_del(&group->hlist);
     pthread_mutex_destroy(&group->buf_lock);
@@ -367,7 +367,7 @@ MPP_RET cluster_worker_init(ClusterWorker *p, MppCluster *cluster)
     p->cluster = cluster;
     p->state = WORKER_IDLE;
     snprintf(p->name, sizeof(p->name) - 1, "%d:W%d", cluster->pid, p->worker_id);
-    thd = new MppThread(cluster->worker_func, p, p->name);
+    thd = new MppThread(cluster->worker_func, p, p->name, MPP_THREAD_ROLE_HAL);
     if (thd) {
         p->thd = thd;
         thd->start();
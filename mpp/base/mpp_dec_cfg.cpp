@@ -163,12 +163,25 @@ static const char *dec_cfg_func_names[] = {
     ENTRY(base, disable_error,  U32, RK_U32,            MPP_DEC_CFG_CHANGE_DISABLE_ERROR,   base, disable_error) \
     ENTRY(base, enable_vproc,   U32, RK_U32,            MPP_DEC_CFG_CHANGE_ENABLE_VPROC,    base, enable_vproc) \
     ENTRY(base, enable_fast_play, U32, RK_U32,          MPP_DEC_CFG_CHANGE_ENABLE_FAST_PLAY, base, enable_fast_play) \
+    ENTRY(base, fast_recovery,  U32, RK_U32,            MPP_DEC_CFG_CHANGE_FAST_RECOVERY,   base, fast_recovery) \
     ENTRY(cb, pkt_rdy_cb,       PTR, MppExtCbFunc,      MPP_DEC_CB_CFG_CHANGE_PKT_RDY,      cb, pkt_rdy_cb) \
     ENTRY(cb, pkt_rdy_ctx,      PTR, MppExtCbCtx,       MPP_DEC_CB_CFG_CHANGE_PKT_RDY,      cb, pkt_rdy_ctx) \
     ENTRY(cb, pkt_rdy_cmd,      S32, RK_S32,            MPP_DEC_CB_CFG_CHANGE_PKT_RDY,      cb, pkt_rdy_cmd) \
     ENTRY(cb, frm_rdy_cb,       PTR, MppExtCbFunc,      MPP_DEC_CB_CFG_CHANGE_FRM_RDY,      cb, frm_rdy_cb) \
     ENTRY(cb, frm_rdy_ctx,      PTR, MppExtCbCtx,       MPP_DEC_CB_CFG_CHANGE_FRM_RDY,      cb, frm_rdy_ctx) \
-    ENTRY(cb, frm_rdy_cmd,      S32, RK_S32,            MPP_DEC_CB_CFG_CHANGE_FRM_RDY,      cb, frm_rdy_cmd)
+    ENTRY(cb, frm_rdy_cmd,      S32, RK_S32,            MPP_DEC_CB_CFG_CHANGE_FRM_RDY,      cb, frm_rdy_cmd) \
+    ENTRY(thread, parser_cpu,   U32, RK_U32,            MPP_DEC_THREAD_CFG_CHANGE_PARSER,   thread, parser_cpu) \
+    ENTRY(thread, parser_nice,  S32, RK_S32,            MPP_DEC_THREAD_CFG_CHANGE_PARSER,   thread, parser_nice) \
+    ENTRY(thread, parser_fifo,  S32, RK_S32,            MPP_DEC_THREAD_CFG_CHANGE_PARSER,   thread, parser_fifo) \
+    ENTRY(thread, parser_time,  S64, RK_S64,            0,                                  thread, parser_time) \
+    ENTRY(thread, hal_cpu,      U32, RK_U32,            MPP_DEC_THREAD_CFG_CHANGE_HAL,      thread, hal_cpu) \
+    ENTRY(thread, hal_nice,     S32, RK_S32,            MPP_DEC_THREAD_CFG_CHANGE_HAL,      thread, hal_nice) \
+    ENTRY(thread, hal_fifo,     S32, RK_S32,            MPP_DEC_THREAD_CFG_CHANGE_HAL,      thread, hal_fifo) \
+    ENTRY(thread, hal_time,     S64, RK_S64,            0,                                  thread, hal_time) \
+    ENTRY(thread, vproc_cpu,    U32, RK_U32,            MPP_DEC_THREAD_CFG_CHANGE_VPROC,    thread, vproc_cpu) \
+    ENTRY(thread, vproc_nice,   S32, RK_S32,            MPP_DEC_THREAD_CFG_CHANGE_VPROC,    thread, vproc_nice) \
+    ENTRY(thread, vproc_fifo,   S32, RK_S32,            MPP_DEC_THREAD_CFG_CHANGE_VPROC,    thread, vproc_fifo) \
+    ENTRY(thread, vproc_time,   S64, RK_S64,            0,                                  thread, vproc_time)
 
 ENTRY_TABLE(EXPAND_AS_FUNC)
 ENTRY_TABLE(EXPAND_AS_API)
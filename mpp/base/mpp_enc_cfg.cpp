@@ -125,6 +125,14 @@ public:
 #define ENTRY_TABLE(ENTRY)  \
     /* base config */ \
     ENTRY(base, low_delay,      S32, RK_S32,            MPP_ENC_BASE_CFG_CHANGE_LOW_DELAY,      base, low_delay) \
+    ENTRY(base, thread_cpu,     U32, RK_U32,            MPP_ENC_BASE_CFG_CHANGE_THREAD,         base, thread_cpu) \
+    ENTRY(base, thread_nice,    S32, RK_S32,            MPP_ENC_BASE_CFG_CHANGE_THREAD,         base, thread_nice) \
+    ENTRY(base, thread_fifo,    S32, RK_S32,            MPP_ENC_BASE_CFG_CHANGE_THREAD,         base, thread_fifo) \
+    ENTRY(base, thread_time,    S64, RK_S64,            0,                                      base, thread_time) \
+    ENTRY(base, pkt_ring,       U32, RK_U32,            MPP_ENC_BASE_CFG_CHANGE_PKT_RING,       base, pkt_ring) \
+    ENTRY(base, static_skip,    U32, RK_U32,            MPP_ENC_BASE_CFG_CHANGE_STATIC,         base, static_skip) \
+    ENTRY(base, static_thd,     U32, RK_U32,            MPP_ENC_BASE_CFG_CHANGE_STATIC,         base, static_thd) \
+    ENTRY(base, pipe_depth,     S32, RK_S32,            MPP_ENC_BASE_CFG_CHANGE_PIPE_DEPTH,     base, pipe_depth) \
     /* rc config */ \
     ENTRY(rc,   mode,           S32, MppEncRcMode,      MPP_ENC_RC_CFG_CHANGE_RC_MODE,          rc, rc_mode) \
     ENTRY(rc,   bps_target,     S32, RK_S32,            MPP_ENC_RC_CFG_CHANGE_BPS,              rc, bps_target) \
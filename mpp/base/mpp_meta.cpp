@@ -65,6 +65,7 @@ static MppMetaDef meta_defs[] = {
     {   KEY_ENC_USE_LTR,        TYPE_S32,       },
     {   KEY_ENC_FRAME_QP,       TYPE_S32,       },
     {   KEY_ENC_BASE_LAYER_PID, TYPE_S32,       },
+    {   KEY_ENC_SLICE_TIME,     TYPE_S64,       },
 };
 
 class MppMetaService
@@ -123,6 +123,9 @@ MPP_RET mpp_packet_copy_init(MppPacket *packet, const MppPacket src)
     if (src_impl->buffer) {
         /* if source packet has buffer just create a new reference to buffer */
         mpp_buffer_inc_ref(src_impl->buffer);
+
+        if (src_impl->ref_cb)
+            src_impl->ref_cb(src_impl->ref_ctx, 1);
     } else {
         /*
          * NOTE: only copy valid data
@@ -143,6 +146,8 @@ MPP_RET mpp_packet_copy_init(MppPacket *packet, const MppPacket src)
         p->data = p->pos = pos;
         p->size = p->length = length;
         p->flag |= MPP_PACKET_FLAG_INTERNAL;
+        p->ref_cb = NULL;
+        p->ref_ctx = NULL;
 
         if (length) {
             memcpy(pos, src_impl->pos, length);
@@ -166,6 +171,10 @@ MPP_RET mpp_packet_deinit(MppPacket *packet)
 
     MppPacketImpl *p = (MppPacketImpl *)(*packet);
 
+    /* release external data owner before buffer reference */
+    if (p->ref_cb)
+        p->ref_cb(p->ref_ctx, -1);
+
     /* release buffer reference */
     if (p->buffer)
         mpp_buffer_put(p->buffer);
@@ -263,6 +272,19 @@ MPP_RET mpp_packet_reset(MppPacketImpl *packet)
     void *data = packet->data;
     size_t size = packet->size;
 
+    /*
+     * external data owner also holds the buffer reference, release both and
+     * drop the data which goes back to the owner
+     */
+    if (packet->ref_cb) {
+        packet->ref_cb(packet->ref_ctx, -1);
+        if (packet->buffer)
+            mpp_buffer_put(packet->buffer);
+
+        data = NULL;
+        size = 0;
+    }
+
     memset(packet, 0, sizeof(*packet));
 
     packet->data = data;
@@ -283,6 +305,13 @@ void mpp_packet_set_buffer(MppPacket packet, MppBuffer buffer)
         if (buffer)
             mpp_buffer_inc_ref(buffer);
 
+        /* external data owner goes with the old buffer */
+        if (p->ref_cb) {
+            p->ref_cb(p->ref_ctx, -1);
+            p->ref_cb = NULL;
+            p->ref_ctx = NULL;
+        }
+
         if (p->buffer)
             mpp_buffer_put(p->buffer);
 
@@ -0,0 +1,245 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_ps_cache"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_list.h"
+#include "mpp_debug.h"
+#include "mpp_common.h"
+#include "mpp_thread.h"
+
+#include "mpp_ps_cache.h"
+
+#define PS_CACHE_DBG_FLOW               (0x00000001)
+#define PS_CACHE_DBG_STAT               (0x00000002)
+
+#define ps_cache_dbg(flag, fmt, ...)    _mpp_dbg_f(mpp_ps_cache_debug, flag, fmt, ## __VA_ARGS__)
+
+#define ps_cache_dbg_flow(fmt, ...)     ps_cache_dbg(PS_CACHE_DBG_FLOW, fmt, ## __VA_ARGS__)
+#define ps_cache_dbg_stat(fmt, ...)     ps_cache_dbg(PS_CACHE_DBG_STAT, fmt, ## __VA_ARGS__)
+
+#define PS_CACHE_SIZE_DEFAULT           64
+/* larger nal is not cached, parameter sets are much smaller in practice */
+#define PS_CACHE_NAL_MAX                4096
+
+static RK_U32 mpp_ps_cache_debug = 0;
+
+typedef struct MppPsCacheEntry_t {
+    struct list_head    list;
+
+    MppCodingType       coding;
+    RK_U32              type;
+    RK_U32              salt;
+    RK_U32              hash;
+
+    /* raw nal bytes then parse result in one allocation */
+    RK_S32              len;
+    RK_S32              size;
+    RK_U8               *nal;
+    void                *parsed;
+} MppPsCacheEntry;
+
+class MppPsCache
+{
+public:
+    static MppPsCache *get_inst() {
+        static MppPsCache inst;
+        return &inst;
+    }
+
+    RK_S32 get(MppCodingType coding, RK_U32 type, RK_U32 salt,
+               const RK_U8 *nal, RK_S32 len, void *dst, RK_S32 size);
+    void put(MppCodingType coding, RK_U32 type, RK_U32 salt,
+             const RK_U8 *nal, RK_S32 len, const void *src, RK_S32 size);
+
+    RK_U32 mMax;
+
+private:
+    MppPsCache();
+    ~MppPsCache();
+    MppPsCache(const MppPsCache &);
+    MppPsCache &operator=(const MppPsCache &);
+
+    MppPsCacheEntry *find(MppCodingType coding, RK_U32 type, RK_U32 salt,
+                          RK_U32 hash, const RK_U8 *nal, RK_S32 len);
+
+    Mutex               mLock;
+    /* most recently used entry at the head */
+    struct list_head    mList;
+    RK_U32              mCount;
+
+    RK_U32              mHit;
+    RK_U32              mMiss;
+};
+
+MppPsCache::MppPsCache()
+    : mMax(PS_CACHE_SIZE_DEFAULT),
+      mCount(0),
+      mHit(0),
+      mMiss(0)
+{
+    INIT_LIST_HEAD(&mList);
+
+    mpp_env_get_u32("mpp_ps_cache_debug", &mpp_ps_cache_debug, 0);
+    mpp_env_get_u32("mpp_ps_cache_size", &mMax, PS_CACHE_SIZE_DEFAULT);
+}
+
+MppPsCache::~MppPsCache()
+{
+    MppPsCacheEntry *pos, *n;
+
+    ps_cache_dbg_stat("hit %d miss %d entry %d\n", mHit, mMiss, mCount);
+
+    list_for_each_entry_safe(pos, n, &mList, MppPsCacheEntry, list) {
+        list_del_init(&pos->list);
+        mpp_free(pos);
+    }
+    mCount = 0;
+}
+
+static RK_U32 ps_cache_hash(const RK_U8 *nal, RK_S32 len)
+{
+    /* FNV-1a */
+    RK_U32 hash = 2166136261u;
+    RK_S32 i;
+
+    for (i = 0; i < len; i++) {
+        hash ^= nal[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/* called with lock */
+MppPsCacheEntry *MppPsCache::find(MppCodingType coding, RK_U32 type, RK_U32 salt,
+                                  RK_U32 hash, const RK_U8 *nal, RK_S32 len)
+{
+    MppPsCacheEntry *pos;
+
+    list_for_each_entry(pos, &mList, MppPsCacheEntry, list) {
+        if (pos->hash == hash && pos->len == len && pos->coding == coding &&
+            pos->type == type && pos->salt == salt &&
+            !memcmp(pos->nal, nal, len))
+            return pos;
+    }
+
+    return NULL;
+}
+
+RK_S32 MppPsCache::get(MppCodingType coding, RK_U32 type, RK_U32 salt,
+                       const RK_U8 *nal, RK_S32 len, void *dst, RK_S32 size)
+{
+    RK_U32 hash = ps_cache_hash(nal, len);
+    MppPsCacheEntry *entry = NULL;
+    RK_S32 hit = 0;
+
+    AutoMutex auto_lock(&mLock);
+
+    entry = find(coding, type, salt, hash, nal, len);
+    if (entry && entry->size == size) {
+        memcpy(dst, entry->parsed, size);
+        list_move(&entry->list, &mList);
+        hit = 1;
+        mHit++;
+    } else {
+        mMiss++;
+    }
+
+    ps_cache_dbg_flow("coding %x type %d len %d hash %08x %s\n",
+                      coding, type, len, hash, hit ? "hit" : "miss");
+
+    return hit;
+}
+
+void MppPsCache::put(MppCodingType coding, RK_U32 type, RK_U32 salt,
+                     const RK_U8 *nal, RK_S32 len, const void *src, RK_S32 size)
+{
+    RK_U32 hash = ps_cache_hash(nal, len);
+    MppPsCacheEntry *entry = NULL;
+    RK_S32 offset = MPP_ALIGN(sizeof(MppPsCacheEntry) + len, sizeof(void *));
+
+    AutoMutex auto_lock(&mLock);
+
+    /* another decoder may have added the same nal after its lookup */
+    entry = find(coding, type, salt, hash, nal, len);
+    if (entry) {
+        list_move(&entry->list, &mList);
+        return;
+    }
+
+    if (mCount >= mMax) {
+        entry = list_last_entry(&mList, MppPsCacheEntry, list);
+        list_del_init(&entry->list);
+        mCount--;
+
+        ps_cache_dbg_flow("drop coding %x type %d hash %08x\n",
+                          entry->coding, entry->type, entry->hash);
+        mpp_free(entry);
+    }
+
+    entry = (MppPsCacheEntry *)mpp_malloc_size(RK_U8, offset + size);
+    if (NULL == entry) {
+        mpp_err_f("failed to malloc entry size %d\n", offset + size);
+        return;
+    }
+
+    INIT_LIST_HEAD(&entry->list);
+    entry->coding = coding;
+    entry->type = type;
+    entry->salt = salt;
+    entry->hash = hash;
+    entry->len = len;
+    entry->size = size;
+    entry->nal = (RK_U8 *)(entry + 1);
+    entry->parsed = (RK_U8 *)entry + offset;
+    memcpy(entry->nal, nal, len);
+    memcpy(entry->parsed, src, size);
+
+    list_add(&entry->list, &mList);
+    mCount++;
+
+    ps_cache_dbg_flow("add coding %x type %d len %d hash %08x entry %d\n",
+                      coding, type, len, hash, mCount);
+}
+
+RK_S32 mpp_ps_cache_get(MppCodingType coding, RK_U32 type, RK_U32 salt,
+                        const RK_U8 *nal, RK_S32 len, void *dst, RK_S32 size)
+{
+    MppPsCache *cache = MppPsCache::get_inst();
+
+    if (!cache->mMax || NULL == nal || len <= 0 || len > PS_CACHE_NAL_MAX ||
+        NULL == dst || size <= 0)
+        return 0;
+
+    return cache->get(coding, type, salt, nal, len, dst, size);
+}
+
+void mpp_ps_cache_put(MppCodingType coding, RK_U32 type, RK_U32 salt,
+                      const RK_U8 *nal, RK_S32 len, const void *src, RK_S32 size)
+{
+    MppPsCache *cache = MppPsCache::get_inst();
+
+    if (!cache->mMax || NULL == nal || len <= 0 || len > PS_CACHE_NAL_MAX ||
+        NULL == src || size <= 0)
+        return;
+
+    cache->put(coding, type, salt, nal, len, src, size);
+}
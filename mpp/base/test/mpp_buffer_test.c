@@ -26,6 +26,7 @@
 #include "mpp_common.h"
 #include "mpp_buffer.h"
 #include "mpp_allocator.h"
+#include "mpp_buffer_impl.h"
 
 #define MPP_BUFFER_TEST_DEBUG_FLAG      (0xf)
 #define MPP_BUFFER_TEST_SIZE            (SZ_1K*4)
@@ -43,6 +44,7 @@ int main()
     void *commit_ptr[MPP_BUFFER_TEST_COMMIT_COUNT];
     MppBuffer normal_buffer[MPP_BUFFER_TEST_NORMAL_COUNT];
     MppBuffer legacy_buffer = NULL;
+    MppBufAccount *account = NULL;
     size_t size = MPP_BUFFER_TEST_SIZE;
     RK_S32 count = MPP_BUFFER_TEST_COMMIT_COUNT;
     RK_S32 i;
@@ -239,6 +241,57 @@ int main()
         group = NULL;
     }
 
+    mpp_log("mpp_buffer_test account budget start\n");
+
+    ret = mpp_buf_account_init(&account, "mpp_buffer_test");
+    if (MPP_OK != ret) {
+        mpp_err("mpp_buffer_test mpp_buf_account_init failed\n");
+        goto MPP_BUFFER_failed;
+    }
+
+    account->budget = MPP_BUFFER_TEST_SIZE * 2;
+    mpp_buf_account_attach(account);
+
+    ret = mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_ION);
+    mpp_buf_account_attach(NULL);
+    if (MPP_OK != ret) {
+        mpp_err("mpp_buffer_test mpp_buffer_group_get failed\n");
+        goto MPP_BUFFER_failed;
+    }
+
+    /* the third buffer goes beyond budget and should be refused */
+    for (i = 0; i < 3; i++)
+        mpp_buffer_get(group, &normal_buffer[i], MPP_BUFFER_TEST_SIZE);
+
+    if (NULL == normal_buffer[0] || NULL == normal_buffer[1] || normal_buffer[2] ||
+        account->usage != MPP_BUFFER_TEST_SIZE * 2 || account->refused != 1) {
+        mpp_err("mpp_buffer_test account usage %zu refused %d mismatch\n",
+                account->usage, account->refused);
+        ret = MPP_NOK;
+        goto MPP_BUFFER_failed;
+    }
+
+    for (i = 0; i < 2; i++) {
+        mpp_buffer_put(normal_buffer[i]);
+        normal_buffer[i] = NULL;
+    }
+
+    mpp_buffer_group_put(group);
+    group = NULL;
+
+    if (account->usage || account->usage_max != MPP_BUFFER_TEST_SIZE * 2 ||
+        account->group_count) {
+        mpp_err("mpp_buffer_test account release usage %zu max %zu group %d mismatch\n",
+                account->usage, account->usage_max, account->group_count);
+        ret = MPP_NOK;
+        goto MPP_BUFFER_failed;
+    }
+
+    mpp_buf_account_deinit(account);
+    account = NULL;
+
+    mpp_log("mpp_buffer_test account budget success\n");
+
     mpp_log("mpp_buffer_test success\n");
 
     ret = mpp_buffer_get(NULL, &legacy_buffer, MPP_BUFFER_TEST_SIZE);
@@ -284,6 +337,11 @@ MPP_BUFFER_failed:
         legacy_buffer = NULL;
     }
 
+    if (account) {
+        mpp_buf_account_deinit(account);
+        account = NULL;
+    }
+
     if (allocator) {
         mpp_allocator_put(&allocator);
     }
@@ -37,6 +37,7 @@ void *meta_test(void *param)
     MppBuffer buffer;
     void *ptr;
     RK_S32 val;
+    RK_S64 val64;
     RK_S32 i;
 
     time_start = mpp_time();
@@ -76,6 +77,7 @@ void *meta_test(void *param)
         ret |= mpp_meta_set_s32(meta, KEY_ENC_USE_LTR, 0);
         ret |= mpp_meta_set_s32(meta, KEY_ENC_FRAME_QP, 0);
         ret |= mpp_meta_set_s32(meta, KEY_ENC_BASE_LAYER_PID, 0);
+        ret |= mpp_meta_set_s64(meta, KEY_ENC_SLICE_TIME, 0);
 
         /* get */
         ret |= mpp_meta_get_frame(meta,  KEY_INPUT_FRAME, &frame);
@@ -108,6 +110,7 @@ void *meta_test(void *param)
         ret |= mpp_meta_get_s32(meta, KEY_ENC_USE_LTR, &val);
         ret |= mpp_meta_get_s32(meta, KEY_ENC_FRAME_QP, &val);
         ret |= mpp_meta_get_s32(meta, KEY_ENC_BASE_LAYER_PID, &val);
+        ret |= mpp_meta_get_s64(meta, KEY_ENC_SLICE_TIME, &val64);
 
         ret |= mpp_meta_put(meta);
     }
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_ps_cache_test"
+
+#include <string.h>
+
+#include "mpp_err.h"
+#include "mpp_log.h"
+
+#include "mpp_ps_cache.h"
+
+typedef struct TestPs_t {
+    RK_S32  id;
+    RK_S32  width;
+    RK_S32  height;
+} TestPs;
+
+#define TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            mpp_err("check %s failed at line %d\n", #cond, __LINE__); \
+            return MPP_NOK; \
+        } \
+    } while (0)
+
+int main()
+{
+    RK_U8 sps[] = { 0x67, 0x42, 0xc0, 0x1e, 0xda, 0x02, 0x80, 0xbf, 0xe5 };
+    RK_U8 alt[] = { 0x67, 0x42, 0xc0, 0x1e, 0xda, 0x02, 0x80, 0xbf, 0xe6 };
+    TestPs src = { 0, 640, 480 };
+    TestPs dst;
+    RK_S32 i;
+
+    mpp_log("mpp_ps_cache_test start\n");
+
+    memset(&dst, 0, sizeof(dst));
+    TEST_CHECK(!mpp_ps_cache_get(MPP_VIDEO_CodingAVC, 7, 0, sps, sizeof(sps),
+                                 &dst, sizeof(dst)));
+
+    mpp_ps_cache_put(MPP_VIDEO_CodingAVC, 7, 0, sps, sizeof(sps), &src, sizeof(src));
+
+    TEST_CHECK(mpp_ps_cache_get(MPP_VIDEO_CodingAVC, 7, 0, sps, sizeof(sps),
+                                &dst, sizeof(dst)));
+    TEST_CHECK(!memcmp(&src, &dst, sizeof(src)));
+
+    /* any difference in key is a miss */
+    TEST_CHECK(!mpp_ps_cache_get(MPP_VIDEO_CodingAVC, 7, 0, alt, sizeof(alt),
+                                 &dst, sizeof(dst)));
+    TEST_CHECK(!mpp_ps_cache_get(MPP_VIDEO_CodingAVC, 7, 1, sps, sizeof(sps),
+                                 &dst, sizeof(dst)));
+    TEST_CHECK(!mpp_ps_cache_get(MPP_VIDEO_CodingHEVC, 7, 0, sps, sizeof(sps),
+                                 &dst, sizeof(dst)));
+    TEST_CHECK(!mpp_ps_cache_get(MPP_VIDEO_CodingAVC, 8, 0, sps, sizeof(sps),
+                                 &dst, sizeof(dst)));
+    TEST_CHECK(!mpp_ps_cache_get(MPP_VIDEO_CodingAVC, 7, 0, sps, sizeof(sps) - 1,
+                                 &dst, sizeof(dst)));
+    TEST_CHECK(!mpp_ps_cache_get(MPP_VIDEO_CodingAVC, 7, 0, sps, sizeof(sps),
+                                 &dst, sizeof(dst) - 1));
+
+    /* least recently used entry is dropped when full */
+    for (i = 0; i < 256; i++) {
+        alt[sizeof(alt) - 1] = (RK_U8)i;
+        src.id = i;
+        mpp_ps_cache_put(MPP_VIDEO_CodingHEVC, 33, 0, alt, sizeof(alt), &src, sizeof(src));
+    }
+
+    TEST_CHECK(!mpp_ps_cache_get(MPP_VIDEO_CodingAVC, 7, 0, sps, sizeof(sps),
+                                 &dst, sizeof(dst)));
+    TEST_CHECK(mpp_ps_cache_get(MPP_VIDEO_CodingHEVC, 33, 0, alt, sizeof(alt),
+                                &dst, sizeof(dst)));
+    TEST_CHECK(dst.id == 255);
+
+    mpp_log("mpp_ps_cache_test success\n");
+
+    return MPP_OK;
+}
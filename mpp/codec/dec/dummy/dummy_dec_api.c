@@ -45,7 +45,6 @@ typedef struct DummyDec_t {
     RK_S64          task_pts;
     RK_U32          task_eos;
 
-    RK_U32          slots_inited;
     RK_U32          frame_count;
     RK_S32          prev_index;
     RK_S32          slot_index[DUMMY_DEC_REF_COUNT];
@@ -83,6 +82,10 @@ MPP_RET dummy_dec_init(void *dec, ParserCfg *cfg)
     p->stream       = stream;
     p->stream_size  = stream_size;
     p->task_pkt     = task_pkt;
+
+    /* slots must be ready before the first parse for unused slot check */
+    mpp_buf_slot_setup(p->frame_slots, DUMMY_DEC_FRAME_COUNT);
+
     for (i = 0; i < DUMMY_DEC_REF_COUNT; i++) {
         p->slot_index[i] = -1;
     }
@@ -206,10 +209,7 @@ MPP_RET dummy_dec_parse(void *dec, HalDecTask *task)
 
     mpp_frame_init(&frame);
 
-    if (!p->slots_inited) {
-        mpp_buf_slot_setup(slots, DUMMY_DEC_FRAME_COUNT);
-        p->slots_inited = 1;
-    } else if (frame_count >= 2) {
+    if (frame_count >= 2) {
         // do info change test
         width = DUMMY_DEC_FRAME_NEW_WIDTH;
         height = DUMMY_DEC_FRAME_NEW_HEIGHT;
@@ -20,6 +20,7 @@
 #include <string.h>
 
 #include "mpp_err.h"
+#include "mpp_ps_cache.h"
 
 #include "h264d_pps.h"
 #include "h264d_scalist.h"
@@ -134,17 +135,33 @@ MPP_RET process_pps(H264_SLICE_t *currSlice)
     H264dCurCtx_t *p_Cur = currSlice->p_Cur;
     BitReadCtx_t *p_bitctx = &p_Cur->bitctx;
     H264_PPS_t *cur_pps = &p_Cur->pps;
+    H264_PPS_t *pps = NULL;
+    //!< scaling list parsing depends on chroma format of current sps
+    RK_U32 salt = p_Cur->sps.chroma_format_idc;
 
     reset_curpps_data(cur_pps);// reset
 
-    FUN_CHECK(ret = parser_pps(p_bitctx, &p_Cur->sps, cur_pps));
+    if (!mpp_ps_cache_get(MPP_VIDEO_CodingAVC, H264_NALU_TYPE_PPS, salt,
+                          p_bitctx->buf, p_bitctx->buf_len,
+                          cur_pps, sizeof(H264_PPS_t))) {
+        FUN_CHECK(ret = parser_pps(p_bitctx, &p_Cur->sps, cur_pps));
+        mpp_ps_cache_put(MPP_VIDEO_CodingAVC, H264_NALU_TYPE_PPS, salt,
+                         p_bitctx->buf, p_bitctx->buf_len,
+                         cur_pps, sizeof(H264_PPS_t));
+    }
     //!< MakePPSavailable
     ASSERT(cur_pps->Valid == 1);
-    if (!currSlice->p_Vid->ppsSet[cur_pps->pic_parameter_set_id]) {
-        currSlice->p_Vid->ppsSet[cur_pps->pic_parameter_set_id] = mpp_malloc(H264_PPS_t, 1);
+    pps = currSlice->p_Vid->ppsSet[cur_pps->pic_parameter_set_id];
+    //!< repeated pps does not need hardware table update
+    if (pps && !memcmp(pps, cur_pps, sizeof(H264_PPS_t)))
+        return ret = MPP_OK;
+
+    if (!pps) {
+        pps = mpp_malloc(H264_PPS_t, 1);
+        currSlice->p_Vid->ppsSet[cur_pps->pic_parameter_set_id] = pps;
     }
 
-    memcpy(currSlice->p_Vid->ppsSet[cur_pps->pic_parameter_set_id], cur_pps, sizeof(H264_PPS_t));
+    memcpy(pps, cur_pps, sizeof(H264_PPS_t));
     p_Cur->p_Vid->spspps_update = 1;
 
     return ret = MPP_OK;
@@ -20,6 +20,7 @@
 #include <string.h>
 
 #include "mpp_mem.h"
+#include "mpp_ps_cache.h"
 
 #include "h264d_global.h"
 #include "h264d_sps.h"
@@ -447,19 +448,34 @@ MPP_RET process_sps(H264_SLICE_t *currSlice)
     H264dCurCtx_t *p_Cur = currSlice->p_Cur;
     BitReadCtx_t *p_bitctx = &p_Cur->bitctx;
     H264_SPS_t *cur_sps = &p_Cur->sps;
+    H264_SPS_t *sps = NULL;
 
     reset_cur_sps_data(cur_sps); // reset
-    //!< parse sps
-    FUN_CHECK(ret = parser_sps(p_bitctx, cur_sps, currSlice->p_Dec));
-    //!< decide "max_dec_frame_buffering" for DPB
-    FUN_CHECK(ret = get_max_dec_frame_buf_size(cur_sps));
+    //!< identical sps parsed by any decoder is taken from cache
+    if (!mpp_ps_cache_get(MPP_VIDEO_CodingAVC, H264_NALU_TYPE_SPS, 0,
+                          p_bitctx->buf, p_bitctx->buf_len,
+                          cur_sps, sizeof(H264_SPS_t))) {
+        //!< parse sps
+        FUN_CHECK(ret = parser_sps(p_bitctx, cur_sps, currSlice->p_Dec));
+        //!< decide "max_dec_frame_buffering" for DPB
+        FUN_CHECK(ret = get_max_dec_frame_buf_size(cur_sps));
+        if (cur_sps->Valid)
+            mpp_ps_cache_put(MPP_VIDEO_CodingAVC, H264_NALU_TYPE_SPS, 0,
+                             p_bitctx->buf, p_bitctx->buf_len,
+                             cur_sps, sizeof(H264_SPS_t));
+    }
     //!< make SPS available, copy
     if (cur_sps->Valid) {
-        if (!currSlice->p_Vid->spsSet[cur_sps->seq_parameter_set_id]) {
-            currSlice->p_Vid->spsSet[cur_sps->seq_parameter_set_id] = mpp_calloc(H264_SPS_t, 1);
+        sps = currSlice->p_Vid->spsSet[cur_sps->seq_parameter_set_id];
+        //!< repeated sps does not need hardware table update
+        if (sps && !memcmp(sps, cur_sps, sizeof(H264_SPS_t)))
+            return ret = MPP_OK;
+
+        if (!sps) {
+            sps = mpp_calloc(H264_SPS_t, 1);
+            currSlice->p_Vid->spsSet[cur_sps->seq_parameter_set_id] = sps;
         }
-        memcpy(currSlice->p_Vid->spsSet[cur_sps->seq_parameter_set_id],
-               cur_sps, sizeof(H264_SPS_t));
+        memcpy(sps, cur_sps, sizeof(H264_SPS_t));
     }
     p_Cur->p_Vid->spspps_update = 1;
 
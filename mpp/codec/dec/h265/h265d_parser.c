@@ -1187,8 +1187,60 @@ static RK_S32 mpp_hevc_output_frame(void *ctx, int flush)
     return 0;
 }
 
+/*
+ * fast recovery: picture with recovery point sei starts decoding like a random
+ * access point and the damage of reference loss ends at the recovery poc.
+ */
+static void hevc_recovery_point(HEVCContext *s)
+{
+    RK_U32 recovery_sei = s->recovery_sei;
+
+    s->recovery_sei = 0;
+    s->recovery_begin = 0;
+
+    if (!s->h265dctx->cfg->base.fast_recovery)
+        return;
+
+    if (IS_IRAP(s)) {
+        s->recovery_valid = 0;
+        return;
+    }
+
+    if (!recovery_sei)
+        return;
+
+    if (s->max_ra == INT_MAX)
+        s->max_ra = INT_MIN;
+
+    s->recovery_begin = 1;
+    s->recovery_valid = 1;
+    s->recovery_poc = s->poc + s->recovery_poc_cnt;
+    h265d_dbg(H265D_DBG_REF, "recovery from poc %d to poc %d\n", s->poc, s->recovery_poc);
+}
+
+/* count lost or damaged frames in reference lists of current frame */
+static RK_U32 hevc_ref_damage(HEVCContext *s)
+{
+    static const RK_U32 lists[] = { ST_CURR_BEF, ST_CURR_AFT, LT_CURR };
+    RK_U32 damage = 0;
+    RK_U32 i;
+    RK_S32 j;
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(lists); i++) {
+        RefPicList *list = &s->rps[lists[i]];
+
+        for (j = 0; j < list->nb_refs; j++) {
+            if (list->ref[j] && list->ref[j]->error_flag)
+                damage++;
+        }
+    }
+
+    return damage;
+}
+
 static RK_S32 hevc_frame_start(HEVCContext *s)
 {
+    RK_U32 fast_recovery = s->h265dctx->cfg->base.fast_recovery;
     int ret;
 
     if (s->ref) {
@@ -1199,6 +1251,18 @@ static RK_S32 hevc_frame_start(HEVCContext *s)
     s->is_decoded        = 0;
     s->first_nal_type    = s->nal_unit_type;
     s->miss_ref_flag = 0;
+    s->new_miss_ref = 0;
+
+    /* references are intact again from the recovery point */
+    if (s->recovery_valid && s->poc >= s->recovery_poc) {
+        RK_U32 i;
+
+        for (i = 0; i < MPP_ARRAY_ELEMS(s->DPB); i++)
+            s->DPB[i].error_flag = 0;
+
+        s->recovery_valid = 0;
+        h265d_dbg(H265D_DBG_REF, "recovered at poc %d\n", s->poc);
+    }
 
     ret = mpp_hevc_frame_rps(s);
     if (ret < 0) {
@@ -1206,13 +1270,21 @@ static RK_S32 hevc_frame_start(HEVCContext *s)
         goto fail;
     }
 
+    /* another loss before the recovery point makes it useless */
+    if (s->new_miss_ref && !s->recovery_begin)
+        s->recovery_valid = 0;
+
     ret = mpp_hevc_set_new_ref(s, &s->frame, s->poc);
     if (ret < 0)
         goto fail;
 
+    mpp_frame_set_damage(s->frame, hevc_ref_damage(s));
+
     if (!s->h265dctx->cfg->base.disable_error && s->miss_ref_flag) {
         if (!IS_IRAP(s)) {
-            mpp_frame_set_errinfo(s->frame, MPP_FRAME_ERR_UNKNOW);
+            /* fast recovery outputs concealed frame and reports damage only */
+            if (!fast_recovery)
+                mpp_frame_set_errinfo(s->frame, MPP_FRAME_ERR_UNKNOW);
             s->ref->error_flag = 1;
         } else {
             /*when found current I frame have miss refer
@@ -1287,32 +1359,38 @@ static RK_S32 parser_nal_unit(HEVCContext *s, const RK_U8 *nal, int length)
         }
         break;
     case NAL_PPS:
-        if (s->pre_pps_data == NULL) {
-            s->pre_pps_data = mpp_calloc(RK_U8, length + 128);
-            memcpy(s->pre_pps_data, nal, length);
-            s->pps_len = length;
-            s->pps_buf_size = length + 128;
-            s->ps_need_upate = 1;
-        } else if (s->pps_len == length) {
-            if (memcmp(s->pre_pps_data, nal, length)) {
-                s->ps_need_upate = 1;
-                memcpy(s->pre_pps_data, nal, length);
-            }
-        } else {
-            if (s->pps_buf_size < length) {
-                MPP_FREE(s->pre_pps_data);
-                s->pre_pps_data = mpp_calloc(RK_U8, length + 128);
-                memcpy(s->pre_pps_data, nal, length);
-                s->pps_buf_size = length + 128;
-                s->pps_len = length;
+        if (s->pre_pps_data && s->pps_len == length &&
+            !memcmp(s->pre_pps_data, nal, length)) {
+            BitReadCtx_t peek = *gb;
+            RK_U32 pps_id = 0;
+
+            /*
+             * same as the last parsed pps and it is still installed, the pps
+             * depending on a changed sps has been dropped on sps update
+             */
+            if (!mpp_read_ue(&peek, &pps_id) && pps_id < MAX_PPS_COUNT &&
+                s->pps_list[pps_id]) {
+                h265d_dbg(H265D_DBG_GLOBAL, "skip repeated pps %d\n", pps_id);
+                break;
             }
-            s->ps_need_upate = 1;
         }
+
+        if (s->pps_buf_size < length) {
+            MPP_FREE(s->pre_pps_data);
+            s->pre_pps_data = mpp_calloc(RK_U8, length + 128);
+            s->pps_buf_size = s->pre_pps_data ? length + 128 : 0;
+        }
+        s->pps_len = 0;
+        s->ps_need_upate = 1;
         ret = mpp_hevc_decode_nal_pps(s);
         if (ret < 0 && !s->is_decoded) {
             mpp_err("mpp_hevc_decode_nal_pps error ret = %d", ret);
             goto fail;
         }
+        if (!ret && s->pre_pps_data) {
+            memcpy(s->pre_pps_data, nal, length);
+            s->pps_len = length;
+        }
         break;
     case NAL_SEI_PREFIX:
     case NAL_SEI_SUFFIX:
@@ -1355,6 +1433,9 @@ static RK_S32 parser_nal_unit(HEVCContext *s, const RK_U8 *nal, int length)
             return ret;
         }
 
+        if (s->sh.first_slice_in_pic_flag)
+            hevc_recovery_point(s);
+
         if (s->max_ra == INT_MAX) {
             if (s->nal_unit_type == NAL_CRA_NUT || IS_BLA(s)) {
                 s->max_ra = s->poc;
@@ -2085,6 +2166,8 @@ MPP_RET h265d_reset(void *ctx)
     h265d_split_reset(h265dctx->split_cxt);
     s->max_ra = INT_MAX;
     s->eos = 0;
+    s->recovery_sei = 0;
+    s->recovery_valid = 0;
     return MPP_OK;
 }
 
@@ -2106,7 +2189,9 @@ MPP_RET h265d_callback(void *ctx, void *err_info)
         MppFrame frame = NULL;
         RK_U32 i = 0;
 
-        if (s->first_nal_type >= 16 && s->first_nal_type <= 23) {
+        /* fast recovery keeps decoding and reports damage on later frames */
+        if (s->first_nal_type >= 16 && s->first_nal_type <= 23 &&
+            !h265dctx->cfg->base.fast_recovery) {
             mpp_log("IS_IRAP frame found error");
             s->max_ra = INT_MAX;
         }
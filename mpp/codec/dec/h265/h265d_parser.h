@@ -604,6 +604,15 @@ typedef struct HEVCContext {
     RK_S64 pts;
     RK_U8  has_get_eos;
     RK_U8  miss_ref_flag;
+    /* new reference loss found on current frame */
+    RK_U8  new_miss_ref;
+
+    /* fast recovery: recovery point sei and the poc where damage ends */
+    RK_U8  recovery_sei;
+    RK_U8  recovery_begin;
+    RK_U8  recovery_valid;
+    RK_S32 recovery_poc_cnt;
+    RK_S32 recovery_poc;
     RK_U8  pre_pps_id;
     RK_U8  ps_need_upate;
 
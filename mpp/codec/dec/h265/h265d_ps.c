@@ -29,6 +29,7 @@
 
 #include "mpp_mem.h"
 #include "mpp_bitread.h"
+#include "mpp_ps_cache.h"
 #include "h265d_parser.h"
 
 static const RK_U8 default_scaling_list_intra[] = {
@@ -1044,6 +1045,12 @@ int mpp_hevc_decode_nal_vps(HEVCContext *s)
         mpp_err( "VPS id out of range: %d\n", vps_id);
         goto err;
     }
+
+    if (NULL == s->h265dctx->compare_info &&
+        mpp_ps_cache_get(MPP_VIDEO_CodingHEVC, NAL_VPS, 0, gb->buf, gb->buf_len,
+                         vps, sizeof(HEVCVPS)))
+        goto install;
+
     READ_BITS(gb, 2, &value);
     if (value != 3) { // vps_reserved_three_2bits
         mpp_err( "vps_reserved_three_2bits is not three\n");
@@ -1139,8 +1146,12 @@ int mpp_hevc_decode_nal_vps(HEVCContext *s)
             return -1;
         }
         mpp_log("compare_vps ok \n");
+    } else {
+        mpp_ps_cache_put(MPP_VIDEO_CodingHEVC, NAL_VPS, 0, gb->buf, gb->buf_len,
+                         vps, sizeof(HEVCVPS));
     }
 
+install:
     if (s->vps_list[vps_id] &&
         !memcmp(s->vps_list[vps_id], vps_buf, sizeof(HEVCVPS))) {
         mpp_free(vps_buf);
@@ -1408,6 +1419,27 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
 
     h265d_dbg(H265D_DBG_FUNCTION, "Decoding SPS\n");
 
+    if (NULL == s->h265dctx->compare_info &&
+        mpp_ps_cache_get(MPP_VIDEO_CodingHEVC, NAL_SPS, s->apply_defdispwin,
+                         gb->buf, gb->buf_len, sps, sizeof(HEVCSPS))) {
+        sps_id = sps->sps_id;
+        if (!s->vps_list[sps->vps_id]) {
+            mpp_err( "VPS %d does not exist\n", sps->vps_id);
+            ret =  MPP_ERR_STREAM;
+            goto err;
+        }
+
+        // NOTE: keep the side effects of a full parse
+        if (sps->scaling_list_enable_flag)
+            s->scaling_list_listen[sps_id] = 1;
+
+        if (s->h265dctx->width == 0 && s->h265dctx->height == 0) {
+            s->h265dctx->width = sps->output_width;
+            s->h265dctx->height = sps->output_height;
+        }
+        goto install;
+    }
+
     // Coded parameters
 
     READ_BITS(gb, 4, &sps->vps_id);
@@ -1821,6 +1853,9 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
             return -1;
         }
         mpp_log("compare sps ok");
+    } else {
+        mpp_ps_cache_put(MPP_VIDEO_CodingHEVC, NAL_SPS, s->apply_defdispwin,
+                         gb->buf, gb->buf_len, sps, sizeof(HEVCSPS));
     }
 #if 0
     if (s->h265dctx->debug & FF_DEBUG_BITSTREAM) {
@@ -1832,6 +1867,7 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
                   av_get_pix_fmt_name(sps->pix_fmt));
     }
 #endif
+install:
     /* check if this is a repeat of an already parsed SPS, then keep the
      * original one.
      * otherwise drop all PPSes that depend on it */
@@ -108,6 +108,7 @@ static HEVCFrame *alloc_frame(HEVCContext *s)
         }
 
         mpp_frame_set_errinfo(frame->frame, 0);
+        mpp_frame_set_damage(frame->frame, 0);
         mpp_frame_set_pts(frame->frame, s->pts);
         mpp_frame_set_poc(frame->frame, s->poc);
         mpp_frame_set_color_range(frame->frame, s->h265dctx->color_range);
@@ -195,6 +196,41 @@ static void mark_ref(HEVCFrame *frame, int flag)
     frame->flags |= flag;
 }
 
+/*
+ * fast recovery: find the decoded frame with buffer nearest to the lost poc
+ * and intact frame first
+ */
+static MppBuffer find_conceal_buf(HEVCContext *s, int poc)
+{
+    MppBuffer best = NULL;
+    RK_U32 best_err = 1;
+    RK_S32 best_dist = INT_MAX;
+    RK_U32 i;
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(s->DPB); i++) {
+        HEVCFrame *frame = &s->DPB[i];
+        MppBuffer buf = NULL;
+        RK_S32 dist;
+
+        if ((frame->slot_index == 0xff) || frame->sequence != s->seq_decode)
+            continue;
+
+        mpp_buf_slot_get_prop(s->slots, frame->slot_index, SLOT_BUFFER, &buf);
+        if (!buf)
+            continue;
+
+        dist = MPP_ABS(frame->poc - poc);
+        if ((!frame->error_flag && best_err) ||
+            (frame->error_flag == best_err && dist < best_dist)) {
+            best = buf;
+            best_err = frame->error_flag ? 1 : 0;
+            best_dist = dist;
+        }
+    }
+
+    return best;
+}
+
 static HEVCFrame *generate_missing_ref(HEVCContext *s, int poc)
 {
     HEVCFrame *frame;
@@ -208,6 +244,16 @@ static HEVCFrame *generate_missing_ref(HEVCContext *s, int poc)
     mpp_buf_slot_set_prop(s->slots, frame->slot_index, SLOT_FRAME, frame->frame);
     mpp_buf_slot_set_flag(s->slots, frame->slot_index, SLOT_CODEC_READY);
     mpp_buf_slot_set_flag(s->slots, frame->slot_index, SLOT_CODEC_USE);
+
+    /* share the buffer of nearest decoded frame instead of a blank one */
+    if (s->h265dctx->cfg->base.fast_recovery) {
+        MppBuffer buf = find_conceal_buf(s, poc);
+
+        if (buf)
+            mpp_buf_slot_set_prop(s->slots, frame->slot_index, SLOT_BUFFER, buf);
+        h265d_dbg(H265D_DBG_REF, "conceal missing poc %d with buffer %p\n", poc, buf);
+    }
+    s->new_miss_ref = 1;
     h265d_dbg(H265D_DBG_REF, "generate_missing_ref frame poc %d slot_index %d", poc, frame->slot_index);
     frame->sequence = s->seq_decode;
     frame->flags    = 0;
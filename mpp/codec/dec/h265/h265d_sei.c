@@ -85,6 +85,34 @@ __BITREAD_ERR:
     return  MPP_ERR_STREAM;
 }
 
+static RK_S32 decode_recovery_point(HEVCContext *s, RK_S32 payload_size)
+{
+    BitReadCtx_t *gb = &s->HEVClc->gb;
+    RK_S32 start = mpp_get_bits_count(gb);
+    RK_S32 recovery_poc_cnt = 0;
+    RK_S32 broken_link = 0;
+    RK_S32 used = 0;
+
+    READ_SE(gb, &recovery_poc_cnt);
+    SKIP_BITS(gb, 1);                   // exact_match_flag
+    READ_ONEBIT(gb, &broken_link);
+
+    h265d_dbg(H265D_DBG_SEI, "recovery point poc cnt %d broken link %d\n",
+              recovery_poc_cnt, broken_link);
+
+    s->recovery_sei = 1;
+    s->recovery_poc_cnt = recovery_poc_cnt;
+
+    // skip payload alignment
+    used = mpp_get_bits_count(gb) - start;
+    if (used < 8 * payload_size)
+        SKIP_BITS(gb, 8 * payload_size - used);
+
+    return 1;
+__BITREAD_ERR:
+    return  MPP_ERR_STREAM;
+}
+
 static RK_S32 decode_pic_timing(HEVCContext *s)
 {
     BitReadCtx_t *gb = &s->HEVClc->gb;
@@ -353,6 +381,8 @@ static RK_S32 decode_nal_sei_message(HEVCContext *s)
             h265d_dbg(H265D_DBG_SEI, "Skipped PREFIX SEI %d\n", payload_type);
             SKIP_BITS(gb, 8 * payload_size);
             return ret;
+        } else if (payload_type == 6) {
+            return decode_recovery_point(s, payload_size);
         } else if (payload_type == 129) {
             active_parameter_sets(s);
             h265d_dbg(H265D_DBG_SEI, "Skipped PREFIX SEI %d\n", payload_type);
@@ -1297,7 +1297,7 @@ const ParserApi api_jpegd_parser = {
     .name = "jpegd_parse",
     .coding = MPP_VIDEO_CodingMJPEG,
     .ctx_size = sizeof(JpegdCtx),
-    .flag = 0,
+    .flag = PARSER_FLAG_INDEP_FRAME,
     .init = jpegd_init,
     .deinit = jpegd_deinit,
     .prepare = jpegd_prepare,
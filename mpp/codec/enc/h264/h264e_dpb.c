@@ -142,6 +142,13 @@ MPP_RET h264e_dpb_setup(H264eDpb *dpb, MppEncCfgSet* cfg, H264eSps *sps)
     if (cfg->hw.extra_buf)
         dpb->total_cnt++;
 
+    /*
+     * non-reference frames in a deeper encoder pipeline hold slots as well,
+     * pipe_depth changes on runtime without dpb setup so reserve the max
+     */
+    dpb->total_cnt += MPP_ENC_PIPE_DEPTH_MAX - MPP_ENC_PIPE_DEPTH_DEFAULT;
+    dpb->total_cnt = MPP_MIN(dpb->total_cnt, (RK_S32)MPP_ARRAY_ELEMS(dpb->frames));
+
     h264e_dbg_dpb("max  ref frm num %d total slot %d\n",
                   ref_frm_num, dpb->total_cnt);
     h264e_dbg_dpb("log2 max frm num %d -> %d\n",
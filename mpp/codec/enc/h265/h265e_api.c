@@ -278,7 +278,7 @@ static MPP_RET h265e_proc_enc_skip(void *ctx, HalEncTask *task)
     ptr += offset;
     p->slice->m_sliceQp = task->rc_task->info.quality_target;
     new_length = h265e_code_slice_skip_frame(ctx, p->slice, ptr, len);
-    task->length = new_length;
+    task->length += new_length;
     task->rc_task->info.bit_real = 8 * new_length;
     ///mpp_packet_set_length(pkt, offset + new_length);
 
@@ -50,6 +50,8 @@ MPP_RET mpp_dec_stop(MppDec ctx);
 
 MPP_RET mpp_dec_reset(MppDec ctx);
 MPP_RET mpp_dec_flush(MppDec ctx);
+/* return the reset decoder to the state after init with cfg for reuse */
+MPP_RET mpp_dec_recycle(MppDec ctx, MppDecCfgSet *cfg);
 MPP_RET mpp_dec_control(MppDec ctx, MpiCmd cmd, void *param);
 MPP_RET mpp_dec_notify(MppDec ctx, RK_U32 flag);
 MPP_RET mpp_dec_callback(MppDec ctx, MppDecEvent event, void *arg);
@@ -107,6 +107,9 @@ typedef struct MppDecImpl_t {
 
     // work mode flags
     RK_U32              parser_fast_mode;
+    /* parser of independent frames parses next frame before previous done */
+    RK_U32              parser_indep_frame;
+    RK_U32              parse_ahead;
     RK_U32              disable_error;
     RK_U32              enable_deinterlace;
 
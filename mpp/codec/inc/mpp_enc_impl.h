@@ -22,6 +22,8 @@
 #include "mpp_enc_ref.h"
 #include "mpp_enc_refs.h"
 #include "mpp_device.h"
+#include "mpp_enc_ring.h"
+#include "mpp_enc_static.h"
 
 #include "rc.h"
 #include "hal_info.h"
@@ -64,6 +66,8 @@ typedef struct MppEncImpl_t {
     RK_S32              rc_cfg_updated;
     RcApiBrief          rc_brief;
     RcCtx               rc_ctx;
+    /* rate control trace recorder for offline simulation */
+    FILE                *rc_trace;
 
     /*
      * thread input / output context
@@ -84,12 +88,30 @@ typedef struct MppEncImpl_t {
 
     /* base task information */
     HalTaskGroup        tasks;
+    RK_S32              task_cnt;
     HalTaskHnd          hnd;
     EncAsyncTaskInfo    *async;
+    /* async task count in hardware */
+    RK_S32              async_cnt;
     RK_U32              task_idx;
     RK_S64              task_pts;
     MppBuffer           frm_buf;
     MppBuffer           pkt_buf;
+    /* output packet ring buffer */
+    MppEncRing          pkt_ring;
+    RK_U32              pkt_ring_size;
+    RK_U32              support_pkt_ring;
+
+    /*
+     * static scene detection
+     * static_cnt       - continuous software skip frame count
+     * static_qp        - real quality of the last hardware encoded frame
+     * static_qp_target - target quality of the last frame from rate control
+     */
+    MppEncStatic        static_ctx;
+    RK_U32              static_cnt;
+    RK_S32              static_qp;
+    RK_S32              static_qp_target;
     MppBuffer           md_info;
 
     // internal status and protection
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_ENC_RING_H__
+#define __MPP_ENC_RING_H__
+
+#include "mpp_packet.h"
+#include "mpp_buffer.h"
+
+/*
+ * Encoder output ring buffer
+ *
+ * One buffer is shared by all output packets of an encoder. Each packet is a
+ * region carved at the ring head and holds a reference to the ring buffer.
+ * The region goes back to the ring when the packet and all of its copies are
+ * released. Regions are reclaimed in carving order, so a packet held by user
+ * blocks the space behind it until it is released.
+ */
+typedef void* MppEncRing;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET mpp_enc_ring_init(MppEncRing *ring, MppBufferGroup group, RK_U32 size);
+/* ring memory is freed after the last region is released */
+MPP_RET mpp_enc_ring_deinit(MppEncRing ring);
+
+RK_U32  mpp_enc_ring_get_size(MppEncRing ring);
+
+/* carve a region of size bytes and attach it to an empty packet */
+MPP_RET mpp_enc_ring_get(MppEncRing ring, MppPacket packet, RK_U32 size);
+/*
+ * grow or trim the region of packet in place
+ * only the latest region can grow, trimming returns the tail space to ring
+ */
+MPP_RET mpp_enc_ring_resize(MppEncRing ring, MppPacket packet, RK_U32 size);
+/* copy packet data to buffer and release the region of packet */
+MPP_RET mpp_enc_ring_move(MppEncRing ring, MppPacket packet, MppBuffer buffer);
+/* return 1 when packet data is a region of ring */
+RK_S32  mpp_enc_ring_check(MppEncRing ring, MppPacket packet);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MPP_ENC_RING_H__ */
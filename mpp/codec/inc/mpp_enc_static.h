@@ -0,0 +1,70 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_ENC_STATIC_H__
+#define __MPP_ENC_STATIC_H__
+
+#include "mpp_frame.h"
+
+/*
+ * Static scene detector for encoder input
+ *
+ * The luma of each 16x16 tile is sampled on two rows against the luma of the
+ * last frame encoded by hardware. A frame is static when the mean absolute
+ * difference of every tile against the reference is not above the threshold.
+ *
+ * The sampled rows move by phase, i.e. the index of the check in current skip
+ * run. Phase 0 ~ 7 cover all 16 rows of a tile, so a change on any row is
+ * found within 8 continuous skip frames.
+ *
+ * Only luma is compared, a change on chroma planes alone is not detected.
+ */
+typedef void* MppEncStatic;
+
+/* encoder state to decide whether a frame may be checked for software skip */
+typedef struct MppEncStaticCond_t {
+    /* max continuous skip frames and current skip count */
+    RK_U32          skip_max;
+    RK_U32          skip_cnt;
+    /* frame needs hardware, e.g. user force config or motion info output */
+    RK_U32          hw_only;
+    /* next frame is intra frame */
+    RK_U32          next_intra;
+    /* real qp of reference frame and rate control target qp */
+    RK_S32          qp_ref;
+    RK_S32          qp_target;
+} MppEncStaticCond;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET mpp_enc_static_init(MppEncStatic *ctx);
+MPP_RET mpp_enc_static_deinit(MppEncStatic ctx);
+
+/* return 1 when the frame may be skipped if it is static */
+RK_S32  mpp_enc_static_allow(const MppEncStaticCond *cond);
+
+/* return 1 when frame is static against reference, 0 on change or no reference */
+RK_S32  mpp_enc_static_check(MppEncStatic ctx, MppFrame frame, RK_U32 thd, RK_U32 phase);
+/* save frame as reference, frame in unsupported format clears reference */
+MPP_RET mpp_enc_static_update(MppEncStatic ctx, MppFrame frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MPP_ENC_STATIC_H__ */
@@ -36,6 +36,8 @@ MPP_RET mpp_parser_flush(Parser prs);
 MPP_RET mpp_parser_control(Parser prs, MpiCmd cmd, void *para);
 MPP_RET mpp_parser_callback(void* prs, void *err_info);
 
+RK_U32  mpp_parser_get_flag(Parser prs);
+
 #ifdef __cplusplus
 }
 #endif
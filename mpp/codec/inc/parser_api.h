@@ -46,7 +46,7 @@ typedef struct DecParserInitCfg_t {
  * name     - decoder name
  * coding   - decoder coding type
  * ctx_size - decoder context size, mpp_dec will use this to malloc memory
- * flag     - reserve
+ * flag     - decoder property flags, see PARSER_FLAG_XXX
  *
  * init     - decoder initialization function
  * deinit   - decoder de-initialization function
@@ -55,6 +55,13 @@ typedef struct DecParserInitCfg_t {
  * flush    - decoder output all frames
  * control  - decoder configure function
  */
+/*
+ * Each frame can be parsed without decoding result of previous frames,
+ * e.g. parser without reference or buffer state update from hal callback.
+ * mpp_dec can parse next frame while hardware is decoding current one.
+ */
+#define PARSER_FLAG_INDEP_FRAME     (0x00000001)
+
 typedef struct ParserApi_t {
     char            *name;
     MppCodingType   coding;
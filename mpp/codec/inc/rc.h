@@ -80,6 +80,9 @@ MPP_RET rc_frm_end(RcCtx ctx, EncRcTask *task);
 MPP_RET rc_hal_start(RcCtx ctx, EncRcTask *task);
 MPP_RET rc_hal_end(RcCtx ctx, EncRcTask *task);
 
+/* Runtime statistic */
+MPP_RET rc_get_stat(RcCtx ctx, RcApiStat *stat);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __RC_TRACE_H__
+#define __RC_TRACE_H__
+
+#include <stdio.h>
+
+#include "mpp_rc_api.h"
+
+/*
+ * Rate control trace
+ *
+ * The trace records the rate control config and the per-frame statistic of
+ * a real encoding session in text format. It is written by encoder when
+ * environment mpp_enc_rc_trace is set to a file name prefix and replayed by
+ * rc_sim_test through any registered RcImplApi without hardware.
+ *
+ * cfg line: cfg w h mode fps_in_num fps_in_denorm fps_out_num fps_out_denorm
+ *               igop vgop bps_min bps_target bps_max stats_time
+ *               init_q min_q max_q min_i_q max_i_q i_q_delta vi_q_delta
+ *               max_i_prop min_i_prop init_ip_ratio max_reenc
+ * frm line: frm seq intra type bit_target bit_max bit_min q_target q_min q_max
+ *               bit_real q_real madi madp reenc_times
+ *
+ * One frm line is written on each rc_frm_end. Frame drop and force pskip
+ * reencode end the frame twice and the reader should keep the last line of
+ * the same seq.
+ */
+typedef enum RcTraceType_e {
+    RC_TRACE_EOF,
+    RC_TRACE_CFG,
+    RC_TRACE_FRM,
+    RC_TRACE_BUTT,
+} RcTraceType;
+
+typedef struct RcTraceFrm_t {
+    RK_S32          seq_idx;
+    RK_S32          is_intra;
+    RK_S32          reenc_times;
+    EncRcTaskInfo   info;
+} RcTraceFrm;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET rc_trace_write_cfg(FILE *fp, RcCfg *cfg);
+MPP_RET rc_trace_write_frm(FILE *fp, EncRcTask *task);
+
+/* read next valid line and return RcTraceType */
+RcTraceType rc_trace_read(FILE *fp, RcCfg *cfg, RcTraceFrm *frm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RC_TRACE_H__ */
@@ -22,6 +22,7 @@
 #include "mpp_mem.h"
 #include "mpp_time.h"
 #include "mpp_debug.h"
+#include "mpp_trace.h"
 
 #include "mpp.h"
 
@@ -359,6 +360,29 @@ static RK_U32 reset_parser_thread(Mpp *mpp, DecTask *task)
     return MPP_OK;
 }
 
+static void mpp_dec_update_thread(MppDecImpl *p)
+{
+    MppDecThreadCfg *cfg = &p->cfg.thread;
+
+    if (p->thread_parser) {
+        MppThreadPolicy policy = { cfg->parser_cpu, cfg->parser_nice, cfg->parser_fifo };
+
+        p->thread_parser->set_policy(&policy);
+    }
+
+    if (p->thread_hal) {
+        MppThreadPolicy policy = { cfg->hal_cpu, cfg->hal_nice, cfg->hal_fifo };
+
+        p->thread_hal->set_policy(&policy);
+    }
+
+    if (p->vproc) {
+        MppThreadPolicy policy = { cfg->vproc_cpu, cfg->vproc_nice, cfg->vproc_fifo };
+
+        dec_vproc_set_policy(p->vproc, &policy);
+    }
+}
+
 MPP_RET mpp_dec_update_cfg(MppDecImpl *p)
 {
     MppDecCfgSet *cfg = &p->cfg;
@@ -366,13 +390,17 @@ MPP_RET mpp_dec_update_cfg(MppDecImpl *p)
     MppDecStatusCfg *status = &cfg->status;
 
     if (status->hal_task_count && !status->hal_support_fast_mode) {
-        if (!p->parser_fast_mode && base->fast_parse) {
+        if (!p->parser_fast_mode && base->fast_parse && !p->parser_indep_frame) {
             mpp_err("can not enable fast parse while hal not support\n");
             base->fast_parse = 0;
         }
     }
 
-    p->parser_fast_mode     = base->fast_parse;
+    /* without hal fast mode independent frames are parsed ahead of hal */
+    p->parse_ahead          = base->fast_parse && p->parser_indep_frame &&
+                              status->hal_task_count &&
+                              !status->hal_support_fast_mode;
+    p->parser_fast_mode     = base->fast_parse && !p->parse_ahead;
     p->enable_deinterlace   = base->enable_vproc;
     p->disable_error        = base->disable_error;
 
@@ -474,6 +502,11 @@ MPP_RET mpp_dec_proc_cfg(MppDecImpl *dec, MpiCmd cmd, void *param)
             mpp_dec_set_cfg(&dec->cfg, &dec_cfg->cfg);
             mpp_dec_update_cfg(dec);
             mpp_dec_check_fbc_cap(dec);
+
+            if (dec->cfg.thread.change) {
+                mpp_dec_update_thread(dec);
+                dec->cfg.thread.change = 0;
+            }
         }
 
         dec_dbg_func("set dec cfg\n");
@@ -481,8 +514,14 @@ MPP_RET mpp_dec_proc_cfg(MppDecImpl *dec, MpiCmd cmd, void *param)
     case MPP_DEC_GET_CFG: {
         MppDecCfgImpl *dec_cfg = (MppDecCfgImpl *)param;
 
-        if (dec_cfg)
+        if (dec_cfg) {
+            MppDecThreadCfg *thd = &dec_cfg->cfg.thread;
+
             memcpy(&dec_cfg->cfg, &dec->cfg, sizeof(dec->cfg));
+            thd->parser_time = dec->thread_parser ? dec->thread_parser->get_cpu_time() : 0;
+            thd->hal_time = dec->thread_hal ? dec->thread_hal->get_cpu_time() : 0;
+            thd->vproc_time = dec->vproc ? dec_vproc_get_cpu_time(dec->vproc) : 0;
+        }
 
         dec_dbg_func("get dec cfg\n");
     } break;
@@ -518,7 +557,11 @@ static void mpp_dec_put_frame(Mpp *mpp, RK_S32 index, HalDecTaskFlag flags)
                 dec->enable_deinterlace = 0;
                 dec->vproc = NULL;
             } else {
+                MppDecThreadCfg *thd = &dec->cfg.thread;
+                MppThreadPolicy policy = { thd->vproc_cpu, thd->vproc_nice, thd->vproc_fifo };
+
                 dec->vproc_tasks = cfg.task_group;
+                dec_vproc_set_policy(dec->vproc, &policy);
                 dec_vproc_start(dec->vproc);
             }
         }
@@ -640,6 +683,7 @@ static void mpp_dec_put_frame(Mpp *mpp, RK_S32 index, HalDecTaskFlag flags)
         list->lock();
         list->add_at_tail(&out, sizeof(out));
         mpp->mFramePutCount++;
+        mpp_trace_int32("dec_out_list", list->list_size());
         list->signal();
         list->unlock();
 
@@ -670,6 +714,7 @@ static void mpp_dec_push_display(Mpp *mpp, HalDecTaskFlag flags)
     tmp.info_change = 0;
 
     dec->thread_hal->lock(THREAD_OUTPUT);
+    mpp_trace_begin("dec_output");
     while (MPP_OK == mpp_buf_slot_dequeue(frame_slots, &index, QUEUE_DISPLAY)) {
         /* deal with current frame */
         if (eos && mpp_slots_is_empty(frame_slots, QUEUE_DISPLAY))
@@ -678,6 +723,7 @@ static void mpp_dec_push_display(Mpp *mpp, HalDecTaskFlag flags)
         mpp_dec_put_frame(mpp, index, tmp);
         mpp_buf_slot_clr_flag(frame_slots, index, SLOT_QUEUE_USE);
     }
+    mpp_trace_end("dec_output");
     dec->thread_hal->unlock(THREAD_OUTPUT);
 }
 
@@ -785,6 +831,27 @@ static MPP_RET try_get_input_packet(Mpp *mpp, DecTask *task)
     return MPP_OK;
 }
 
+/* return MPP_NOK when previous task is still on hardware */
+static MPP_RET dec_wait_prev_task(HalTaskGroup tasks, DecTask *task)
+{
+    HalTaskHnd task_prev = NULL;
+
+    if (task->status.prev_task_rdy)
+        return MPP_OK;
+
+    hal_task_get_hnd(tasks, TASK_PROC_DONE, &task_prev);
+    if (NULL == task_prev) {
+        task->wait.prev_task = 1;
+        return MPP_NOK;
+    }
+
+    task->status.prev_task_rdy  = 1;
+    task->wait.prev_task = 0;
+    hal_task_hnd_set_status(task_prev, TASK_IDLE);
+
+    return MPP_OK;
+}
+
 static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
 {
     MppDecImpl *dec = (MppDecImpl *)mpp->mDec;
@@ -853,7 +920,9 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
         mpp_dbg_pts("input packet pts %lld\n", mpp_packet_get_pts(dec->mpp_pkt_in));
 
         mpp_clock_start(dec->clocks[DEC_PRS_PREPARE]);
+        mpp_trace_begin("dec_prs_prepare");
         mpp_parser_prepare(dec->parser, dec->mpp_pkt_in, task_dec);
+        mpp_trace_end("dec_prs_prepare");
         mpp_clock_pause(dec->clocks[DEC_PRS_PREPARE]);
         if (dec->cfg.base.sort_pts && task_dec->valid) {
             task->ts_cur.pts = mpp_packet_get_pts(dec->mpp_pkt_in);
@@ -923,22 +992,13 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
         task->status.dec_pkt_copy_rdy = 1;
     }
 
-    /* 7.1 if not fast mode wait previous task done here */
-    if (!dec->parser_fast_mode) {
-        // wait previous task done
-        if (!task->status.prev_task_rdy) {
-            HalTaskHnd task_prev = NULL;
-            hal_task_get_hnd(tasks, TASK_PROC_DONE, &task_prev);
-            if (task_prev) {
-                task->status.prev_task_rdy  = 1;
-                task->wait.prev_task = 0;
-                hal_task_hnd_set_status(task_prev, TASK_IDLE);
-                task_prev = NULL;
-            } else {
-                task->wait.prev_task = 1;
-                return MPP_NOK;
-            }
-        }
+    /*
+     * 7.1 if not fast mode wait previous task done here
+     * parse ahead mode waits after parsing on step 8.1
+     */
+    if (!dec->parser_fast_mode && !dec->parse_ahead) {
+        if (dec_wait_prev_task(tasks, task))
+            return MPP_NOK;
     }
 
     // for vp9 only wait all task is processed
@@ -959,10 +1019,15 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
     }
     dec_dbg_detail("detail: %p check mframes pass\n", dec);
 
-    /* 7.3 wait for a unused slot index for decoder parse operation */
-    task->wait.dec_slot_idx = (mpp_slots_get_unused_count(frame_slots)) ? (0) : (1);
-    if (task->wait.dec_slot_idx)
-        return MPP_ERR_BUFFER_FULL;
+    /*
+     * 7.3 wait for a unused slot index for decoder parse operation
+     * parse ahead task waiting previous task already has its slot
+     */
+    if (!dec->parse_ahead || !task->status.task_parsed_rdy) {
+        task->wait.dec_slot_idx = (mpp_slots_get_unused_count(frame_slots)) ? (0) : (1);
+        if (task->wait.dec_slot_idx)
+            return MPP_ERR_BUFFER_FULL;
+    }
 
     /*
      * 8. send packet data to parser
@@ -980,7 +1045,9 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
      */
     if (!task->status.task_parsed_rdy) {
         mpp_clock_start(dec->clocks[DEC_PRS_PARSE]);
+        mpp_trace_begin("dec_prs_parse");
         mpp_parser_parse(dec->parser, task_dec);
+        mpp_trace_end("dec_prs_parse");
         mpp_clock_pause(dec->clocks[DEC_PRS_PARSE]);
         task->status.task_parsed_rdy = 1;
     }
@@ -1010,6 +1077,19 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
     }
     dec_dbg_detail("detail: %p check output index pass\n", dec);
 
+    /*
+     * 8.1 parse ahead mode wait previous task done here
+     *
+     * The frame is parsed while hardware is decoding previous one. Hal has
+     * only one register set so register generation still waits for it.
+     */
+    if (dec->parse_ahead) {
+        if (dec_wait_prev_task(tasks, task))
+            return MPP_NOK;
+
+        dec_dbg_detail("detail: %p parse ahead wait prev task pass\n", dec);
+    }
+
     /*
      * 9. parse local task and slot to check whether new buffer or info change is needed.
      *
@@ -1112,14 +1192,25 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
         }
     }
 
+    /*
+     * frame in flight from register generation to hardware done, keyed by
+     * output slot. Only tasks reaching here go through mpp_hal_hw_wait on hal
+     * thread, info change / eos / skipped tasks never open the slice.
+     */
+    mpp_trace_async_begin("dec_frame", output);
+
     /* generating registers table */
     mpp_clock_start(dec->clocks[DEC_HAL_GEN_REG]);
+    mpp_trace_begin("dec_hal_gen_reg");
     mpp_hal_reg_gen(dec->hal, &task->info);
+    mpp_trace_end("dec_hal_gen_reg");
     mpp_clock_pause(dec->clocks[DEC_HAL_GEN_REG]);
 
     /* send current register set to hardware */
     mpp_clock_start(dec->clocks[DEC_HW_START]);
+    mpp_trace_begin("dec_hw_start");
     mpp_hal_hw_start(dec->hal, &task->info);
+    mpp_trace_end("dec_hw_start");
     mpp_clock_pause(dec->clocks[DEC_HW_START]);
 
     /*
@@ -1154,6 +1245,7 @@ void *mpp_dec_parser_thread(void *data)
 
     dec_task_init(&task);
 
+    mpp_buf_account_attach(mpp->mBufAccount);
     mpp_clock_start(dec->clocks[DEC_PRS_TOTAL]);
 
     while (1) {
@@ -1170,8 +1262,12 @@ void *mpp_dec_parser_thread(void *data)
              * 3. no buffer on analyzing output task
              */
             if (check_task_wait(dec, &task)) {
+                /* wait flag shows which of packet / slot / task is missing */
+                mpp_trace_int32("dec_prs_wait_flag", task.wait.val);
                 mpp_clock_start(dec->clocks[DEC_PRS_WAIT]);
+                mpp_trace_begin("dec_prs_wait");
                 parser->wait();
+                mpp_trace_end("dec_prs_wait");
                 mpp_clock_pause(dec->clocks[DEC_PRS_WAIT]);
             }
         }
@@ -1235,6 +1331,7 @@ void *mpp_dec_hal_thread(void *data)
     HalTaskInfo task_info;
     HalDecTask  *task_dec = &task_info.dec;
 
+    mpp_buf_account_attach(mpp->mBufAccount);
     mpp_clock_start(dec->clocks[DEC_HAL_TOTAL]);
 
     while (1) {
@@ -1257,7 +1354,9 @@ void *mpp_dec_hal_thread(void *data)
 
                 mpp_dec_notify(dec, MPP_DEC_NOTIFY_TASK_ALL_DONE);
                 mpp_clock_start(dec->clocks[DEC_HAL_WAIT]);
+                mpp_trace_begin("dec_hal_wait");
                 hal->wait();
+                mpp_trace_end("dec_hal_wait");
                 mpp_clock_pause(dec->clocks[DEC_HAL_WAIT]);
                 continue;
             }
@@ -1312,7 +1411,10 @@ void *mpp_dec_hal_thread(void *data)
             }
 
             mpp_clock_start(dec->clocks[DEC_HW_WAIT]);
+            mpp_trace_begin("dec_hw_wait");
             mpp_hal_hw_wait(dec->hal, &task_info);
+            mpp_trace_end("dec_hw_wait");
+            mpp_trace_async_end("dec_frame", task_dec->output);
             mpp_clock_pause(dec->clocks[DEC_HW_WAIT]);
             dec->dec_hw_run_count++;
 
@@ -1378,14 +1480,19 @@ void *mpp_dec_advanced_thread(void *data)
     MppFrame frame = NULL;
     MppPacket packet = NULL;
 
+    mpp_buf_account_attach(mpp->mBufAccount);
+
     while (1) {
         {
             AutoMutex autolock(thd_dec->mutex());
             if (MPP_THREAD_RUNNING != thd_dec->get_status())
                 break;
 
-            if (check_task_wait(dec, &task))
+            if (check_task_wait(dec, &task)) {
+                mpp_trace_begin("dec_prs_wait");
                 thd_dec->wait();
+                mpp_trace_end("dec_prs_wait");
+            }
         }
 
         // process user control
@@ -1441,7 +1548,9 @@ void *mpp_dec_advanced_thread(void *data)
             MppBuffer input_buffer = mpp_packet_get_buffer(packet);
             MppBuffer output_buffer = mpp_frame_get_buffer(frame);
 
+            mpp_trace_begin("dec_prs_prepare");
             mpp_parser_prepare(dec->parser, packet, task_dec);
+            mpp_trace_end("dec_prs_prepare");
 
             /*
              * We may find eos in prepare step and there will be no anymore vaild task generated.
@@ -1463,7 +1572,9 @@ void *mpp_dec_advanced_thread(void *data)
             mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_CODEC_READY);
             mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
 
+            mpp_trace_begin("dec_prs_parse");
             ret = mpp_parser_parse(dec->parser, task_dec);
+            mpp_trace_end("dec_prs_parse");
             if (ret != MPP_OK) {
                 mpp_err_f("something wrong with mpp_parser_parse!\n");
                 mpp_frame_set_errinfo(frame, 1); /* 0 - OK; 1 - error */
@@ -1496,9 +1607,15 @@ void *mpp_dec_advanced_thread(void *data)
                 dec->info_updated = 1;
             }
             // register genertation
+            mpp_trace_begin("dec_hal_gen_reg");
             mpp_hal_reg_gen(dec->hal, &pTask->info);
+            mpp_trace_end("dec_hal_gen_reg");
+            mpp_trace_begin("dec_hw_start");
             mpp_hal_hw_start(dec->hal, &pTask->info);
+            mpp_trace_end("dec_hw_start");
+            mpp_trace_begin("dec_hw_wait");
             mpp_hal_hw_wait(dec->hal, &pTask->info);
+            mpp_trace_end("dec_hw_wait");
 
             MppFrame tmp = NULL;
             mpp_buf_slot_get_prop(frame_slots, task_dec->output, SLOT_FRAME_PTR, &tmp);
@@ -1619,6 +1736,9 @@ MPP_RET mpp_dec_set_cfg(MppDecCfgSet *dst, MppDecCfgSet *src)
         if (change & MPP_DEC_CFG_CHANGE_ENABLE_FAST_PLAY)
             dst_base->enable_fast_play = src_base->enable_fast_play;
 
+        if (change & MPP_DEC_CFG_CHANGE_FAST_RECOVERY)
+            dst_base->fast_recovery = src_base->fast_recovery;
+
         dst_base->change = change;
         src_base->change = 0;
     }
@@ -1643,6 +1763,33 @@ MPP_RET mpp_dec_set_cfg(MppDecCfgSet *dst, MppDecCfgSet *src)
         src_cb->change = 0;
     }
 
+    if (src->thread.change) {
+        MppDecThreadCfg *dst_thd = &dst->thread;
+        MppDecThreadCfg *src_thd = &src->thread;
+        RK_U32 change = src_thd->change;
+
+        if (change & MPP_DEC_THREAD_CFG_CHANGE_PARSER) {
+            dst_thd->parser_cpu = src_thd->parser_cpu;
+            dst_thd->parser_nice = src_thd->parser_nice;
+            dst_thd->parser_fifo = src_thd->parser_fifo;
+        }
+
+        if (change & MPP_DEC_THREAD_CFG_CHANGE_HAL) {
+            dst_thd->hal_cpu = src_thd->hal_cpu;
+            dst_thd->hal_nice = src_thd->hal_nice;
+            dst_thd->hal_fifo = src_thd->hal_fifo;
+        }
+
+        if (change & MPP_DEC_THREAD_CFG_CHANGE_VPROC) {
+            dst_thd->vproc_cpu = src_thd->vproc_cpu;
+            dst_thd->vproc_nice = src_thd->vproc_nice;
+            dst_thd->vproc_fifo = src_thd->vproc_fifo;
+        }
+
+        dst_thd->change = change;
+        src_thd->change = 0;
+    }
+
     return MPP_OK;
 }
 
@@ -1739,12 +1886,9 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecInitCfg *cfg)
 
         support_fast_mode = hal_cfg.support_fast_mode;
 
-        if (dec_cfg->base.fast_parse && support_fast_mode) {
+        if (dec_cfg->base.fast_parse && support_fast_mode)
             hal_task_count = 3;
-        } else {
-            dec_cfg->base.fast_parse = 0;
-            p->parser_fast_mode = 0;
-        }
+
         dec_cfg->status.hal_support_fast_mode = support_fast_mode;
         dec_cfg->status.hal_task_count = hal_task_count;
 
@@ -1775,6 +1919,15 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecInitCfg *cfg)
             break;
         }
 
+        /* independent frames can still be parsed ahead without hal fast mode */
+        p->parser_indep_frame = (mpp_parser_get_flag(parser) & PARSER_FLAG_INDEP_FRAME) ? 1 : 0;
+        if (!support_fast_mode && !p->parser_indep_frame)
+            dec_cfg->base.fast_parse = 0;
+
+        mpp_dec_update_cfg(p);
+        dec_dbg_detail("detail: %p fast parse %d parse ahead %d\n", p,
+                       p->parser_fast_mode, p->parse_ahead);
+
         ret = hal_info_init(&p->hal_info, MPP_CTX_DEC, coding);
         if (ret) {
             mpp_err_f("could not init hal info\n");
@@ -1914,15 +2067,20 @@ MPP_RET mpp_dec_start(MppDec ctx)
 
     if (dec->coding != MPP_VIDEO_CodingMJPEG) {
         dec->thread_parser = new MppThread(mpp_dec_parser_thread,
-                                           dec->mpp, "mpp_dec_parser");
+                                           dec->mpp, "mpp_dec_parser",
+                                           MPP_THREAD_ROLE_PARSER);
         dec->thread_hal = new MppThread(mpp_dec_hal_thread,
-                                        dec->mpp, "mpp_dec_hal");
+                                        dec->mpp, "mpp_dec_hal",
+                                        MPP_THREAD_ROLE_HAL);
 
+        mpp_dec_update_thread(dec);
         dec->thread_parser->start();
         dec->thread_hal->start();
     } else {
         dec->thread_parser = new MppThread(mpp_dec_advanced_thread,
-                                           dec->mpp, "mpp_dec_parser");
+                                           dec->mpp, "mpp_dec_parser",
+                                           MPP_THREAD_ROLE_PARSER);
+        mpp_dec_update_thread(dec);
         dec->thread_parser->start();
     }
 
@@ -1987,6 +2145,46 @@ MPP_RET mpp_dec_reset(MppDec ctx)
     return MPP_OK;
 }
 
+MPP_RET mpp_dec_recycle(MppDec ctx, MppDecCfgSet *cfg)
+{
+    MppDecImpl *dec = (MppDecImpl *)ctx;
+    MppDecCfgSet init;
+    MPP_RET ret;
+
+    dec_dbg_func("%p in\n", dec);
+    if (NULL == dec || NULL == cfg) {
+        mpp_err_f("found NULL input dec %p cfg %p\n", dec, cfg);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    /* advanced mode has no parser reset flow */
+    if (dec->coding == MPP_VIDEO_CodingMJPEG)
+        return MPP_NOK;
+
+    /* all frames must be returned by user after reset */
+    if (mpp_slots_get_used_count(dec->frame_slots) ||
+        mpp_slots_get_used_count(dec->packet_slots))
+        return MPP_NOK;
+
+    ret = mpp_buf_slot_reset_info(dec->frame_slots);
+    if (ret)
+        return ret;
+
+    memcpy(&init, cfg, sizeof(init));
+    init.base.change = MPP_DEC_CFG_CHANGE_ALL;
+    init.cb.change = MPP_DEC_CB_CFG_CHANGE_ALL;
+    init.thread.change = MPP_DEC_THREAD_CFG_CHANGE_ALL;
+
+    mpp_dec_set_cfg(&dec->cfg, &init);
+    mpp_dec_update_cfg(dec);
+    mpp_dec_check_fbc_cap(dec);
+    mpp_dec_update_thread(dec);
+    dec->cfg.thread.change = 0;
+
+    dec_dbg_func("%p out\n", dec);
+    return MPP_OK;
+}
+
 MPP_RET mpp_dec_flush(MppDec ctx)
 {
     MppDecImpl *dec = (MppDecImpl *)ctx;
@@ -43,5 +43,7 @@
 #define enc_dbg_frm_status(fmt, ...)    mpp_enc_dbg_f(MPP_ENC_DBG_FRM_STATUS, fmt, ## __VA_ARGS__)
 
 extern RK_U32 mpp_enc_debug;
+/* trace enabled flag checked before each traced stage */
+extern RK_U32 mpp_enc_trace;
 
 #endif /* __MPP_ENC_DEBUG_H__ */
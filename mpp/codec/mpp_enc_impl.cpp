@@ -21,6 +21,7 @@
 #include <limits.h>
 
 #include "mpp_time.h"
+#include "mpp_trace.h"
 #include "mpp_common.h"
 
 #include "mpp_frame_impl.h"
@@ -30,6 +31,7 @@
 #include "mpp_enc_debug.h"
 #include "mpp_enc_cfg_impl.h"
 #include "mpp_enc_impl.h"
+#include "rc_trace.h"
 #include "mpp_enc_cb_param.h"
 
 typedef union EncAsyncWait_u {
@@ -461,6 +463,8 @@ MPP_RET mpp_enc_callback(const char *caller, void *ctx, RK_S32 cmd, void *param)
         impl->status.soi = part_first;
         impl->status.eoi = 1;
 
+        mpp_meta_set_s64(mpp_packet_get_meta(packet), KEY_ENC_SLICE_TIME, mpp_time());
+
         task->part_pos += slice_length;
         task->part_length += slice_length;
         task->part_count++;
@@ -490,6 +494,7 @@ MPP_RET mpp_enc_callback(const char *caller, void *ctx, RK_S32 cmd, void *param)
             EncFrmStatus *frm = &task->rc_task->frm;
 
             mpp_meta_set_s32(impl->meta, KEY_OUTPUT_INTRA, frm->is_intra);
+            mpp_meta_set_s64(impl->meta, KEY_ENC_SLICE_TIME, mpp_time());
         }
 
         mpp_packet_copy_segment_info(impl, packet);
@@ -834,6 +839,40 @@ MPP_RET mpp_enc_proc_cfg(MppEncImpl *enc, MpiCmd cmd, void *param)
             if (change & MPP_ENC_BASE_CFG_CHANGE_LOW_DELAY)
                 dst->base.low_delay = src->base.low_delay;
 
+            if (change & MPP_ENC_BASE_CFG_CHANGE_THREAD) {
+                MppThreadPolicy policy;
+
+                dst->base.thread_cpu = src->base.thread_cpu;
+                dst->base.thread_nice = src->base.thread_nice;
+                dst->base.thread_fifo = src->base.thread_fifo;
+
+                policy.cpu_mask = dst->base.thread_cpu;
+                policy.nice = dst->base.thread_nice;
+                policy.fifo = dst->base.thread_fifo;
+
+                if (enc->thread_enc)
+                    enc->thread_enc->set_policy(&policy);
+            }
+
+            if (change & MPP_ENC_BASE_CFG_CHANGE_PKT_RING)
+                dst->base.pkt_ring = src->base.pkt_ring;
+
+            if (change & MPP_ENC_BASE_CFG_CHANGE_STATIC) {
+                dst->base.static_skip = src->base.static_skip;
+                dst->base.static_thd = src->base.static_thd;
+            }
+
+            if (change & MPP_ENC_BASE_CFG_CHANGE_PIPE_DEPTH) {
+                RK_S32 depth = src->base.pipe_depth;
+
+                if (depth < 0 || depth > MPP_ENC_PIPE_DEPTH_MAX) {
+                    mpp_err("invalid pipe depth %d not in range [0, %d]\n",
+                            depth, MPP_ENC_PIPE_DEPTH_MAX);
+                    ret = MPP_ERR_VALUE;
+                } else
+                    dst->base.pipe_depth = depth;
+            }
+
             src->base.change = 0;
         }
 
@@ -924,6 +963,11 @@ MPP_RET mpp_enc_proc_cfg(MppEncImpl *enc, MpiCmd cmd, void *param)
         enc->rc_status.rc_api_user_cfg = 1;
         enc->rc_status.rc_api_updated = 1;
     } break;
+    case MPP_ENC_GET_RC_API_STAT : {
+        RcApiStat *stat = (RcApiStat *)param;
+
+        ret = rc_get_stat(enc->rc_ctx, stat);
+    } break;
     case MPP_ENC_SET_HEADER_MODE : {
         if (param) {
             MppEncHeaderMode mode = *((MppEncHeaderMode *)param);
@@ -1260,6 +1304,8 @@ MPP_RET mpp_enc_proc_rc_update(MppEncImpl *enc)
         memset(&usr_cfg, 0 , sizeof(usr_cfg));
         set_rc_cfg(&usr_cfg, cfg);
         ret = rc_update_usr_cfg(enc->rc_ctx, &usr_cfg);
+        if (enc->rc_trace)
+            rc_trace_write_cfg(enc->rc_trace, &usr_cfg);
         rc_cfg->change = 0;
         prep_cfg->change = 0;
 
@@ -1281,7 +1327,11 @@ MPP_RET mpp_enc_proc_rc_update(MppEncImpl *enc)
 }
 
 #define ENC_RUN_FUNC2(func, ctx, task, mpp, ret)        \
+    if (mpp_enc_trace)                                  \
+        mpp_trace_begin(#func);                         \
     ret = func(ctx, task);                              \
+    if (mpp_enc_trace)                                  \
+        mpp_trace_end(#func);                           \
     if (ret) {                                          \
         mpp_err("mpp %p "#func":%-4d failed return %d", \
                 mpp, __LINE__, ret);                    \
@@ -1317,19 +1367,212 @@ static MPP_RET mpp_enc_check_frm_pkt(MppEncImpl *enc)
     return (NULL == enc->frame || NULL == enc->frm_buf) ? MPP_NOK : MPP_OK;
 }
 
+static RK_U32 mpp_enc_get_pkt_buf_size(MppEncImpl *enc)
+{
+    /* NOTE: set buffer w * h * 1.5 to avoid buffer overflow */
+    MppEncPrepCfg *prep = &enc->cfg.prep;
+    RK_U32 width  = MPP_ALIGN(prep->width, 16);
+    RK_U32 height = MPP_ALIGN(prep->height, 16);
+
+    if (enc->coding == MPP_VIDEO_CodingMJPEG)
+        return width * height * 3 / 2;
+
+    /* budget refuses the allocation instead of shrinking the buffer */
+    return width * height;
+}
+
+/* header room of ring region before rate control predicts the frame size */
+#define ENC_PKT_RING_HDR_SIZE   SZ_4K
+#define ENC_PKT_RING_MIN_SIZE   SZ_64K
+
+static void mpp_enc_check_pkt_ring(MppEncImpl *enc)
+{
+    Mpp *mpp = (Mpp *)enc->mpp;
+    RK_U32 size = 0;
+
+    /*
+     * low delay partition output shares the packet buffer while encoding and
+     * two pass deflicker encodes the first pass before rate control start
+     */
+    if (enc->cfg.base.pkt_ring && enc->support_pkt_ring && !enc->low_delay_part_mode &&
+        !(enc->support_hw_deflicker && enc->cfg.rc.debreath_en)) {
+        size = enc->cfg.base.pkt_ring;
+        if (size == 1)
+            size = mpp_enc_get_pkt_buf_size(enc);
+
+        size = MPP_MAX(size, ENC_PKT_RING_MIN_SIZE);
+    }
+
+    if (size == enc->pkt_ring_size)
+        return;
+
+    /* packets still in use keep the old ring until they are released */
+    if (enc->pkt_ring) {
+        mpp_enc_ring_deinit(enc->pkt_ring);
+        enc->pkt_ring = NULL;
+    }
+
+    if (size)
+        mpp_enc_ring_init(&enc->pkt_ring, mpp->mPacketGroup, size);
+
+    enc->pkt_ring_size = size;
+}
+
+/*
+ * Predict the output size of ring region from rate control target with 50%
+ * margin plus the header, sei and user data added before hardware stream.
+ */
+static RK_U32 mpp_enc_get_pkt_ring_size(MppEncImpl *enc, EncAsyncTaskInfo *task)
+{
+    HalEncTask *hal_task = &task->task;
+    EncRcTaskInfo *info = &task->rc.info;
+    EncFrmStatus *frm = &task->rc.frm;
+    RK_U32 full = mpp_enc_get_pkt_buf_size(enc);
+    RK_S32 bits = MPP_MAX(info->bit_max, info->bit_target);
+    RK_U32 size = 0;
+
+    /* no frame size limit from rate control, e.g. fixqp */
+    if (bits <= 0)
+        return full;
+
+    size = hal_task->length + bits / 8 * 3 / 2 + ENC_PKT_RING_HDR_SIZE;
+
+    if (frm->is_intra)
+        size += enc->hdr_len;
+
+    if (frm->is_idr)
+        size += enc->version_length + enc->rc_cfg_length;
+
+    if (mpp_frame_has_meta(hal_task->frame)) {
+        MppMeta meta = mpp_frame_get_meta(hal_task->frame);
+        MppEncUserData *user_data = NULL;
+        MppEncUserDataSet *user_datas = NULL;
+        RK_U32 i;
+
+        /* sei payload with emulation prevention worst case */
+        mpp_meta_get_ptr(meta, KEY_USER_DATA, (void**)&user_data);
+        if (user_data)
+            size += user_data->len * 3 / 2;
+
+        mpp_meta_get_ptr(meta, KEY_USER_DATAS, (void**)&user_datas);
+        if (user_datas) {
+            for (i = 0; i < user_datas->count; i++)
+                size += user_datas->datas[i].len * 3 / 2 + 32;
+        }
+    }
+
+    return MPP_MIN(size, full);
+}
+
+/* move packet out of ring region to a full size buffer */
+static MPP_RET mpp_enc_move_pkt_buf(MppEncImpl *enc, HalEncTask *hal_task)
+{
+    Mpp *mpp = (Mpp *)enc->mpp;
+    MppBuffer buffer = NULL;
+
+    mpp_buffer_get(mpp->mPacketGroup, &buffer, mpp_enc_get_pkt_buf_size(enc));
+    if (NULL == buffer) {
+        mpp_err_f("failed to get full size packet buffer\n");
+        return MPP_ERR_NOMEM;
+    }
+
+    if (mpp_enc_ring_move(enc->pkt_ring, hal_task->packet, buffer)) {
+        mpp_buffer_put(buffer);
+        return MPP_NOK;
+    }
+
+    enc->pkt_buf = buffer;
+    hal_task->output = buffer;
+
+    enc_dbg_detail("move output pkt %p to buf %p\n", hal_task->packet, buffer);
+
+    return MPP_OK;
+}
+
+/* grow ring region to the predicted size after rate control start */
+static MPP_RET mpp_enc_fit_pkt_buf(MppEncImpl *enc, EncAsyncTaskInfo *task)
+{
+    HalEncTask *hal_task = &task->task;
+    RK_U32 size;
+
+    if (!mpp_enc_ring_check(enc->pkt_ring, hal_task->packet))
+        return MPP_OK;
+
+    size = mpp_enc_get_pkt_ring_size(enc, task);
+
+    enc_dbg_detail("task %d ring region size %d\n", task->rc.frm.seq_idx, size);
+
+    if (!mpp_enc_ring_resize(enc->pkt_ring, hal_task->packet, size))
+        return MPP_OK;
+
+    return mpp_enc_move_pkt_buf(enc, hal_task);
+}
+
+/*
+ * When hardware stream overflows the ring region finish the hardware task
+ * and encode the frame again to a full size buffer with the same rate
+ * control result. Overflow on full size buffer keeps the legacy behavior.
+ */
+static MPP_RET mpp_enc_check_pkt_overflow(Mpp *mpp, EncAsyncTaskInfo *task)
+{
+    MppEncImpl *enc = (MppEncImpl *)mpp->mEnc;
+    MppEncHal hal = enc->enc_hal;
+    EncFrmStatus *frm = &task->rc.frm;
+    HalEncTask *hal_task = &task->task;
+    MPP_RET ret = MPP_OK;
+
+    if (!(hal_task->flags.err & HAL_ENC_TASK_ERR_OVERFLOW))
+        return MPP_OK;
+
+    hal_task->flags.err &= ~HAL_ENC_TASK_ERR_OVERFLOW;
+
+    if (!mpp_enc_ring_check(enc->pkt_ring, hal_task->packet))
+        return MPP_OK;
+
+    enc_dbg_detail("task %d ring region overflow retry\n", frm->seq_idx);
+
+    ENC_RUN_FUNC2(mpp_enc_hal_ret_task, hal, hal_task, mpp, ret);
+
+    hal_task->length -= hal_task->hw_length;
+    hal_task->hw_length = 0;
+
+    ENC_RUN_FUNC2(mpp_enc_move_pkt_buf, enc, hal_task, mpp, ret);
+
+    enc_dbg_detail("task %d hal get task\n", frm->seq_idx);
+    ENC_RUN_FUNC2(mpp_enc_hal_get_task, hal, hal_task, mpp, ret);
+
+    enc_dbg_detail("task %d hal generate reg\n", frm->seq_idx);
+    ENC_RUN_FUNC2(mpp_enc_hal_gen_regs, hal, hal_task, mpp, ret);
+
+    enc_dbg_detail("task %d hal start\n", frm->seq_idx);
+    ENC_RUN_FUNC2(mpp_enc_hal_start, hal, hal_task, mpp, ret);
+
+    enc_dbg_detail("task %d hal wait\n", frm->seq_idx);
+    ENC_RUN_FUNC2(mpp_enc_hal_wait,  hal, hal_task, mpp, ret);
+
+TASK_DONE:
+    return ret;
+}
+
 static MPP_RET mpp_enc_check_pkt_buf(MppEncImpl *enc)
 {
     if (NULL == enc->pkt_buf) {
-        /* NOTE: set buffer w * h * 1.5 to avoid buffer overflow */
         Mpp *mpp = (Mpp *)enc->mpp;
-        MppEncPrepCfg *prep = &enc->cfg.prep;
-        RK_U32 width  = MPP_ALIGN(prep->width, 16);
-        RK_U32 height = MPP_ALIGN(prep->height, 16);
-        RK_U32 size = (enc->coding == MPP_VIDEO_CodingMJPEG) ?
-                      (width * height * 3 / 2) : (width * height);
+        RK_U32 size = mpp_enc_get_pkt_buf_size(enc);
         MppPacketImpl *pkt = (MppPacketImpl *)enc->packet;
         MppBuffer buffer = NULL;
 
+        /* carve header room from ring and fit it after rate control start */
+        mpp_enc_check_pkt_ring(enc);
+        if (enc->pkt_ring &&
+            !mpp_enc_ring_get(enc->pkt_ring, enc->packet, ENC_PKT_RING_HDR_SIZE)) {
+            enc->pkt_buf = pkt->buffer;
+
+            enc_dbg_detail("create output pkt %p in ring %p\n",
+                           enc->packet, enc->pkt_ring);
+            return MPP_OK;
+        }
+
         mpp_assert(size);
         mpp_buffer_get(mpp->mPacketGroup, &buffer, size);
         mpp_assert(buffer);
@@ -1458,6 +1701,9 @@ static MPP_RET mpp_enc_normal(Mpp *mpp, EncAsyncTaskInfo *task)
     enc_dbg_detail("task %d rc frame start\n", frm->seq_idx);
     ENC_RUN_FUNC2(rc_frm_start, enc->rc_ctx, rc_task, mpp, ret);
 
+    enc_dbg_detail("task %d fit output buffer\n", frm->seq_idx);
+    ENC_RUN_FUNC2(mpp_enc_fit_pkt_buf, enc, task, mpp, ret);
+
     // 16. generate header before hardware stream
     if (enc->hdr_mode == MPP_ENC_HEADER_MODE_EACH_IDR &&
         frm->is_intra &&
@@ -1521,6 +1767,7 @@ static MPP_RET mpp_enc_normal(Mpp *mpp, EncAsyncTaskInfo *task)
 
     enc_dbg_detail("task %d hal wait\n", frm->seq_idx);
     ENC_RUN_FUNC2(mpp_enc_hal_wait,  hal, hal_task, mpp, ret);
+    ENC_RUN_FUNC2(mpp_enc_check_pkt_overflow, mpp, task, mpp, ret);
 
     mpp_stopwatch_record(hal_task->stopwatch, "encode hal finish");
 
@@ -1565,6 +1812,7 @@ static MPP_RET mpp_enc_reenc_simple(Mpp *mpp, EncAsyncTaskInfo *task)
 
     enc_dbg_detail("task %d hal wait\n", frm->seq_idx);
     ENC_RUN_FUNC2(mpp_enc_hal_wait,  hal, hal_task, mpp, ret);
+    ENC_RUN_FUNC2(mpp_enc_check_pkt_overflow, mpp, task, mpp, ret);
 
     enc_dbg_detail("task %d rc hal end\n", frm->seq_idx);
     ENC_RUN_FUNC2(rc_hal_end, enc->rc_ctx, rc_task, mpp, ret);
@@ -1582,6 +1830,20 @@ TASK_DONE:
     return ret;
 }
 
+/*
+ * all rc_frm_end calls go through here so the rc trace records the same
+ * frame end sequence as the rate control sees
+ */
+static MPP_RET mpp_enc_rc_frm_end(MppEncImpl *enc, EncRcTask *rc_task)
+{
+    MPP_RET ret = rc_frm_end(enc->rc_ctx, rc_task);
+
+    if (enc->rc_trace)
+        rc_trace_write_frm(enc->rc_trace, rc_task);
+
+    return ret;
+}
+
 static MPP_RET mpp_enc_reenc_drop(Mpp *mpp, EncAsyncTaskInfo *task)
 {
     MppEncImpl *enc = (MppEncImpl *)mpp->mEnc;
@@ -1598,7 +1860,7 @@ static MPP_RET mpp_enc_reenc_drop(Mpp *mpp, EncAsyncTaskInfo *task)
     info->quality_real = info->quality_target;
 
     enc_dbg_detail("task %d rc frame end\n", frm->seq_idx);
-    ENC_RUN_FUNC2(rc_frm_end, enc->rc_ctx, rc_task, mpp, ret);
+    ENC_RUN_FUNC2(mpp_enc_rc_frm_end, enc, rc_task, mpp, ret);
 
 TASK_DONE:
     enc_dbg_func("leave\n");
@@ -1636,7 +1898,123 @@ static MPP_RET mpp_enc_reenc_force_pskip(Mpp *mpp, EncAsyncTaskInfo *task)
     ENC_RUN_FUNC2(enc_impl_sw_enc, impl, hal_task, mpp, ret);
 
     enc_dbg_detail("task %d rc frame end\n", frm->seq_idx);
-    ENC_RUN_FUNC2(rc_frm_end, enc->rc_ctx, rc_task, mpp, ret);
+    ENC_RUN_FUNC2(mpp_enc_rc_frm_end, enc, rc_task, mpp, ret);
+
+TASK_DONE:
+    enc_dbg_func("leave\n");
+    return ret;
+}
+
+static RK_S32 mpp_enc_check_static(MppEncImpl *enc, EncAsyncTaskInfo *task)
+{
+    MppEncBaseCfg *base = &enc->cfg.base;
+    HalEncTask *hal_task = &task->task;
+    MppEncStaticCond cond;
+    RK_S32 is_static = 0;
+
+    if (!base->static_skip ||
+        (enc->coding != MPP_VIDEO_CodingAVC && enc->coding != MPP_VIDEO_CodingHEVC)) {
+        if (enc->static_ctx) {
+            mpp_enc_static_deinit(enc->static_ctx);
+            enc->static_ctx = NULL;
+        }
+        return 0;
+    }
+
+    if (NULL == enc->static_ctx) {
+        mpp_enc_static_init(&enc->static_ctx);
+        enc->static_cnt = 0;
+        return 0;
+    }
+
+    /*
+     * user force config, motion info output, partition output and two pass
+     * encoding need hardware. Intra frame and too many continuous skip frames
+     * also go to hardware.
+     */
+    cond.skip_max = base->static_skip;
+    cond.skip_cnt = enc->static_cnt;
+    cond.hw_only = task->usr.force_flag || hal_task->md_info || enc->low_delay_part_mode ||
+                   (enc->support_hw_deflicker && enc->cfg.rc.debreath_en);
+    cond.next_intra = mpp_enc_refs_next_frm_is_intra(enc->refs);
+    cond.qp_ref = enc->static_qp;
+    cond.qp_target = enc->static_qp_target;
+
+    if (!mpp_enc_static_allow(&cond))
+        return 0;
+
+    is_static = mpp_enc_static_check(enc->static_ctx, hal_task->frame,
+                                     base->static_thd, enc->static_cnt);
+
+    enc_dbg_detail("task %d static %d count %d\n", task->rc.frm.seq_idx,
+                   is_static, enc->static_cnt);
+
+    return is_static;
+}
+
+static void mpp_enc_update_static(MppEncImpl *enc, EncAsyncTaskInfo *task)
+{
+    EncRcTask *rc_task = &task->rc;
+    EncFrmStatus *frm = &rc_task->frm;
+
+    if (NULL == enc->static_ctx)
+        return;
+
+    enc->static_qp_target = rc_task->info.quality_target;
+
+    if (frm->force_pskip) {
+        enc->static_cnt++;
+        return;
+    }
+
+    /* reference only follows the frames encoded by hardware */
+    if (frm->drop)
+        return;
+
+    mpp_enc_static_update(enc->static_ctx, task->task.frame);
+    enc->static_qp = rc_task->info.quality_real;
+    enc->static_cnt = 0;
+}
+
+/* encode static frame as non-reference P-skip frame without hardware */
+static MPP_RET mpp_enc_static_pskip(Mpp *mpp, EncAsyncTaskInfo *task)
+{
+    MppEncImpl *enc = (MppEncImpl *)mpp->mEnc;
+    EncImpl impl = enc->impl;
+    MppEncRefFrmUsrCfg *frm_cfg = &task->usr;
+    EncRcTask *rc_task = &task->rc;
+    EncCpbStatus *cpb = &rc_task->cpb;
+    EncFrmStatus *frm = &rc_task->frm;
+    HalEncTask *hal_task = &task->task;
+    MPP_RET ret = MPP_OK;
+
+    enc_dbg_func("enter\n");
+
+    frm_cfg->force_pskip++;
+    frm_cfg->force_flag |= ENC_FORCE_PSKIP;
+    mpp_enc_refs_set_usr_cfg(enc->refs, frm_cfg);
+
+    enc_dbg_detail("task %d enc proc dpb\n", frm->seq_idx);
+    mpp_enc_refs_get_cpb(enc->refs, cpb);
+
+    enc_dbg_frm_status("frm %d start ***********************************\n", cpb->curr.seq_idx);
+    ENC_RUN_FUNC2(enc_impl_proc_dpb, impl, hal_task, mpp, ret);
+
+    frm->force_pskip = 1;
+
+    enc_dbg_detail("task %d rc frame start\n", frm->seq_idx);
+    ENC_RUN_FUNC2(rc_frm_start, enc->rc_ctx, rc_task, mpp, ret);
+
+    enc_dbg_detail("task %d fit output buffer\n", frm->seq_idx);
+    ENC_RUN_FUNC2(mpp_enc_fit_pkt_buf, enc, task, mpp, ret);
+
+    if (mpp_frame_has_meta(hal_task->frame))
+        update_user_datas(impl, hal_task->packet, hal_task->frame, hal_task);
+
+    check_hal_task_pkt_len(hal_task, "user data adding");
+
+    enc_dbg_detail("task %d enc sw enc start\n", frm->seq_idx);
+    ENC_RUN_FUNC2(enc_impl_sw_enc, impl, hal_task, mpp, ret);
 
 TASK_DONE:
     enc_dbg_func("leave\n");
@@ -1833,6 +2211,7 @@ static MPP_RET try_get_enc_task(MppEncImpl *enc, EncAsyncTaskInfo *task, EncAsyn
     // 13. check frm_meta data force key in input frame and start one frame
     if (!status->enc_start) {
         enc_dbg_detail("task %d enc start\n", frm->seq_idx);
+        mpp_trace_async_begin("enc_frame", frm->seq_idx);
         ENC_RUN_FUNC2(enc_impl_start, enc->impl, hal_task, enc->mpp, ret);
         status->enc_start = 1;
     }
@@ -2055,6 +2434,7 @@ TASK_DONE:
                        frm->seq_idx, enc->task_pts, hal_task->part_count);
         mpp_task_meta_set_packet(enc->task_out, KEY_OUTPUT_PACKET, packet);
         mpp_port_enqueue(enc->output, enc->task_out);
+        mpp_trace_async_end("enc_frame", frm->seq_idx);
         enc->task_out = NULL;
         hal_task->part_count = 0;
     }
@@ -2070,6 +2450,10 @@ TASK_DONE:
     enc_dbg_detail("task %d rc hal end\n", frm->seq_idx);
     ENC_RUN_FUNC2(rc_hal_end, enc->rc_ctx, rc_task, mpp, ret);
 
+    /* already after TASK_DONE so do not jump back on error */
+    enc_dbg_detail("task %d rc frame end\n", frm->seq_idx);
+    mpp_enc_rc_frm_end(enc, rc_task);
+
     enc_dbg_detail("task %d enqueue frame pts %lld\n", frm->seq_idx, enc->task_pts);
 
     mpp_task_meta_set_frame(enc->task_in, KEY_INPUT_FRAME, enc->frame);
@@ -2095,8 +2479,12 @@ static MPP_RET try_proc_normal_task(MppEncImpl *enc, EncAsyncTaskInfo *task)
     if (hal_task->flags.drop_by_fps)
         goto TASK_DONE;
 
-    // 17. normal encode
-    ENC_RUN_FUNC2(mpp_enc_normal, mpp, task, mpp, ret);
+    // 17. normal encode or software pskip on static scene
+    if (mpp_enc_check_static(enc, task)) {
+        ENC_RUN_FUNC2(mpp_enc_static_pskip, mpp, task, mpp, ret);
+    } else {
+        ENC_RUN_FUNC2(mpp_enc_normal, mpp, task, mpp, ret);
+    }
 
     // 18. drop, force pskip and reencode  process
     while (frm->reencode && frm->reencode_times < enc->cfg.rc.max_reenc_times) {
@@ -2120,7 +2508,9 @@ static MPP_RET try_proc_normal_task(MppEncImpl *enc, EncAsyncTaskInfo *task)
         mpp_enc_reenc_simple(mpp, task);
     }
     enc_dbg_detail("task %d rc frame end\n", frm->seq_idx);
-    ENC_RUN_FUNC2(rc_frm_end, enc->rc_ctx, rc_task, mpp, ret);
+    ENC_RUN_FUNC2(mpp_enc_rc_frm_end, enc, rc_task, mpp, ret);
+
+    mpp_enc_update_static(enc, task);
 
     enc->time_end = mpp_time();
     enc->frame_count++;
@@ -2141,6 +2531,10 @@ TASK_DONE:
         mpp_packet_set_length(packet, hal_task->length);
     }
 
+    /* return the unused space of ring region */
+    if (mpp_enc_ring_check(enc->pkt_ring, packet))
+        mpp_enc_ring_resize(enc->pkt_ring, packet, hal_task->length);
+
     {
         MppMeta meta = mpp_packet_get_meta(packet);
 
@@ -2164,6 +2558,7 @@ TASK_DONE:
 
     mpp_task_meta_set_packet(enc->task_out, KEY_OUTPUT_PACKET, packet);
     mpp_port_enqueue(enc->output, enc->task_out);
+    mpp_trace_async_end("enc_frame", frm->seq_idx);
 
     enc_dbg_detail("task %d enqueue frame pts %lld\n", frm->seq_idx, enc->task_pts);
 
@@ -2190,6 +2585,7 @@ void *mpp_enc_thread(void *data)
     memset(&task, 0, sizeof(task));
     wait.val = 0;
 
+    mpp_buf_account_attach(mpp->mBufAccount);
     enc->time_base = mpp_time();
 
     while (1) {
@@ -2198,8 +2594,12 @@ void *mpp_enc_thread(void *data)
             if (MPP_THREAD_RUNNING != thd_enc->get_status())
                 break;
 
-            if (check_enc_task_wait(enc, &wait))
+            if (check_enc_task_wait(enc, &wait)) {
+                mpp_trace_int32("enc_wait_flag", wait.val);
+                mpp_trace_begin("enc_wait");
                 thd_enc->wait();
+                mpp_trace_end("enc_wait");
+            }
         }
 
         // When encoder is not on encoding process external config and reset
@@ -2296,7 +2696,8 @@ static void async_task_terminate(MppEncImpl *enc, EncAsyncTaskInfo *async)
         MppPacket pkt = hal_task->packet;
 
         /* setup output packet and meta data */
-        mpp_packet_set_length(pkt, hal_task->length);
+        if (!mpp_packet_is_partition(pkt))
+            mpp_packet_set_length(pkt, hal_task->length);
 
         /*
          * First return output packet.
@@ -2428,13 +2829,8 @@ static MPP_RET check_async_pkt_buf(MppEncImpl *enc, EncAsyncTaskInfo *async)
     HalEncTask *hal_task = &async->task;
 
     if (NULL == hal_task->output) {
-        /* NOTE: set buffer w * h * 1.5 to avoid buffer overflow */
         Mpp *mpp = (Mpp *)enc->mpp;
-        MppEncPrepCfg *prep = &enc->cfg.prep;
-        RK_U32 width  = MPP_ALIGN(prep->width, 16);
-        RK_U32 height = MPP_ALIGN(prep->height, 16);
-        RK_U32 size = (enc->coding == MPP_VIDEO_CodingMJPEG) ?
-                      (width * height * 3 / 2) : (width * height);
+        RK_U32 size = mpp_enc_get_pkt_buf_size(enc);
         MppPacketImpl *pkt = (MppPacketImpl *)hal_task->packet;
         MppBuffer buffer = NULL;
 
@@ -2460,6 +2856,25 @@ static MPP_RET check_async_pkt_buf(MppEncImpl *enc, EncAsyncTaskInfo *async)
     return MPP_OK;
 }
 
+static RK_S32 mpp_enc_get_pipe_depth(MppEncImpl *enc)
+{
+    RK_S32 depth = enc->cfg.base.pipe_depth;
+
+    if (!depth)
+        depth = MPP_ENC_PIPE_DEPTH_DEFAULT;
+
+    /*
+     * Rate control of intra frame needs the feedback of recent frames.
+     * Drain to the default depth before it.
+     */
+    if (depth > MPP_ENC_PIPE_DEPTH_DEFAULT &&
+        ((enc->frm_cfg.force_flag & ENC_FORCE_IDR) ||
+         mpp_enc_refs_next_frm_is_intra(enc->refs)))
+        depth = MPP_ENC_PIPE_DEPTH_DEFAULT;
+
+    return MPP_MIN(depth, enc->task_cnt);
+}
+
 static MPP_RET try_get_async_task(MppEncImpl *enc, EncAsyncWait *wait)
 {
     Mpp *mpp = (Mpp *)enc->mpp;
@@ -2475,6 +2890,12 @@ static MPP_RET try_get_async_task(MppEncImpl *enc, EncAsyncWait *wait)
     MPP_RET ret = MPP_OK;
 
     if (NULL == enc->hnd) {
+        if (enc->async_cnt >= mpp_enc_get_pipe_depth(enc)) {
+            wait->task_hnd = 1;
+            enc_dbg_detail("pipeline full with %d tasks\n", enc->async_cnt);
+            return MPP_NOK;
+        }
+
         hal_task_get_hnd(enc->tasks, TASK_IDLE, &enc->hnd);
         if (enc->hnd) {
             wait->task_hnd = 0;
@@ -2641,6 +3062,7 @@ static MPP_RET try_get_async_task(MppEncImpl *enc, EncAsyncWait *wait)
     // 13. check frm_meta data force key in input frame and start one frame
     if (!status->enc_start) {
         enc_dbg_detail("task %d enc start\n", seq_idx);
+        mpp_trace_async_begin("enc_frame", seq_idx);
         ENC_RUN_FUNC2(enc_impl_start, enc->impl, hal_task, enc->mpp, ret);
         status->enc_start = 1;
     }
@@ -2767,6 +3189,7 @@ static MPP_RET proc_async_task(MppEncImpl *enc)
 SEND_TASK_INFO:
     status->enc_done = 0;
     hal_task_hnd_set_status(enc->hnd, TASK_PROCESSING);
+    enc->async_cnt++;
     enc_dbg_detail("task %d on processing ret %d\n", frm->seq_idx, ret);
 
     enc->hnd = NULL;
@@ -2844,7 +3267,7 @@ static MPP_RET enc_async_wait_task(MppEncImpl *enc, EncAsyncTaskInfo *info)
     ENC_RUN_FUNC2(mpp_enc_hal_ret_task, hal, hal_task, mpp, ret);
 
     enc_dbg_detail("task %d rc frame end\n", frm->seq_idx);
-    ENC_RUN_FUNC2(rc_frm_end, enc->rc_ctx, rc_task, mpp, ret);
+    ENC_RUN_FUNC2(mpp_enc_rc_frm_end, enc, rc_task, mpp, ret);
 
 TASK_DONE:
     if (!mpp_packet_is_partition(pkt)) {
@@ -2861,6 +3284,7 @@ TASK_DONE:
     mpp_meta_set_frame(meta, KEY_INPUT_FRAME, hal_task->frame);
 
     enc_dbg_detail("task %d output packet pts %lld\n", info->seq_idx, info->pts);
+    mpp_trace_async_end("enc_frame", info->seq_idx);
 
     if (mpp->mPktOut) {
         mpp_list *pkt_out = mpp->mPktOut;
@@ -2869,6 +3293,7 @@ TASK_DONE:
 
         pkt_out->add_at_tail(&pkt, sizeof(pkt));
         mpp->mPacketPutCount++;
+        mpp_trace_int32("enc_out_list", pkt_out->list_size());
         pkt_out->signal();
     }
 
@@ -2887,6 +3312,8 @@ void *mpp_enc_async_thread(void *data)
 
     wait.val = 0;
 
+    mpp_buf_account_attach(mpp->mBufAccount);
+
     while (1) {
         {
             AutoMutex autolock(thd_enc->mutex());
@@ -2895,7 +3322,10 @@ void *mpp_enc_async_thread(void *data)
 
             if (check_enc_async_wait(enc, &wait)) {
                 enc_dbg_detail("wait start\n");
+                mpp_trace_int32("enc_wait_flag", wait.val);
+                mpp_trace_begin("enc_wait");
                 thd_enc->wait();
+                mpp_trace_end("enc_wait");
                 enc_dbg_detail("wait done\n");
             }
         }
@@ -2920,6 +3350,7 @@ void *mpp_enc_async_thread(void *data)
 
                 enc_async_wait_task(enc, info);
                 hal_task_hnd_set_status(hnd, TASK_IDLE);
+                enc->async_cnt--;
                 wait.task_hnd = 0;
             }
 
@@ -2986,6 +3417,7 @@ void *mpp_enc_async_thread(void *data)
 
                 enc_async_wait_task(enc, info);
                 hal_task_hnd_set_status(hnd, TASK_IDLE);
+                enc->async_cnt--;
                 wait.task_hnd = 0;
             }
 
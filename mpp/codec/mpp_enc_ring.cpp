@@ -0,0 +1,362 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_enc_ring"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_list.h"
+#include "mpp_debug.h"
+#include "mpp_common.h"
+#include "mpp_thread.h"
+
+#include "mpp_packet_impl.h"
+#include "mpp_enc_ring.h"
+
+#define ENC_RING_DBG_FUNCTION           (0x00000001)
+#define ENC_RING_DBG_REGION             (0x00000002)
+
+#define enc_ring_dbg(flag, fmt, ...)    _mpp_dbg_f(mpp_enc_ring_debug, flag, fmt, ## __VA_ARGS__)
+
+#define enc_ring_dbg_func(fmt, ...)     enc_ring_dbg(ENC_RING_DBG_FUNCTION, fmt, ## __VA_ARGS__)
+#define enc_ring_dbg_region(fmt, ...)   enc_ring_dbg(ENC_RING_DBG_REGION, fmt, ## __VA_ARGS__)
+
+/* region start alignment for hardware bitstream base address */
+#define ENC_RING_ALIGN                  256
+
+typedef struct MppEncRingImpl_t MppEncRingImpl;
+
+typedef struct MppEncRingRegion_t {
+    struct list_head    list;
+    MppEncRingImpl      *ring;
+    RK_U32              start;
+    RK_U32              size;
+    /* reference from packet and its copies */
+    RK_S32              ref;
+} MppEncRingRegion;
+
+struct MppEncRingImpl_t {
+    Mutex               *lock;
+    MppBuffer           buffer;
+    RK_U8               *base;
+    RK_U32              size;
+
+    /* carving position */
+    RK_U32              head;
+
+    /* regions in carving order, the first one is the ring tail */
+    struct list_head    regions;
+    RK_S32              region_cnt;
+    /* cleared on deinit, then the last released region frees the ring */
+    RK_U32              active;
+};
+
+static RK_U32 mpp_enc_ring_debug = 0;
+
+static void mpp_enc_ring_free(MppEncRingImpl *p)
+{
+    enc_ring_dbg_func("ring %p free\n", p);
+
+    if (p->buffer) {
+        mpp_buffer_put(p->buffer);
+        p->buffer = NULL;
+    }
+
+    delete p->lock;
+    mpp_free(p);
+}
+
+/*
+ * Return the free space limit after head, called with lock.
+ * Regions are never empty, so head is behind tail only after wrapping.
+ */
+static RK_U32 mpp_enc_ring_limit(MppEncRingImpl *p, RK_U32 *tail)
+{
+    MppEncRingRegion *first;
+
+    if (list_empty(&p->regions)) {
+        *tail = 0;
+        return p->size;
+    }
+
+    first = list_first_entry(&p->regions, MppEncRingRegion, list);
+    *tail = first->start;
+
+    return (p->head <= first->start) ? first->start : p->size;
+}
+
+/* called with lock */
+static void mpp_enc_ring_reclaim(MppEncRingImpl *p)
+{
+    MppEncRingRegion *pos, *n;
+
+    list_for_each_entry_safe(pos, n, &p->regions, MppEncRingRegion, list) {
+        if (pos->ref > 0)
+            break;
+
+        enc_ring_dbg_region("ring %p reclaim [%x %x)\n",
+                            p, pos->start, pos->start + pos->size);
+
+        list_del_init(&pos->list);
+        p->region_cnt--;
+        mpp_free(pos);
+    }
+
+    if (list_empty(&p->regions))
+        p->head = 0;
+}
+
+static void mpp_enc_ring_ref(void *ctx, RK_S32 delta)
+{
+    MppEncRingRegion *region = (MppEncRingRegion *)ctx;
+    MppEncRingImpl *p = region->ring;
+    RK_U32 release = 0;
+
+    p->lock->lock();
+
+    region->ref += delta;
+    mpp_assert(region->ref >= 0);
+
+    if (!region->ref)
+        mpp_enc_ring_reclaim(p);
+
+    release = !p->active && !p->region_cnt;
+
+    p->lock->unlock();
+
+    if (release)
+        mpp_enc_ring_free(p);
+}
+
+MPP_RET mpp_enc_ring_init(MppEncRing *ring, MppBufferGroup group, RK_U32 size)
+{
+    MppEncRingImpl *p = NULL;
+
+    if (NULL == ring || NULL == group || !size) {
+        mpp_err_f("invalid input ring %p group %p size %d\n", ring, group, size);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    mpp_env_get_u32("mpp_enc_ring_debug", &mpp_enc_ring_debug, 0);
+
+    *ring = NULL;
+
+    p = mpp_calloc(MppEncRingImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    size = MPP_ALIGN(size, ENC_RING_ALIGN);
+    mpp_buffer_get(group, &p->buffer, size);
+    if (NULL == p->buffer) {
+        mpp_err_f("failed to get ring buffer size %d\n", size);
+        mpp_free(p);
+        return MPP_ERR_NOMEM;
+    }
+
+    p->lock = new Mutex();
+    p->base = (RK_U8 *)mpp_buffer_get_ptr(p->buffer);
+    p->size = size;
+    p->active = 1;
+    INIT_LIST_HEAD(&p->regions);
+
+    enc_ring_dbg_func("ring %p size %x\n", p, size);
+
+    *ring = p;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_enc_ring_deinit(MppEncRing ring)
+{
+    MppEncRingImpl *p = (MppEncRingImpl *)ring;
+    RK_U32 release = 0;
+
+    if (NULL == p)
+        return MPP_OK;
+
+    p->lock->lock();
+    p->active = 0;
+    release = !p->region_cnt;
+    if (!release)
+        enc_ring_dbg_func("ring %p deinit with %d regions left\n", p, p->region_cnt);
+    p->lock->unlock();
+
+    if (release)
+        mpp_enc_ring_free(p);
+
+    return MPP_OK;
+}
+
+RK_U32 mpp_enc_ring_get_size(MppEncRing ring)
+{
+    MppEncRingImpl *p = (MppEncRingImpl *)ring;
+
+    return p ? p->size : 0;
+}
+
+MPP_RET mpp_enc_ring_get(MppEncRing ring, MppPacket packet, RK_U32 size)
+{
+    MppEncRingImpl *p = (MppEncRingImpl *)ring;
+    MppPacketImpl *pkt = (MppPacketImpl *)packet;
+    MppEncRingRegion *region = NULL;
+    RK_U32 start = 0;
+    RK_U32 limit = 0;
+    RK_U32 tail = 0;
+    MPP_RET ret = MPP_NOK;
+
+    if (NULL == p || NULL == pkt || NULL != pkt->buffer || !size)
+        return MPP_ERR_VALUE;
+
+    region = mpp_calloc(MppEncRingRegion, 1);
+    if (NULL == region)
+        return MPP_ERR_MALLOC;
+
+    size = MPP_ALIGN(size, ENC_RING_ALIGN);
+
+    p->lock->lock();
+
+    limit = mpp_enc_ring_limit(p, &tail);
+
+    if (p->head + size <= limit) {
+        start = p->head;
+        ret = MPP_OK;
+    } else if (limit == p->size && size <= tail) {
+        /* wrap to the start when the space at the end is too small */
+        start = 0;
+        ret = MPP_OK;
+    }
+
+    if (!ret) {
+        INIT_LIST_HEAD(&region->list);
+        region->ring = p;
+        region->start = start;
+        region->size = size;
+        region->ref = 1;
+        list_add_tail(&region->list, &p->regions);
+        p->region_cnt++;
+        p->head = start + size;
+    }
+
+    enc_ring_dbg_region("ring %p get [%x %x) head %x tail %x ret %d\n",
+                        p, start, start + size, p->head, tail, ret);
+
+    p->lock->unlock();
+
+    if (ret) {
+        mpp_free(region);
+        return ret;
+    }
+
+    mpp_buffer_inc_ref(p->buffer);
+
+    pkt->data   = p->base + start;
+    pkt->pos    = pkt->data;
+    pkt->size   = size;
+    pkt->length = 0;
+    pkt->buffer = p->buffer;
+    pkt->ref_cb = mpp_enc_ring_ref;
+    pkt->ref_ctx = region;
+
+    return MPP_OK;
+}
+
+RK_S32 mpp_enc_ring_check(MppEncRing ring, MppPacket packet)
+{
+    MppPacketImpl *pkt = (MppPacketImpl *)packet;
+
+    if (NULL == ring || NULL == pkt || pkt->ref_cb != mpp_enc_ring_ref)
+        return 0;
+
+    return ((MppEncRingRegion *)pkt->ref_ctx)->ring == ring;
+}
+
+MPP_RET mpp_enc_ring_resize(MppEncRing ring, MppPacket packet, RK_U32 size)
+{
+    MppEncRingImpl *p = (MppEncRingImpl *)ring;
+    MppPacketImpl *pkt = (MppPacketImpl *)packet;
+    MppEncRingRegion *region = NULL;
+    RK_U32 used = 0;
+    RK_U32 limit = 0;
+    RK_U32 tail = 0;
+    MPP_RET ret = MPP_NOK;
+
+    if (!mpp_enc_ring_check(ring, packet))
+        return MPP_ERR_VALUE;
+
+    region = (MppEncRingRegion *)pkt->ref_ctx;
+    used = (RK_U8 *)pkt->pos - (RK_U8 *)pkt->data + pkt->length;
+    /* keep at least one alignment unit for empty packet */
+    size = MPP_ALIGN(MPP_MAX(MPP_MAX(size, used), 1), ENC_RING_ALIGN);
+
+    p->lock->lock();
+
+    limit = mpp_enc_ring_limit(p, &tail);
+
+    if (region != list_last_entry(&p->regions, MppEncRingRegion, list)) {
+        /* older region can not move the head */
+        if (size <= region->size)
+            ret = MPP_OK;
+    } else if (region->start + size <= limit) {
+        region->size = size;
+        p->head = region->start + size;
+        pkt->size = size;
+        ret = MPP_OK;
+    }
+
+    enc_ring_dbg_region("ring %p resize [%x %x) head %x tail %x ret %d\n",
+                        p, region->start, region->start + size,
+                        p->head, tail, ret);
+
+    p->lock->unlock();
+
+    return ret;
+}
+
+MPP_RET mpp_enc_ring_move(MppEncRing ring, MppPacket packet, MppBuffer buffer)
+{
+    MppPacketImpl *pkt = (MppPacketImpl *)packet;
+    RK_U8 *dst = (RK_U8 *)mpp_buffer_get_ptr(buffer);
+    size_t size = mpp_buffer_get_size(buffer);
+    size_t offset = 0;
+
+    if (!mpp_enc_ring_check(ring, packet) || NULL == dst)
+        return MPP_ERR_VALUE;
+
+    offset = (RK_U8 *)pkt->pos - (RK_U8 *)pkt->data;
+    if (offset + pkt->length > size) {
+        mpp_err_f("buffer size %d is too small for %d\n",
+                  size, offset + pkt->length);
+        return MPP_NOK;
+    }
+
+    memcpy(dst, pkt->data, offset + pkt->length);
+
+    pkt->ref_cb(pkt->ref_ctx, -1);
+    pkt->ref_cb = NULL;
+    pkt->ref_ctx = NULL;
+    mpp_buffer_put(pkt->buffer);
+
+    pkt->data   = dst;
+    pkt->pos    = dst + offset;
+    pkt->size   = size;
+    pkt->buffer = buffer;
+
+    return MPP_OK;
+}
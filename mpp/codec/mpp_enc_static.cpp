@@ -0,0 +1,307 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_enc_static"
+
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define STATIC_SIMD_NEON
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#define STATIC_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_debug.h"
+#include "mpp_common.h"
+
+#include "mpp_enc_static.h"
+
+#define ENC_STATIC_DBG_FUNCTION         (0x00000001)
+#define ENC_STATIC_DBG_DETAIL           (0x00000002)
+
+#define enc_static_dbg(flag, fmt, ...)  _mpp_dbg_f(mpp_enc_static_debug, flag, fmt, ## __VA_ARGS__)
+
+#define enc_static_dbg_func(fmt, ...)   enc_static_dbg(ENC_STATIC_DBG_FUNCTION, fmt, ## __VA_ARGS__)
+#define enc_static_dbg_detail(fmt, ...) enc_static_dbg(ENC_STATIC_DBG_DETAIL, fmt, ## __VA_ARGS__)
+
+#define STATIC_TILE_SIZE                16
+/* sampled rows in each tile, the rows move on each check of a skip run */
+#define STATIC_TILE_ROWS                2
+#define STATIC_PHASE_CNT                (STATIC_TILE_SIZE / STATIC_TILE_ROWS)
+#define STATIC_THD_DEFAULT              4
+/* rate control wants better quality than the reference, encode by hardware */
+#define STATIC_QP_DELTA                 3
+
+typedef struct MppEncStaticImpl_t {
+    RK_S32          width;
+    RK_S32          height;
+    RK_S32          tile_w;
+    RK_S32          tile_h;
+
+    /* luma of reference, width bytes per row */
+    RK_U8           *ref;
+    RK_U32          ref_size;
+    RK_U32          valid;
+
+    /* sum of absolute difference of each tile in current tile row */
+    RK_U32          *sad;
+    RK_S32          sad_cnt;
+} MppEncStaticImpl;
+
+static RK_U32 mpp_enc_static_debug = 0;
+
+static const RK_U8 *get_luma(MppFrame frame, RK_S32 *stride)
+{
+    MppFrameFormat fmt = mpp_frame_get_fmt(frame);
+    MppBuffer buf = mpp_frame_get_buffer(frame);
+    RK_U8 *ptr = NULL;
+    RK_S32 hor_stride;
+
+    if (NULL == buf || MPP_FRAME_FMT_IS_FBC(fmt) || !MPP_FRAME_FMT_IS_YUV(fmt))
+        return NULL;
+
+    switch (fmt & MPP_FRAME_FMT_MASK) {
+    case MPP_FMT_YUV420SP :
+    case MPP_FMT_YUV422SP :
+    case MPP_FMT_YUV420P :
+    case MPP_FMT_YUV420SP_VU :
+    case MPP_FMT_YUV422P :
+    case MPP_FMT_YUV422SP_VU :
+    case MPP_FMT_YUV400 :
+    case MPP_FMT_YUV440SP :
+    case MPP_FMT_YUV411SP :
+    case MPP_FMT_YUV444SP :
+    case MPP_FMT_YUV444P : {
+    } break;
+    default : {
+        /* packed and high bit depth luma is not supported */
+        return NULL;
+    } break;
+    }
+
+    ptr = (RK_U8 *)mpp_buffer_get_ptr(buf);
+    if (NULL == ptr)
+        return NULL;
+
+    hor_stride = mpp_frame_get_hor_stride(frame);
+    *stride = hor_stride;
+
+    return ptr + mpp_frame_get_offset_y(frame) * hor_stride + mpp_frame_get_offset_x(frame);
+}
+
+/* accumulate the sad of each 16 pixel tile in one row */
+static void row_sad(RK_U32 *sad, const RK_U8 *cur, const RK_U8 *ref, RK_S32 width)
+{
+    RK_S32 tiles = width / STATIC_TILE_SIZE;
+    RK_S32 i;
+
+#if defined(STATIC_SIMD_NEON)
+    for (i = 0; i < tiles; i++) {
+        uint8x16_t d = vabdq_u8(vld1q_u8(cur), vld1q_u8(ref));
+        uint64x2_t s = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(d)));
+
+        sad[i] += (RK_U32)(vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1));
+        cur += STATIC_TILE_SIZE;
+        ref += STATIC_TILE_SIZE;
+    }
+#elif defined(STATIC_SIMD_SSE2)
+    for (i = 0; i < tiles; i++) {
+        __m128i s = _mm_sad_epu8(_mm_loadu_si128((const __m128i *)cur),
+                                 _mm_loadu_si128((const __m128i *)ref));
+
+        sad[i] += _mm_cvtsi128_si32(s) + _mm_cvtsi128_si32(_mm_srli_si128(s, 8));
+        cur += STATIC_TILE_SIZE;
+        ref += STATIC_TILE_SIZE;
+    }
+#else
+    for (i = 0; i < tiles; i++) {
+        RK_U32 acc = 0;
+        RK_S32 j;
+
+        for (j = 0; j < STATIC_TILE_SIZE; j++)
+            acc += MPP_ABS(cur[j] - ref[j]);
+
+        sad[i] += acc;
+        cur += STATIC_TILE_SIZE;
+        ref += STATIC_TILE_SIZE;
+    }
+#endif
+
+    /* partial tile on the right edge */
+    width -= tiles * STATIC_TILE_SIZE;
+    for (i = 0; i < width; i++)
+        sad[tiles] += MPP_ABS(cur[i] - ref[i]);
+}
+
+MPP_RET mpp_enc_static_init(MppEncStatic *ctx)
+{
+    MppEncStaticImpl *p = NULL;
+
+    if (NULL == ctx) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    mpp_env_get_u32("mpp_enc_static_debug", &mpp_enc_static_debug, 0);
+
+    p = mpp_calloc(MppEncStaticImpl, 1);
+    *ctx = p;
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_enc_static_deinit(MppEncStatic ctx)
+{
+    MppEncStaticImpl *p = (MppEncStaticImpl *)ctx;
+
+    if (p) {
+        MPP_FREE(p->ref);
+        MPP_FREE(p->sad);
+        mpp_free(p);
+    }
+
+    return MPP_OK;
+}
+
+RK_S32 mpp_enc_static_allow(const MppEncStaticCond *cond)
+{
+    /* too many continuous skip frames, hardware only and intra frame */
+    if (!cond->skip_max || cond->skip_cnt >= cond->skip_max ||
+        cond->hw_only || cond->next_intra)
+        return 0;
+
+    if (cond->qp_ref > cond->qp_target + STATIC_QP_DELTA)
+        return 0;
+
+    return 1;
+}
+
+/*
+ * sampled row y of tile row ty, rows of phase 0 ~ STATIC_PHASE_CNT - 1 cover
+ * all rows of the tile
+ */
+static RK_S32 get_sample_row(MppEncStaticImpl *p, RK_S32 ty, RK_S32 k, RK_U32 phase)
+{
+    RK_S32 y = ty * STATIC_TILE_SIZE + phase % STATIC_PHASE_CNT + k * STATIC_PHASE_CNT;
+
+    return MPP_MIN(y, p->height - 1);
+}
+
+RK_S32 mpp_enc_static_check(MppEncStatic ctx, MppFrame frame, RK_U32 thd, RK_U32 phase)
+{
+    MppEncStaticImpl *p = (MppEncStaticImpl *)ctx;
+    const RK_U8 *luma = NULL;
+    RK_S32 stride = 0;
+    RK_S32 ty, k, i;
+
+    if (NULL == p || NULL == frame || !p->valid)
+        return 0;
+
+    if (p->width != (RK_S32)mpp_frame_get_width(frame) ||
+        p->height != (RK_S32)mpp_frame_get_height(frame))
+        return 0;
+
+    luma = get_luma(frame, &stride);
+    if (NULL == luma)
+        return 0;
+
+    if (!thd)
+        thd = STATIC_THD_DEFAULT;
+
+    for (ty = 0; ty < p->tile_h; ty++) {
+        memset(p->sad, 0, sizeof(p->sad[0]) * p->tile_w);
+
+        for (k = 0; k < STATIC_TILE_ROWS; k++) {
+            RK_S32 y = get_sample_row(p, ty, k, phase);
+
+            row_sad(p->sad, luma + y * stride, p->ref + y * p->width, p->width);
+        }
+
+        for (i = 0; i < p->tile_w; i++) {
+            RK_S32 w = MPP_MIN(STATIC_TILE_SIZE, p->width - i * STATIC_TILE_SIZE);
+
+            if (p->sad[i] > thd * w * STATIC_TILE_ROWS) {
+                enc_static_dbg_detail("tile (%d, %d) sad %d changed\n", i, ty, p->sad[i]);
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+MPP_RET mpp_enc_static_update(MppEncStatic ctx, MppFrame frame)
+{
+    MppEncStaticImpl *p = (MppEncStaticImpl *)ctx;
+    const RK_U8 *luma = NULL;
+    RK_S32 width = 0;
+    RK_S32 height = 0;
+    RK_S32 stride = 0;
+    RK_U32 size = 0;
+    RK_S32 y;
+
+    if (NULL == p || NULL == frame)
+        return MPP_ERR_NULL_PTR;
+
+    p->valid = 0;
+
+    luma = get_luma(frame, &stride);
+    width = mpp_frame_get_width(frame);
+    height = mpp_frame_get_height(frame);
+    if (NULL == luma || width <= 0 || height <= 0)
+        return MPP_OK;
+
+    p->width = width;
+    p->height = height;
+    p->tile_w = (width + STATIC_TILE_SIZE - 1) / STATIC_TILE_SIZE;
+    p->tile_h = (height + STATIC_TILE_SIZE - 1) / STATIC_TILE_SIZE;
+
+    size = height * width;
+    if (size > p->ref_size) {
+        MPP_FREE(p->ref);
+        p->ref = mpp_malloc(RK_U8, size);
+        p->ref_size = p->ref ? size : 0;
+    }
+
+    if (p->tile_w > p->sad_cnt) {
+        MPP_FREE(p->sad);
+        p->sad = mpp_malloc(RK_U32, p->tile_w);
+        p->sad_cnt = p->sad ? p->tile_w : 0;
+    }
+
+    if (NULL == p->ref || NULL == p->sad) {
+        mpp_err_f("failed to malloc reference size %d\n", size);
+        return MPP_ERR_MALLOC;
+    }
+
+    /* keep all rows for the sampled rows change on each check */
+    for (y = 0; y < height; y++)
+        memcpy(p->ref + y * width, luma + y * stride, width);
+
+    p->valid = 1;
+
+    enc_static_dbg_func("update reference %dx%d\n", width, height);
+
+    return MPP_OK;
+}
@@ -20,9 +20,11 @@
 
 #include "mpp_env.h"
 #include "mpp_mem.h"
+#include "mpp_lock.h"
 #include "mpp_info.h"
 #include "mpp_common.h"
 #include "mpp_2str.h"
+#include "mpp_trace.h"
 
 #include "mpp.h"
 #include "mpp_enc_debug.h"
@@ -31,6 +33,27 @@
 #include "mpp_enc_cb_param.h"
 
 RK_U32 mpp_enc_debug = 0;
+RK_U32 mpp_enc_trace = 0;
+static RK_U32 mpp_enc_rc_trace_idx = 0;
+
+static void mpp_enc_rc_trace_open(MppEncImpl *enc)
+{
+    const char *prefix = NULL;
+    char name[256];
+
+    mpp_env_get_str("mpp_enc_rc_trace", &prefix, NULL);
+    if (NULL == prefix || !prefix[0])
+        return;
+
+    snprintf(name, sizeof(name) - 1, "%s_%d_%d.txt", prefix, getpid(),
+             MPP_FETCH_ADD(&mpp_enc_rc_trace_idx, 1));
+
+    enc->rc_trace = fopen(name, "w");
+    if (NULL == enc->rc_trace)
+        mpp_err_f("failed to open rc trace file %s\n", name);
+    else
+        mpp_log("enc %p record rc trace to %s\n", enc, name);
+}
 
 MPP_RET mpp_enc_init_v2(MppEnc *enc, MppEncInitCfg *cfg)
 {
@@ -43,6 +66,7 @@ MPP_RET mpp_enc_init_v2(MppEnc *enc, MppEncInitCfg *cfg)
     EncImplCfg ctrl_cfg;
 
     mpp_env_get_u32("mpp_enc_debug", &mpp_enc_debug, 0);
+    mpp_enc_trace = mpp_trace_enabled();
 
     if (NULL == enc) {
         mpp_err_f("failed to malloc context\n");
@@ -76,6 +100,7 @@ MPP_RET mpp_enc_init_v2(MppEnc *enc, MppEncInitCfg *cfg)
     enc_hal_cfg.type = VPU_CLIENT_BUTT;
     enc_hal_cfg.dev = NULL;
     enc_hal_cfg.cap_recn_out = 0;
+    enc_hal_cfg.cap_pkt_ring = 0;
 
     ctrl_cfg.coding = coding;
     ctrl_cfg.type = VPU_CLIENT_BUTT;
@@ -108,15 +133,20 @@ MPP_RET mpp_enc_init_v2(MppEnc *enc, MppEncInitCfg *cfg)
     p->dev      = enc_hal_cfg.dev;
     p->mpp      = cfg->mpp;
     p->tasks    = enc_hal_cfg.tasks;
+    p->task_cnt = cfg->task_cnt;
     p->sei_mode = MPP_ENC_SEI_MODE_ONE_SEQ;
     p->version_info = get_mpp_version();
     p->version_length = strlen(p->version_info);
     p->rc_cfg_size = SZ_1K;
     p->rc_cfg_info = mpp_calloc_size(char, p->rc_cfg_size);
+    mpp_enc_rc_trace_open(p);
 
     if (enc_hal_cfg.cap_recn_out)
         p->support_hw_deflicker = 1;
 
+    if (enc_hal_cfg.cap_pkt_ring)
+        p->support_pkt_ring = 1;
+
     {
         // create header packet storage
         size_t size = SZ_1K;
@@ -177,6 +207,16 @@ MPP_RET mpp_enc_deinit_v2(MppEnc ctx)
     if (enc->hdr_pkt)
         mpp_packet_deinit(&enc->hdr_pkt);
 
+    if (enc->pkt_ring) {
+        mpp_enc_ring_deinit(enc->pkt_ring);
+        enc->pkt_ring = NULL;
+    }
+
+    if (enc->static_ctx) {
+        mpp_enc_static_deinit(enc->static_ctx);
+        enc->static_ctx = NULL;
+    }
+
     MPP_FREE(enc->hdr_buf);
 
     if (enc->cfg.ref_cfg) {
@@ -194,6 +234,11 @@ MPP_RET mpp_enc_deinit_v2(MppEnc ctx)
         enc->rc_ctx = NULL;
     }
 
+    if (enc->rc_trace) {
+        fclose(enc->rc_trace);
+        enc->rc_trace = NULL;
+    }
+
     MPP_FREE(enc->rc_cfg_info);
     enc->rc_cfg_size = 0;
     enc->rc_cfg_length = 0;
@@ -216,7 +261,8 @@ MPP_RET mpp_enc_start_v2(MppEnc ctx)
     snprintf(name, sizeof(name) - 1, "mpp_%se_%d",
              strof_coding_type(enc->coding), getpid());
 
-    enc->thread_enc = new MppThread(mpp_enc_thread, enc->mpp, name);
+    enc->thread_enc = new MppThread(mpp_enc_thread, enc->mpp, name,
+                                    MPP_THREAD_ROLE_ENC);
     enc->thread_enc->start();
 
     enc_dbg_func("%p out\n", enc);
@@ -234,7 +280,8 @@ MPP_RET mpp_enc_start_async(MppEnc ctx)
     snprintf(name, sizeof(name) - 1, "mpp_%se_%d",
              strof_coding_type(enc->coding), getpid());
 
-    enc->thread_enc = new MppThread(mpp_enc_async_thread, enc->mpp, name);
+    enc->thread_enc = new MppThread(mpp_enc_async_thread, enc->mpp, name,
+                                    MPP_THREAD_ROLE_ENC);
     enc->thread_enc->start();
 
     enc_dbg_func("%p out\n", enc);
@@ -343,6 +390,8 @@ MPP_RET mpp_enc_control_v2(MppEnc ctx, MpiCmd cmd, void *param)
 
         enc_dbg_ctrl("get all config\n");
         memcpy(cfg, &enc->cfg, sizeof(enc->cfg));
+        if (enc->thread_enc)
+            cfg->base.thread_time = enc->thread_enc->get_cpu_time();
         if (cfg->prep.rotation == MPP_ENC_ROT_90 ||
             cfg->prep.rotation == MPP_ENC_ROT_270) {
             MPP_SWAP(RK_S32, cfg->prep.width, cfg->prep.height);
@@ -18,6 +18,7 @@
 
 #include <string.h>
 
+#include "mpp_env.h"
 #include "mpp_mem.h"
 #include "mpp_log.h"
 #include "mpp_common.h"
@@ -93,10 +94,23 @@ MPP_RET mpp_parser_init(Parser *prs, ParserCfg *cfg)
 
     *prs = NULL;
 
+    RK_U32 hal_dummy = 0;
     RK_U32 i;
+
+    /*
+     * dummy hal outputs no real picture so the stream is not parsed either.
+     * jpeg decoder keeps the real parser as dummy parser does not support
+     * its frame in frame out flow.
+     */
+    mpp_env_get_u32("mpp_hal_dummy", &hal_dummy, 0);
+    if (cfg->coding == MPP_VIDEO_CodingMJPEG)
+        hal_dummy = 0;
+
     for (i = 0; i < MPP_ARRAY_ELEMS(parsers); i++) {
         const ParserApi *api = parsers[i];
-        if (cfg->coding == api->coding) {
+        MppCodingType coding = hal_dummy ? MPP_VIDEO_CodingUnused : cfg->coding;
+
+        if (coding == api->coding) {
             ParserImpl *p = mpp_calloc(ParserImpl, 1);
             void *ctx = mpp_calloc_size(void, api->ctx_size);
             if (NULL == ctx || NULL == p) {
@@ -221,3 +235,13 @@ MPP_RET mpp_parser_control(Parser prs, MpiCmd cmd, void *para)
     return p->api->control(p->ctx, cmd, para);
 }
 
+RK_U32 mpp_parser_get_flag(Parser prs)
+{
+    if (NULL == prs) {
+        mpp_err_f("found NULL input\n");
+        return 0;
+    }
+
+    ParserImpl *p = (ParserImpl *)prs;
+    return p->api->flag;
+}
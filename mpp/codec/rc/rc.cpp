@@ -39,6 +39,10 @@ typedef struct MppRcImpl_t {
 
     RK_U32          frm_send;
     RK_U32          frm_done;
+
+    /* hardware reencode statistic */
+    RK_S64          stat_frm_cnt;
+    RK_S64          stat_reenc_cnt;
 } MppRcImpl;
 
 RK_U32 rc_debug = 0;
@@ -177,11 +181,22 @@ MPP_RET rc_frm_check_reenc(RcCtx ctx, EncRcTask *task)
 {
     MppRcImpl *p = (MppRcImpl *)ctx;
     const RcImplApi *api = p->api;
+    MPP_RET ret;
 
     if (!api || !api->check_reenc || !p->ctx || !task)
         return MPP_OK;
 
-    return api->check_reenc(p->ctx, task);
+    ret = api->check_reenc(p->ctx, task);
+
+    /*
+     * frame drop reencode does not run hardware again and force pskip
+     * reencode of non-idr and non-ltr frame is done by software
+     */
+    if (task->frm.reencode && !task->frm.drop &&
+        !(task->frm.force_pskip && !task->frm.is_idr && !task->frm.is_lt_ref))
+        p->stat_reenc_cnt++;
+
+    return ret;
 }
 
 MPP_RET rc_frm_start(RcCtx ctx, EncRcTask *task)
@@ -189,7 +204,13 @@ MPP_RET rc_frm_start(RcCtx ctx, EncRcTask *task)
     MppRcImpl *p = (MppRcImpl *)ctx;
     const RcImplApi *api = p->api;
 
-    if (!api || !api->frm_start || !p->ctx || !task)
+    if (!task)
+        return MPP_OK;
+
+    /* frm_end may be called more than once on drop and pskip reencode */
+    p->stat_frm_cnt++;
+
+    if (!api || !api->frm_start || !p->ctx)
         return MPP_OK;
 
     return api->frm_start(p->ctx, task);
@@ -227,3 +248,23 @@ MPP_RET rc_hal_end(RcCtx ctx, EncRcTask *task)
 
     return api->hal_end(p->ctx, task);
 }
+
+MPP_RET rc_get_stat(RcCtx ctx, RcApiStat *stat)
+{
+    MppRcImpl *p = (MppRcImpl *)ctx;
+
+    if (!stat)
+        return MPP_ERR_NULL_PTR;
+
+    memset(stat, 0, sizeof(*stat));
+
+    if (!p)
+        return MPP_OK;
+
+    stat->frm_cnt = p->stat_frm_cnt;
+    stat->reenc_cnt = p->stat_reenc_cnt;
+    if (p->stat_frm_cnt)
+        stat->reenc_rate = (RK_S32)(p->stat_reenc_cnt * 1000 / p->stat_frm_cnt);
+
+    return MPP_OK;
+}
@@ -0,0 +1,437 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "rc_model_v2_pred"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+
+#include "rc_debug.h"
+#include "rc_ctx.h"
+#include "rc_model_v2.h"
+#include "rc_model_v2_pred.h"
+
+/*
+ * Predictive rate control model
+ *
+ * The model reuses the bit allocation of rc_model_v2 and replaces its
+ * feedback-only qp decision with an online fitted rate-quantization model:
+ *
+ *      bits / pixel = alpha * cplx / qstep ^ beta
+ *
+ * cplx is the frame complexity reported by hardware (madi for intra frame,
+ * madp for inter frame) and qstep = 2 ^ ((qp - 4) / 6). alpha and beta are
+ * fitted per frame type in log domain after each encoded frame.
+ *
+ * With an accurate first pass qp the overshoot which triggers hardware
+ * reencode becomes rare. When check_re_enc still reports overshoot the model
+ * is refitted with the real complexity of the current frame and the reencode
+ * is skipped when it can not change the qp by more than PRED_REENC_MIN_DQP.
+ * Otherwise the reencode directly uses the refitted qp so one extra pass is
+ * usually enough.
+ */
+#define PRED_TYPE_I             0
+#define PRED_TYPE_P             1
+#define PRED_TYPE_BUTT          2
+
+#define PRED_ALPHA_WEIGHT       (0.4)
+#define PRED_BETA_WEIGHT        (0.2)
+#define PRED_ERR_WEIGHT         (0.25)
+#define PRED_BETA_INIT          (1.0)
+#define PRED_BETA_MIN           (0.5)
+#define PRED_BETA_MAX           (2.0)
+#define PRED_BETA_MIN_DQP       2
+/* max qp difference from the feedback model decision */
+#define PRED_QP_RANGE           8
+/* minimum qp improvement to make a hardware reencode worthwhile */
+#define PRED_REENC_MIN_DQP      2
+
+typedef struct RcPredModel_t {
+    RK_S32          valid;
+    double          log_alpha;
+    double          beta;
+    /* last observation for beta fitting */
+    RK_S32          last_qp;
+    double          last_log_bpp;
+    double          last_log_cplx;
+    /* prediction error in log domain */
+    double          log_err;
+} RcPredModel;
+
+typedef struct RcModelV2PredCtx_t {
+    /* NOTE: base context must be the first element */
+    RcModelV2Ctx    base;
+
+    RcPredModel     model[PRED_TYPE_BUTT];
+    RK_S32          pixels;
+    RK_S32          cplx_i;
+    RK_S32          cplx_p;
+
+    /* qp used by current frame and qp for reencode */
+    RK_S32          frm_qp;
+    RK_S32          reenc_qp;
+    /* accumulated real bits minus target bits */
+    RK_S64          bits_err;
+
+    /* statistic for debug */
+    RK_S64          frm_cnt;
+    RK_S64          reenc_skip;
+    RK_S64          reenc_cnt;
+} RcModelV2PredCtx;
+
+static RK_S32 pred_type(EncRcTaskInfo *info)
+{
+    return (info->frame_type == INTRA_FRAME) ? PRED_TYPE_I : PRED_TYPE_P;
+}
+
+static RK_S32 pred_cplx(RK_S32 type, RK_S32 madi, RK_S32 madp)
+{
+    RK_S32 cplx = (type == PRED_TYPE_I) ? madi : madp;
+
+    /* some hardware do not report madp then use madi instead */
+    if (cplx <= 0)
+        cplx = madi;
+
+    return (cplx > 0) ? cplx : 1;
+}
+
+static double pred_log_qstep(RK_S32 qp)
+{
+    return (qp - 4) * M_LN2 / 6.0;
+}
+
+static void pred_model_reset(RcPredModel *m)
+{
+    memset(m, 0, sizeof(*m));
+    m->beta = PRED_BETA_INIT;
+}
+
+static void pred_model_update(RcPredModel *m, RK_S32 qp, RK_S32 bits,
+                              RK_S32 pixels, RK_S32 cplx)
+{
+    double log_bpp;
+    double log_cplx;
+    double log_q;
+    double obs;
+
+    if (bits <= 0 || qp <= 0 || pixels <= 0)
+        return;
+
+    log_bpp = log((double)bits / pixels);
+    log_cplx = log((double)cplx);
+    log_q = pred_log_qstep(qp);
+
+    if (m->valid) {
+        double err = log_bpp - (m->log_alpha + log_cplx - m->beta * log_q);
+
+        m->log_err += PRED_ERR_WEIGHT * (fabs(err) - m->log_err);
+
+        /* fit beta only when the two observations have enough qp distance */
+        if (abs(qp - m->last_qp) >= PRED_BETA_MIN_DQP) {
+            double beta = -((log_bpp - log_cplx) - (m->last_log_bpp - m->last_log_cplx)) /
+                          (log_q - pred_log_qstep(m->last_qp));
+
+            if (beta < PRED_BETA_MIN)
+                beta = PRED_BETA_MIN;
+            if (beta > PRED_BETA_MAX)
+                beta = PRED_BETA_MAX;
+
+            m->beta += PRED_BETA_WEIGHT * (beta - m->beta);
+        }
+    }
+
+    obs = log_bpp - log_cplx + m->beta * log_q;
+
+    if (m->valid)
+        m->log_alpha += PRED_ALPHA_WEIGHT * (obs - m->log_alpha);
+    else
+        m->log_alpha = obs;
+
+    m->valid = 1;
+    m->last_qp = qp;
+    m->last_log_bpp = log_bpp;
+    m->last_log_cplx = log_cplx;
+}
+
+static RK_S32 pred_model_qp(RcPredModel *m, RK_S32 bits, RK_S32 pixels, RK_S32 cplx)
+{
+    /*
+     * alpha is fitted in log domain which predicts the geometric mean of bits.
+     * Add half variance to predict arithmetic mean. The mean absolute error is
+     * about 0.8 of standard deviation for normal distribution.
+     */
+    double sigma = m->log_err * 1.25;
+    double log_q;
+
+    if (bits <= 0)
+        bits = 1;
+
+    log_q = (m->log_alpha + sigma * sigma / 2 + log((double)cplx) -
+             log((double)bits / pixels)) / m->beta;
+
+    return (RK_S32)floor(log_q * 6.0 / M_LN2 + 4 + 0.5);
+}
+
+/*
+ * The bit target from base model is an open loop allocation. The accumulated
+ * difference between real bits and target bits is spread to the following
+ * frames in one second to close the loop. Otherwise the small prediction bias
+ * is hidden by qp rounding and keeps accumulating.
+ */
+static RK_S32 pred_target_bits(RcModelV2PredCtx *p, EncRcTaskInfo *info)
+{
+    RcFpsCfg *fps = &p->base.usr_cfg.fps;
+    RK_S64 fps_out = fps->fps_out_denorm ? fps->fps_out_num / fps->fps_out_denorm : 0;
+    RK_S64 bits = info->bit_target;
+
+    if (fps_out <= 0)
+        fps_out = 1;
+
+    bits -= p->bits_err / fps_out;
+    bits = mpp_clip(bits, info->bit_target * 2 / 3, info->bit_target * 3 / 2);
+
+    return (RK_S32)bits;
+}
+
+static MPP_RET rc_model_v2_pred_init(void *ctx, RcCfg *cfg)
+{
+    RcModelV2PredCtx *p = (RcModelV2PredCtx *)ctx;
+    RK_S32 i;
+
+    rc_dbg_func("enter %p\n", ctx);
+
+    for (i = 0; i < PRED_TYPE_BUTT; i++)
+        pred_model_reset(&p->model[i]);
+
+    p->pixels = MPP_ALIGN(cfg->width, 16) * MPP_ALIGN(cfg->height, 16);
+    p->cplx_i = 1;
+    p->cplx_p = 1;
+    p->frm_qp = -1;
+    p->reenc_qp = -1;
+    p->bits_err = 0;
+
+    rc_dbg_func("leave %p\n", ctx);
+
+    return rc_model_v2_init(&p->base, cfg);
+}
+
+static MPP_RET rc_model_v2_pred_deinit(void *ctx)
+{
+    RcModelV2PredCtx *p = (RcModelV2PredCtx *)ctx;
+
+    rc_dbg_rc("frame %lld reenc %lld skipped %lld\n",
+              p->frm_cnt, p->reenc_cnt, p->reenc_skip);
+
+    return rc_model_v2_deinit(&p->base);
+}
+
+static MPP_RET rc_model_v2_pred_start(void *ctx, EncRcTask *task)
+{
+    RcModelV2PredCtx *p = (RcModelV2PredCtx *)ctx;
+
+    p->reenc_qp = -1;
+
+    return rc_model_v2_start(&p->base, task);
+}
+
+static MPP_RET rc_model_v2_pred_hal_start(void *ctx, EncRcTask *task)
+{
+    RcModelV2PredCtx *p = (RcModelV2PredCtx *)ctx;
+    RcModelV2Ctx *base = &p->base;
+    EncRcTaskInfo *info = &task->info;
+    RcCfg *usr_cfg = &base->usr_cfg;
+    RcPredModel *m = NULL;
+    RK_S32 type = pred_type(info);
+    RK_S32 base_qp;
+    RK_S32 qp;
+    MPP_RET ret;
+
+    ret = rc_model_v2_hal_start(base, task);
+    if (ret)
+        return ret;
+
+    if (usr_cfg->mode == RC_FIXQP || (task->force.force_flag & ENC_RC_FORCE_QP))
+        return MPP_OK;
+
+    base_qp = info->quality_target;
+    m = &p->model[type];
+
+    if (base->reenc_cnt && p->reenc_qp > 0) {
+        /* reencode uses the qp refitted by the overshoot frame */
+        qp = p->reenc_qp;
+    } else if (m->valid) {
+        RK_S32 cplx = (type == PRED_TYPE_I) ? p->cplx_i : p->cplx_p;
+
+        qp = pred_model_qp(m, pred_target_bits(p, info), p->pixels, cplx);
+        qp = mpp_clip(qp, base_qp - PRED_QP_RANGE, base_qp + PRED_QP_RANGE);
+
+        rc_dbg_qp("pred type %d cplx %d target %d qp %d -> %d\n",
+                  type, cplx, info->bit_target, base_qp, qp);
+    } else {
+        qp = base_qp;
+    }
+
+    qp = mpp_clip(qp, info->quality_min, info->quality_max);
+
+    /* keep the vi / hierarchical qp offset of the base model scale qp */
+    if (type == PRED_TYPE_P) {
+        RK_S32 offset = base_qp - (base->cur_scale_qp >> 6);
+
+        base->cur_scale_qp = mpp_clip(qp - offset, info->quality_min,
+                                      info->quality_max) << 6;
+    }
+
+    base->start_qp = qp;
+    info->quality_target = qp;
+    p->frm_qp = qp;
+
+    return MPP_OK;
+}
+
+static MPP_RET rc_model_v2_pred_hal_end(void *ctx, EncRcTask *task)
+{
+    RcModelV2PredCtx *p = (RcModelV2PredCtx *)ctx;
+
+    return rc_model_v2_hal_end(&p->base, task);
+}
+
+static RK_S32 pred_is_super_frame(RcCfg *usr_cfg, EncRcTaskInfo *info)
+{
+    RcSuperframeCfg *super_cfg = &usr_cfg->super_cfg;
+    RK_U32 bits_thr;
+
+    if (!super_cfg->super_mode)
+        return 0;
+
+    bits_thr = (info->frame_type == INTRA_FRAME) ?
+               super_cfg->super_i_thd : super_cfg->super_p_thd;
+
+    return (RK_U32)info->bit_real >= bits_thr;
+}
+
+static MPP_RET rc_model_v2_pred_check_reenc(void *ctx, EncRcTask *task)
+{
+    RcModelV2PredCtx *p = (RcModelV2PredCtx *)ctx;
+    RcModelV2Ctx *base = &p->base;
+    EncRcTaskInfo *info = &task->info;
+    EncFrmStatus *frm = &task->frm;
+    RcPredModel *m = NULL;
+    RK_S32 type = pred_type(info);
+    RK_S32 cplx;
+    RK_S32 qp;
+    MPP_RET ret;
+
+    ret = rc_model_v2_check_reenc(base, task);
+    if (ret || !frm->reencode || frm->drop || frm->force_pskip)
+        return ret;
+
+    /* super frame reencode is mandatory by user config */
+    if (pred_is_super_frame(&base->usr_cfg, info) || p->frm_qp <= 0)
+        return MPP_OK;
+
+    /* refit model with the real complexity of the overshoot frame */
+    cplx = pred_cplx(type, info->madi, info->madp);
+    m = &p->model[type];
+    pred_model_update(m, p->frm_qp, info->bit_real, p->pixels, cplx);
+
+    qp = pred_model_qp(m, info->bit_target, p->pixels, cplx);
+    qp = mpp_clip(qp, info->quality_min, info->quality_max);
+
+    if (qp - p->frm_qp < PRED_REENC_MIN_DQP) {
+        /* let the bit allocation absorb the overshoot in following frames */
+        frm->reencode = 0;
+        if (base->reenc_cnt > 0)
+            base->reenc_cnt--;
+        p->reenc_skip++;
+        rc_dbg_rc("skip reenc qp %d -> %d real %d target %d\n",
+                  p->frm_qp, qp, info->bit_real, info->bit_target);
+    } else {
+        p->reenc_qp = qp;
+        p->reenc_cnt++;
+        rc_dbg_rc("reenc qp %d -> %d real %d target %d\n",
+                  p->frm_qp, qp, info->bit_real, info->bit_target);
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET rc_model_v2_pred_end(void *ctx, EncRcTask *task)
+{
+    RcModelV2PredCtx *p = (RcModelV2PredCtx *)ctx;
+    EncRcTaskInfo *info = &task->info;
+    RK_S32 type = pred_type(info);
+    RK_S32 qp = (info->quality_real > 0) ? info->quality_real : p->frm_qp;
+
+    if (p->base.usr_cfg.mode != RC_FIXQP && !task->frm.drop &&
+        !task->frm.force_pskip && qp > 0) {
+        pred_model_update(&p->model[type], qp, info->bit_real, p->pixels,
+                          pred_cplx(type, info->madi, info->madp));
+
+        rc_dbg_rc("model %d alpha %.3f beta %.3f err %.3f\n", type,
+                  p->model[type].log_alpha, p->model[type].beta,
+                  p->model[type].log_err);
+    }
+
+    p->bits_err += info->bit_real - info->bit_target;
+    /* vbr like mode only compensates the overshoot */
+    if (p->base.usr_cfg.mode != RC_CBR && p->bits_err < 0)
+        p->bits_err = 0;
+
+    /* madi is valid for all frame type and madp is only valid on inter frame */
+    if (info->madi > 0)
+        p->cplx_i = info->madi;
+    if (type == PRED_TYPE_P)
+        p->cplx_p = pred_cplx(type, info->madi, info->madp);
+
+    p->frm_cnt++;
+    p->frm_qp = -1;
+    p->reenc_qp = -1;
+
+    return rc_model_v2_end(&p->base, task);
+}
+
+const RcImplApi pred_h264e = {
+    "predict",
+    MPP_VIDEO_CodingAVC,
+    sizeof(RcModelV2PredCtx),
+    rc_model_v2_pred_init,
+    rc_model_v2_pred_deinit,
+    NULL,
+    rc_model_v2_pred_check_reenc,
+    rc_model_v2_pred_start,
+    rc_model_v2_pred_end,
+    rc_model_v2_pred_hal_start,
+    rc_model_v2_pred_hal_end,
+};
+
+const RcImplApi pred_h265e = {
+    "predict",
+    MPP_VIDEO_CodingHEVC,
+    sizeof(RcModelV2PredCtx),
+    rc_model_v2_pred_init,
+    rc_model_v2_pred_deinit,
+    NULL,
+    rc_model_v2_pred_check_reenc,
+    rc_model_v2_pred_start,
+    rc_model_v2_pred_end,
+    rc_model_v2_pred_hal_start,
+    rc_model_v2_pred_hal_end,
+};
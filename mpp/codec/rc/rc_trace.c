@@ -0,0 +1,144 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "rc_trace"
+
+#include <string.h>
+
+#include "mpp_log.h"
+
+#include "rc_trace.h"
+
+#define RC_TRACE_LINE_SIZE      512
+#define RC_TRACE_CFG_CNT        24
+#define RC_TRACE_FRM_CNT        14
+
+MPP_RET rc_trace_write_cfg(FILE *fp, RcCfg *cfg)
+{
+    if (NULL == fp || NULL == cfg)
+        return MPP_ERR_NULL_PTR;
+
+    fprintf(fp, "cfg %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d\n",
+            cfg->width, cfg->height, cfg->mode,
+            cfg->fps.fps_in_num, cfg->fps.fps_in_denorm,
+            cfg->fps.fps_out_num, cfg->fps.fps_out_denorm,
+            cfg->igop, cfg->vgop,
+            cfg->bps_min, cfg->bps_target, cfg->bps_max, cfg->stats_time,
+            cfg->init_quality, cfg->min_quality, cfg->max_quality,
+            cfg->min_i_quality, cfg->max_i_quality,
+            cfg->i_quality_delta, cfg->vi_quality_delta,
+            cfg->max_i_bit_prop, cfg->min_i_bit_prop, cfg->init_ip_ratio,
+            cfg->max_reencode_times);
+    fflush(fp);
+
+    return MPP_OK;
+}
+
+MPP_RET rc_trace_write_frm(FILE *fp, EncRcTask *task)
+{
+    EncRcTaskInfo *info;
+    EncFrmStatus *frm;
+
+    if (NULL == fp || NULL == task)
+        return MPP_ERR_NULL_PTR;
+
+    info = &task->info;
+    frm = &task->frm;
+
+    fprintf(fp, "frm %d %d %d %d %d %d %d %d %d %d %d %d %d %d\n",
+            frm->seq_idx, frm->is_intra, info->frame_type,
+            info->bit_target, info->bit_max, info->bit_min,
+            info->quality_target, info->quality_min, info->quality_max,
+            info->bit_real, info->quality_real, info->madi, info->madp,
+            frm->reencode_times);
+
+    return MPP_OK;
+}
+
+static RcTraceType rc_trace_parse_cfg(const char *line, RcCfg *cfg)
+{
+    RK_S32 mode = 0;
+    RK_S32 cnt;
+
+    memset(cfg, 0, sizeof(*cfg));
+
+    cnt = sscanf(line, "cfg %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d",
+                 &cfg->width, &cfg->height, &mode,
+                 &cfg->fps.fps_in_num, &cfg->fps.fps_in_denorm,
+                 &cfg->fps.fps_out_num, &cfg->fps.fps_out_denorm,
+                 &cfg->igop, &cfg->vgop,
+                 &cfg->bps_min, &cfg->bps_target, &cfg->bps_max, &cfg->stats_time,
+                 &cfg->init_quality, &cfg->min_quality, &cfg->max_quality,
+                 &cfg->min_i_quality, &cfg->max_i_quality,
+                 &cfg->i_quality_delta, &cfg->vi_quality_delta,
+                 &cfg->max_i_bit_prop, &cfg->min_i_bit_prop, &cfg->init_ip_ratio,
+                 &cfg->max_reencode_times);
+    if (cnt != RC_TRACE_CFG_CNT) {
+        mpp_err_f("invalid cfg line with %d items\n", cnt);
+        return RC_TRACE_BUTT;
+    }
+
+    cfg->mode = (RcMode)mode;
+    cfg->layer_bit_prop[0] = 256;
+    if (cfg->vgop && cfg->vgop < cfg->igop)
+        cfg->gop_mode = SMART_P;
+
+    return RC_TRACE_CFG;
+}
+
+static RcTraceType rc_trace_parse_frm(const char *line, RcTraceFrm *frm)
+{
+    EncRcTaskInfo *info = &frm->info;
+    RK_S32 frame_type = 0;
+    RK_S32 cnt;
+
+    memset(frm, 0, sizeof(*frm));
+
+    cnt = sscanf(line, "frm %d %d %d %d %d %d %d %d %d %d %d %d %d %d",
+                 &frm->seq_idx, &frm->is_intra, &frame_type,
+                 &info->bit_target, &info->bit_max, &info->bit_min,
+                 &info->quality_target, &info->quality_min, &info->quality_max,
+                 &info->bit_real, &info->quality_real, &info->madi, &info->madp,
+                 &frm->reenc_times);
+    if (cnt != RC_TRACE_FRM_CNT) {
+        mpp_err_f("invalid frm line with %d items\n", cnt);
+        return RC_TRACE_BUTT;
+    }
+
+    info->frame_type = (EncFrmType)frame_type;
+
+    return RC_TRACE_FRM;
+}
+
+RcTraceType rc_trace_read(FILE *fp, RcCfg *cfg, RcTraceFrm *frm)
+{
+    char line[RC_TRACE_LINE_SIZE];
+
+    if (NULL == fp)
+        return RC_TRACE_EOF;
+
+    while (fgets(line, sizeof(line), fp)) {
+        if (!strncmp(line, "cfg ", 4) && cfg)
+            return rc_trace_parse_cfg(line, cfg);
+
+        if (!strncmp(line, "frm ", 4) && frm)
+            return rc_trace_parse_frm(line, frm);
+
+        /* skip comment and unknown line */
+    }
+
+    return RC_TRACE_EOF;
+}
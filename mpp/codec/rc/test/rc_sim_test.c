@@ -0,0 +1,428 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "rc_sim_test"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_frame.h"
+
+#include "rc.h"
+#include "rc_trace.h"
+
+/*
+ * Offline rate control simulator
+ *
+ * Replay the per-frame statistic recorded by encoder (environment
+ * mpp_enc_rc_trace) through registered rate control api without hardware.
+ * The real bits of each frame is rescaled from the recorded bits by the
+ * difference between the recorded qp and the qp selected by the rc model.
+ *
+ * usage: rc_sim_test [-i trace] [-n rc_name|all] [-t h264|h265]
+ *
+ * Without input trace a synthetic trace with scene cuts is generated.
+ */
+#define MAX_QUERY_COUNT     16
+#define SIM_TRACE_FRAMES    1800
+#define SIM_SCENE_MIN       30
+#define SIM_SCENE_MAX       150
+
+typedef struct RcSimTrace_t {
+    RcCfg           cfg;
+    RcTraceFrm      *frms;
+    RK_S32          count;
+    RK_S32          size;
+} RcSimTrace;
+
+typedef struct RcSimStat_t {
+    RK_S64          bits_total;
+    RK_S32          frm_cnt;
+    RK_S32          drop_cnt;
+    RK_S32          reenc_cnt;
+    RK_S32          qp_sum;
+
+    /* virtual buffer fullness in bits */
+    RK_S64          buf_size;
+    RK_S64          buf_level;
+    RK_S64          buf_max;
+    RK_S32          buf_overflow;
+
+    RK_S64          time_total;
+    RK_S64          time_max;
+} RcSimStat;
+
+static RK_U32 sim_rand_seed = 0x12345678;
+
+static RK_S32 sim_rand(RK_S32 min, RK_S32 max)
+{
+    sim_rand_seed = sim_rand_seed * 1103515245 + 12345;
+
+    return min + (RK_S32)((sim_rand_seed >> 8) % (RK_U32)(max - min + 1));
+}
+
+static MPP_RET sim_trace_add(RcSimTrace *trace, RcTraceFrm *frm)
+{
+    /* drop and pskip reencode end the same frame twice, keep the last one */
+    if (trace->count && trace->frms[trace->count - 1].seq_idx == frm->seq_idx) {
+        trace->frms[trace->count - 1] = *frm;
+        return MPP_OK;
+    }
+
+    if (trace->count >= trace->size) {
+        RK_S32 size = trace->size ? trace->size * 2 : 256;
+        RcTraceFrm *frms = mpp_realloc(trace->frms, RcTraceFrm, size);
+
+        if (NULL == frms) {
+            mpp_err_f("failed to realloc %d frames\n", size);
+            return MPP_ERR_MALLOC;
+        }
+
+        trace->frms = frms;
+        trace->size = size;
+    }
+
+    trace->frms[trace->count++] = *frm;
+    return MPP_OK;
+}
+
+static MPP_RET sim_trace_load(RcSimTrace *trace, const char *name)
+{
+    FILE *fp = fopen(name, "r");
+    RcCfg cfg;
+    RcTraceFrm frm;
+    RcTraceType type;
+    RK_S32 has_cfg = 0;
+
+    if (NULL == fp) {
+        mpp_err_f("failed to open trace %s\n", name);
+        return MPP_NOK;
+    }
+
+    do {
+        type = rc_trace_read(fp, &cfg, &frm);
+        if (type == RC_TRACE_CFG) {
+            /* only the first config is used in simulation */
+            if (!has_cfg)
+                memcpy(&trace->cfg, &cfg, sizeof(cfg));
+            has_cfg = 1;
+        } else if (type == RC_TRACE_FRM) {
+            if (sim_trace_add(trace, &frm))
+                break;
+        }
+    } while (type != RC_TRACE_EOF && type != RC_TRACE_BUTT);
+
+    fclose(fp);
+
+    if (!has_cfg || !trace->count) {
+        mpp_err_f("trace %s has cfg %d frames %d\n", name, has_cfg, trace->count);
+        return MPP_NOK;
+    }
+
+    mpp_log("load trace %s %dx%d frames %d\n", name,
+            trace->cfg.width, trace->cfg.height, trace->count);
+
+    return MPP_OK;
+}
+
+static double sim_qstep(RK_S32 qp)
+{
+    return pow(2.0, (qp - 4) / 6.0);
+}
+
+static void sim_trace_gen(RcSimTrace *trace)
+{
+    RcCfg *cfg = &trace->cfg;
+    RK_S32 pixels = 1920 * 1088;
+    RK_S32 scene_left = 0;
+    RK_S32 madi = 0;
+    RK_S32 madp = 0;
+    RK_S32 i;
+
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->width = 1920;
+    cfg->height = 1080;
+    cfg->mode = RC_CBR;
+    cfg->fps.fps_in_num = 30;
+    cfg->fps.fps_in_denorm = 1;
+    cfg->fps.fps_out_num = 30;
+    cfg->fps.fps_out_denorm = 1;
+    cfg->igop = 60;
+    cfg->bps_target = 4 * 1000 * 1000;
+    cfg->bps_max = cfg->bps_target * 17 / 16;
+    cfg->bps_min = cfg->bps_target * 15 / 16;
+    cfg->stats_time = 3;
+    cfg->init_quality = -1;
+    cfg->min_quality = 8;
+    cfg->max_quality = 48;
+    cfg->min_i_quality = 8;
+    cfg->max_i_quality = 48;
+    cfg->i_quality_delta = 2;
+    cfg->max_i_bit_prop = 30;
+    cfg->min_i_bit_prop = 10;
+    cfg->init_ip_ratio = 160;
+    cfg->max_reencode_times = 1;
+    cfg->layer_bit_prop[0] = 256;
+
+    for (i = 0; i < SIM_TRACE_FRAMES; i++) {
+        RcTraceFrm frm;
+        EncRcTaskInfo *info = &frm.info;
+        RK_S32 qp = 32;
+        double bits;
+
+        if (scene_left <= 0) {
+            scene_left = sim_rand(SIM_SCENE_MIN, SIM_SCENE_MAX);
+            madi = sim_rand(8, 60);
+            madp = sim_rand(2, madi / 2 + 2);
+        }
+        scene_left--;
+
+        memset(&frm, 0, sizeof(frm));
+        frm.seq_idx = i;
+        frm.is_intra = (i % cfg->igop) == 0;
+        info->frame_type = frm.is_intra ? INTRA_FRAME : INTER_P_FRAME;
+        info->quality_target = qp;
+        info->quality_real = qp;
+        info->madi = madi + sim_rand(-2, 2);
+        info->madp = madp + sim_rand(-1, 1);
+        if (info->madi < 1)
+            info->madi = 1;
+        if (info->madp < 1)
+            info->madp = 1;
+
+        /* rate model with 10% noise */
+        bits = pixels * (frm.is_intra ? 0.6 * info->madi : 0.4 * info->madp) / sim_qstep(qp);
+        bits = bits * sim_rand(90, 110) / 100;
+        info->bit_real = (RK_S32)bits;
+
+        sim_trace_add(trace, &frm);
+    }
+}
+
+static RK_S32 sim_frame_bits(RcTraceFrm *frm, RK_S32 qp)
+{
+    EncRcTaskInfo *rec = &frm->info;
+    RK_S32 rec_qp = rec->quality_real > 0 ? rec->quality_real : rec->quality_target;
+
+    if (rec_qp <= 0 || qp <= 0)
+        return rec->bit_real;
+
+    return (RK_S32)(rec->bit_real * pow(2.0, (rec_qp - qp) / 6.0));
+}
+
+static void sim_frame_hw(EncRcTask *task, RcTraceFrm *frm)
+{
+    EncRcTaskInfo *info = &task->info;
+
+    info->bit_real = sim_frame_bits(frm, info->quality_target);
+    info->quality_real = info->quality_target;
+    info->madi = frm->info.madi;
+    info->madp = frm->info.madp;
+}
+
+static MPP_RET sim_run(RcSimTrace *trace, MppCodingType type, const char *name,
+                       RcSimStat *stat)
+{
+    RcCfg *cfg = &trace->cfg;
+    RK_S32 fps_num = cfg->fps.fps_out_num ? cfg->fps.fps_out_num : 30;
+    RK_S32 fps_den = cfg->fps.fps_out_denorm ? cfg->fps.fps_out_denorm : 1;
+    RK_S64 bits_per_frm = (RK_S64)cfg->bps_target * fps_den / fps_num;
+    RK_S32 pskip_bits = MPP_ALIGN(cfg->width, 16) * MPP_ALIGN(cfg->height, 16) / 256;
+    RcCtx ctx = NULL;
+    MppFrame frame = NULL;
+    const char *rc_name = name;
+    RcCfg usr_cfg;
+    MPP_RET ret;
+    RK_S32 i;
+
+    memset(stat, 0, sizeof(*stat));
+
+    ret = rc_init(&ctx, type, &rc_name);
+    if (ret || NULL == ctx) {
+        mpp_err_f("failed to init rc %s\n", name);
+        return MPP_NOK;
+    }
+
+    /* some rc model reads frame size and meta from input frame */
+    mpp_frame_init(&frame);
+    mpp_frame_set_width(frame, cfg->width);
+    mpp_frame_set_height(frame, cfg->height);
+
+    /* rc model may modify the config */
+    memcpy(&usr_cfg, cfg, sizeof(usr_cfg));
+    rc_update_usr_cfg(ctx, &usr_cfg);
+
+    stat->buf_size = cfg->bps_target;
+    stat->buf_level = stat->buf_size / 2;
+
+    for (i = 0; i < trace->count; i++) {
+        RcTraceFrm *frm = &trace->frms[i];
+        EncRcTask task;
+        EncFrmStatus *status = &task.frm;
+        RK_S64 time_start;
+        RK_S64 time_cost;
+
+        memset(&task, 0, sizeof(task));
+        task.frame = frame;
+        status->valid = 1;
+        status->seq_idx = frm->seq_idx;
+        status->is_intra = frm->is_intra;
+        status->is_idr = frm->is_intra;
+
+        time_start = mpp_time();
+
+        rc_frm_start(ctx, &task);
+        rc_hal_start(ctx, &task);
+        sim_frame_hw(&task, frm);
+        rc_hal_end(ctx, &task);
+        rc_frm_check_reenc(ctx, &task);
+
+        while (status->reencode && status->reencode_times < (RK_U32)cfg->max_reencode_times) {
+            status->reencode_times++;
+
+            if (status->drop) {
+                task.info.bit_real = 0;
+                stat->drop_cnt++;
+                break;
+            }
+
+            if (status->force_pskip) {
+                task.info.bit_real = pskip_bits;
+                break;
+            }
+
+            stat->reenc_cnt++;
+            rc_hal_start(ctx, &task);
+            sim_frame_hw(&task, frm);
+            rc_hal_end(ctx, &task);
+            rc_frm_check_reenc(ctx, &task);
+        }
+
+        rc_frm_end(ctx, &task);
+
+        time_cost = mpp_time() - time_start;
+        stat->time_total += time_cost;
+        if (time_cost > stat->time_max)
+            stat->time_max = time_cost;
+
+        stat->bits_total += task.info.bit_real;
+        stat->qp_sum += task.info.quality_target;
+        stat->frm_cnt++;
+
+        /* leaky bucket buffer fullness */
+        stat->buf_level += task.info.bit_real - bits_per_frm;
+        if (stat->buf_level < 0)
+            stat->buf_level = 0;
+        if (stat->buf_level > stat->buf_max)
+            stat->buf_max = stat->buf_level;
+        if (stat->buf_level > stat->buf_size)
+            stat->buf_overflow++;
+    }
+
+    rc_deinit(ctx);
+    mpp_frame_deinit(&frame);
+
+    return MPP_OK;
+}
+
+static void sim_report(RcSimTrace *trace, const char *name, RcSimStat *stat)
+{
+    RcCfg *cfg = &trace->cfg;
+    RK_S32 fps_num = cfg->fps.fps_out_num ? cfg->fps.fps_out_num : 30;
+    RK_S32 fps_den = cfg->fps.fps_out_denorm ? cfg->fps.fps_out_denorm : 1;
+    double duration = (double)stat->frm_cnt * fps_den / fps_num;
+    double bps = duration > 0 ? stat->bits_total / duration : 0;
+    double err = cfg->bps_target ? (bps - cfg->bps_target) * 100.0 / cfg->bps_target : 0;
+    RK_S32 cnt = stat->frm_cnt ? stat->frm_cnt : 1;
+
+    mpp_log("%-8s bps %9.0f err %6.2f%% qp %5.2f reenc %4d (%5.2f%%) drop %4d "
+            "buf max %6.2f%% overflow %4d rc time avg %5.2f us max %lld us\n",
+            name, bps, err, (double)stat->qp_sum / cnt,
+            stat->reenc_cnt, stat->reenc_cnt * 100.0 / cnt, stat->drop_cnt,
+            stat->buf_size ? stat->buf_max * 100.0 / stat->buf_size : 0,
+            stat->buf_overflow, (double)stat->time_total / cnt, stat->time_max);
+}
+
+int main(int argc, char **argv)
+{
+    MppCodingType type = MPP_VIDEO_CodingAVC;
+    const char *input = NULL;
+    const char *name = "all";
+    RcApiBrief briefs[MAX_QUERY_COUNT];
+    RcApiQueryType query;
+    RcSimTrace trace;
+    RcSimStat stat;
+    MPP_RET ret = MPP_OK;
+    RK_S32 i;
+
+    for (i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "-i")) {
+            input = argv[i + 1];
+        } else if (!strcmp(argv[i], "-n")) {
+            name = argv[i + 1];
+        } else if (!strcmp(argv[i], "-t")) {
+            type = !strcmp(argv[i + 1], "h265") ?
+                   MPP_VIDEO_CodingHEVC : MPP_VIDEO_CodingAVC;
+        } else {
+            mpp_log("usage: %s [-i trace] [-n rc_name|all] [-t h264|h265]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    mpp_log("rc sim test start\n");
+
+    memset(&trace, 0, sizeof(trace));
+    if (input) {
+        ret = sim_trace_load(&trace, input);
+        if (ret)
+            goto DONE;
+    } else {
+        sim_trace_gen(&trace);
+    }
+
+    if (strcmp(name, "all")) {
+        ret = sim_run(&trace, type, name, &stat);
+        if (!ret)
+            sim_report(&trace, name, &stat);
+        goto DONE;
+    }
+
+    query.brief = briefs;
+    query.max_count = MAX_QUERY_COUNT;
+    query.type = type;
+    query.count = 0;
+
+    rc_brief_get_by_type(&query);
+
+    for (i = 0; i < query.count; i++) {
+        ret = sim_run(&trace, type, briefs[i].name, &stat);
+        if (ret)
+            break;
+
+        sim_report(&trace, briefs[i].name, &stat);
+    }
+
+DONE:
+    MPP_FREE(trace.frms);
+    mpp_log("rc sim test %s\n", ret ? "failed" : "done");
+
+    return ret;
+}
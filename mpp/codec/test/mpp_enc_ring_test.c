@@ -0,0 +1,161 @@
+/*
+ * Copyright 2026 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_enc_ring_test"
+
+#include "mpp_log.h"
+#include "mpp_common.h"
+
+#include "mpp_packet_impl.h"
+#include "mpp_enc_ring.h"
+
+#define ENC_RING_TEST_SIZE      4096
+
+#define ENC_RING_TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            mpp_err("check %s failed at line %d\n", #cond, __LINE__); \
+            ret = MPP_NOK; \
+            goto DONE; \
+        } \
+    } while (0)
+
+static RK_U8 *ring_base = NULL;
+
+/* carve a region to a new packet, return the region offset or -1 */
+static RK_S32 ring_test_get(MppEncRing ring, MppPacket *packet, RK_U32 size)
+{
+    RK_U8 *data;
+
+    *packet = NULL;
+    if (mpp_packet_new(packet))
+        return -1;
+
+    if (mpp_enc_ring_get(ring, *packet, size)) {
+        mpp_packet_deinit(packet);
+        return -1;
+    }
+
+    data = (RK_U8 *)mpp_packet_get_data(*packet);
+    if (NULL == ring_base)
+        ring_base = data;
+
+    return data - ring_base;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_OK;
+    MppBufferGroup grp = NULL;
+    MppEncRing ring = NULL;
+    MppPacket a = NULL;
+    MppPacket a_copy = NULL;
+    MppPacket b = NULL;
+    MppPacket c = NULL;
+    MppPacket d = NULL;
+    MppPacket e = NULL;
+    MppPacket f = NULL;
+    MppPacket g = NULL;
+    MppPacket h = NULL;
+    MppPacket tmp = NULL;
+
+    mpp_log("mpp_enc_ring_test start\n");
+
+    mpp_buffer_group_get_internal(&grp, MPP_BUFFER_TYPE_NORMAL);
+    ENC_RING_TEST_CHECK(grp);
+    ENC_RING_TEST_CHECK(!mpp_enc_ring_init(&ring, grp, ENC_RING_TEST_SIZE));
+    ENC_RING_TEST_CHECK(mpp_enc_ring_get_size(ring) == ENC_RING_TEST_SIZE);
+
+    /* carve in order */
+    ENC_RING_TEST_CHECK(ring_test_get(ring, &a, 1000) == 0);
+    ENC_RING_TEST_CHECK(ring_test_get(ring, &b, 1024) == 1024);
+    ENC_RING_TEST_CHECK(ring_test_get(ring, &c, 1024) == 2048);
+    ENC_RING_TEST_CHECK(mpp_packet_get_size(a) == 1024);
+    ENC_RING_TEST_CHECK(mpp_enc_ring_check(ring, a));
+    ENC_RING_TEST_CHECK(ring_test_get(ring, &tmp, 2048) < 0);
+
+    /* regions are reclaimed in carving order */
+    mpp_packet_deinit(&b);
+    ENC_RING_TEST_CHECK(ring_test_get(ring, &tmp, 2048) < 0);
+
+    /* copy keeps the region after the packet is released */
+    ENC_RING_TEST_CHECK(!mpp_packet_copy_init(&a_copy, a));
+    mpp_packet_deinit(&a);
+    ENC_RING_TEST_CHECK(ring_test_get(ring, &tmp, 2048) < 0);
+
+    /* reset releases the region */
+    mpp_packet_reset((MppPacketImpl *)a_copy);
+    ENC_RING_TEST_CHECK(!mpp_enc_ring_check(ring, a_copy));
+    ENC_RING_TEST_CHECK(NULL == mpp_packet_get_buffer(a_copy));
+    ENC_RING_TEST_CHECK(NULL == mpp_packet_get_data(a_copy));
+    mpp_packet_deinit(&a_copy);
+
+    /* tail is now c, wrap to the start when the end is too small */
+    ENC_RING_TEST_CHECK(ring_test_get(ring, &d, 1024) == 3072);
+    ENC_RING_TEST_CHECK(ring_test_get(ring, &e, 1024) == 0);
+    ENC_RING_TEST_CHECK(ring_test_get(ring, &f, 1024) == 1024);
+    ENC_RING_TEST_CHECK(ring_test_get(ring, &tmp, 256) < 0);
+
+    /* set buffer releases the region */
+    mpp_packet_set_buffer(c, NULL);
+    ENC_RING_TEST_CHECK(!mpp_enc_ring_check(ring, c));
+    mpp_packet_deinit(&c);
+    ENC_RING_TEST_CHECK(ring_test_get(ring, &g, 1024) == 2048);
+    ENC_RING_TEST_CHECK(ring_test_get(ring, &tmp, 256) < 0);
+
+    /* trim the latest region gives the tail space back */
+    mpp_packet_set_length(g, 100);
+    ENC_RING_TEST_CHECK(!mpp_enc_ring_resize(ring, g, 100));
+    ENC_RING_TEST_CHECK(mpp_packet_get_size(g) == 256);
+    ENC_RING_TEST_CHECK(ring_test_get(ring, &h, 768) == 2304);
+    /* older region can not grow */
+    ENC_RING_TEST_CHECK(mpp_enc_ring_resize(ring, g, 512));
+
+    /* ring memory is kept until the last region is released */
+    mpp_enc_ring_deinit(ring);
+    ring = NULL;
+    ENC_RING_TEST_CHECK(mpp_packet_get_buffer(d));
+
+DONE:
+    if (tmp)
+        mpp_packet_deinit(&tmp);
+    if (a)
+        mpp_packet_deinit(&a);
+    if (a_copy)
+        mpp_packet_deinit(&a_copy);
+    if (b)
+        mpp_packet_deinit(&b);
+    if (c)
+        mpp_packet_deinit(&c);
+    if (d)
+        mpp_packet_deinit(&d);
+    if (e)
+        mpp_packet_deinit(&e);
+    if (f)
+        mpp_packet_deinit(&f);
+    if (g)
+        mpp_packet_deinit(&g);
+    if (h)
+        mpp_packet_deinit(&h);
+    if (ring)
+        mpp_enc_ring_deinit(ring);
+    if (grp)
+        mpp_buffer_group_put(grp);
+
+    mpp_log("mpp_enc_ring_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -0,0 +1,264 @@
+/*
+ * Copyright 2026 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_enc_static_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_common.h"
+
+#include "mpp_enc_static.h"
+
+/* not tile aligned to cover the partial tiles on right and bottom edge */
+#define STATIC_TEST_WIDTH       120
+#define STATIC_TEST_HEIGHT      72
+#define STATIC_TEST_THD         4
+/* sampled row phases to cover all rows of a tile */
+#define STATIC_TEST_PHASES      8
+
+#define STATIC_TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            mpp_err("check %s failed at line %d\n", #cond, __LINE__); \
+            ret = MPP_NOK; \
+            goto DONE; \
+        } \
+    } while (0)
+
+static MppFrame static_test_alloc(MppBufferGroup grp, RK_U32 hor_stride, RK_U32 ver_stride,
+                                  RK_S32 luma_delta)
+{
+    MppFrame frame = NULL;
+    MppBuffer buf = NULL;
+    RK_U8 *base;
+    RK_U32 x, y;
+
+    mpp_buffer_get(grp, &buf, hor_stride * ver_stride * 3 / 2);
+    if (NULL == buf)
+        return NULL;
+
+    mpp_frame_init(&frame);
+    mpp_frame_set_width(frame, STATIC_TEST_WIDTH);
+    mpp_frame_set_height(frame, STATIC_TEST_HEIGHT);
+    mpp_frame_set_hor_stride(frame, hor_stride);
+    mpp_frame_set_ver_stride(frame, ver_stride);
+    mpp_frame_set_fmt(frame, MPP_FMT_YUV420SP);
+    mpp_frame_set_buffer(frame, buf);
+    mpp_buffer_put(buf);
+
+    /* padding is filled with garbage which must not be compared */
+    base = (RK_U8 *)mpp_buffer_get_ptr(buf);
+    memset(base, 0xa5, hor_stride * ver_stride * 3 / 2);
+    for (y = 0; y < STATIC_TEST_HEIGHT; y++)
+        for (x = 0; x < STATIC_TEST_WIDTH; x++)
+            base[y * hor_stride + x] = (RK_U8)(64 + (x * 3 + y * 5) % 96 + luma_delta);
+
+    base += hor_stride * ver_stride;
+    for (y = 0; y < STATIC_TEST_HEIGHT / 2; y++)
+        for (x = 0; x < STATIC_TEST_WIDTH; x++)
+            base[y * hor_stride + x] = (RK_U8)(x * 7 + y * 11);
+
+    return frame;
+}
+
+/* add delta to count pixels from (x, y) on one row of plane */
+static void static_test_modify(MppFrame frame, RK_U32 plane, RK_U32 x, RK_U32 y,
+                               RK_U32 count, RK_S32 delta)
+{
+    RK_U8 *base = (RK_U8 *)mpp_buffer_get_ptr(mpp_frame_get_buffer(frame));
+    RK_U32 stride = mpp_frame_get_hor_stride(frame);
+    RK_U32 i;
+
+    if (plane)
+        base += stride * mpp_frame_get_ver_stride(frame);
+
+    for (i = 0; i < count; i++)
+        base[y * stride + x + i] += delta;
+}
+
+/* return bit mask of the phases which find the frame static */
+static RK_U32 static_test_phases(MppEncStatic ctx, MppFrame frame)
+{
+    RK_U32 mask = 0;
+    RK_U32 phase;
+
+    for (phase = 0; phase < STATIC_TEST_PHASES; phase++)
+        if (mpp_enc_static_check(ctx, frame, STATIC_TEST_THD, phase))
+            mask |= 1 << phase;
+
+    return mask;
+}
+
+static MPP_RET static_test_detect(MppBufferGroup grp)
+{
+    MPP_RET ret = MPP_OK;
+    MppEncStatic ctx = NULL;
+    MppFrame ref = static_test_alloc(grp, STATIC_TEST_WIDTH, STATIC_TEST_HEIGHT, 0);
+    MppFrame cur = NULL;
+    RK_S32 delta;
+    RK_U32 row;
+
+    STATIC_TEST_CHECK(ref);
+    STATIC_TEST_CHECK(!mpp_enc_static_init(&ctx));
+
+    /* no reference yet */
+    STATIC_TEST_CHECK(!mpp_enc_static_check(ctx, ref, STATIC_TEST_THD, 0));
+
+    STATIC_TEST_CHECK(!mpp_enc_static_update(ctx, ref));
+    STATIC_TEST_CHECK(static_test_phases(ctx, ref) == 0xff);
+
+    /* same content with larger stride and garbage in padding */
+    cur = static_test_alloc(grp, STATIC_TEST_WIDTH + 72, STATIC_TEST_HEIGHT + 8, 0);
+    STATIC_TEST_CHECK(cur);
+    STATIC_TEST_CHECK(static_test_phases(ctx, cur) == 0xff);
+    mpp_frame_deinit(&cur);
+
+    /*
+     * slowly drifting scene against the fixed reference, static until the
+     * mean difference is above the threshold
+     */
+    for (delta = 1; delta <= STATIC_TEST_THD + 2; delta++) {
+        cur = static_test_alloc(grp, STATIC_TEST_WIDTH, STATIC_TEST_HEIGHT, delta);
+        STATIC_TEST_CHECK(cur);
+        STATIC_TEST_CHECK(static_test_phases(ctx, cur) ==
+                          ((delta <= STATIC_TEST_THD) ? 0xff : 0));
+        mpp_frame_deinit(&cur);
+    }
+
+    /* change on one row is only found by the phase sampling the row */
+    for (row = 0; row < 16; row++) {
+        cur = static_test_alloc(grp, STATIC_TEST_WIDTH, STATIC_TEST_HEIGHT, 0);
+        STATIC_TEST_CHECK(cur);
+        static_test_modify(cur, 0, 32, 16 + row, 16, 100);
+        STATIC_TEST_CHECK(static_test_phases(ctx, cur) == (0xffu & ~(1 << (row % 8))));
+        mpp_frame_deinit(&cur);
+    }
+
+    /* the last rows of partial bottom tile are sampled on every phase */
+    cur = static_test_alloc(grp, STATIC_TEST_WIDTH, STATIC_TEST_HEIGHT, 0);
+    STATIC_TEST_CHECK(cur);
+    static_test_modify(cur, 0, 112, STATIC_TEST_HEIGHT - 1, 8, 100);
+    STATIC_TEST_CHECK(static_test_phases(ctx, cur) == 0);
+    mpp_frame_deinit(&cur);
+
+    /* small change of a few pixels stays below threshold */
+    cur = static_test_alloc(grp, STATIC_TEST_WIDTH, STATIC_TEST_HEIGHT, 0);
+    STATIC_TEST_CHECK(cur);
+    static_test_modify(cur, 0, 0, 0, 2, 30);
+    STATIC_TEST_CHECK(static_test_phases(ctx, cur) == 0xff);
+    mpp_frame_deinit(&cur);
+
+    /* chroma is not compared */
+    cur = static_test_alloc(grp, STATIC_TEST_WIDTH, STATIC_TEST_HEIGHT, 0);
+    STATIC_TEST_CHECK(cur);
+    static_test_modify(cur, 1, 0, 4, STATIC_TEST_WIDTH, 100);
+    STATIC_TEST_CHECK(static_test_phases(ctx, cur) == 0xff);
+    mpp_frame_deinit(&cur);
+
+    /* size change is never static */
+    cur = static_test_alloc(grp, STATIC_TEST_WIDTH, STATIC_TEST_HEIGHT, 0);
+    STATIC_TEST_CHECK(cur);
+    mpp_frame_set_width(cur, STATIC_TEST_WIDTH - 16);
+    STATIC_TEST_CHECK(static_test_phases(ctx, cur) == 0);
+
+    /* unsupported format clears the reference */
+    mpp_frame_set_width(cur, STATIC_TEST_WIDTH);
+    mpp_frame_set_fmt(cur, MPP_FMT_RGB888);
+    STATIC_TEST_CHECK(static_test_phases(ctx, cur) == 0);
+    STATIC_TEST_CHECK(!mpp_enc_static_update(ctx, cur));
+    STATIC_TEST_CHECK(static_test_phases(ctx, ref) == 0);
+
+DONE:
+    if (cur)
+        mpp_frame_deinit(&cur);
+    if (ref)
+        mpp_frame_deinit(&ref);
+    mpp_enc_static_deinit(ctx);
+
+    mpp_log("static detect %s\n", ret ? "failed" : "success");
+    return ret;
+}
+
+static MPP_RET static_test_guard(void)
+{
+    MPP_RET ret = MPP_OK;
+    MppEncStaticCond base;
+    MppEncStaticCond cond;
+
+    memset(&base, 0, sizeof(base));
+    base.skip_max = 4;
+    base.qp_ref = 30;
+    base.qp_target = 30;
+
+    STATIC_TEST_CHECK(mpp_enc_static_allow(&base));
+
+    /* disabled and skip run limit */
+    cond = base;
+    cond.skip_max = 0;
+    STATIC_TEST_CHECK(!mpp_enc_static_allow(&cond));
+    cond = base;
+    cond.skip_cnt = 3;
+    STATIC_TEST_CHECK(mpp_enc_static_allow(&cond));
+    cond.skip_cnt = 4;
+    STATIC_TEST_CHECK(!mpp_enc_static_allow(&cond));
+
+    /* force flag and other hardware only frames */
+    cond = base;
+    cond.hw_only = 1;
+    STATIC_TEST_CHECK(!mpp_enc_static_allow(&cond));
+
+    /* pending intra frame */
+    cond = base;
+    cond.next_intra = 1;
+    STATIC_TEST_CHECK(!mpp_enc_static_allow(&cond));
+
+    /* reference quality well below rate control target */
+    cond = base;
+    cond.qp_ref = 33;
+    STATIC_TEST_CHECK(mpp_enc_static_allow(&cond));
+    cond.qp_ref = 34;
+    STATIC_TEST_CHECK(!mpp_enc_static_allow(&cond));
+    cond.qp_ref = 20;
+    STATIC_TEST_CHECK(mpp_enc_static_allow(&cond));
+
+DONE:
+    mpp_log("static guard %s\n", ret ? "failed" : "success");
+    return ret;
+}
+
+int main()
+{
+    MppBufferGroup grp = NULL;
+    MPP_RET ret = MPP_OK;
+
+    mpp_log("mpp_enc_static_test start\n");
+
+    mpp_buffer_group_get_internal(&grp, MPP_BUFFER_TYPE_NORMAL);
+    if (NULL == grp) {
+        mpp_err("failed to get buffer group\n");
+        return -1;
+    }
+
+    ret |= static_test_detect(grp);
+    ret |= static_test_guard();
+
+    mpp_buffer_group_put(grp);
+
+    mpp_log("mpp_enc_static_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define MODULE_TAG "hal_regs"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_debug.h"
+#include "mpp_common.h"
+
+#include "hal_regs.h"
+
+#define HAL_REGS_DBG_FUNCTION           (0x00000001)
+#define HAL_REGS_DBG_DIRTY              (0x00000002)
+#define HAL_REGS_DBG_DUMP               (0x00000010)
+
+#define hal_regs_dbg(flag, fmt, ...)    _mpp_dbg_f(hal_regs_debug, flag, fmt, ## __VA_ARGS__)
+
+#define hal_regs_dbg_func(fmt, ...)     hal_regs_dbg(HAL_REGS_DBG_FUNCTION, fmt, ## __VA_ARGS__)
+#define hal_regs_dbg_dirty(fmt, ...)    hal_regs_dbg(HAL_REGS_DBG_DIRTY, fmt, ## __VA_ARGS__)
+
+#define MAX_HAL_REGS_SEC_CNT            16
+
+typedef struct HalRegsSec_t {
+    RK_U32          pos;
+    RK_U32          size;
+    RK_U32          offset;
+    RK_U32          flag;
+} HalRegsSec;
+
+typedef struct HalRegsImpl_t {
+    RK_U8           *base;
+    RK_U32          img_size;
+    RK_S32          img_cnt;
+
+    RK_S32          sec_cnt;
+    HalRegsSec      secs[MAX_HAL_REGS_SEC_CNT];
+    /* const section clean bit of each register struct */
+    RK_U32          *clean;
+} HalRegsImpl;
+
+static RK_U32 hal_regs_debug = 0;
+
+MPP_RET hal_regs_init(HalRegs *regs, void *base, RK_U32 img_size, RK_S32 img_cnt)
+{
+    HalRegsImpl *impl = NULL;
+
+    if (NULL == regs || NULL == base || !img_size || img_cnt <= 0) {
+        mpp_err_f("invalid input regs %p base %p size %d count %d\n",
+                  regs, base, img_size, img_cnt);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    mpp_env_get_u32("hal_regs_debug", &hal_regs_debug, 0);
+
+    impl = mpp_calloc_size(HalRegsImpl, sizeof(HalRegsImpl) + sizeof(RK_U32) * img_cnt);
+    if (NULL == impl) {
+        mpp_err_f("failed to malloc context\n");
+        *regs = NULL;
+        return MPP_ERR_MALLOC;
+    }
+
+    impl->base = (RK_U8 *)base;
+    impl->img_size = img_size;
+    impl->img_cnt = img_cnt;
+    impl->clean = (RK_U32 *)(impl + 1);
+
+    *regs = impl;
+
+    return MPP_OK;
+}
+
+MPP_RET hal_regs_deinit(HalRegs regs)
+{
+    MPP_FREE(regs);
+    return MPP_OK;
+}
+
+MPP_RET hal_regs_add(HalRegs regs, RK_U32 pos, RK_U32 size, RK_U32 offset, RK_U32 flag)
+{
+    HalRegsImpl *impl = (HalRegsImpl *)regs;
+    HalRegsSec *sec;
+
+    if (NULL == impl || pos + size > impl->img_size || impl->sec_cnt >= MAX_HAL_REGS_SEC_CNT) {
+        mpp_err_f("invalid section pos %x size %x\n", pos, size);
+        return MPP_NOK;
+    }
+
+    sec = &impl->secs[impl->sec_cnt++];
+    sec->pos = pos;
+    sec->size = size;
+    sec->offset = offset;
+    sec->flag = flag;
+
+    hal_regs_dbg_func("section %d pos %04x size %04x offset %04x flag %x\n",
+                      impl->sec_cnt - 1, pos, size, offset, flag);
+
+    return MPP_OK;
+}
+
+MPP_RET hal_regs_clear(HalRegs regs, RK_S32 idx)
+{
+    HalRegsImpl *impl = (HalRegsImpl *)regs;
+    RK_U8 *img = impl->base + impl->img_size * idx;
+    RK_S32 i;
+
+    for (i = 0; i < impl->sec_cnt; i++) {
+        HalRegsSec *sec = &impl->secs[i];
+
+        if (!(sec->flag & HAL_REGS_SEC_CONST))
+            memset(img + sec->pos, 0, sec->size);
+    }
+
+    return MPP_OK;
+}
+
+MPP_RET hal_regs_invalidate(HalRegs regs)
+{
+    HalRegsImpl *impl = (HalRegsImpl *)regs;
+
+    memset(impl->clean, 0, sizeof(RK_U32) * impl->img_cnt);
+
+    return MPP_OK;
+}
+
+RK_S32 hal_regs_dirty(HalRegs regs, RK_S32 idx, RK_U32 pos)
+{
+    HalRegsImpl *impl = (HalRegsImpl *)regs;
+    RK_S32 i;
+
+    for (i = 0; i < impl->sec_cnt; i++) {
+        HalRegsSec *sec = &impl->secs[i];
+        RK_U32 mask = 1 << i;
+
+        if (sec->pos != pos || !(sec->flag & HAL_REGS_SEC_CONST))
+            continue;
+
+        if (impl->clean[idx] & mask)
+            return 0;
+
+        hal_regs_dbg_dirty("regs %d section %d offset %04x dirty\n", idx, i, sec->offset);
+
+        impl->clean[idx] |= mask;
+        return 1;
+    }
+
+    /* unknown section is always generated */
+    return 1;
+}
+
+MPP_RET hal_regs_write(HalRegs regs, RK_S32 idx, MppDev dev)
+{
+    HalRegsImpl *impl = (HalRegsImpl *)regs;
+    RK_U8 *img = impl->base + impl->img_size * idx;
+    MPP_RET ret = MPP_OK;
+    RK_S32 i;
+
+    for (i = 0; i < impl->sec_cnt; i++) {
+        HalRegsSec *sec = &impl->secs[i];
+        MppDevRegWrCfg wr_cfg;
+
+        wr_cfg.reg = img + sec->pos;
+        wr_cfg.size = sec->size;
+        wr_cfg.offset = sec->offset;
+
+        if (hal_regs_debug & HAL_REGS_DBG_DUMP) {
+            RK_U32 *reg = (RK_U32 *)wr_cfg.reg;
+            RK_U32 j;
+
+            for (j = 0; j < sec->size / sizeof(RK_U32); j++)
+                mpp_log("reg[%04x] = 0x%08x\n", sec->offset + j * 4, reg[j]);
+        }
+
+        ret = mpp_dev_ioctl(dev, MPP_DEV_REG_WR, &wr_cfg);
+        if (ret) {
+            mpp_err_f("set register write failed %d\n", ret);
+            break;
+        }
+    }
+
+    return ret;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HAL_REGS_H__
+#define __HAL_REGS_H__
+
+#include "mpp_device.h"
+
+/*
+ * HalRegs describes the sections of a hal register struct and the hardware
+ * offset each section is written to. One HalRegs covers img_cnt register
+ * structs of the same type placed in an array, e.g. one per task slot.
+ *
+ * Frame sections are cleared before each register generation. Const sections
+ * are kept between frames and only generated again when they are dirty, which
+ * is on the first use of each register struct and after invalidate.
+ *
+ * The kernel driver builds the register image of each task from the written
+ * ranges only and a task may run on any core, so all sections are still
+ * written on every task.
+ */
+#define HAL_REGS_SEC_FRAME      (0x00000000)
+#define HAL_REGS_SEC_CONST      (0x00000001)
+
+typedef void* HalRegs;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET hal_regs_init(HalRegs *regs, void *base, RK_U32 img_size, RK_S32 img_cnt);
+MPP_RET hal_regs_deinit(HalRegs regs);
+
+/* add section at byte position pos of register struct */
+MPP_RET hal_regs_add(HalRegs regs, RK_U32 pos, RK_U32 size, RK_U32 offset, RK_U32 flag);
+
+/* clear frame sections of register struct idx */
+MPP_RET hal_regs_clear(HalRegs regs, RK_S32 idx);
+/* mark const sections of all register structs dirty */
+MPP_RET hal_regs_invalidate(HalRegs regs);
+/* return 1 and mark clean when const section at pos of struct idx is dirty */
+RK_S32 hal_regs_dirty(HalRegs regs, RK_S32 idx, RK_U32 pos);
+
+/* write all sections of register struct idx to device */
+MPP_RET hal_regs_write(HalRegs regs, RK_S32 idx, MppDev dev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HAL_REGS_H__ */
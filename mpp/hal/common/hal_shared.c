@@ -0,0 +1,315 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "hal_shared"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_list.h"
+#include "mpp_debug.h"
+#include "mpp_common.h"
+#include "mpp_buffer_impl.h"
+
+#include "hal_shared.h"
+
+#define HAL_SHARED_DBG_FUNCTION         (0x00000001)
+#define HAL_SHARED_DBG_ALLOC            (0x00000002)
+
+#define hal_shared_dbg(flag, fmt, ...)  _mpp_dbg(hal_shared_debug, flag, fmt, ## __VA_ARGS__)
+#define hal_shared_dbg_f(flag, fmt, ...) _mpp_dbg_f(hal_shared_debug, flag, fmt, ## __VA_ARGS__)
+
+#define hal_shared_dbg_alloc(fmt, ...)  hal_shared_dbg_f(HAL_SHARED_DBG_ALLOC, fmt, ## __VA_ARGS__)
+
+#define HAL_CONST_TAB_NAME_LEN          32
+/* min idle scratch buffers kept for the next lease */
+#define HAL_SCRATCH_IDLE_MAX            4
+
+typedef struct HalConstTab_t {
+    struct list_head    list;
+    char                name[HAL_CONST_TAB_NAME_LEN];
+    size_t              size;
+    RK_S32              ref_count;
+    MppBuffer           buf;
+} HalConstTab;
+
+typedef struct HalScratch_t {
+    struct list_head    list;
+    size_t              size;
+    RK_S32              used;
+    MppBuffer           buf;
+} HalScratch;
+
+static RK_U32 hal_shared_debug = 0;
+static pthread_mutex_t hal_shared_lock = PTHREAD_MUTEX_INITIALIZER;
+static MppBufferGroup hal_shared_group = NULL;
+static LIST_HEAD(hal_const_tabs);
+static LIST_HEAD(hal_scratches);
+static RK_S32 hal_scratch_used = 0;
+static RK_S32 hal_scratch_idle = 0;
+/* max concurrent leases, idle cache grows to it to avoid per run alloc */
+static RK_S32 hal_scratch_peak = 0;
+
+static MPP_RET hal_shared_group_check(void)
+{
+    MppBufAccount *prev;
+    MPP_RET ret;
+
+    if (hal_shared_group)
+        return MPP_OK;
+
+    mpp_env_get_u32("hal_shared_debug", &hal_shared_debug, 0);
+
+    /* shared buffers belong to the process, not to the calling context */
+    prev = mpp_buf_account_attach(NULL);
+    ret = mpp_buffer_group_get_internal(&hal_shared_group, MPP_BUFFER_TYPE_ION);
+    mpp_buf_account_attach(prev);
+
+    if (ret)
+        mpp_err_f("failed to get shared buffer group ret %d\n", ret);
+
+    return ret;
+}
+
+static void hal_scratch_free(HalScratch *scratch)
+{
+    list_del_init(&scratch->list);
+    mpp_buffer_put(scratch->buf);
+    mpp_free(scratch);
+}
+
+/* release everything once the last user has gone */
+static void hal_shared_trim(void)
+{
+    HalScratch *pos, *n;
+
+    if (!list_empty(&hal_const_tabs) || hal_scratch_used)
+        return;
+
+    list_for_each_entry_safe(pos, n, &hal_scratches, HalScratch, list) {
+        hal_scratch_free(pos);
+    }
+    hal_scratch_idle = 0;
+    hal_scratch_peak = 0;
+
+    if (hal_shared_group) {
+        mpp_buffer_group_put(hal_shared_group);
+        hal_shared_group = NULL;
+    }
+}
+
+MPP_RET hal_const_tab_get(MppBuffer *buf, const char *name, const void *data, size_t size)
+{
+    HalConstTab *tab = NULL;
+    HalConstTab *pos, *n;
+    MPP_RET ret = MPP_OK;
+
+    if (NULL == buf || NULL == name || NULL == data || !size) {
+        mpp_err_f("invalid input buf %p name %p data %p size %d\n",
+                  buf, name, data, (RK_S32)size);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    pthread_mutex_lock(&hal_shared_lock);
+
+    list_for_each_entry_safe(pos, n, &hal_const_tabs, HalConstTab, list) {
+        if (pos->size == size && !strncmp(pos->name, name, sizeof(pos->name))) {
+            tab = pos;
+            break;
+        }
+    }
+
+    if (tab) {
+        tab->ref_count++;
+        *buf = tab->buf;
+        goto DONE;
+    }
+
+    ret = hal_shared_group_check();
+    if (ret)
+        goto DONE;
+
+    tab = mpp_calloc(HalConstTab, 1);
+    if (NULL == tab) {
+        ret = MPP_ERR_MALLOC;
+        goto DONE;
+    }
+
+    ret = mpp_buffer_get(hal_shared_group, &tab->buf, size);
+    if (ret) {
+        mpp_err_f("failed to get table %s size %d\n", name, (RK_S32)size);
+        mpp_free(tab);
+        goto DONE;
+    }
+
+    memcpy(mpp_buffer_get_ptr(tab->buf), data, size);
+
+    strncpy(tab->name, name, sizeof(tab->name) - 1);
+    tab->size = size;
+    tab->ref_count = 1;
+    INIT_LIST_HEAD(&tab->list);
+    list_add_tail(&tab->list, &hal_const_tabs);
+    *buf = tab->buf;
+
+    hal_shared_dbg_alloc("table %s size %d created\n", name, (RK_S32)size);
+
+DONE:
+    if (ret) {
+        *buf = NULL;
+        hal_shared_trim();
+    }
+
+    pthread_mutex_unlock(&hal_shared_lock);
+
+    return ret;
+}
+
+MPP_RET hal_const_tab_put(MppBuffer buf)
+{
+    HalConstTab *pos, *n;
+    MPP_RET ret = MPP_NOK;
+
+    if (NULL == buf)
+        return MPP_OK;
+
+    pthread_mutex_lock(&hal_shared_lock);
+
+    list_for_each_entry_safe(pos, n, &hal_const_tabs, HalConstTab, list) {
+        if (pos->buf != buf)
+            continue;
+
+        if (!--pos->ref_count) {
+            hal_shared_dbg_alloc("table %s size %d released\n", pos->name, (RK_S32)pos->size);
+            list_del_init(&pos->list);
+            mpp_buffer_put(pos->buf);
+            mpp_free(pos);
+            hal_shared_trim();
+        }
+        ret = MPP_OK;
+        break;
+    }
+
+    pthread_mutex_unlock(&hal_shared_lock);
+
+    if (ret)
+        mpp_err_f("buffer %p is not a shared table\n", buf);
+
+    return ret;
+}
+
+MPP_RET hal_scratch_get(MppBuffer *buf, size_t size)
+{
+    HalScratch *scratch = NULL;
+    HalScratch *pos, *n;
+    MPP_RET ret = MPP_OK;
+
+    if (NULL == buf || !size) {
+        mpp_err_f("invalid input buf %p size %d\n", buf, (RK_S32)size);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    pthread_mutex_lock(&hal_shared_lock);
+
+    /* best fit in idle buffers, do not waste more than half of a buffer */
+    list_for_each_entry_safe(pos, n, &hal_scratches, HalScratch, list) {
+        if (pos->used || pos->size < size || pos->size > size * 2)
+            continue;
+
+        if (NULL == scratch || pos->size < scratch->size)
+            scratch = pos;
+    }
+
+    if (scratch) {
+        hal_scratch_idle--;
+        goto DONE;
+    }
+
+    ret = hal_shared_group_check();
+    if (ret)
+        goto DONE;
+
+    scratch = mpp_calloc(HalScratch, 1);
+    if (NULL == scratch) {
+        ret = MPP_ERR_MALLOC;
+        goto DONE;
+    }
+
+    ret = mpp_buffer_get(hal_shared_group, &scratch->buf, size);
+    if (ret) {
+        mpp_err_f("failed to get scratch size %d\n", (RK_S32)size);
+        mpp_free(scratch);
+        scratch = NULL;
+        goto DONE;
+    }
+
+    scratch->size = size;
+    INIT_LIST_HEAD(&scratch->list);
+    list_add_tail(&scratch->list, &hal_scratches);
+
+    hal_shared_dbg_alloc("scratch size %d created\n", (RK_S32)size);
+
+DONE:
+    if (scratch) {
+        scratch->used = 1;
+        hal_scratch_used++;
+        if (hal_scratch_peak < hal_scratch_used)
+            hal_scratch_peak = hal_scratch_used;
+        *buf = scratch->buf;
+    } else {
+        *buf = NULL;
+        hal_shared_trim();
+    }
+
+    pthread_mutex_unlock(&hal_shared_lock);
+
+    return ret;
+}
+
+MPP_RET hal_scratch_put(MppBuffer buf)
+{
+    HalScratch *pos, *n;
+    MPP_RET ret = MPP_NOK;
+
+    if (NULL == buf)
+        return MPP_OK;
+
+    pthread_mutex_lock(&hal_shared_lock);
+
+    list_for_each_entry_safe(pos, n, &hal_scratches, HalScratch, list) {
+        if (pos->buf != buf || !pos->used)
+            continue;
+
+        pos->used = 0;
+        hal_scratch_used--;
+
+        if (hal_scratch_idle < MPP_MAX(HAL_SCRATCH_IDLE_MAX, hal_scratch_peak))
+            hal_scratch_idle++;
+        else
+            hal_scratch_free(pos);
+
+        hal_shared_trim();
+        ret = MPP_OK;
+        break;
+    }
+
+    pthread_mutex_unlock(&hal_shared_lock);
+
+    if (ret)
+        mpp_err_f("buffer %p is not a leased scratch\n", buf);
+
+    return ret;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HAL_SHARED_H__
+#define __HAL_SHARED_H__
+
+#include "mpp_buffer.h"
+
+/*
+ * Process wide hardware buffers shared by all hal contexts.
+ *
+ * Constant table: read-only table (cabac / probability init table etc.)
+ * which is identical for every context of the same codec. The first get
+ * allocates and fills the buffer, later gets with the same name only take
+ * a reference. The buffer must NOT be written by the hardware.
+ *
+ * Scratch: hardware working buffer (rcb etc.) whose content does not need
+ * to live across frames. It is leased right before the hardware run and
+ * returned after wait, so the memory follows the hardware runs in flight
+ * instead of the context count.
+ *
+ * Returned scratch buffers are cached for the next lease. The cache keeps
+ * at least a few buffers and grows to the max concurrent leases seen, so
+ * steady state leases only take the pool lock without any allocation. All
+ * of them are released when the last constant table is put and no scratch
+ * is leased, i.e. when the last hal context using this module is gone.
+ *
+ * Buffers here are not charged to any context memory account.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET hal_const_tab_get(MppBuffer *buf, const char *name, const void *data, size_t size);
+MPP_RET hal_const_tab_put(MppBuffer buf);
+
+MPP_RET hal_scratch_get(MppBuffer *buf, size_t size);
+MPP_RET hal_scratch_put(MppBuffer buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HAL_SHARED_H__ */
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "hal_dummy_enc_v2"
+
+#include <string.h>
+
+#include "mpp_common.h"
+#include "mpp_packet.h"
+
+#include "hal_dummy_enc_api_v2.h"
+
+static MPP_RET hal_dummy_enc_v2_init(void *hal, MppEncHalCfg *cfg)
+{
+    (void)hal;
+
+    cfg->type = VPU_CLIENT_BUTT;
+    cfg->dev = NULL;
+    cfg->cap_recn_out = 0;
+    cfg->cap_pkt_ring = 0;
+
+    return MPP_OK;
+}
+
+static MPP_RET hal_dummy_enc_v2_deinit(void *hal)
+{
+    (void)hal;
+    return MPP_OK;
+}
+
+static MPP_RET hal_dummy_enc_v2_task(void *hal, HalEncTask *task)
+{
+    (void)hal;
+    (void)task;
+    return MPP_OK;
+}
+
+static MPP_RET hal_dummy_enc_v2_wait(void *hal, HalEncTask *task)
+{
+    MppPacket packet = task->packet;
+    RK_U8 *base = (RK_U8 *)mpp_packet_get_data(packet);
+    RK_U8 *dst = (RK_U8 *)mpp_packet_get_pos(packet) + task->length;
+    RK_S32 room = (RK_S32)mpp_packet_get_size(packet) - (RK_S32)(dst - base);
+    RK_S32 size = MPP_MAX(task->rc_task->info.bit_target / 8, 1);
+
+    (void)hal;
+
+    size = MPP_MIN(size, room);
+    if (size < 0)
+        size = 0;
+
+    memset(dst, 0, size);
+    task->hw_length = size;
+
+    return MPP_OK;
+}
+
+static MPP_RET hal_dummy_enc_v2_ret_task(void *hal, HalEncTask *task)
+{
+    EncRcTaskInfo *rc_info = &task->rc_task->info;
+
+    (void)hal;
+
+    task->length += task->hw_length;
+
+    rc_info->bit_real = task->hw_length * 8;
+    rc_info->quality_real = rc_info->quality_target;
+
+    task->hal_ret.data = NULL;
+    task->hal_ret.number = 0;
+
+    return MPP_OK;
+}
+
+const MppEncHalApi hal_api_dummy_enc_v2 = {
+    .name       = "hal_dummy_enc_v2",
+    .coding     = MPP_VIDEO_CodingUnused,
+    .ctx_size   = 0,
+    .flag       = 0,
+    .init       = hal_dummy_enc_v2_init,
+    .deinit     = hal_dummy_enc_v2_deinit,
+    .prepare    = NULL,
+    .get_task   = hal_dummy_enc_v2_task,
+    .gen_regs   = hal_dummy_enc_v2_task,
+    .start      = hal_dummy_enc_v2_task,
+    .wait       = hal_dummy_enc_v2_wait,
+    .part_start = NULL,
+    .part_wait  = NULL,
+    .ret_task   = hal_dummy_enc_v2_ret_task,
+};
@@ -63,7 +63,10 @@ typedef union HalDecTaskFlag_t {
         RK_U32      used_for_ref     : 1;
 
         RK_U32      wait_done        : 1;
-        RK_U32      reserved0        : 2;
+        /* task is decoded by software backend instead of hardware */
+        RK_U32      soft_dec         : 1;
+        /* task is counted in the hardware load of hal until wait */
+        RK_U32      hw_load          : 1;
         RK_U32      ref_miss         : 8;
         RK_U32      ref_used         : 8;
     };
@@ -0,0 +1,38 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HAL_DUMMY_ENC_API_V2_H__
+#define __HAL_DUMMY_ENC_API_V2_H__
+
+#include "mpp_enc_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Encoder hal without hardware access. Selected for every coding by
+ * mpp_enc_hal_init when env mpp_hal_dummy is set. It emits zero filled
+ * stream of the rate control target size so the controller and the task
+ * flow can be exercised on hosts without encoder device.
+ */
+extern const MppEncHalApi hal_api_dummy_enc_v2;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__HAL_DUMMY_ENC_API_V2_H__*/
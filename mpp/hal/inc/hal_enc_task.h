@@ -30,6 +30,7 @@
 #define HAL_ENC_TASK_ERR_GENREG       0x00001000
 #define HAL_ENC_TASK_ERR_START        0x00010000
 #define HAL_ENC_TASK_ERR_WAIT         0x00100000
+#define HAL_ENC_TASK_ERR_OVERFLOW     0x01000000
 
 typedef struct HalEncTaskFlag_t {
     RK_U32          err;
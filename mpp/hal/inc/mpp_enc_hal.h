@@ -32,6 +32,8 @@ typedef struct MppEncHalCfg_t {
     MppClientType   type;
     MppDev          dev;
     RK_S32          cap_recn_out;
+    /* hal supports output packet in the middle of buffer and overflow report */
+    RK_S32          cap_pkt_ring;
     HalTaskGroup    tasks;
 } MppEncHalCfg;
 
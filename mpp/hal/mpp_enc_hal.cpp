@@ -16,6 +16,7 @@
 
 #define  MODULE_TAG "mpp_enc_hal"
 
+#include "mpp_env.h"
 #include "mpp_mem.h"
 #include "mpp_log.h"
 #include "mpp_common.h"
@@ -28,6 +29,7 @@
 #include "hal_h265e_api_v2.h"
 #include "hal_jpege_api_v2.h"
 #include "hal_vp8e_api_v2.h"
+#include "hal_dummy_enc_api_v2.h"
 
 static const MppEncHalApi *hw_enc_apis[] = {
 #if HAVE_H264E
@@ -67,16 +69,21 @@ MPP_RET mpp_enc_hal_init(MppEncHal *ctx, MppEncHalCfg *cfg)
         return MPP_ERR_MALLOC;
     }
 
+    RK_U32 hal_dummy = 0;
     RK_U32 i;
+
+    /* env mpp_hal_dummy runs all encoders without hardware for benchmark */
+    mpp_env_get_u32("mpp_hal_dummy", &hal_dummy, 0);
+
     for (i = 0; i < MPP_ARRAY_ELEMS(hw_enc_apis); i++) {
         if (cfg->coding == hw_enc_apis[i]->coding) {
             p->coding       = cfg->coding;
-            p->api          = hw_enc_apis[i];
+            p->api          = hal_dummy ? &hal_api_dummy_enc_v2 : hw_enc_apis[i];
             p->ctx          = mpp_calloc_size(void, p->api->ctx_size);
 
             MPP_RET ret = p->api->init(p->ctx, cfg);
             if (ret) {
-                mpp_err_f("hal %s init failed ret %d\n", hw_enc_apis[i]->name, ret);
+                mpp_err_f("hal %s init failed ret %d\n", p->api->name, ret);
                 break;
             }
 
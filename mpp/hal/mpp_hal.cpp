@@ -16,6 +16,7 @@
 
 #define  MODULE_TAG "mpp_hal"
 
+#include "mpp_env.h"
 #include "mpp_mem.h"
 #include "mpp_log.h"
 #include "mpp_common.h"
@@ -103,16 +104,27 @@ MPP_RET mpp_hal_init(MppHal *ctx, MppHalCfg *cfg)
         return MPP_ERR_MALLOC;
     }
 
+    RK_U32 hal_dummy = 0;
     RK_U32 i;
+
+    /*
+     * env mpp_hal_dummy runs decoders without hardware for benchmark.
+     * jpeg decoder runs frame in frame out and keeps the real hal.
+     */
+    mpp_env_get_u32("mpp_hal_dummy", &hal_dummy, 0);
+
     for (i = 0; i < MPP_ARRAY_ELEMS(hw_apis); i++) {
         if (cfg->type   == hw_apis[i]->type &&
             cfg->coding == hw_apis[i]->coding) {
             p->api  = hw_apis[i];
+            if (hal_dummy && cfg->type == MPP_CTX_DEC &&
+                cfg->coding != MPP_VIDEO_CodingMJPEG)
+                p->api = &hal_api_dummy_dec;
             p->ctx  = mpp_calloc_size(void, p->api->ctx_size);
 
             MPP_RET ret = p->api->init(p->ctx, cfg);
             if (ret) {
-                mpp_err_f("hal %s init failed ret %d\n", hw_apis[i]->name, ret);
+                mpp_err_f("hal %s init failed ret %d\n", p->api->name, ret);
                 break;
             }
 
@@ -28,6 +28,7 @@
 
 #include "mpp_device.h"
 
+#include "hal_shared.h"
 #include "hal_h264d_global.h"
 #include "hal_h264d_vdpu34x.h"
 #include "vdpu34x_h264d.h"
@@ -36,14 +37,12 @@
 /* Number registers for the decoder */
 #define DEC_VDPU34X_REGISTERS       276
 
-#define VDPU34X_CABAC_TAB_SIZE      (928*4 + 128)       /* bytes */
 #define VDPU34X_SPSPPS_SIZE         (256*48 + 128)      /* bytes */
 #define VDPU34X_RPS_SIZE            (128 + 128 + 128)   /* bytes */
 #define VDPU34X_SCALING_LIST_SIZE   (6*16+2*64 + 128)   /* bytes */
 #define VDPU34X_ERROR_INFO_SIZE     (256*144*4)         /* bytes */
 #define H264_CTU_SIZE               16
 
-#define VDPU34X_CABAC_TAB_ALIGNED_SIZE      (MPP_ALIGN(VDPU34X_CABAC_TAB_SIZE, SZ_4K))
 #define VDPU34X_ERROR_INFO_ALIGNED_SIZE     (0)
 #define VDPU34X_SPSPPS_ALIGNED_SIZE         (MPP_ALIGN(VDPU34X_SPSPPS_SIZE, SZ_4K))
 #define VDPU34X_RPS_ALIGNED_SIZE            (MPP_ALIGN(VDPU34X_RPS_SIZE, SZ_4K))
@@ -52,8 +51,7 @@
                                              VDPU34X_RPS_ALIGNED_SIZE + \
                                              VDPU34X_SCALING_LIST_ALIGNED_SIZE)
 
-#define VDPU34X_CABAC_TAB_OFFSET            (0)
-#define VDPU34X_ERROR_INFO_OFFSET           (VDPU34X_CABAC_TAB_OFFSET + VDPU34X_CABAC_TAB_ALIGNED_SIZE)
+#define VDPU34X_ERROR_INFO_OFFSET           (0)
 #define VDPU34X_STREAM_INFO_OFFSET_BASE     (VDPU34X_ERROR_INFO_OFFSET + VDPU34X_ERROR_INFO_ALIGNED_SIZE)
 #define VDPU34X_SPSPPS_OFFSET(pos)          (VDPU34X_STREAM_INFO_OFFSET_BASE + (VDPU34X_STREAM_INFO_SET_SIZE * pos))
 #define VDPU34X_RPS_OFFSET(pos)             (VDPU34X_SPSPPS_OFFSET(pos) + VDPU34X_SPSPPS_ALIGNED_SIZE)
@@ -137,7 +135,8 @@ typedef struct Vdpu34xH264dRegCtx_t {
     MppBuffer           bufs;
     RK_S32              bufs_fd;
     void                *bufs_ptr;
-    RK_U32              offset_cabac;
+    /* cabac table shared by all contexts */
+    MppBuffer           cabac_buf;
     RK_U32              offset_errinfo;
     RK_U32              offset_spspps[VDPU34X_FAST_REG_SET_CNT];
     RK_U32              offset_rps[VDPU34X_FAST_REG_SET_CNT];
@@ -158,6 +157,7 @@ typedef struct Vdpu34xH264dRegCtx_t {
 
     RK_S32              rcb_buf_size;
     Vdpu34xRcbInfo      rcb_info[RCB_BUF_COUNT];
+    /* rcb buffers leased from shared scratch from gen_regs to wait */
     MppBuffer           rcb_buf[VDPU34X_FAST_REG_SET_CNT];
 
     Vdpu34xH264dRegSet  *regs;
@@ -666,8 +666,7 @@ static MPP_RET set_registers(H264dHalCtx_t *p_hal, Vdpu34xH264dRegSet *regs, Hal
         regs->common_addr.reg128_rlc_base = mpp_buffer_get_fd(mbuffer);
         regs->common_addr.reg129_rlcwrite_base = regs->common_addr.reg128_rlc_base;
 
-        regs->h264d_addr.cabactbl_base = reg_ctx->bufs_fd;
-        mpp_dev_set_reg_offset(p_hal->dev, 197, reg_ctx->offset_cabac);
+        regs->h264d_addr.cabactbl_base = mpp_buffer_get_fd(reg_ctx->cabac_buf);
     }
 
     return MPP_OK;
@@ -727,7 +726,6 @@ MPP_RET vdpu34x_h264d_init(void *hal, MppHalCfg *cfg)
                                    VDPU34X_INFO_BUFFER_SIZE(max_cnt)));
     reg_ctx->bufs_fd = mpp_buffer_get_fd(reg_ctx->bufs);
     reg_ctx->bufs_ptr = mpp_buffer_get_ptr(reg_ctx->bufs);
-    reg_ctx->offset_cabac = VDPU34X_CABAC_TAB_OFFSET;
     reg_ctx->offset_errinfo = VDPU34X_ERROR_INFO_OFFSET;
     for (i = 0; i < max_cnt; i++) {
         reg_ctx->reg_buf[i].regs = mpp_calloc(Vdpu34xH264dRegSet, 1);
@@ -744,9 +742,9 @@ MPP_RET vdpu34x_h264d_init(void *hal, MppHalCfg *cfg)
         reg_ctx->sclst_offset = reg_ctx->offset_sclst[0];
     }
 
-    //!< copy cabac table bytes
-    memcpy((char *)reg_ctx->bufs_ptr + reg_ctx->offset_cabac,
-           (void *)rkv_cabac_table_v34x, sizeof(rkv_cabac_table_v34x));
+    //!< get shared cabac table
+    FUN_CHECK(ret = hal_const_tab_get(&reg_ctx->cabac_buf, "vdpu34x_h264d_cabac",
+                                      rkv_cabac_table_v34x, sizeof(rkv_cabac_table_v34x)));
 
     mpp_slots_set_prop(p_hal->frame_slots, SLOTS_HOR_ALIGN, rkv_hor_align);
     mpp_slots_set_prop(p_hal->frame_slots, SLOTS_VER_ALIGN, rkv_ver_align);
@@ -785,6 +783,8 @@ MPP_RET vdpu34x_h264d_deinit(void *hal)
     RK_U32 loop = p_hal->fast_mode ? MPP_ARRAY_ELEMS(reg_ctx->reg_buf) : 1;
 
     mpp_buffer_put(reg_ctx->bufs);
+    hal_const_tab_put(reg_ctx->cabac_buf);
+    reg_ctx->cabac_buf = NULL;
 
     for (i = 0; i < loop; i++)
         MPP_FREE(reg_ctx->reg_buf[i].regs);
@@ -792,7 +792,7 @@ MPP_RET vdpu34x_h264d_deinit(void *hal)
     loop = p_hal->fast_mode ? MPP_ARRAY_ELEMS(reg_ctx->rcb_buf) : 1;
     for (i = 0; i < loop; i++) {
         if (reg_ctx->rcb_buf[i]) {
-            mpp_buffer_put(reg_ctx->rcb_buf[i]);
+            hal_scratch_put(reg_ctx->rcb_buf[i]);
             reg_ctx->rcb_buf[i] = NULL;
         }
     }
@@ -874,21 +874,8 @@ static void hal_h264d_rcb_info_update(void *hal, Vdpu34xH264dRegSet *regs)
          ctx->mbaff != mbaff ||
          ctx->width != width ||
          ctx->height != height) {
-        RK_U32 i;
-        RK_U32 loop = p_hal->fast_mode ? MPP_ARRAY_ELEMS(ctx->reg_buf) : 1;
-
         ctx->rcb_buf_size = get_rcb_buf_size(ctx->rcb_info, width, height);
         h264d_refine_rcb_size(hal, ctx->rcb_info, regs, width, height);
-        for (i = 0; i < loop; i++) {
-            MppBuffer rcb_buf = ctx->rcb_buf[i];
-
-            if (rcb_buf) {
-                mpp_buffer_put(rcb_buf);
-                ctx->rcb_buf[i] = NULL;
-            }
-            mpp_buffer_get(p_hal->buf_group, &rcb_buf, ctx->rcb_buf_size);
-            ctx->rcb_buf[i] = rcb_buf;
-        }
         ctx->bit_depth      = bit_depth;
         ctx->width          = width;
         ctx->height         = height;
@@ -996,9 +983,18 @@ MPP_RET vdpu34x_h264d_gen_regs(void *hal, HalTaskInfo *task)
     }
 
     hal_h264d_rcb_info_update(p_hal, regs);
-    vdpu34x_setup_rcb(&regs->common_addr, p_hal->dev, p_hal->fast_mode ?
-                      ctx->rcb_buf[task->dec.reg_index] : ctx->rcb_buf[0],
-                      ctx->rcb_info);
+    {
+        RK_U32 idx = p_hal->fast_mode ? task->dec.reg_index : 0;
+
+        /* leased for the hardware run only and returned in wait */
+        if (hal_scratch_get(&ctx->rcb_buf[idx], ctx->rcb_buf_size)) {
+            mpp_err_f("failed to get rcb buffer size %d\n", ctx->rcb_buf_size);
+            task->dec.flags.parse_err = 1;
+            goto __RETURN;
+        }
+        vdpu34x_setup_rcb(&regs->common_addr, p_hal->dev, ctx->rcb_buf[idx],
+                          ctx->rcb_info);
+    }
     vdpu34x_setup_statistic(&regs->common, &regs->statistic);
 
 __RETURN:
@@ -1147,7 +1143,16 @@ MPP_RET vdpu34x_h264d_wait(void *hal, HalTaskInfo *task)
     if (ret)
         mpp_err_f("poll cmd failed %d\n", ret);
 
-__SKIP_HARD:
+__SKIP_HARD: {
+        RK_U32 idx = p_hal->fast_mode ? task->dec.reg_index : 0;
+
+        /* hardware is done with rcb, return it for the other contexts */
+        if (reg_ctx->rcb_buf[idx]) {
+            hal_scratch_put(reg_ctx->rcb_buf[idx]);
+            reg_ctx->rcb_buf[idx] = NULL;
+        }
+    }
+
     if (p_hal->dec_cb) {
         DecCbHalDone param;
 
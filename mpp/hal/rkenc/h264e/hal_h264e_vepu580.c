@@ -16,6 +16,7 @@
 
 #define MODULE_TAG "hal_h264e_vepu580"
 
+#include <stddef.h>
 #include <string.h>
 
 #include "mpp_env.h"
@@ -32,13 +33,13 @@
 
 #include "hal_h264e_debug.h"
 #include "hal_bufs.h"
+#include "hal_regs.h"
 #include "mpp_enc_hal.h"
 #include "vepu541_common.h"
 #include "hal_h264e_vepu580_reg.h"
 #include "mpp_enc_cb_param.h"
 
-#define DUMP_REG 0
-#define MAX_TASK_CNT        2
+#define MAX_TASK_CNT        4
 
 typedef struct HalH264eVepu580Ctx_t {
     MppEncCfgSet            *cfg;
@@ -54,6 +55,8 @@ typedef struct HalH264eVepu580Ctx_t {
     RK_S32                  pixel_buf_size;
     RK_S32                  thumb_buf_size;
     RK_S32                  max_buf_cnt;
+    /* recon buffers used by current pipeline depth, allocated on prepare */
+    RK_S32                  pre_buf_cnt;
     MppDevRegOffCfgs        *offsets;
 
     /* external line buffer over 4K */
@@ -89,6 +92,7 @@ typedef struct HalH264eVepu580Ctx_t {
 
     /* register */
     HalVepu580RegSet        *regs_sets;
+    HalRegs                 regs_secs;
 
     /* frame parallel info */
     RK_S32                  task_idx;
@@ -150,11 +154,23 @@ static RK_S32 h264_I_aq_step_default[16] = {
 
 #include "hal_h264e_vepu580_tune.c"
 
+/* register sets in round robin, tasks beyond pipeline depth are never used */
+static RK_S32 get_task_depth(HalH264eVepu580Ctx *ctx)
+{
+    RK_S32 depth = ctx->cfg->base.pipe_depth;
+
+    if (!depth)
+        depth = MPP_ENC_PIPE_DEPTH_DEFAULT;
+
+    return MPP_MIN(depth, (RK_S32)ctx->task_cnt);
+}
+
 static void setup_ext_line_bufs(HalH264eVepu580Ctx *ctx)
 {
     RK_U32 i;
 
-    for (i = 0; i < ctx->task_cnt; i++) {
+    /* buffers of the tasks beyond default pipeline depth are got on use */
+    for (i = 0; i < (RK_U32)MPP_MIN(get_task_depth(ctx), MPP_ENC_PIPE_DEPTH_DEFAULT); i++) {
         if (ctx->ext_line_bufs[i])
             continue;
 
@@ -188,6 +204,11 @@ static MPP_RET hal_h264e_vepu580_deinit(void *hal)
 
     clear_ext_line_bufs(p);
 
+    if (p->regs_secs) {
+        hal_regs_deinit(p->regs_secs);
+        p->regs_secs = NULL;
+    }
+
     MPP_FREE(p->regs_sets);
     MPP_FREE(p->poll_cfgs);
 
@@ -247,13 +268,39 @@ static MPP_RET hal_h264e_vepu580_init(void *hal, MppEncHalCfg *cfg)
         goto DONE;
     }
 
-    p->regs_sets = mpp_malloc(HalVepu580RegSet, p->task_cnt);
+    p->regs_sets = mpp_calloc(HalVepu580RegSet, p->task_cnt);
     if (NULL == p->regs_sets) {
         ret = MPP_ERR_MALLOC;
         mpp_err_f("init register buffer failed\n");
         goto DONE;
     }
 
+    ret = hal_regs_init(&p->regs_secs, p->regs_sets, sizeof(HalVepu580RegSet), p->task_cnt);
+    if (ret) {
+        mpp_err_f("init register sections failed\n");
+        goto DONE;
+    }
+
+    {
+        HalRegs secs = p->regs_secs;
+
+        hal_regs_add(secs, offsetof(HalVepu580RegSet, reg_ctl), sizeof(Vepu580ControlCfg),
+                     VEPU580_CONTROL_CFG_OFFSET, HAL_REGS_SEC_FRAME);
+        hal_regs_add(secs, offsetof(HalVepu580RegSet, reg_base), sizeof(Vepu580BaseCfg),
+                     VEPU580_BASE_CFG_OFFSET, HAL_REGS_SEC_FRAME);
+        hal_regs_add(secs, offsetof(HalVepu580RegSet, reg_rc_klut), sizeof(Vepu580RcKlutCfg),
+                     VEPU580_RC_KLUT_CFG_OFFSET, HAL_REGS_SEC_FRAME);
+        hal_regs_add(secs, offsetof(HalVepu580RegSet, reg_s3), sizeof(Vepu580Section3),
+                     VEPU580_SECTION_3_OFFSET, HAL_REGS_SEC_FRAME);
+        hal_regs_add(secs, offsetof(HalVepu580RegSet, reg_rdo), sizeof(Vepu580RdoCfg),
+                     VEPU580_RDO_CFG_OFFSET, HAL_REGS_SEC_FRAME);
+        /* scaling list table is fixed for the whole session */
+        hal_regs_add(secs, offsetof(HalVepu580RegSet, reg_scl), sizeof(Vepu580SclCfg),
+                     VEPU580_SCL_CFG_OFFSET, HAL_REGS_SEC_CONST);
+        hal_regs_add(secs, offsetof(HalVepu580RegSet, reg_osd), sizeof(Vepu580Osd),
+                     VEPU580_OSD_OFFSET, HAL_REGS_SEC_FRAME);
+    }
+
     p->poll_slice_max = 8;
     p->poll_cfg_size = (sizeof(p->poll_cfgs) + sizeof(RK_S32) * p->poll_slice_max);
     p->poll_cfgs = mpp_malloc_size(MppDevPollCfg, p->poll_cfg_size * p->task_cnt);
@@ -296,6 +343,7 @@ static MPP_RET hal_h264e_vepu580_init(void *hal, MppEncHalCfg *cfg)
     p->output_cb = cfg->output_cb;
 
     cfg->cap_recn_out = 1;
+    cfg->cap_pkt_ring = 1;
 
 DONE:
     if (ret)
@@ -323,14 +371,26 @@ static void setup_hal_bufs(HalH264eVepu580Ctx *ctx)
     RK_S32 thumb_buf_size = MPP_ALIGN(aligned_w / 64 * aligned_h / 64 * 256, SZ_8K);
     RK_S32 old_max_cnt = ctx->max_buf_cnt;
     RK_S32 new_max_cnt = 4;
+    RK_S32 pre_buf_cnt = 4;
+    /*
+     * Non-reference frames in hardware hold recon buffers besides dpb. The
+     * buffer slots cover the max pipeline depth of the task count, so that a
+     * deeper pipe_depth on runtime does not reallocate recon buffers. Slots
+     * beyond current depth are only allocated when dpb uses them.
+     */
+    RK_S32 pipe_max = MPP_MAX(MPP_MIN(MPP_ENC_PIPE_DEPTH_MAX, (RK_S32)ctx->task_cnt) - 1, 1);
+    RK_S32 pipe_cnt = MPP_MAX(get_task_depth(ctx) - 1, 1);
     MppEncRefCfg ref_cfg = cfg->ref_cfg;
 
     if (ref_cfg) {
         MppEncCpbInfo *info = mpp_enc_ref_cfg_get_cpb_info(ref_cfg);
-        if (new_max_cnt < MPP_MAX(new_max_cnt, info->dpb_size + 1))
-            new_max_cnt = MPP_MAX(new_max_cnt, info->dpb_size + 1);
+
+        new_max_cnt = MPP_MAX(new_max_cnt, info->dpb_size + pipe_max);
+        pre_buf_cnt = MPP_MAX(pre_buf_cnt, info->dpb_size + pipe_cnt);
     }
 
+    ctx->pre_buf_cnt = MPP_MIN(pre_buf_cnt, new_max_cnt);
+
     if (aligned_w > SZ_4K) {
         /* 480 bytes for each ctu above 3072 */
         RK_S32 ext_line_buf_size = (aligned_w - 3 * SZ_1K) / 64 * 480;
@@ -395,7 +455,7 @@ static MPP_RET hal_h264e_vepu580_prepare(void *hal)
 
         // pre-alloc required buffers to reduce first frame delay
         setup_hal_bufs(ctx);
-        for (i = 0; i < ctx->max_buf_cnt; i++)
+        for (i = 0; i < ctx->pre_buf_cnt; i++)
             hal_bufs_get_buf(ctx->hw_recn, i);
 
         prep->change = 0;
@@ -474,6 +534,16 @@ static MPP_RET hal_h264e_vepu580_get_task(void *hal, HalEncTask *task)
         mpp_meta_get_ptr_d(meta, KEY_OSD_DATA2, (void **)&ctx->osd_cfg.osd_data2, NULL);
     }
 
+    if (ctx->ext_line_buf_size && NULL == ctx->ext_line_bufs[ctx->task_idx]) {
+        mpp_buffer_get(ctx->ext_line_buf_grp, &ctx->ext_line_bufs[ctx->task_idx],
+                       ctx->ext_line_buf_size);
+        if (NULL == ctx->ext_line_bufs[ctx->task_idx]) {
+            mpp_err_f("failed to get ext line buffer size %d\n", ctx->ext_line_buf_size);
+            task->flags.err |= HAL_ENC_TASK_ERR_ALLOC;
+            return MPP_ERR_MALLOC;
+        }
+    }
+
     if (ctx->dpb) {
         h264e_dpb_hal_start(ctx->dpb, frms->curr_idx);
         h264e_dpb_hal_start(ctx->dpb, frms->refr_idx);
@@ -490,7 +560,7 @@ static MPP_RET hal_h264e_vepu580_get_task(void *hal, HalEncTask *task)
     ctx->osd_cfg.reg_base = &ctx->regs_set->reg_osd;
 
     if (ctx->task_cnt > 1)
-        ctx->task_idx = !ctx->task_idx;
+        ctx->task_idx = (ctx->task_idx + 1) % get_task_depth(ctx);
 
     hal_h264e_dbg_func("leave %p\n", hal);
 
@@ -1298,7 +1368,9 @@ static void setup_vepu580_io_buf(HalVepu580RegSet *regs, MppDevRegOffCfgs *offse
     RK_S32 ver_stride = mpp_frame_get_ver_stride(frm);
     RK_S32 fd_in = mpp_buffer_get_fd(buf_in);
     RK_U32 off_in[2] = {0};
-    RK_U32 off_out = mpp_packet_get_length(pkt);
+    /* packet may be a region in the middle of output buffer */
+    RK_U32 off_bs = (RK_U8 *)mpp_packet_get_data(pkt) - (RK_U8 *)mpp_buffer_get_ptr(buf_out);
+    RK_U32 off_out = off_bs + mpp_packet_get_length(pkt);
     size_t siz_out = mpp_buffer_get_size(buf_out);
     RK_S32 fd_out = mpp_buffer_get_fd(buf_out);
 
@@ -1363,6 +1435,15 @@ static void setup_vepu580_io_buf(HalVepu580RegSet *regs, MppDevRegOffCfgs *offse
 
     mpp_dev_multi_offset_update(offsets, 161, off_in[0]);
     mpp_dev_multi_offset_update(offsets, 162, off_in[1]);
+    /* bound stream by packet size for overflow report */
+    if (mpp_packet_get_size(pkt))
+        siz_out = MPP_MIN(siz_out, off_bs + mpp_packet_get_size(pkt));
+
+    if (off_bs) {
+        mpp_dev_multi_offset_update(offsets, 173, off_bs);
+        mpp_dev_multi_offset_update(offsets, 174, off_bs);
+    }
+
     mpp_dev_multi_offset_update(offsets, 172, siz_out);
     mpp_dev_multi_offset_update(offsets, 175, off_out);
 
@@ -1899,13 +1980,14 @@ static MPP_RET hal_h264e_vepu580_gen_regs(void *hal, HalEncTask *task)
     H264eSlice *slice = ctx->slice;
     EncRcTask *rc_task = task->rc_task;
     EncFrmStatus *frm = &rc_task->frm;
+    RK_S32 regs_idx = regs - ctx->regs_sets;
     MPP_RET ret = MPP_OK;
 
     hal_h264e_dbg_func("enter %p\n", hal);
     hal_h264e_dbg_detail("frame %d generate regs now", ctx->frms->seq_idx);
 
     /* register setup */
-    memset(regs, 0, sizeof(*regs));
+    hal_regs_clear(ctx->regs_secs, regs_idx);
 
     setup_vepu580_normal(regs);
     ret = setup_vepu580_prep(regs, &ctx->cfg->prep, task);
@@ -1917,7 +1999,8 @@ static MPP_RET hal_h264e_vepu580_gen_regs(void *hal, HalEncTask *task)
     setup_vepu580_rdo_pred(regs, sps, pps, slice);
     setup_vepu580_rdo_cfg(&regs->reg_rdo);
     setup_vepu580_rdo_bias_cfg(&regs->reg_rdo, &cfg->hw);
-    setup_vepu580_scl_cfg(&regs->reg_scl);
+    if (hal_regs_dirty(ctx->regs_secs, regs_idx, offsetof(HalVepu580RegSet, reg_scl)))
+        setup_vepu580_scl_cfg(&regs->reg_scl);
     setup_vepu580_rc_base(regs, sps, slice, &cfg->hw, rc_task);
     setup_vepu580_io_buf(regs, ctx->offsets, task);
     setup_vepu580_roi(regs, ctx);
@@ -1975,84 +2058,11 @@ static MPP_RET hal_h264e_vepu580_start(void *hal, HalEncTask *task)
     hal_h264e_dbg_func("enter %p\n", hal);
 
     do {
-        MppDevRegWrCfg wr_cfg;
         MppDevRegRdCfg rd_cfg;
 
-        wr_cfg.reg = &regs->reg_ctl;
-        wr_cfg.size = sizeof(regs->reg_ctl);
-        wr_cfg.offset = VEPU580_CONTROL_CFG_OFFSET;
-#if DUMP_REG
-        {
-            RK_U32 i;
-            RK_U32 *reg = (RK_U32)wr_cfg.reg;
-            for ( i = 0; i < sizeof(regs->reg_ctl) / sizeof(RK_U32); i++) {
-                /* code */
-                mpp_log("reg[%d] = 0x%08x\n", i, reg[i]);
-            }
-
-        }
-#endif
-        ret = mpp_dev_ioctl(ctx->dev, MPP_DEV_REG_WR, &wr_cfg);
-        if (ret) {
-            mpp_err_f("set register write failed %d\n", ret);
-            break;
-        }
-        wr_cfg.reg = &regs->reg_base;
-        wr_cfg.size = sizeof(regs->reg_base);
-        wr_cfg.offset = VEPU580_BASE_CFG_OFFSET;
-
-        ret = mpp_dev_ioctl(ctx->dev, MPP_DEV_REG_WR, &wr_cfg);
-        if (ret) {
-            mpp_err_f("set register write failed %d\n", ret);
+        ret = hal_regs_write(ctx->regs_secs, regs - ctx->regs_sets, ctx->dev);
+        if (ret)
             break;
-        }
-        wr_cfg.reg = &regs->reg_rc_klut;
-        wr_cfg.size = sizeof(regs->reg_rc_klut);
-        wr_cfg.offset = VEPU580_RC_KLUT_CFG_OFFSET;
-
-        ret = mpp_dev_ioctl(ctx->dev, MPP_DEV_REG_WR, &wr_cfg);
-        if (ret) {
-            mpp_err_f("set register write failed %d\n", ret);
-            break;
-        }
-        wr_cfg.reg = &regs->reg_s3;
-        wr_cfg.size = sizeof(regs->reg_s3);
-        wr_cfg.offset = VEPU580_SECTION_3_OFFSET;
-
-        ret = mpp_dev_ioctl(ctx->dev, MPP_DEV_REG_WR, &wr_cfg);
-        if (ret) {
-            mpp_err_f("set register write failed %d\n", ret);
-            break;
-        }
-        wr_cfg.reg = &regs->reg_rdo;
-        wr_cfg.size = sizeof(regs->reg_rdo);
-        wr_cfg.offset = VEPU580_RDO_CFG_OFFSET;
-
-        ret = mpp_dev_ioctl(ctx->dev, MPP_DEV_REG_WR, &wr_cfg);
-        if (ret) {
-            mpp_err_f("set register write failed %d\n", ret);
-            break;
-        }
-
-        wr_cfg.reg = &regs->reg_scl;
-        wr_cfg.size = sizeof(regs->reg_scl);
-        wr_cfg.offset = VEPU580_SCL_CFG_OFFSET;
-
-        ret = mpp_dev_ioctl(ctx->dev, MPP_DEV_REG_WR, &wr_cfg);
-        if (ret) {
-            mpp_err_f("set register write failed %d\n", ret);
-            break;
-        }
-
-        wr_cfg.reg = &regs->reg_osd;
-        wr_cfg.size = sizeof(regs->reg_osd);
-        wr_cfg.offset = VEPU580_OSD_OFFSET;
-
-        ret = mpp_dev_ioctl(ctx->dev, MPP_DEV_REG_WR, &wr_cfg);
-        if (ret) {
-            mpp_err_f("set register write failed %d\n", ret);
-            break;
-        }
 
         ret = mpp_dev_ioctl(ctx->dev, MPP_DEV_REG_OFFS, ctx->offsets);
         if (ret) {
@@ -2070,6 +2080,11 @@ static MPP_RET hal_h264e_vepu580_start(void *hal, HalEncTask *task)
             break;
         }
 
+        /*
+         * status is not a frame section, clear it here so that a failed task
+         * does not report the previous frame status
+         */
+        memset(&regs->reg_st, 0, sizeof(regs->reg_st));
         rd_cfg.reg = &regs->reg_st;
         rd_cfg.size = sizeof(regs->reg_st);
         rd_cfg.offset = VEPU580_STATUS_OFFSET;
@@ -2093,7 +2108,7 @@ static MPP_RET hal_h264e_vepu580_start(void *hal, HalEncTask *task)
     return ret;
 }
 
-static MPP_RET hal_h264e_vepu580_status_check(HalVepu580RegSet *regs)
+static MPP_RET hal_h264e_vepu580_status_check(HalVepu580RegSet *regs, HalEncTask *task)
 {
     if (regs->reg_ctl.int_sta.lkt_node_done_sta)
         hal_h264e_dbg_detail("lkt_done finish");
@@ -2107,8 +2122,10 @@ static MPP_RET hal_h264e_vepu580_status_check(HalVepu580RegSet *regs)
     if (regs->reg_ctl.int_sta.sclr_done_sta)
         hal_h264e_dbg_detail("safe clear finsh");
 
-    if (regs->reg_ctl.int_sta.bsf_oflw_sta)
+    if (regs->reg_ctl.int_sta.bsf_oflw_sta) {
         mpp_err_f("bit stream overflow");
+        task->flags.err |= HAL_ENC_TASK_ERR_OVERFLOW;
+    }
 
     if (regs->reg_ctl.int_sta.brsp_otsd_sta)
         mpp_err_f("bus write full");
@@ -2183,7 +2200,7 @@ static MPP_RET hal_h264e_vepu580_wait(void *hal, HalEncTask *task)
         }
     }
 
-    hal_h264e_vepu580_status_check(regs);
+    hal_h264e_vepu580_status_check(regs, task);
     task->hw_length += regs->reg_st.bs_lgth_l32;
 
     hal_h264e_dbg_func("leave %p ret %d\n", hal, ret);
@@ -26,6 +26,7 @@
 #include "mpp_common.h"
 #include "mpp_device.h"
 #include "mpp_frame_impl.h"
+#include "mpp_packet_impl.h"
 
 #include "h265e_syntax_new.h"
 #include "hal_h265e_debug.h"
@@ -36,6 +37,7 @@
 #include "mpp_enc_hal.h"
 #include "hal_bufs.h"
 #include "mpp_enc_ref.h"
+#include "mpp_enc_cb_param.h"
 
 #define hal_h265e_err(fmt, ...) \
     do {\
@@ -108,6 +110,12 @@ typedef struct H265eV541HalContext_t {
     HalBufs             dpb_bufs;
     RK_U32              is_vepu540;
     RK_S32              fbc_header_len;
+
+    /* slice length fifo polling for split output */
+    RK_S32              poll_slice_max;
+    RK_S32              poll_cfg_size;
+    MppDevPollCfg       *poll_cfgs;
+    MppCbCtx            *output_cb;
 } H265eV541HalContext;
 
 static RK_U32 klut_weight[24] = {
@@ -663,6 +671,16 @@ MPP_RET hal_h265e_v541_init(void *hal, MppEncHalCfg *cfg)
 
     ctx->frame_type = INTRA_FRAME;
 
+    ctx->poll_slice_max = 8;
+    ctx->poll_cfg_size = sizeof(MppDevPollCfg) +
+                         sizeof(MppDevPollEncSliceInfo) * ctx->poll_slice_max;
+    ctx->poll_cfgs = mpp_malloc_size(MppDevPollCfg, ctx->poll_cfg_size);
+    if (NULL == ctx->poll_cfgs) {
+        mpp_err_f("init poll cfg buffer failed\n");
+        return MPP_ERR_MALLOC;
+    }
+    ctx->output_cb = cfg->output_cb;
+
     {   /* setup default hardware config */
         MppEncHwCfg *hw = &cfg->cfg->hw;
 
@@ -688,6 +706,7 @@ MPP_RET hal_h265e_v541_deinit(void *hal)
     MPP_FREE(ctx->reg_out);
     MPP_FREE(ctx->input_fmt);
     MPP_FREE(ctx->roi_buf);
+    MPP_FREE(ctx->poll_cfgs);
     hal_bufs_deinit(ctx->dpb_bufs);
 
     if (ctx->roi_hw_buf) {
@@ -1485,6 +1504,9 @@ MPP_RET hal_h265e_v541_gen_regs(void *hal, HalEncTask *task)
     regs->sli_spl.sli_splt_cnum_m1  = syn->sp.sli_splt_cnum_m1;
     regs->sli_spl_byte.sli_splt_byte = syn->sp.sli_splt_byte;
 
+    /* report each slice length through fifo for split output */
+    regs->enc_pic.slen_fifo = (syn->sp.sli_splt && ctx->cfg->split.split_out) ? 1 : 0;
+
     vepu541_h265_set_me_regs(ctx, syn, regs);
 
     regs->rdo_cfg.chrm_special   = 1;
@@ -1875,9 +1897,58 @@ MPP_RET hal_h265e_v541_wait(void *hal, HalEncTask *task)
                       enc_task->flags.err);
         return MPP_NOK;
     }
-    ret = mpp_dev_ioctl(ctx->dev, MPP_DEV_CMD_POLL, NULL);
-    if (ret)
-        mpp_err_f("poll cmd failed %d status %d \n", ret, elem->hw_status);
+
+    if (ctx->cfg->split.split_mode && ctx->cfg->split.split_out) {
+        RK_U32 split_out = ctx->cfg->split.split_out;
+        MppPacket pkt = enc_task->packet;
+        RK_U32 type = ((H265eV541RegSet *)ctx->regs)->synt_nal.nal_unit_type;
+        RK_U32 seg_offset = mpp_packet_get_length(pkt);
+        MppDevPollCfg *poll_cfg = ctx->poll_cfgs;
+        RK_U32 slice_last = 0;
+        EncOutParam param;
+
+        param.task = task;
+        param.base = mpp_packet_get_data(pkt);
+
+        /* hand out each slice as soon as hardware reports it done */
+        do {
+            RK_S32 i;
+
+            poll_cfg->poll_type = 0;
+            poll_cfg->poll_ret  = 0;
+            poll_cfg->count_max = ctx->poll_slice_max;
+            poll_cfg->count_ret = 0;
+
+            ret = mpp_dev_ioctl(ctx->dev, MPP_DEV_CMD_POLL, poll_cfg);
+            if (ret) {
+                mpp_err_f("poll cmd failed %d status %d\n", ret, elem->hw_status);
+                break;
+            }
+
+            for (i = 0; i < poll_cfg->count_ret; i++) {
+                RK_U32 slice_len = poll_cfg->slice_info[i].length;
+
+                slice_last = poll_cfg->slice_info[i].last;
+                param.length = slice_len;
+
+                hal_h265e_dbg_detail("slice %d len %d last %d\n", i, slice_len, slice_last);
+
+                if (split_out & MPP_ENC_SPLIT_OUT_SEGMENT)
+                    mpp_packet_add_segment_info(pkt, type, seg_offset, slice_len);
+
+                if (split_out & MPP_ENC_SPLIT_OUT_LOWDELAY) {
+                    ctx->output_cb->cmd = slice_last ? ENC_OUTPUT_FINISH : ENC_OUTPUT_SLICE;
+                    mpp_callback(ctx->output_cb, &param);
+                }
+
+                seg_offset += slice_len;
+            }
+        } while (!slice_last);
+    } else {
+        ret = mpp_dev_ioctl(ctx->dev, MPP_DEV_CMD_POLL, NULL);
+        if (ret)
+            mpp_err_f("poll cmd failed %d status %d \n", ret, elem->hw_status);
+    }
 
     hal_h265e_leave();
     return ret;
@@ -1915,6 +1986,8 @@ MPP_RET hal_h265e_v541_get_task(void *hal, HalEncTask *task)
         mpp_meta_get_buffer_d(meta, KEY_QPMAP0, &ctx->qpmap, NULL);
     }
     memset(&ctx->feedback, 0, sizeof(vepu541_h265_fbk));
+    task->part_first = 1;
+    task->part_last = 0;
 
     hal_h265e_leave();
     return MPP_OK;
@@ -2809,11 +2809,9 @@ MPP_RET hal_h265e_v580_wait(void *hal, HalEncTask *task)
                 ctx->output_cb->cmd = ENC_OUTPUT_SLICE;
                 if (slice_last) {
                     finish_cnt++;
-                    if (ctx->tile_parall_en) {
-                        if (finish_cnt + 1 > ctx->tile_num) {
-                            ctx->output_cb->cmd = ENC_OUTPUT_FINISH;
-                        }
-                    }
+                    /* the last slice of the last tile finishes the frame */
+                    if (!ctx->tile_parall_en || finish_cnt + 1 > ctx->tile_num)
+                        ctx->output_cb->cmd = ENC_OUTPUT_FINISH;
                 }
 
                 if (split_out & MPP_ENC_SPLIT_OUT_SEGMENT)
@@ -667,7 +667,11 @@ static MPP_RET hal_h264e_vepu1_wait_v2(void *hal, HalEncTask *task)
         HalH264eVepuStreamAmend *amend = &ctx->amend;
         if (amend->enable) {
             amend->old_length = hw_mbrc->out_strm_size;
-            h264e_vepu_stream_amend_proc(amend);
+            if (h264e_vepu_stream_amend_proc(amend)) {
+                /* truncated stream can not be output */
+                task->flags.err |= HAL_ENC_TASK_ERR_WAIT;
+                return MPP_NOK;
+            }
             ctx->hw_mbrc.out_strm_size = amend->new_length;
         } else if (amend->prefix) {
             /* check prefix value */
@@ -742,17 +742,278 @@ static RK_S32 get_next_nal(RK_U8 *buf, RK_S32 *length)
     return consumed;
 }
 
+#define AMEND_FIFO_SIZE     SZ_4K
+#define AMEND_CHUNK_SIZE    SZ_1K
+#define AMEND_HDR_SIZE      256
+
+/*
+ * In place stream io for slice header amendment.
+ *
+ * The new stream is written to the same buffer from where the hardware stream
+ * is read. When the new stream is longer the writer goes ahead of the reader.
+ * Then the source bytes under the writer are saved to fifo before they are
+ * overwritten. The fifo is indexed by stream position and only holds the
+ * bytes in [rd, saved).
+ */
+typedef struct HalH264eAmendIo_t {
+    HalH264eVepuStreamAmend *ctx;
+    RK_U8           *buf;
+    RK_S32          end;
+    RK_S32          limit;
+    RK_S32          rd;
+    RK_S32          wr;
+    RK_S32          saved;
+    RK_S32          err;
+} HalH264eAmendIo;
+
+static MPP_RET amend_fifo_reserve(HalH264eAmendIo *io, RK_S32 size)
+{
+    HalH264eVepuStreamAmend *ctx = io->ctx;
+    RK_S32 new_size = ctx->fifo_size ? ctx->fifo_size : AMEND_FIFO_SIZE;
+    RK_U8 *fifo;
+    RK_S32 i;
+
+    if (size <= ctx->fifo_size)
+        return MPP_OK;
+
+    while (new_size < size)
+        new_size <<= 1;
+
+    fifo = mpp_malloc(RK_U8, new_size);
+    if (NULL == fifo) {
+        mpp_err_f("failed to malloc fifo size %d\n", new_size);
+        io->err = 1;
+        return MPP_ERR_NOMEM;
+    }
+
+    /* re-index saved bytes with the new mask */
+    for (i = io->rd; i < io->saved; i++)
+        fifo[i & (new_size - 1)] = ctx->fifo[i & (ctx->fifo_size - 1)];
+
+    MPP_FREE(ctx->fifo);
+    ctx->fifo = fifo;
+    ctx->fifo_size = new_size;
+
+    return MPP_OK;
+}
+
+/* copy fifo bytes of position [pos, pos + size) to dst */
+static void amend_fifo_read(HalH264eAmendIo *io, RK_S32 pos, RK_U8 *dst, RK_S32 size)
+{
+    HalH264eVepuStreamAmend *ctx = io->ctx;
+    RK_S32 mask = ctx->fifo_size - 1;
+    RK_S32 first = MPP_MIN(size, ctx->fifo_size - (pos & mask));
+
+    memcpy(dst, ctx->fifo + (pos & mask), first);
+    if (size > first)
+        memcpy(dst + first, ctx->fifo, size - first);
+}
+
+/* save source bytes before position upto which are going to be overwritten */
+static void amend_save(HalH264eAmendIo *io, RK_S32 upto)
+{
+    HalH264eVepuStreamAmend *ctx;
+    RK_S32 pos;
+    RK_S32 mask;
+
+    upto = MPP_MIN(upto, io->end);
+    if (io->saved < io->rd)
+        io->saved = io->rd;
+
+    if (upto <= io->saved)
+        return;
+
+    if (amend_fifo_reserve(io, upto - io->rd))
+        return;
+
+    ctx = io->ctx;
+    mask = ctx->fifo_size - 1;
+
+    for (pos = io->saved; pos < upto;) {
+        RK_S32 size = MPP_MIN(upto - pos, ctx->fifo_size - (pos & mask));
+
+        memcpy(ctx->fifo + (pos & mask), io->buf + pos, size);
+        pos += size;
+    }
+
+    io->saved = upto;
+}
+
+static RK_U8 amend_get_byte(HalH264eAmendIo *io, RK_S32 pos)
+{
+    HalH264eVepuStreamAmend *ctx = io->ctx;
+
+    return (pos < io->saved) ? ctx->fifo[pos & (ctx->fifo_size - 1)] : io->buf[pos];
+}
+
+/* read source bytes without consuming them */
+static void amend_peek(HalH264eAmendIo *io, RK_S32 pos, RK_U8 *dst, RK_S32 size)
+{
+    RK_S32 cnt = MPP_CLIP3(0, size, io->saved - pos);
+
+    if (cnt)
+        amend_fifo_read(io, pos, dst, cnt);
+    if (size > cnt)
+        memcpy(dst + cnt, io->buf + pos + cnt, size - cnt);
+}
+
+static void amend_put_byte(HalH264eAmendIo *io, RK_U8 val)
+{
+    if (io->wr >= io->limit) {
+        io->err = 1;
+        return;
+    }
+
+    amend_save(io, io->wr + 1);
+    io->buf[io->wr++] = val;
+}
+
+static void amend_put_data(HalH264eAmendIo *io, const RK_U8 *src, RK_S32 size)
+{
+    if (io->wr + size > io->limit) {
+        io->err = 1;
+        return;
+    }
+
+    amend_save(io, io->wr + size);
+    memcpy(io->buf + io->wr, src, size);
+    io->wr += size;
+}
+
+/* copy size source bytes to writer */
+static void amend_copy(HalH264eAmendIo *io, RK_S32 size)
+{
+    if (io->wr + size > io->limit) {
+        io->err = 1;
+        return;
+    }
+
+    /* stream is not moved at all */
+    if (io->wr == io->rd && io->saved <= io->rd) {
+        io->wr += size;
+        io->rd += size;
+        return;
+    }
+
+    while (size > 0) {
+        RK_S32 chunk = MPP_MIN(size, AMEND_CHUNK_SIZE);
+        RK_S32 cnt;
+
+        amend_save(io, io->wr + chunk);
+        if (io->err)
+            return;
+
+        /* bytes in fifo first then the remaining in buffer */
+        cnt = MPP_CLIP3(0, chunk, io->saved - io->rd);
+        if (cnt)
+            amend_fifo_read(io, io->rd, io->buf + io->wr, cnt);
+        if (chunk > cnt)
+            memmove(io->buf + io->wr + cnt, io->buf + io->rd + cnt, chunk - cnt);
+
+        io->wr += chunk;
+        io->rd += chunk;
+        size -= chunk;
+    }
+}
+
+static RK_S32 amend_zero_cnt(const RK_U8 *p, RK_S32 size)
+{
+    RK_S32 cnt = 0;
+
+    while (cnt < 2 && cnt < size && !p[size - 1 - cnt])
+        cnt++;
+
+    return cnt;
+}
+
+/*
+ * Move slice data after the new header. The emulation prevention bytes are
+ * removed on reading and inserted again on writing. When the new header has
+ * the same bit phase as the old one, which is always true for cabac, the rest
+ * data is copied by bytes once the emulation state of both streams is in sync.
+ */
+static void amend_shift_data(HalH264eAmendIo *io, const RK_U8 *hdr, RK_S32 hdr_bit,
+                             RK_S32 src_bit, RK_S32 src_zero, RK_S32 nal_end,
+                             RK_S32 tail_0bit)
+{
+    RK_S32 hdr_byte = hdr_bit >> 3;
+    RK_S32 acc_bits = hdr_bit & 7;
+    RK_U32 acc = hdr[hdr_byte] >> (8 - acc_bits);
+    RK_S32 dst_zero = amend_zero_cnt(hdr, hdr_byte);
+    RK_S32 skip = src_bit & 7;
+
+    amend_put_data(io, hdr, hdr_byte);
+    io->rd += src_bit >> 3;
+
+    while (io->rd < nal_end && !io->err) {
+        RK_U32 val = amend_get_byte(io, io->rd);
+        RK_S32 bits = 8;
+
+        io->rd++;
+
+        if (src_zero >= 2 && val == 3) {
+            src_zero = 0;
+            continue;
+        }
+        src_zero = val ? 0 : src_zero + 1;
+
+        if (skip) {
+            val &= 0xff >> skip;
+            bits -= skip;
+            skip = 0;
+        }
+
+        /* drop the zero bits after rbsp_stop_one_bit */
+        if (io->rd == nal_end) {
+            val >>= tail_0bit;
+            bits -= tail_0bit;
+        }
+
+        acc = (acc << bits) | val;
+        acc_bits += bits;
+
+        while (acc_bits >= 8) {
+            RK_U8 out = (acc >> (acc_bits - 8)) & 0xff;
+
+            acc_bits -= 8;
+
+            if (dst_zero >= 2 && out <= 3) {
+                amend_put_byte(io, 3);
+                dst_zero = 0;
+            }
+
+            amend_put_byte(io, out);
+            dst_zero = out ? 0 : dst_zero + 1;
+        }
+
+        acc &= (1 << acc_bits) - 1;
+
+        if (!acc_bits && !src_zero && !dst_zero) {
+            amend_copy(io, nal_end - io->rd);
+            return;
+        }
+    }
+
+    if (acc_bits) {
+        RK_U8 out = (acc << (8 - acc_bits)) & 0xff;
+
+        if (dst_zero >= 2 && out <= 3)
+            amend_put_byte(io, 3);
+
+        amend_put_byte(io, out);
+    }
+}
+
 MPP_RET h264e_vepu_stream_amend_init(HalH264eVepuStreamAmend *ctx)
 {
     memset(ctx, 0, sizeof(*ctx));
-    ctx->buf_size = SZ_128K;
     return MPP_OK;
 }
 
 MPP_RET h264e_vepu_stream_amend_deinit(HalH264eVepuStreamAmend *ctx)
 {
-    MPP_FREE(ctx->src_buf);
-    MPP_FREE(ctx->dst_buf);
+    MPP_FREE(ctx->fifo);
+    MPP_FREE(ctx->nal_lens);
     return MPP_OK;
 }
 
@@ -765,14 +1026,9 @@ MPP_RET h264e_vepu_stream_amend_config(HalH264eVepuStreamAmend *ctx,
     if (ref->lt_cfg_cnt || ref->st_cfg_cnt > 1) {
         ctx->enable = 1;
         ctx->slice_enabled = 0;
-
-        if (NULL == ctx->dst_buf)
-            ctx->dst_buf = mpp_calloc(RK_U8, ctx->buf_size);
-        if (NULL == ctx->src_buf)
-            ctx->src_buf = mpp_calloc(RK_U8, ctx->buf_size);
     } else {
-        MPP_FREE(ctx->dst_buf);
-        MPP_FREE(ctx->src_buf);
+        MPP_FREE(ctx->fifo);
+        MPP_FREE(ctx->nal_lens);
         memset(ctx, 0, sizeof(*ctx));
     }
 
@@ -786,155 +1042,140 @@ MPP_RET h264e_vepu_stream_amend_config(HalH264eVepuStreamAmend *ctx,
     return MPP_OK;
 }
 
-MPP_RET h264e_vepu_stream_amend_proc(HalH264eVepuStreamAmend *ctx)
+/* record nal length of each slice in hardware stream */
+static RK_S32 amend_split_nals(HalH264eVepuStreamAmend *ctx, RK_U8 *p, RK_S32 len)
 {
-    H264ePrefixNal *prefix = ctx->prefix;
-    H264eSlice *slice = ctx->slice;
-    MppPacket pkt = ctx->packet;
-    RK_U8 *p = mpp_packet_get_pos(pkt);
-    RK_S32 size = mpp_packet_get_size(pkt);
-    RK_S32 base = ctx->buf_base;
-    RK_S32 len = ctx->old_length;
-    RK_S32 hw_len_bit = 0;
-    RK_S32 sw_len_bit = 0;
-    RK_S32 hw_len_byte = 0;
-    RK_S32 sw_len_byte = 0;
-    RK_S32 diff_size = 0;
-    RK_S32 tail_0bit = 0;
-    RK_U8  tail_byte = 0;
-    RK_U8  tail_tmp = 0;
-    RK_U8 *dst_buf = NULL;
-    RK_S32 buf_size;
-    RK_S32 final_len = 0;
-    RK_S32 last_slice = 0;
-
-    {
-        RK_S32 more_buf = 0;
-        while (len > ctx->buf_size - 16) {
-            ctx->buf_size *= 2;
-            more_buf = 1;
-        }
+    RK_S32 cnt = 0;
 
-        if (more_buf) {
-            MPP_FREE(ctx->src_buf);
-            MPP_FREE(ctx->dst_buf);
-            ctx->src_buf = mpp_malloc(RK_U8, ctx->buf_size);
-            ctx->dst_buf = mpp_malloc(RK_U8, ctx->buf_size);
+    while (len > 0) {
+        RK_S32 nal_len = len;
+
+        if (ctx->slice->is_multi_slice)
+            nal_len = get_next_nal(p, &len);
+        else
+            len = 0;
+
+        if (nal_len <= 0)
+            break;
+
+        if (cnt >= ctx->nal_max) {
+            RK_S32 nal_max = MPP_MAX(8, ctx->nal_max * 2);
+            RK_S32 *lens = mpp_realloc(ctx->nal_lens, RK_S32, nal_max);
+
+            if (NULL == lens) {
+                mpp_err_f("failed to realloc nal count %d\n", nal_max);
+                return 0;
+            }
+
+            ctx->nal_lens = lens;
+            ctx->nal_max = nal_max;
         }
+
+        ctx->nal_lens[cnt++] = nal_len;
+        p += nal_len;
     }
 
-    memset(ctx->dst_buf, 0, ctx->buf_size);
-    memset(ctx->src_buf, 0, ctx->buf_size);
-    dst_buf = ctx->dst_buf;
-    buf_size = ctx->buf_size;
-    p += base;
+    return cnt;
+}
 
-    do {
-        RK_U32 nal_len = 0;
-        tail_0bit = 0;
-        // copy hw stream to stream buffer first
-        if (slice->is_multi_slice) {
-            nal_len = get_next_nal(p, &len);
+MPP_RET h264e_vepu_stream_amend_proc(HalH264eVepuStreamAmend *ctx)
+{
+    H264ePrefixNal *prefix = ctx->prefix;
+    H264eSlice *slice = ctx->slice;
+    MppPacket pkt = ctx->packet;
+    RK_U8 *p = (RK_U8 *)mpp_packet_get_pos(pkt) + ctx->buf_base;
+    RK_S32 size = mpp_packet_get_size(pkt) - ctx->buf_base;
+    RK_U8 hw_hdr[AMEND_HDR_SIZE];
+    RK_U8 sw_hdr[AMEND_HDR_SIZE];
+    HalH264eAmendIo io;
+    RK_S32 nal_cnt;
+    RK_S32 i;
 
-            memcpy(ctx->src_buf, p, nal_len);
-            p += nal_len;
-            last_slice = (len == 0);
-        } else {
-            memcpy(ctx->src_buf, p, len);
-            nal_len = len;
-            last_slice = 1;
-        }
+    nal_cnt = amend_split_nals(ctx, p, ctx->old_length);
+
+    memset(&io, 0, sizeof(io));
+    io.ctx = ctx;
+    io.buf = p;
+    io.end = ctx->old_length;
+    io.limit = size;
+
+    for (i = 0; i < nal_cnt && !io.err; i++) {
+        RK_S32 nal_len = ctx->nal_lens[i];
+        RK_S32 nal_end = io.rd + nal_len;
+        RK_S32 peek = MPP_MIN(nal_len, AMEND_HDR_SIZE);
+        RK_S32 hw_len_bit;
+        RK_S32 sw_len_bit;
+        RK_S32 tail_0bit = 0;
+        RK_S32 start = io.wr;
+        H264eSlice slice_rd;
 
-        hal_h264e_dbg_amend("nal_len %d multi %d last %d prefix %p\n",
-                            nal_len, slice->is_multi_slice, last_slice, prefix);
+        hal_h264e_dbg_amend("nal %d len %d multi %d prefix %p\n",
+                            i, nal_len, slice->is_multi_slice, prefix);
 
         if (prefix) {
             /* add prefix for each slice */
-            RK_S32 prefix_bit = h264e_slice_write_prefix_nal_unit_svc(prefix, dst_buf, buf_size);
+            RK_S32 prefix_bit;
 
-            prefix_bit = (prefix_bit + 7) / 8;
-
-            dst_buf += prefix_bit;
-            buf_size -= prefix_bit;
-            final_len += prefix_bit;
+            memset(sw_hdr, 0, sizeof(sw_hdr));
+            prefix_bit = h264e_slice_write_prefix_nal_unit_svc(prefix, sw_hdr, sizeof(sw_hdr));
+            amend_put_data(&io, sw_hdr, (prefix_bit + 7) / 8);
         }
 
-        H264eSlice slice_rd;
+        /* read hardware slice header */
+        amend_peek(&io, io.rd, hw_hdr, peek);
 
         memcpy(&slice_rd, slice, sizeof(slice_rd));
         slice_rd.log2_max_frame_num = 16;
         slice_rd.pic_order_cnt_type = 2;
 
-        hw_len_bit = h264e_slice_read(&slice_rd, ctx->src_buf, size);
+        hw_len_bit = h264e_slice_read(&slice_rd, hw_hdr, peek);
 
-        // write new header to header buffer
+        /* write new slice header */
         slice->qp_delta = slice_rd.qp_delta;
         slice->first_mb_in_slice = slice_rd.first_mb_in_slice;
-        sw_len_bit = h264e_slice_write(slice, dst_buf, buf_size);
-
-        hw_len_byte = (hw_len_bit + 7) / 8;
-        sw_len_byte = (sw_len_bit + 7) / 8;
 
-        tail_byte = ctx->src_buf[nal_len - 1];
-        tail_tmp = tail_byte;
-
-        while (!(tail_tmp & 1) && tail_0bit < 8) {
-            tail_tmp >>= 1;
-            tail_0bit++;
-        }
-
-        mpp_assert(tail_0bit < 8);
-
-        // move the reset slice data from src buffer to dst buffer
-        diff_size = h264e_slice_move(dst_buf, ctx->src_buf,
-                                     sw_len_bit, hw_len_bit, nal_len);
-
-        hal_h264e_dbg_amend("tail 0x%02x %d hw_hdr %d sw_hdr %d len %d hw_byte %d sw_byte %d diff %d\n",
-                            tail_byte, tail_0bit, hw_len_bit, sw_len_bit, nal_len, hw_len_byte, sw_len_byte, diff_size);
+        memset(sw_hdr, 0, sizeof(sw_hdr));
+        sw_len_bit = h264e_slice_write(slice, sw_hdr, sizeof(sw_hdr));
 
         if (slice->entropy_coding_mode) {
-            memcpy(dst_buf + sw_len_byte, ctx->src_buf + hw_len_byte,
-                   nal_len - hw_len_byte);
-            final_len += nal_len - hw_len_byte + sw_len_byte;
-            nal_len = nal_len - hw_len_byte + sw_len_byte;
+            /* cabac header is byte aligned, data is moved by bytes */
+            hw_len_bit = MPP_ALIGN(hw_len_bit, 8);
+            sw_len_bit = MPP_ALIGN(sw_len_bit, 8);
         } else {
-            RK_S32 hdr_diff_bit = sw_len_bit - hw_len_bit;
-            RK_S32 bit_len = nal_len * 8 - tail_0bit + hdr_diff_bit;
-            RK_S32 new_len = (bit_len + diff_size * 8 + 7) / 8;
-
-            hal_h264e_dbg_amend("frm %4d %c len %d bit hw %d sw %d byte hw %d sw %d diff %d -> %d\n",
-                                slice->frame_num, (slice->idr_flag ? 'I' : 'P'),
-                                nal_len, hw_len_bit, sw_len_bit,
-                                hw_len_byte, sw_len_byte, diff_size, new_len);
-
-            hal_h264e_dbg_amend("%02x %02x %02x %02x -> %02x %02x %02x %02x\n",
-                                ctx->src_buf[nal_len - 4], ctx->src_buf[nal_len - 3],
-                                ctx->src_buf[nal_len - 2], ctx->src_buf[nal_len - 1],
-                                dst_buf[new_len - 4], dst_buf[new_len - 3],
-                                dst_buf[new_len - 2], dst_buf[new_len - 1]);
-            nal_len = new_len;
-            final_len += new_len;
+            RK_U8 tail_byte = amend_get_byte(&io, nal_end - 1);
+
+            while (!(tail_byte & 1) && tail_0bit < 8) {
+                tail_byte >>= 1;
+                tail_0bit++;
+            }
+
+            mpp_assert(tail_0bit < 8);
         }
 
-        if (last_slice) {
-            p = mpp_packet_get_pos(pkt);
-            p += base;
-            memcpy(p, ctx->dst_buf, final_len);
+        amend_shift_data(&io, sw_hdr, sw_len_bit, hw_len_bit,
+                         amend_zero_cnt(hw_hdr, hw_len_bit >> 3),
+                         nal_end, tail_0bit);
 
-            if (slice->entropy_coding_mode) {
-                if (final_len < ctx->old_length)
-                    memset(p + final_len, 0,  ctx->old_length - final_len);
-            } else
-                p[final_len] = 0;
+        hal_h264e_dbg_amend("frm %4d %c hdr bit hw %d sw %d len %d -> %d\n",
+                            slice->frame_num, (slice->idr_flag ? 'I' : 'P'),
+                            hw_len_bit, sw_len_bit, nal_len, io.wr - start);
 
-            break;
-        }
+        io.rd = nal_end;
+    }
 
-        dst_buf += nal_len;
-        buf_size -= nal_len;
-    } while (1);
+    if (io.err || i < nal_cnt || !nal_cnt) {
+        mpp_err_f("amend stream failed, len %d buffer %d\n", ctx->old_length, size);
+        ctx->new_length = io.wr;
+        return MPP_NOK;
+    }
+
+    if (slice->entropy_coding_mode) {
+        if (io.wr < ctx->old_length)
+            memset(p + io.wr, 0, ctx->old_length - io.wr);
+    } else if (io.wr < size)
+        p[io.wr] = 0;
 
-    ctx->new_length = final_len;
+    ctx->new_length = io.wr;
 
     return MPP_OK;
 }
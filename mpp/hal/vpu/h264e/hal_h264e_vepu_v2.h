@@ -171,9 +171,15 @@ typedef struct HalH264eVepuStreamAmend_t {
     H264ePrefixNal  *prefix;
     RK_S32          slice_enabled;
 
-    RK_U8           *src_buf;
-    RK_U8           *dst_buf;
-    RK_S32          buf_size;
+    /*
+     * slice headers are rewritten in place in the packet. The fifo keeps the
+     * hardware stream bytes which are overtaken by a longer new header.
+     */
+    RK_U8           *fifo;
+    RK_S32          fifo_size;
+    /* nal length of each slice in hardware stream */
+    RK_S32          *nal_lens;
+    RK_S32          nal_max;
 
     MppPacket       packet;
     RK_S32          buf_base;
@@ -0,0 +1,353 @@
+/*
+ * Copyright 2026 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "hal_h264e_amend_test"
+
+#include <string.h>
+
+#include "mpp_mem.h"
+#include "mpp_debug.h"
+#include "mpp_common.h"
+#include "mpp_packet.h"
+#include "mpp_bitwrite.h"
+
+#include "h264e_slice.h"
+#include "hal_h264e_vepu_v2.h"
+
+/*
+ * The test builds a hardware like stream with the hardware fixed slice header
+ * syntax, amends it with the in-place stream amend and compares the result
+ * with the stream rebuilt by h264e_slice_move into separated buffers, which
+ * is the way the stream used to be amended.
+ */
+#define AMEND_TEST_BUF_SIZE     (64 * 1024)
+/* bytes before the hardware stream in the packet */
+#define AMEND_TEST_BASE         24
+#define AMEND_TEST_MAX_SLICE    8
+#define AMEND_TEST_MB_W         20
+#define AMEND_TEST_MB_H         12
+
+#define AMEND_TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            mpp_err("check %s failed at line %d\n", #cond, __LINE__); \
+            ret = MPP_NOK; \
+            goto DONE; \
+        } \
+    } while (0)
+
+typedef struct AmendTestCase_t {
+    const char      *name;
+    RK_S32          cabac;
+    RK_S32          idr;
+    RK_S32          slice_cnt;
+    /* hardware header has long idr_pic_id, reorder and mmco syntax */
+    RK_S32          hw_ext;
+    /* software header has poc lsb, long idr_pic_id, reorder and mmco syntax */
+    RK_S32          sw_ext;
+    /* slice data size in bytes */
+    RK_S32          data_size;
+} AmendTestCase;
+
+typedef struct AmendTestSlice_t {
+    H264eSlice          slice;
+    H264eReorderInfo    reorder;
+    H264eMarkingInfo    marking;
+} AmendTestSlice;
+
+static const AmendTestCase amend_test_cases[] = {
+    { "cavlc idr longer",       0, 1, 1, 0, 1, 300  },
+    { "cavlc idr shorter",      0, 1, 1, 1, 0, 300  },
+    { "cavlc p longer",         0, 0, 1, 0, 1, 200  },
+    { "cavlc p shorter",        0, 0, 1, 1, 0, 200  },
+    { "cavlc p multi longer",   0, 0, 4, 0, 1, 120  },
+    { "cavlc p multi shorter",  0, 0, 4, 1, 0, 120  },
+    { "cavlc idr multi large",  0, 1, 3, 0, 1, 4000 },
+    { "cabac idr longer",       1, 1, 1, 0, 1, 300  },
+    { "cabac idr shorter",      1, 1, 1, 1, 0, 300  },
+    { "cabac p longer",         1, 0, 1, 0, 1, 200  },
+    { "cabac p shorter",        1, 0, 1, 1, 0, 200  },
+    { "cabac p multi longer",   1, 0, 4, 0, 1, 120  },
+    { "cabac p multi shorter",  1, 0, 4, 1, 0, 120  },
+    { "cabac idr multi large",  1, 1, 3, 0, 1, 4000 },
+};
+
+static RK_U32 amend_test_seed = 1;
+
+/* slice data with many zero and small bytes to trigger emulation prevention */
+static RK_U8 amend_test_rand(void)
+{
+    RK_U32 val;
+
+    amend_test_seed = amend_test_seed * 1103515245 + 12345;
+    val = (amend_test_seed >> 16) & 0x7fff;
+
+    return (val & 0x300) ? (RK_U8)(val & 3) : (RK_U8)val;
+}
+
+static void amend_test_slice(AmendTestSlice *s, const AmendTestCase *c, RK_S32 ext,
+                             RK_S32 hw)
+{
+    H264eSlice *slice = &s->slice;
+
+    h264e_slice_init(slice, &s->reorder, &s->marking);
+    h264e_reorder_init(&s->reorder);
+    h264e_marking_init(&s->marking);
+
+    slice->mb_w = AMEND_TEST_MB_W;
+    slice->mb_h = AMEND_TEST_MB_H;
+    slice->max_num_ref_frames = 4;
+    slice->entropy_coding_mode = c->cabac;
+    slice->log2_max_frame_num = 16;
+    slice->log2_max_poc_lsb = 16;
+    slice->pic_order_cnt_type = 2;
+    slice->qp_init = 26;
+    slice->nal_reference_idc = c->idr ? H264_NALU_PRIORITY_HIGHEST : H264_NALU_PRIORITY_HIGH;
+    slice->nalu_type = c->idr ? H264_NALU_TYPE_IDR : H264_NALU_TYPE_SLICE;
+    slice->slice_type = c->idr ? H264_I_SLICE : H264_P_SLICE;
+    slice->frame_num = c->idr ? 0 : 7;
+    slice->cabac_init_idc = c->cabac ? 1 : 0;
+    slice->idr_flag = c->idr;
+    slice->is_multi_slice = c->slice_cnt > 1;
+
+    if (!ext)
+        return;
+
+    if (c->idr) {
+        slice->idr_pic_id = hw ? 1000 : 300;
+        s->marking.long_term_reference_flag = 1;
+    } else {
+        H264eRplmo rplmo;
+        H264eMmco mmco;
+
+        memset(&rplmo, 0, sizeof(rplmo));
+        rplmo.modification_of_pic_nums_idc = hw ? 0 : 2;
+        rplmo.abs_diff_pic_num_minus1 = 40;
+        rplmo.long_term_pic_idx = 3;
+        h264e_reorder_wr_op(&s->reorder, &rplmo);
+
+        memset(&mmco, 0, sizeof(mmco));
+        mmco.mmco = hw ? 1 : 3;
+        mmco.difference_of_pic_nums_minus1 = 60;
+        mmco.long_term_frame_idx = 1;
+        h264e_marking_wr_op(&s->marking, &mmco);
+
+        if (!hw) {
+            mmco.mmco = 4;
+            mmco.max_long_term_frame_idx_plus1 = 2;
+            h264e_marking_wr_op(&s->marking, &mmco);
+        }
+    }
+
+    if (!hw) {
+        slice->pic_order_cnt_type = 0;
+        slice->pic_order_cnt_lsb = c->idr ? 0 : 14;
+    }
+}
+
+/* write one hardware slice with header and random slice data */
+static RK_S32 amend_test_write_nal(H264eSlice *slice, RK_U8 *p, RK_S32 size,
+                                   RK_S32 data_size)
+{
+    MppWriteCtx ctx;
+    MppWriteCtx *s = &ctx;
+    RK_S32 hdr_bit;
+    RK_S32 i;
+
+    hdr_bit = h264e_slice_write(slice, p, size);
+
+    /* continue writing after the header */
+    mpp_writer_init(s, p, size);
+    s->stream = p + hdr_bit / 8;
+    s->byte_cnt = hdr_bit / 8;
+    s->buffered_bits = hdr_bit & 7;
+    s->byte_buffer = (RK_U32)(p[hdr_bit / 8] & (0xff00 >> s->buffered_bits)) << 24;
+    for (i = hdr_bit / 8 - 1; i >= 0 && !p[i] && s->zero_bytes < 2; i--)
+        s->zero_bytes++;
+
+    for (i = 0; i < data_size; i++)
+        mpp_writer_put_bits(s, amend_test_rand(), 8);
+
+    /* cavlc stop bit lands at any bit position */
+    if (!slice->entropy_coding_mode)
+        mpp_writer_put_bits(s, amend_test_rand() & 0x1f, 5);
+
+    mpp_writer_trailing(s);
+    mpp_writer_flush(s);
+
+    return s->byte_cnt;
+}
+
+/* the old amend flow with h264e_slice_move on separated src / dst buffers */
+static RK_S32 amend_test_ref(H264eSlice *slice, RK_U8 *stream, RK_S32 *nal_lens,
+                             RK_S32 nal_cnt, RK_U8 *dst)
+{
+    RK_U8 *src_buf = mpp_calloc(RK_U8, AMEND_TEST_BUF_SIZE);
+    RK_U8 *dst_buf = dst;
+    RK_S32 final_len = 0;
+    RK_S32 i;
+
+    for (i = 0; i < nal_cnt; i++) {
+        RK_S32 nal_len = nal_lens[i];
+        RK_S32 tail_0bit = 0;
+        RK_U8 tail_tmp;
+        RK_S32 hw_len_bit;
+        RK_S32 sw_len_bit;
+        RK_S32 hw_len_byte;
+        RK_S32 sw_len_byte;
+        RK_S32 diff_size;
+        H264eSlice slice_rd;
+
+        memset(src_buf, 0, AMEND_TEST_BUF_SIZE);
+        memcpy(src_buf, stream, nal_len);
+        stream += nal_len;
+
+        memcpy(&slice_rd, slice, sizeof(slice_rd));
+        slice_rd.log2_max_frame_num = 16;
+        slice_rd.pic_order_cnt_type = 2;
+
+        hw_len_bit = h264e_slice_read(&slice_rd, src_buf, nal_len);
+
+        slice->qp_delta = slice_rd.qp_delta;
+        slice->first_mb_in_slice = slice_rd.first_mb_in_slice;
+        sw_len_bit = h264e_slice_write(slice, dst_buf, AMEND_TEST_BUF_SIZE - final_len);
+
+        hw_len_byte = (hw_len_bit + 7) / 8;
+        sw_len_byte = (sw_len_bit + 7) / 8;
+
+        tail_tmp = src_buf[nal_len - 1];
+        while (!(tail_tmp & 1) && tail_0bit < 8) {
+            tail_tmp >>= 1;
+            tail_0bit++;
+        }
+
+        diff_size = h264e_slice_move(dst_buf, src_buf, sw_len_bit, hw_len_bit, nal_len);
+
+        if (slice->entropy_coding_mode) {
+            memcpy(dst_buf + sw_len_byte, src_buf + hw_len_byte, nal_len - hw_len_byte);
+            nal_len = nal_len - hw_len_byte + sw_len_byte;
+        } else {
+            RK_S32 bit_len = nal_len * 8 - tail_0bit + sw_len_bit - hw_len_bit;
+
+            nal_len = (bit_len + diff_size * 8 + 7) / 8;
+        }
+
+        final_len += nal_len;
+        dst_buf += nal_len;
+    }
+
+    MPP_FREE(src_buf);
+
+    return final_len;
+}
+
+static MPP_RET amend_test_run(const AmendTestCase *c)
+{
+    MPP_RET ret = MPP_OK;
+    RK_U8 *buf = mpp_calloc(RK_U8, AMEND_TEST_BUF_SIZE);
+    RK_U8 *hw_strm = mpp_calloc(RK_U8, AMEND_TEST_BUF_SIZE);
+    RK_U8 *ref = mpp_calloc(RK_U8, AMEND_TEST_BUF_SIZE);
+    RK_S32 nal_lens[AMEND_TEST_MAX_SLICE];
+    AmendTestSlice hw;
+    AmendTestSlice sw;
+    AmendTestSlice sw_ref;
+    HalH264eVepuStreamAmend amend;
+    MppPacket pkt = NULL;
+    RK_S32 mbs = AMEND_TEST_MB_W * AMEND_TEST_MB_H;
+    RK_S32 hw_len = 0;
+    RK_S32 ref_len;
+    RK_S32 i;
+
+    h264e_vepu_stream_amend_init(&amend);
+
+    AMEND_TEST_CHECK(buf && hw_strm && ref);
+
+    amend_test_slice(&hw, c, c->hw_ext, 1);
+    amend_test_slice(&sw, c, c->sw_ext, 0);
+    amend_test_slice(&sw_ref, c, c->sw_ext, 0);
+
+    for (i = 0; i < c->slice_cnt; i++) {
+        hw.slice.first_mb_in_slice = mbs * i / c->slice_cnt;
+        hw.slice.qp_delta = i * 3 - 4;
+        nal_lens[i] = amend_test_write_nal(&hw.slice, hw_strm + hw_len,
+                                           AMEND_TEST_BUF_SIZE - hw_len,
+                                           c->data_size + i * 7);
+        hw_len += nal_lens[i];
+    }
+
+    ref_len = amend_test_ref(&sw_ref.slice, hw_strm, nal_lens, c->slice_cnt, ref);
+
+    /* in-place amend on the packet after some existing data */
+    memset(buf, 0xcc, AMEND_TEST_BASE);
+    memcpy(buf + AMEND_TEST_BASE, hw_strm, hw_len);
+    mpp_packet_init(&pkt, buf, AMEND_TEST_BUF_SIZE);
+    mpp_packet_set_length(pkt, AMEND_TEST_BASE);
+
+    amend.enable = 1;
+    amend.slice = &sw.slice;
+    amend.packet = pkt;
+    amend.buf_base = AMEND_TEST_BASE;
+    amend.old_length = hw_len;
+
+    AMEND_TEST_CHECK(!h264e_vepu_stream_amend_proc(&amend));
+    AMEND_TEST_CHECK(amend.new_length == ref_len);
+    AMEND_TEST_CHECK(!memcmp(buf + AMEND_TEST_BASE, ref, ref_len));
+    AMEND_TEST_CHECK(c->sw_ext ? ref_len > hw_len : ref_len < hw_len);
+    for (i = 0; i < AMEND_TEST_BASE; i++)
+        AMEND_TEST_CHECK(buf[i] == 0xcc);
+
+    /* the output does not fit in the packet */
+    if (c->sw_ext) {
+        mpp_packet_deinit(&pkt);
+        memcpy(buf + AMEND_TEST_BASE, hw_strm, hw_len);
+        mpp_packet_init(&pkt, buf, AMEND_TEST_BASE + hw_len + 1);
+        amend_test_slice(&sw, c, c->sw_ext, 0);
+        amend.slice = &sw.slice;
+        amend.packet = pkt;
+        amend.old_length = hw_len;
+
+        AMEND_TEST_CHECK(h264e_vepu_stream_amend_proc(&amend));
+        AMEND_TEST_CHECK(amend.new_length <= hw_len + 1);
+    }
+
+DONE:
+    mpp_log("%-24s len %5d -> %5d %s\n", c->name, hw_len, ref_len,
+            ret ? "failed" : "success");
+
+    if (pkt)
+        mpp_packet_deinit(&pkt);
+    h264e_vepu_stream_amend_deinit(&amend);
+    MPP_FREE(buf);
+    MPP_FREE(hw_strm);
+    MPP_FREE(ref);
+
+    return ret;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_OK;
+    RK_U32 i;
+
+    mpp_log("h264e stream amend test start\n");
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(amend_test_cases); i++)
+        ret |= amend_test_run(&amend_test_cases[i]);
+
+    mpp_log("h264e stream amend test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -19,6 +19,7 @@
 #include <string.h>
 
 #include "mpp_env.h"
+#include "mpp_lock.h"
 #include "mpp_debug.h"
 #include "osal_2str.h"
 
@@ -28,23 +29,58 @@
 #include "hal_jpegd_vdpu2.h"
 #include "hal_jpegd_vdpu1.h"
 #include "hal_jpegd_rkv.h"
+#include "hal_jpegd_soft.h"
+
+/* jpeg hardware tasks in flight of all contexts in this process */
+static volatile RK_S32 jpegd_hw_load = 0;
 
 static MPP_RET hal_jpegd_reg_gen(void *hal, HalTaskInfo *task)
 {
     JpegdHalCtx *self = (JpegdHalCtx *)hal;
+
+    task->dec.flags.soft_dec = 0;
+    if (self->soft && self->hal_api.reg_gen != hal_jpegd_soft_gen_regs &&
+        hal_jpegd_soft_spill(self, task, jpegd_hw_load)) {
+        task->dec.flags.soft_dec = 1;
+        return hal_jpegd_soft_gen_regs(hal, task);
+    }
+
     return self->hal_api.reg_gen (hal, task);
 }
 
 static MPP_RET hal_jpegd_start(void *hal, HalTaskInfo *task)
 {
     JpegdHalCtx *self = (JpegdHalCtx *)hal;
-    return self->hal_api.start (hal, task);
+    MPP_RET ret;
+
+    if (task->dec.flags.soft_dec)
+        return hal_jpegd_soft_start(hal, task);
+
+    MPP_FETCH_ADD(&jpegd_hw_load, 1);
+    ret = self->hal_api.start (hal, task);
+    /* wait is still called on failed task so mark the counted one */
+    if (ret)
+        MPP_FETCH_SUB(&jpegd_hw_load, 1);
+    else
+        task->dec.flags.hw_load = 1;
+
+    return ret;
 }
 
 static MPP_RET hal_jpegd_wait(void *hal, HalTaskInfo *task)
 {
     JpegdHalCtx *self = (JpegdHalCtx *)hal;
-    return self->hal_api.wait (hal, task);
+    MPP_RET ret;
+
+    if (task->dec.flags.soft_dec)
+        return hal_jpegd_soft_wait(hal, task);
+
+    ret = self->hal_api.wait (hal, task);
+    if (task->dec.flags.hw_load) {
+        task->dec.flags.hw_load = 0;
+        MPP_FETCH_SUB(&jpegd_hw_load, 1);
+    }
+    return ret;
 }
 
 static MPP_RET hal_jpegd_reset(void *hal)
@@ -68,7 +104,11 @@ static MPP_RET hal_jpegd_control(void *hal, MpiCmd cmd_type, void *param)
 static MPP_RET hal_jpegd_deinit(void *hal)
 {
     JpegdHalCtx *self = (JpegdHalCtx *)hal;
-    return self->hal_api.deinit (hal);
+    MPP_RET ret = self->hal_api.deinit (hal);
+
+    /* software overflow of hardware backend */
+    hal_jpegd_soft_close(self);
+    return ret;
 }
 
 static MPP_RET hal_jpegd_init(void *hal, MppHalCfg *cfg)
@@ -79,6 +119,9 @@ static MPP_RET hal_jpegd_init(void *hal, MppHalCfg *cfg)
     MppDecBaseCfg *base = &cfg->cfg->base;
     RK_S32 hw_type = -1;
     RK_U32 hw_flag = 0;
+    RK_U32 soft = 0;
+    RK_U32 spill = 0;
+    MPP_RET ret;
 
     if (NULL == self)
         return MPP_ERR_VALUE;
@@ -111,6 +154,22 @@ static MPP_RET hal_jpegd_init(void *hal, MppHalCfg *cfg)
     }
 
     mpp_env_get_u32("jpegd_mode", &client_type, client_type);
+    mpp_env_get_u32("jpegd_soft", &soft, 0);
+    mpp_env_get_u32("jpegd_soft_spill", &spill, 0);
+
+    /* no jpeg decoder hardware found, decode by cpu */
+    if (soft || client_type == VPU_CLIENT_BUTT) {
+        p_api->init = hal_jpegd_soft_init;
+        p_api->deinit = hal_jpegd_soft_deinit;
+        p_api->reg_gen = hal_jpegd_soft_gen_regs;
+        p_api->start = hal_jpegd_soft_start;
+        p_api->wait = hal_jpegd_soft_wait;
+        p_api->reset = hal_jpegd_soft_reset;
+        p_api->flush = hal_jpegd_soft_flush;
+        p_api->control = hal_jpegd_soft_control;
+
+        return p_api->init(hal, cfg);
+    }
 
     switch (client_type) {
     case VPU_CLIENT_VDPU2 :
@@ -150,7 +209,11 @@ static MPP_RET hal_jpegd_init(void *hal, MppHalCfg *cfg)
     } break;
     }
 
-    return p_api->init(hal, cfg);
+    ret = p_api->init(hal, cfg);
+    if (!ret && spill)
+        ret = hal_jpegd_soft_open(self);
+
+    return ret;
 }
 
 const MppHalApi hal_api_jpegd = {
@@ -58,6 +58,11 @@ typedef struct JpegdHalCtx {
 
     RK_U32                 have_pp;
     PPInfo                 pp_info;
+
+    /* software decoder context, see hal_jpegd_soft.h */
+    void                   *soft;
+    /* multi-core strip decoding context of hardware backend */
+    void                   *ctx_ext;
 } JpegdHalCtx;
 
 #endif /* __HAL_JPEGD_COMMON_H__ */
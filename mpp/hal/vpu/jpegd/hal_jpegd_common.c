@@ -574,3 +574,100 @@ MPP_RET jpeg_image_check_size(RK_U32 hor_stride, RK_U32 ver_stride)
 
     return ret;
 }
+
+static RK_U32 jpegd_gcd(RK_U32 a, RK_U32 b)
+{
+    while (b) {
+        RK_U32 t = a % b;
+
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+RK_S32 jpegd_split_strips(JpegdSyntax *syntax, const RK_U8 *strm,
+                          JpegdStrip *strips, RK_S32 max)
+{
+    JpegdSyntax *s = syntax;
+    RK_U32 mcu_w = (s->nb_components == 1) ? 8 : s->h_max * 8;
+    RK_U32 mcu_h = (s->nb_components == 1) ? 8 : s->v_max * 8;
+    RK_U32 mb_rows = s->ver_stride >> 4;
+    RK_U32 ri = s->restart_interval;
+    RK_U32 seg_idx[JPEGD_STRIP_MAX];
+    RK_U32 mcus_per_row;
+    RK_U32 step, units;
+    RK_U32 seg, found;
+    const RK_U8 *pos;
+    const RK_U8 *end;
+    RK_S32 cnt;
+    RK_S32 i;
+
+    if (!ri || max < 2 || !mcu_h || (16 % mcu_h) || NULL == strm)
+        return 1;
+
+    /* mcus in one macroblock row */
+    mcus_per_row = (s->width + mcu_w - 1) / mcu_w * (16 / mcu_h);
+
+    /* strips can only begin on rows where a restart interval begins */
+    step = ri / jpegd_gcd(ri, mcus_per_row);
+    units = mb_rows / step;
+    cnt = MPP_MIN(max, (RK_S32)MPP_MIN(units, JPEGD_STRIP_MAX));
+    if (cnt < 2)
+        return 1;
+
+    /* begin each strip on the row candidate nearest to even split */
+    for (i = 0; i < cnt; i++) {
+        strips[i].mb_y = (mb_rows * i / cnt + step / 2) / step * step;
+        seg_idx[i] = strips[i].mb_y * mcus_per_row / ri;
+    }
+
+    for (i = 0; i < cnt; i++) {
+        RK_U32 next = (i + 1 < cnt) ? strips[i + 1].mb_y : mb_rows;
+
+        strips[i].mb_rows = next - strips[i].mb_y;
+    }
+
+    /* locate the RST marker in front of each strip */
+    strips[0].strm_offset = s->strm_offset;
+    pos = strm + s->strm_offset;
+    end = strm + s->pkt_len;
+    seg = 0;
+    found = 1;
+
+    while (found < (RK_U32)cnt && pos + 1 < end) {
+        const RK_U8 *ff = memchr(pos, 0xff, end - pos - 1);
+        RK_U32 m;
+
+        if (NULL == ff)
+            break;
+
+        m = ff[1];
+        if (m == 0xff) {
+            pos = ff + 1;
+            continue;
+        }
+
+        pos = ff + 2;
+        if (m < 0xd0 || m > 0xd7) {
+            /* stuffed zero byte or end of scan */
+            if (m)
+                break;
+            continue;
+        }
+
+        seg++;
+        if (seg == seg_idx[found]) {
+            strips[found].strm_offset = pos - strm;
+            found++;
+        }
+    }
+
+    if (found < (RK_U32)cnt) {
+        jpegd_dbg_hal("found %d of %d strips, decode as one picture\n", found, cnt);
+        return 1;
+    }
+
+    return cnt;
+}
@@ -43,6 +43,8 @@
 #define MAX_HEIGHT                        (8*1024)  /* 4K Bytes */
 #define MAX_STREAM_LENGTH                 (MAX_WIDTH * MAX_HEIGHT) /* 16M Bytes */
 
+#define JPEGD_STRIP_MAX                   (4)
+
 static const RK_U8 zzOrder[64] = {
     0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
     12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
@@ -69,6 +71,17 @@ typedef struct PpRgbCfg_t {
     RK_U32  b_mask;
 } PpRgbCfg;
 
+/*
+ * Horizontal strip of a picture with restart interval. Each strip starts
+ * right after a RST marker on a macroblock row, so it can be decoded as an
+ * independent picture by another hardware core.
+ */
+typedef struct JpegdStrip_t {
+    RK_U32  strm_offset;    /* entropy data start of the strip in packet */
+    RK_U32  mb_y;           /* first macroblock row */
+    RK_U32  mb_rows;        /* macroblock row count */
+} JpegdStrip;
+
 PpRgbCfg* get_pp_rgb_Cfg(MppFrameFormat fmt);
 RK_U32 jpegd_vdpu_tail_0xFF_patch(MppBuffer stream, RK_U32 length);
 
@@ -81,4 +94,8 @@ MPP_RET jpegd_setup_output_fmt(JpegdHalCtx *ctx, JpegdSyntax *syntax,
 
 MPP_RET jpeg_image_check_size(RK_U32 hor_stride, RK_U32 ver_stride);
 
+/* split picture into at most max strips, return the strip count */
+RK_S32 jpegd_split_strips(JpegdSyntax *syntax, const RK_U8 *strm,
+                          JpegdStrip *strips, RK_S32 max);
+
 #endif /* __HAL_JPEGD_COMMON_H__ */
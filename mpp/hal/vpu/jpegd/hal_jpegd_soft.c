@@ -0,0 +1,1059 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "hal_jpegd_soft"
+
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_debug.h"
+#include "mpp_frame.h"
+#include "mpp_common.h"
+
+#include "jpegd_syntax.h"
+#include "hal_jpegd_common.h"
+#include "hal_jpegd_soft.h"
+
+/* huffman codes up to this length are decoded by one table lookup */
+#define SOFT_LOOKAHEAD          9
+#define SOFT_THREAD_MAX         8
+/* a thread is only worth for this many restart intervals */
+#define SOFT_SEG_PER_THREAD     2
+/* max blocks in one component of a mcu */
+#define SOFT_SAMPLING_MAX       4
+#define SOFT_MARKER_RST0        0xd0
+#define SOFT_MARKER_RST7        0xd7
+
+/*
+ * 8 lanes of idct data. The compiler maps the operation to the native simd
+ * instructions, neon on arm and sse / avx on x86.
+ */
+typedef RK_S32 SoftVec __attribute__((vector_size(32)));
+
+typedef union SoftBlock_u {
+    SoftVec         v[8];
+    RK_S32          s[8][8];
+} SoftBlock;
+
+typedef struct JpegdSoftHuff_t {
+    RK_U8           look_len[1 << SOFT_LOOKAHEAD];
+    RK_U8           look_sym[1 << SOFT_LOOKAHEAD];
+    RK_S32          maxcode[MAX_HUFFMAN_CODE_BIT_LENGTH + 1];
+    RK_S32          valoffset[MAX_HUFFMAN_CODE_BIT_LENGTH + 1];
+    RK_U8           vals[256];
+} JpegdSoftHuff;
+
+typedef struct JpegdSoftBits_t {
+    const RK_U8     *pos;
+    const RK_U8     *end;
+    RK_U64          buf;
+    RK_S32          cnt;
+    /* zero bytes fed after the end of data */
+    RK_S32          pad;
+} JpegdSoftBits;
+
+typedef struct JpegdSoftSeg_t {
+    const RK_U8     *start;
+    const RK_U8     *end;
+} JpegdSoftSeg;
+
+typedef struct JpegdSoftComp_t {
+    RK_U8           *plane;
+    RK_S32          stride;
+    RK_S32          height;
+    /* blocks of this component in one mcu */
+    RK_S32          h;
+    RK_S32          v;
+    const RK_U16    *quant;
+    JpegdSoftHuff   *dc;
+    JpegdSoftHuff   *ac;
+} JpegdSoftComp;
+
+typedef struct JpegdSoftJob_t {
+    struct JpegdSoftCtx_t *ctx;
+    RK_S32          first;
+    RK_S32          last;
+    RK_U32          err;
+} JpegdSoftJob;
+
+typedef struct JpegdSoftCtx_t {
+    RK_U32          threads;
+    RK_U32          spill;
+
+    /* workers live with the context, job 0 runs on the calling thread */
+    pthread_t       thds[SOFT_THREAD_MAX];
+    RK_S32          thd_cnt;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond_job;
+    pthread_cond_t  cond_done;
+    RK_U32          job_seq;
+    RK_S32          job_cnt;
+    RK_S32          job_pending;
+    RK_U32          quit;
+    JpegdSoftJob    jobs[SOFT_THREAD_MAX];
+
+    JpegdSoftHuff   dc[HUFFMAN_TABLE_ID_TWO];
+    JpegdSoftHuff   ac[HUFFMAN_TABLE_ID_TWO];
+    JpegdSoftComp   comp[MAX_COMPONENTS];
+    RK_S32          comp_cnt;
+    RK_S32          h_max;
+    RK_S32          v_max;
+    RK_S32          mcus_x;
+    RK_S32          mcus_y;
+    RK_S32          mcu_total;
+    /* mcus in one restart interval */
+    RK_S32          mcu_seg;
+
+    RK_U8           *planes;
+    size_t          planes_size;
+
+    JpegdSoftSeg    *segs;
+    RK_S32          seg_cnt;
+    RK_S32          seg_max;
+
+    RK_S32          *xmap;
+    RK_S32          xmap_size;
+
+    MppFrameFormat  fmt;
+    RK_U8           *dst;
+    RK_S32          hor_stride;
+    RK_S32          ver_stride;
+    RK_U32          errinfo;
+} JpegdSoftCtx;
+
+static MPP_RET soft_huff_build(JpegdSoftHuff *h, const RK_U32 *bits,
+                               const RK_U32 *vals, RK_U32 count)
+{
+    RK_S32 code = 0;
+    RK_U32 k = 0;
+    RK_S32 len;
+
+    memset(h->look_len, 0, sizeof(h->look_len));
+
+    for (len = 1; len <= MAX_HUFFMAN_CODE_BIT_LENGTH; len++) {
+        RK_U32 n = bits[len - 1];
+        RK_U32 i;
+
+        h->valoffset[len] = (RK_S32)k - code;
+
+        for (i = 0; i < n; i++, k++, code++) {
+            if (k >= count || k >= MPP_ARRAY_ELEMS(h->vals))
+                return MPP_NOK;
+
+            /* over-subscribed table must be rejected before the lookup fill */
+            if (code >= (1 << len))
+                return MPP_NOK;
+
+            h->vals[k] = (RK_U8)vals[k];
+
+            if (len <= SOFT_LOOKAHEAD) {
+                RK_S32 shift = SOFT_LOOKAHEAD - len;
+                RK_S32 base = code << shift;
+                RK_S32 j;
+
+                for (j = 0; j < (1 << shift); j++) {
+                    h->look_len[base + j] = len;
+                    h->look_sym[base + j] = (RK_U8)vals[k];
+                }
+            }
+        }
+
+        h->maxcode[len] = n ? code - 1 : -1;
+        code <<= 1;
+    }
+
+    return MPP_OK;
+}
+
+static void soft_bits_fill(JpegdSoftBits *b)
+{
+    while (b->cnt <= 56) {
+        RK_U32 c = 0;
+
+        if (b->pos < b->end) {
+            c = *b->pos++;
+            if (c == 0xff) {
+                if (b->pos < b->end && !b->pos[0]) {
+                    b->pos++;
+                } else {
+                    /* marker or truncated stream, feed zero from now on */
+                    b->pos = b->end;
+                    c = 0;
+                    b->pad++;
+                }
+            }
+        } else {
+            b->pad++;
+        }
+
+        b->buf |= (RK_U64)c << (56 - b->cnt);
+        b->cnt += 8;
+    }
+}
+
+static inline RK_S32 soft_huff_decode(JpegdSoftBits *b, const JpegdSoftHuff *h)
+{
+    RK_U32 look;
+    RK_S32 len;
+
+    if (b->cnt < MAX_HUFFMAN_CODE_BIT_LENGTH)
+        soft_bits_fill(b);
+
+    look = (RK_U32)(b->buf >> (64 - SOFT_LOOKAHEAD));
+    len = h->look_len[look];
+    if (len) {
+        b->buf <<= len;
+        b->cnt -= len;
+        return h->look_sym[look];
+    }
+
+    for (len = SOFT_LOOKAHEAD + 1; len <= MAX_HUFFMAN_CODE_BIT_LENGTH; len++) {
+        RK_S32 code = (RK_S32)(b->buf >> (64 - len));
+
+        if (code <= h->maxcode[len]) {
+            b->buf <<= len;
+            b->cnt -= len;
+            return h->vals[code + h->valoffset[len]];
+        }
+    }
+
+    return -1;
+}
+
+static inline RK_S32 soft_get_signed(JpegdSoftBits *b, RK_S32 s)
+{
+    RK_S32 v;
+
+    if (b->cnt < s)
+        soft_bits_fill(b);
+
+    v = (RK_S32)(b->buf >> (64 - s));
+    b->buf <<= s;
+    b->cnt -= s;
+
+    if (v < (1 << (s - 1)))
+        v -= (1 << s) - 1;
+
+    return v;
+}
+
+/* return the last coefficient index, 0 for dc only block, negative on error */
+static RK_S32 soft_decode_block(JpegdSoftBits *b, const JpegdSoftComp *c,
+                                RK_S32 *pred, RK_S32 *blk)
+{
+    const RK_U16 *q = c->quant;
+    RK_S32 last = 0;
+    RK_S32 k;
+    RK_S32 s;
+
+    s = soft_huff_decode(b, c->dc);
+    if (s < 0 || s > 11)
+        return -1;
+
+    if (s)
+        *pred += soft_get_signed(b, s);
+
+    blk[0] = *pred * q[0];
+
+    for (k = 1; k < 64; k++) {
+        RK_S32 rs = soft_huff_decode(b, c->ac);
+
+        if (rs < 0)
+            return -1;
+
+        s = rs & 15;
+        if (!s) {
+            if (rs != 0xf0)
+                break;
+
+            k += 15;
+            continue;
+        }
+
+        k += rs >> 4;
+        if (k > 63)
+            return -1;
+
+        blk[zzOrder[k]] = soft_get_signed(b, s) * q[k];
+        last = k;
+    }
+
+    return last;
+}
+
+#define SOFT_CONST_BITS         13
+#define SOFT_PASS1_BITS         2
+
+#define FIX_0_298631336         2446
+#define FIX_0_390180644         3196
+#define FIX_0_541196100         4433
+#define FIX_0_765366865         6270
+#define FIX_0_899976223         7373
+#define FIX_1_175875602         9633
+#define FIX_1_501321110         12299
+#define FIX_1_847759065         15137
+#define FIX_1_961570560         16069
+#define FIX_2_053119869         16819
+#define FIX_2_562915447         20995
+#define FIX_3_072711026         25172
+
+/* accurate integer idct of 8 rows or columns at once */
+static inline void soft_idct_1d(const SoftVec *in, SoftVec *out, RK_S32 shift)
+{
+    RK_S32 round = 1 << (shift - 1);
+    SoftVec tmp0, tmp1, tmp2, tmp3;
+    SoftVec tmp10, tmp11, tmp12, tmp13;
+    SoftVec z1, z2, z3, z4, z5;
+
+    z1 = (in[2] + in[6]) * FIX_0_541196100;
+    tmp2 = z1 - in[6] * FIX_1_847759065;
+    tmp3 = z1 + in[2] * FIX_0_765366865;
+
+    tmp0 = (in[0] + in[4]) << SOFT_CONST_BITS;
+    tmp1 = (in[0] - in[4]) << SOFT_CONST_BITS;
+
+    tmp10 = tmp0 + tmp3 + round;
+    tmp13 = tmp0 - tmp3 + round;
+    tmp11 = tmp1 + tmp2 + round;
+    tmp12 = tmp1 - tmp2 + round;
+
+    z1 = in[7] + in[1];
+    z2 = in[5] + in[3];
+    z3 = in[7] + in[3];
+    z4 = in[5] + in[1];
+    z5 = (z3 + z4) * FIX_1_175875602;
+
+    tmp0 = in[7] * FIX_0_298631336;
+    tmp1 = in[5] * FIX_2_053119869;
+    tmp2 = in[3] * FIX_3_072711026;
+    tmp3 = in[1] * FIX_1_501321110;
+    z1 = z1 * -FIX_0_899976223;
+    z2 = z2 * -FIX_2_562915447;
+    z3 = z3 * -FIX_1_961570560 + z5;
+    z4 = z4 * -FIX_0_390180644 + z5;
+
+    tmp0 += z1 + z3;
+    tmp1 += z2 + z4;
+    tmp2 += z2 + z3;
+    tmp3 += z1 + z4;
+
+    out[0] = (tmp10 + tmp3) >> shift;
+    out[7] = (tmp10 - tmp3) >> shift;
+    out[1] = (tmp11 + tmp2) >> shift;
+    out[6] = (tmp11 - tmp2) >> shift;
+    out[2] = (tmp12 + tmp1) >> shift;
+    out[5] = (tmp12 - tmp1) >> shift;
+    out[3] = (tmp13 + tmp0) >> shift;
+    out[4] = (tmp13 - tmp0) >> shift;
+}
+
+static inline RK_U8 soft_clip(RK_S32 v)
+{
+    return (v < 0) ? 0 : (v > 255) ? 255 : (RK_U8)v;
+}
+
+static void soft_idct(const SoftBlock *blk, RK_U8 *dst, RK_S32 stride)
+{
+    SoftBlock tmp;
+    SoftBlock col;
+    RK_S32 i, j;
+
+    /* columns first, the lanes are columns */
+    soft_idct_1d(blk->v, tmp.v, SOFT_CONST_BITS - SOFT_PASS1_BITS);
+
+    for (i = 0; i < 8; i++)
+        for (j = 0; j < 8; j++)
+            col.s[j][i] = tmp.s[i][j];
+
+    /* then rows, the lanes are rows */
+    soft_idct_1d(col.v, tmp.v, SOFT_CONST_BITS + SOFT_PASS1_BITS + 3);
+
+    for (i = 0; i < 8; i++, dst += stride)
+        for (j = 0; j < 8; j++)
+            dst[j] = soft_clip(tmp.s[j][i] + 128);
+}
+
+static void soft_idct_dc(RK_S32 dc, RK_U8 *dst, RK_S32 stride)
+{
+    RK_U8 val = soft_clip(((dc + 4) >> 3) + 128);
+    RK_S32 i;
+
+    for (i = 0; i < 8; i++, dst += stride)
+        memset(dst, val, 8);
+}
+
+static RK_U32 soft_decode_segs(JpegdSoftCtx *p, RK_S32 first, RK_S32 last)
+{
+    SoftBlock blk;
+    RK_U32 err = 0;
+    RK_S32 seg;
+
+    for (seg = first; seg < last; seg++) {
+        JpegdSoftBits b;
+        RK_S32 pred[MAX_COMPONENTS] = { 0 };
+        RK_S32 mcu = seg * p->mcu_seg;
+        RK_S32 mcu_end = MPP_MIN(mcu + p->mcu_seg, p->mcu_total);
+
+        b.pos = p->segs[seg].start;
+        b.end = p->segs[seg].end;
+        b.buf = 0;
+        b.cnt = 0;
+        b.pad = 0;
+
+        for (; mcu < mcu_end; mcu++) {
+            RK_S32 mx = mcu % p->mcus_x;
+            RK_S32 my = mcu / p->mcus_x;
+            RK_S32 c, h, v;
+
+            for (c = 0; c < p->comp_cnt; c++) {
+                const JpegdSoftComp *comp = &p->comp[c];
+
+                for (v = 0; v < comp->v; v++) {
+                    for (h = 0; h < comp->h; h++) {
+                        RK_U8 *dst = comp->plane +
+                                     ((my * comp->v + v) * 8) * comp->stride +
+                                     (mx * comp->h + h) * 8;
+                        RK_S32 ret;
+
+                        memset(&blk, 0, sizeof(blk));
+                        ret = soft_decode_block(&b, comp, &pred[c], &blk.s[0][0]);
+                        if (ret < 0) {
+                            err = 1;
+                            goto NEXT_SEG;
+                        }
+
+                        if (ret)
+                            soft_idct(&blk, dst, comp->stride);
+                        else
+                            soft_idct_dc(blk.s[0][0], dst, comp->stride);
+                    }
+                }
+            }
+        }
+
+        /* padding bits are consumed on truncated stream */
+        if (b.pad * 8 > b.cnt)
+            err = 1;
+    NEXT_SEG:
+        ;
+    }
+
+    return err;
+}
+
+static void *soft_decode_thread(void *arg)
+{
+    JpegdSoftJob *job = (JpegdSoftJob *)arg;
+    JpegdSoftCtx *p = job->ctx;
+    RK_S32 idx = (RK_S32)(job - p->jobs);
+    RK_U32 seq = 0;
+
+    pthread_mutex_lock(&p->lock);
+    while (1) {
+        while (!p->quit && seq == p->job_seq)
+            pthread_cond_wait(&p->cond_job, &p->lock);
+
+        if (p->quit)
+            break;
+
+        seq = p->job_seq;
+        if (idx >= p->job_cnt)
+            continue;
+
+        pthread_mutex_unlock(&p->lock);
+        job->err = soft_decode_segs(p, job->first, job->last);
+        pthread_mutex_lock(&p->lock);
+
+        if (!--p->job_pending)
+            pthread_cond_signal(&p->cond_done);
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    return NULL;
+}
+
+/* start the workers on first multi-thread frame, keep them until close */
+static void soft_pool_start(JpegdSoftCtx *p)
+{
+    RK_S32 i;
+
+    if (p->thd_cnt || p->threads <= 1)
+        return;
+
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond_job, NULL);
+    pthread_cond_init(&p->cond_done, NULL);
+
+    for (i = 1; i < (RK_S32)p->threads; i++) {
+        p->jobs[i].ctx = p;
+        if (pthread_create(&p->thds[i], NULL, soft_decode_thread, &p->jobs[i]))
+            break;
+    }
+
+    /* the calling thread counts as one */
+    p->thd_cnt = i;
+}
+
+static void soft_pool_stop(JpegdSoftCtx *p)
+{
+    RK_S32 i;
+
+    if (!p->thd_cnt)
+        return;
+
+    pthread_mutex_lock(&p->lock);
+    p->quit = 1;
+    pthread_cond_broadcast(&p->cond_job);
+    pthread_mutex_unlock(&p->lock);
+
+    for (i = 1; i < p->thd_cnt; i++)
+        pthread_join(p->thds[i], NULL);
+
+    pthread_cond_destroy(&p->cond_done);
+    pthread_cond_destroy(&p->cond_job);
+    pthread_mutex_destroy(&p->lock);
+    p->thd_cnt = 0;
+}
+
+static RK_U32 soft_decode(JpegdSoftCtx *p)
+{
+    RK_S32 cnt = MPP_MIN((RK_S32)p->threads, p->seg_cnt / SOFT_SEG_PER_THREAD);
+    RK_U32 err = 0;
+    RK_S32 i;
+
+    if (cnt > 1)
+        soft_pool_start(p);
+
+    cnt = MPP_MIN(cnt, p->thd_cnt);
+    if (cnt <= 1)
+        return soft_decode_segs(p, 0, p->seg_cnt);
+
+    pthread_mutex_lock(&p->lock);
+    for (i = 0; i < cnt; i++) {
+        p->jobs[i].ctx = p;
+        p->jobs[i].first = p->seg_cnt * i / cnt;
+        p->jobs[i].last = p->seg_cnt * (i + 1) / cnt;
+        p->jobs[i].err = 0;
+    }
+    p->job_cnt = cnt;
+    p->job_pending = cnt - 1;
+    p->job_seq++;
+    pthread_cond_broadcast(&p->cond_job);
+    pthread_mutex_unlock(&p->lock);
+
+    /* the calling thread takes the first part */
+    err = soft_decode_segs(p, p->jobs[0].first, p->jobs[0].last);
+
+    pthread_mutex_lock(&p->lock);
+    while (p->job_pending)
+        pthread_cond_wait(&p->cond_done, &p->lock);
+    pthread_mutex_unlock(&p->lock);
+
+    for (i = 1; i < cnt; i++)
+        err |= p->jobs[i].err;
+
+    return err;
+}
+
+static MPP_RET soft_add_seg(JpegdSoftCtx *p, const RK_U8 *start, const RK_U8 *end)
+{
+    if (p->seg_cnt >= p->seg_max) {
+        RK_S32 max = p->seg_max ? p->seg_max * 2 : 64;
+        JpegdSoftSeg *segs = mpp_realloc(p->segs, JpegdSoftSeg, max);
+
+        if (NULL == segs)
+            return MPP_ERR_NOMEM;
+
+        p->segs = segs;
+        p->seg_max = max;
+    }
+
+    p->segs[p->seg_cnt].start = start;
+    p->segs[p->seg_cnt].end = end;
+    p->seg_cnt++;
+
+    return MPP_OK;
+}
+
+/* split the entropy coded data at restart markers */
+static MPP_RET soft_split_segs(JpegdSoftCtx *p, const RK_U8 *data, const RK_U8 *end)
+{
+    const RK_U8 *start = data;
+    const RK_U8 *pos = data;
+    MPP_RET ret;
+
+    p->seg_cnt = 0;
+
+    while (pos < end) {
+        const RK_U8 *ff = memchr(pos, 0xff, end - pos);
+        RK_U32 m;
+
+        if (NULL == ff || ff + 1 >= end)
+            break;
+
+        m = ff[1];
+        if (m == 0xff) {
+            /* fill byte */
+            pos = ff + 1;
+            continue;
+        }
+
+        if (!m) {
+            /* stuffed zero byte */
+            pos = ff + 2;
+            continue;
+        }
+
+        if (m >= SOFT_MARKER_RST0 && m <= SOFT_MARKER_RST7 && p->mcu_seg < p->mcu_total) {
+            ret = soft_add_seg(p, start, ff);
+            if (ret)
+                return ret;
+
+            start = ff + 2;
+            pos = start;
+            continue;
+        }
+
+        /* any other marker ends the scan */
+        end = ff;
+        break;
+    }
+
+    return soft_add_seg(p, start, end);
+}
+
+static MPP_RET soft_check_fmt(JpegdHalCtx *ctx, JpegdSyntax *s, MppFrameFormat *fmt)
+{
+    MppFrameFormat out = ctx->set_output_fmt_flag ? ctx->output_fmt : s->output_fmt;
+
+    /* no native output for these samplings, convert to yuv420sp */
+    if (out == MPP_FMT_YUV440SP || out == MPP_FMT_YUV411SP)
+        out = MPP_FMT_YUV420SP;
+
+    switch (out) {
+    case MPP_FMT_YUV420SP :
+    case MPP_FMT_YUV422SP :
+    case MPP_FMT_YUV444SP :
+    case MPP_FMT_YUV400 : {
+    } break;
+    default : {
+        jpegd_dbg_hal("soft decoder does not support output format %x\n", out);
+        return MPP_NOK;
+    } break;
+    }
+
+    if (s->sample_precision != DCT_SAMPLE_PRECISION_8 ||
+        s->qtable_cnt != s->nb_components) {
+        jpegd_dbg_hal("soft decoder does not support precision %d scan %d/%d\n",
+                      s->sample_precision, s->qtable_cnt, s->nb_components);
+        return MPP_NOK;
+    }
+
+    if (fmt)
+        *fmt = out;
+
+    return MPP_OK;
+}
+
+static MPP_RET soft_setup(JpegdHalCtx *ctx, JpegdSyntax *s)
+{
+    JpegdSoftCtx *p = (JpegdSoftCtx *)ctx->soft;
+    size_t size = 0;
+    RK_U8 *plane;
+    RK_U32 i;
+
+    p->comp_cnt = s->nb_components;
+    if (p->comp_cnt == 1) {
+        /* non-interleaved scan, one block per mcu */
+        p->h_max = 1;
+        p->v_max = 1;
+    } else {
+        p->h_max = s->h_max;
+        p->v_max = s->v_max;
+    }
+
+    p->mcus_x = (s->width + p->h_max * 8 - 1) / (p->h_max * 8);
+    p->mcus_y = (s->height + p->v_max * 8 - 1) / (p->v_max * 8);
+    p->mcu_total = p->mcus_x * p->mcus_y;
+    p->mcu_seg = s->restart_interval ? (RK_S32)s->restart_interval : p->mcu_total;
+
+    for (i = 0; i < HUFFMAN_TABLE_ID_TWO; i++) {
+        if (soft_huff_build(&p->dc[i], s->dc_table[i].bits, s->dc_table[i].vals,
+                            s->dc_table[i].actual_length) ||
+            soft_huff_build(&p->ac[i], s->ac_table[i].bits, s->ac_table[i].vals,
+                            s->ac_table[i].actual_length)) {
+            mpp_err_f("invalid huffman table %d\n", i);
+            return MPP_ERR_STREAM;
+        }
+    }
+
+    for (i = 0; i < (RK_U32)p->comp_cnt; i++) {
+        JpegdSoftComp *comp = &p->comp[i];
+
+        comp->h = (p->comp_cnt == 1) ? 1 : (RK_S32)s->h_count[i];
+        comp->v = (p->comp_cnt == 1) ? 1 : (RK_S32)s->v_count[i];
+        if (comp->h > SOFT_SAMPLING_MAX || comp->v > SOFT_SAMPLING_MAX) {
+            mpp_err_f("invalid sampling %d:%d\n", comp->h, comp->v);
+            return MPP_ERR_STREAM;
+        }
+
+        comp->stride = p->mcus_x * comp->h * 8;
+        comp->height = p->mcus_y * comp->v * 8;
+        comp->quant = s->quant_matrixes[s->quant_index[i]];
+        comp->dc = &p->dc[s->dc_index[i]];
+        comp->ac = &p->ac[s->ac_index[i]];
+        size += comp->stride * comp->height;
+    }
+
+    if (size > p->planes_size) {
+        MPP_FREE(p->planes);
+        p->planes = mpp_malloc(RK_U8, size);
+        if (NULL == p->planes) {
+            p->planes_size = 0;
+            return MPP_ERR_NOMEM;
+        }
+        p->planes_size = size;
+    }
+
+    plane = p->planes;
+    for (i = 0; i < (RK_U32)p->comp_cnt; i++) {
+        p->comp[i].plane = plane;
+        plane += p->comp[i].stride * p->comp[i].height;
+    }
+
+    return MPP_OK;
+}
+
+static void soft_write_frame(JpegdSoftCtx *p)
+{
+    const JpegdSoftComp *y = &p->comp[0];
+    RK_S32 hor_stride = p->hor_stride;
+    RK_S32 ver_stride = p->ver_stride;
+    RK_S32 rows = MPP_MIN(ver_stride, y->height);
+    RK_S32 cols = MPP_MIN(hor_stride, y->stride);
+    RK_U8 *dst = p->dst;
+    RK_S32 sub_x, sub_y, cw, ch;
+    RK_S32 i, j;
+
+    for (i = 0; i < rows; i++)
+        memcpy(dst + i * hor_stride, y->plane + i * y->stride, cols);
+
+    if (p->fmt == MPP_FMT_YUV400)
+        return;
+
+    sub_x = (p->fmt == MPP_FMT_YUV444SP) ? 1 : 2;
+    sub_y = (p->fmt == MPP_FMT_YUV420SP) ? 2 : 1;
+    cw = hor_stride / sub_x;
+    ch = ver_stride / sub_y;
+    dst += hor_stride * ver_stride;
+
+    if (p->comp_cnt == 1) {
+        memset(dst, 128, cw * ch * 2);
+        return;
+    }
+
+    {
+        const JpegdSoftComp *cb = &p->comp[1];
+        const JpegdSoftComp *cr = &p->comp[2];
+        RK_U32 same = (sub_x * cb->h == p->h_max) && (cw <= cb->stride);
+
+        if (!same) {
+            if (cw > p->xmap_size) {
+                MPP_FREE(p->xmap);
+                p->xmap = mpp_malloc(RK_S32, cw);
+                p->xmap_size = p->xmap ? cw : 0;
+                if (NULL == p->xmap)
+                    return;
+            }
+
+            for (j = 0; j < cw; j++)
+                p->xmap[j] = MPP_MIN(j * sub_x * cb->h / p->h_max, cb->stride - 1);
+        }
+
+        for (i = 0; i < ch; i++) {
+            RK_S32 sy = MPP_MIN(i * sub_y * cb->v / p->v_max, cb->height - 1);
+            const RK_U8 *u = cb->plane + sy * cb->stride;
+            const RK_U8 *v = cr->plane + sy * cr->stride;
+            RK_U8 *uv = dst + i * cw * 2;
+
+            if (same) {
+                for (j = 0; j < cw; j++) {
+                    uv[2 * j] = u[j];
+                    uv[2 * j + 1] = v[j];
+                }
+            } else {
+                for (j = 0; j < cw; j++) {
+                    uv[2 * j] = u[p->xmap[j]];
+                    uv[2 * j + 1] = v[p->xmap[j]];
+                }
+            }
+        }
+    }
+}
+
+static size_t soft_frame_size(MppFrameFormat fmt, RK_S32 hor_stride, RK_S32 ver_stride)
+{
+    size_t size = hor_stride * ver_stride;
+
+    switch (fmt) {
+    case MPP_FMT_YUV420SP : return size * 3 / 2;
+    case MPP_FMT_YUV422SP : return size * 2;
+    case MPP_FMT_YUV444SP : return size * 3;
+    default : break;
+    }
+
+    return size;
+}
+
+MPP_RET hal_jpegd_soft_open(JpegdHalCtx *ctx)
+{
+    JpegdSoftCtx *p = mpp_calloc(JpegdSoftCtx, 1);
+    RK_U32 threads = 0;
+
+    if (NULL == p) {
+        mpp_err_f("malloc soft context failed\n");
+        return MPP_ERR_NOMEM;
+    }
+
+    mpp_env_get_u32("jpegd_soft_threads", &threads, 0);
+    mpp_env_get_u32("jpegd_soft_spill", &p->spill, 0);
+
+    if (!threads) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+        threads = (cpus > 0) ? (RK_U32)cpus : 1;
+    }
+    p->threads = MPP_MIN(threads, SOFT_THREAD_MAX);
+
+    ctx->soft = p;
+
+    jpegd_dbg_hal("soft decoder threads %d spill %d\n", p->threads, p->spill);
+
+    return MPP_OK;
+}
+
+void hal_jpegd_soft_close(JpegdHalCtx *ctx)
+{
+    JpegdSoftCtx *p = (JpegdSoftCtx *)ctx->soft;
+
+    if (NULL == p)
+        return;
+
+    soft_pool_stop(p);
+    MPP_FREE(p->planes);
+    MPP_FREE(p->segs);
+    MPP_FREE(p->xmap);
+    MPP_FREE(ctx->soft);
+}
+
+RK_U32 hal_jpegd_soft_spill(JpegdHalCtx *ctx, HalTaskInfo *task, RK_S32 hw_load)
+{
+    JpegdSoftCtx *p = (JpegdSoftCtx *)ctx->soft;
+    JpegdSyntax *s = (JpegdSyntax *)task->dec.syntax.data;
+
+    if (NULL == p || !p->spill || hw_load < (RK_S32)p->spill || !task->dec.valid)
+        return 0;
+
+    if (soft_check_fmt(ctx, s, NULL))
+        return 0;
+
+    jpegd_dbg_hal("spill %dx%d to soft decoder on hw load %d\n",
+                  s->width, s->height, hw_load);
+
+    return 1;
+}
+
+MPP_RET hal_jpegd_soft_init(void *hal, MppHalCfg *cfg)
+{
+    JpegdHalCtx *ctx = (JpegdHalCtx *)hal;
+
+    jpegd_dbg_func("enter\n");
+
+    ctx->packet_slots = cfg->packet_slots;
+    ctx->frame_slots = cfg->frame_slots;
+    ctx->dev_type = VPU_CLIENT_BUTT;
+    ctx->output_fmt = MPP_FMT_YUV420SP;
+    ctx->set_output_fmt_flag = 0;
+    cfg->dev = NULL;
+
+    mpp_log("init with software decoder\n");
+
+    jpegd_dbg_func("exit\n");
+    return hal_jpegd_soft_open(ctx);
+}
+
+MPP_RET hal_jpegd_soft_deinit(void *hal)
+{
+    JpegdHalCtx *ctx = (JpegdHalCtx *)hal;
+
+    jpegd_dbg_func("enter\n");
+
+    hal_jpegd_soft_close(ctx);
+    ctx->set_output_fmt_flag = 0;
+
+    jpegd_dbg_func("exit\n");
+    return MPP_OK;
+}
+
+MPP_RET hal_jpegd_soft_gen_regs(void *hal, HalTaskInfo *task)
+{
+    JpegdHalCtx *ctx = (JpegdHalCtx *)hal;
+    JpegdSoftCtx *p = (JpegdSoftCtx *)ctx->soft;
+    JpegdSyntax *s = (JpegdSyntax *)task->dec.syntax.data;
+    MppBuffer strm_buf = NULL;
+    MppBuffer frm_buf = NULL;
+    MppFrame frm = NULL;
+    RK_U8 *strm;
+    MPP_RET ret = MPP_OK;
+
+    jpegd_dbg_func("enter\n");
+
+    if (!task->dec.valid)
+        return MPP_OK;
+
+    ret = jpeg_image_check_size(s->hor_stride, s->ver_stride);
+    if (ret)
+        goto RET;
+
+    ret = soft_check_fmt(ctx, s, &p->fmt);
+    if (ret) {
+        mpp_err_f("unsupported output format %x\n", s->output_fmt);
+        goto RET;
+    }
+
+    ret = soft_setup(ctx, s);
+    if (ret)
+        goto RET;
+
+    mpp_buf_slot_get_prop(ctx->packet_slots, task->dec.input, SLOT_BUFFER, &strm_buf);
+    mpp_buf_slot_get_prop(ctx->frame_slots, task->dec.output, SLOT_BUFFER, &frm_buf);
+    mpp_buf_slot_get_prop(ctx->frame_slots, task->dec.output, SLOT_FRAME_PTR, &frm);
+
+    strm = (RK_U8 *)mpp_buffer_get_ptr(strm_buf);
+    p->dst = (RK_U8 *)mpp_buffer_get_ptr(frm_buf);
+    p->hor_stride = s->hor_stride;
+    p->ver_stride = s->ver_stride;
+
+    if (NULL == strm || NULL == p->dst || s->strm_offset >= s->pkt_len ||
+        mpp_buffer_get_size(frm_buf) < soft_frame_size(p->fmt, p->hor_stride, p->ver_stride)) {
+        mpp_err_f("invalid stream %p or frame %p\n", strm, p->dst);
+        ret = MPP_ERR_VALUE;
+        goto RET;
+    }
+
+    ret = soft_split_segs(p, strm + s->strm_offset, strm + s->pkt_len);
+    if (ret)
+        goto RET;
+
+    mpp_frame_set_fmt(frm, p->fmt);
+    mpp_frame_set_hor_stride_pixel(frm, s->hor_stride);
+
+RET:
+    if (ret)
+        task->dec.valid = 0;
+
+    jpegd_dbg_func("exit ret %d\n", ret);
+    return ret;
+}
+
+MPP_RET hal_jpegd_soft_start(void *hal, HalTaskInfo *task)
+{
+    JpegdHalCtx *ctx = (JpegdHalCtx *)hal;
+    JpegdSoftCtx *p = (JpegdSoftCtx *)ctx->soft;
+    RK_S32 seg_expect;
+    RK_S64 start;
+
+    jpegd_dbg_func("enter\n");
+
+    p->errinfo = 1;
+    if (!task->dec.valid)
+        return MPP_OK;
+
+    start = mpp_time();
+
+    seg_expect = (p->mcu_total + p->mcu_seg - 1) / p->mcu_seg;
+    p->errinfo = (p->seg_cnt != seg_expect);
+    if (p->seg_cnt > seg_expect)
+        p->seg_cnt = seg_expect;
+
+    p->errinfo |= soft_decode(p);
+    soft_write_frame(p);
+
+    jpegd_dbg_hal("soft decode %d segments of %d mcus cost %lld us err %d\n",
+                  p->seg_cnt, p->mcu_total, mpp_time() - start, p->errinfo);
+
+    jpegd_dbg_func("exit\n");
+    return MPP_OK;
+}
+
+MPP_RET hal_jpegd_soft_wait(void *hal, HalTaskInfo *task)
+{
+    JpegdHalCtx *ctx = (JpegdHalCtx *)hal;
+    JpegdSoftCtx *p = (JpegdSoftCtx *)ctx->soft;
+    MppFrame frm = NULL;
+
+    jpegd_dbg_func("enter\n");
+
+    mpp_buf_slot_get_prop(ctx->frame_slots, task->dec.output, SLOT_FRAME_PTR, &frm);
+    if (frm)
+        mpp_frame_set_errinfo(frm, p->errinfo);
+
+    jpegd_dbg_func("exit\n");
+    return MPP_OK;
+}
+
+MPP_RET hal_jpegd_soft_reset(void *hal)
+{
+    (void)hal;
+    return MPP_OK;
+}
+
+MPP_RET hal_jpegd_soft_flush(void *hal)
+{
+    (void)hal;
+    return MPP_OK;
+}
+
+MPP_RET hal_jpegd_soft_control(void *hal, MpiCmd cmd_type, void *param)
+{
+    JpegdHalCtx *ctx = (JpegdHalCtx *)hal;
+    MPP_RET ret = MPP_OK;
+
+    jpegd_dbg_func("enter\n");
+
+    switch (cmd_type) {
+    case MPP_DEC_SET_OUTPUT_FORMAT: {
+        ctx->output_fmt = *((MppFrameFormat *)param);
+        ctx->set_output_fmt_flag = 1;
+        jpegd_dbg_hal("output_format:%d\n", ctx->output_fmt);
+
+        if (!MPP_FRAME_FMT_IS_YUV(ctx->output_fmt)) {
+            mpp_err_f("output format %d is not supported by soft decoder\n",
+                      ctx->output_fmt);
+            ret = MPP_ERR_VALUE;
+        }
+    } break;
+    default :
+        break;
+    }
+
+    jpegd_dbg_func("exit ret %d\n", ret);
+    return ret;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __HAL_JPEGD_SOFT_H__
+#define __HAL_JPEGD_SOFT_H__
+
+#include "hal_jpegd_base.h"
+
+/*
+ * Software baseline jpeg decoder backend.
+ *
+ * It is used as the only backend when there is no jpeg decoder hardware or
+ * env jpegd_soft is set to 1. Otherwise it is attached to the hardware
+ * backend as overflow when env jpegd_soft_spill is non-zero. Then a task is
+ * decoded by cpu when the jpeg hardware tasks in flight in this process reach
+ * jpegd_soft_spill.
+ *
+ * Restart intervals are decoded by up to env jpegd_soft_threads threads,
+ * 0 for the online cpu count.
+ */
+MPP_RET hal_jpegd_soft_init(void *hal, MppHalCfg *cfg);
+MPP_RET hal_jpegd_soft_deinit(void *hal);
+MPP_RET hal_jpegd_soft_gen_regs(void *hal, HalTaskInfo *task);
+MPP_RET hal_jpegd_soft_start(void *hal, HalTaskInfo *task);
+MPP_RET hal_jpegd_soft_wait(void *hal, HalTaskInfo *task);
+MPP_RET hal_jpegd_soft_reset(void *hal);
+MPP_RET hal_jpegd_soft_flush(void *hal);
+MPP_RET hal_jpegd_soft_control(void *hal, MpiCmd cmd_type, void *param);
+
+/* attach / detach software overflow to a hardware backend */
+MPP_RET hal_jpegd_soft_open(JpegdHalCtx *ctx);
+void hal_jpegd_soft_close(JpegdHalCtx *ctx);
+/* return 1 when the task should be decoded by software for hardware load */
+RK_U32 hal_jpegd_soft_spill(JpegdHalCtx *ctx, HalTaskInfo *task, RK_S32 hw_load);
+
+#endif /* __HAL_JPEGD_SOFT_H__ */
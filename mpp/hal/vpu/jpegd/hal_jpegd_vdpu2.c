@@ -33,6 +33,18 @@
 
 extern RK_U32 jpegd_debug;
 
+#define VDPU2_REG_OUT_Y             63
+#define VDPU2_REG_STREAM            64
+#define VDPU2_REG_OUT_C             131
+
+typedef struct JpegdMultiCoreCtx_t {
+    /* env jpegd_multi_core, max strip count of one picture */
+    RK_U32              strip_max;
+    RK_S32              strip_cnt;
+    JpegdStrip          strips[JPEGD_STRIP_MAX];
+    JpegdIocRegInfo     regs[JPEGD_STRIP_MAX];
+} JpegdMultiCoreCtx;
+
 static MPP_RET jpegd_regs_init(JpegRegSet *reg)
 {
     jpegd_dbg_func("enter\n");
@@ -713,6 +725,154 @@ MPP_RET jpegd_gen_regs(JpegdHalCtx *ctx, JpegdSyntax *syntax)
     return ret;
 }
 
+/*
+ * Split picture with restart interval into macroblock row strips. Each strip
+ * gets its own register set and is sent as one task, so the kernel driver can
+ * run the strips on different cores and write them into the same frame.
+ */
+static void jpegd_setup_strips(JpegdHalCtx *ctx, JpegdSyntax *syntax,
+                               MppBuffer streambuf)
+{
+    JpegdMultiCoreCtx *ctx_ext = (JpegdMultiCoreCtx *)ctx->ctx_ext;
+    JpegdIocRegInfo *info = (JpegdIocRegInfo *)ctx->regs;
+    JpegdSyntax *s = syntax;
+    RK_S32 i;
+
+    if (NULL == ctx_ext)
+        return;
+
+    ctx_ext->strip_cnt = 0;
+
+    /* small image do not need to split */
+    if (s->hor_stride * s->ver_stride <= 1920 * 1088 || ctx->pp_info.pp_enable)
+        return;
+
+    if (s->yuv_mode != JPEGDEC_YUV420 && s->yuv_mode != JPEGDEC_YUV422 &&
+        s->yuv_mode != JPEGDEC_YUV400)
+        return;
+
+    ctx_ext->strip_cnt = jpegd_split_strips(s, mpp_buffer_get_ptr(streambuf),
+                                            ctx_ext->strips, ctx_ext->strip_max);
+    if (ctx_ext->strip_cnt < 2) {
+        ctx_ext->strip_cnt = 0;
+        return;
+    }
+
+    for (i = 0; i < ctx_ext->strip_cnt; i++) {
+        JpegdStrip *strip = &ctx_ext->strips[i];
+        JpegRegSet *reg = &ctx_ext->regs[i].regs;
+        RK_U32 last = (i == ctx_ext->strip_cnt - 1);
+
+        memcpy(&ctx_ext->regs[i], info, sizeof(*info));
+
+        reg->reg120.sw_pic_mb_h_ext = (strip->mb_rows & 0x700) >> 8;
+        reg->reg120.sw_pic_mb_hight_p = strip->mb_rows & 0x0FF;
+
+        if (!last) {
+            reg->reg121.sw_pjpeg_fildown_e = 0;
+            reg->reg148.sw_jpeg_height8_flag = 0;
+        }
+
+        /* the first strip keeps the stream setup of the whole picture */
+        if (i) {
+            reg->reg122.sw_strm_start_bit = (strip->strm_offset & 7) * 8;
+            reg->reg51_stream_info.sw_stream_len = s->pkt_len - (strip->strm_offset & (~7));
+        }
+
+        jpegd_dbg_hal("strip %d mb row %d count %d stream offset %d\n",
+                      i, strip->mb_y, strip->mb_rows, strip->strm_offset);
+    }
+}
+
+static MPP_RET jpegd_start_strips(JpegdHalCtx *ctx, JpegdSyntax *syntax)
+{
+    JpegdMultiCoreCtx *ctx_ext = (JpegdMultiCoreCtx *)ctx->ctx_ext;
+    JpegdSyntax *s = syntax;
+    RK_U32 uv_offset = s->hor_stride * s->ver_stride;
+    MPP_RET ret = MPP_OK;
+    RK_S32 i;
+
+    for (i = 0; i < ctx_ext->strip_cnt; i++) {
+        JpegdStrip *strip = &ctx_ext->strips[i];
+        RK_U32 y_offset = strip->mb_y * 16 * s->hor_stride;
+        RK_U32 c_offset = uv_offset;
+        MppDevRegWrCfg wr_cfg;
+        MppDevRegRdCfg rd_cfg;
+
+        if (s->yuv_mode == JPEGDEC_YUV420)
+            c_offset += y_offset / 2;
+        else if (s->yuv_mode == JPEGDEC_YUV422)
+            c_offset += y_offset;
+
+        wr_cfg.reg = &ctx_ext->regs[i];
+        wr_cfg.size = mpp_get_ioctl_version() ?
+                      sizeof(((JpegdIocRegInfo *)0)->regs) :
+                      sizeof(JpegdIocRegInfo) - EXTRA_INFO_SIZE;
+        wr_cfg.offset = 0;
+
+        ret = mpp_dev_ioctl(ctx->dev, MPP_DEV_REG_WR, &wr_cfg);
+        if (ret) {
+            mpp_err_f("set register write failed %d\n", ret);
+            break;
+        }
+
+        rd_cfg.reg = &ctx_ext->regs[i];
+        rd_cfg.size = sizeof(JpegdIocRegInfo) - EXTRA_INFO_SIZE;
+        rd_cfg.offset = 0;
+
+        ret = mpp_dev_ioctl(ctx->dev, MPP_DEV_REG_RD, &rd_cfg);
+        if (ret) {
+            mpp_err_f("set register read failed %d\n", ret);
+            break;
+        }
+
+        /* offsets of the first strip have been set on register generation */
+        if (i) {
+            mpp_dev_set_reg_offset(ctx->dev, VDPU2_REG_STREAM, strip->strm_offset & (~7));
+            mpp_dev_set_reg_offset(ctx->dev, VDPU2_REG_OUT_Y, y_offset);
+            mpp_dev_set_reg_offset(ctx->dev, VDPU2_REG_OUT_C, c_offset);
+        }
+
+        if (i < ctx_ext->strip_cnt - 1) {
+            ret = mpp_dev_ioctl(ctx->dev, MPP_DEV_DELIMIT, NULL);
+            if (ret) {
+                mpp_err_f("send delimit failed %d\n", ret);
+                break;
+            }
+        }
+    }
+
+    if (!ret) {
+        ret = mpp_dev_ioctl(ctx->dev, MPP_DEV_CMD_SEND, NULL);
+        if (ret)
+            mpp_err_f("send cmd failed %d\n", ret);
+    }
+
+    return ret;
+}
+
+static RK_U32 jpegd_check_irq(JpegRegSet *reg_out)
+{
+    RK_U32 errinfo = 1;
+
+    if (reg_out->reg55_Interrupt.sw_dec_bus_int) {
+        mpp_err_f("IRQ BUS ERROR!");
+    } else if (reg_out->reg55_Interrupt.sw_dec_error_int) {
+        mpp_err_f("IRQ STREAM ERROR!");
+    } else if (reg_out->reg55_Interrupt.sw_dec_timeout) {
+        mpp_err_f("IRQ TIMEOUT!");
+    } else if (reg_out->reg55_Interrupt.sw_dec_buffer_int) {
+        mpp_err_f("IRQ BUFFER EMPTY!");
+    } else if (reg_out->reg55_Interrupt.sw_dec_irq) {
+        errinfo = 0;
+        jpegd_dbg_result("DECODE SUCCESS!");
+    }
+
+    memset(&reg_out->reg55_Interrupt, 0, sizeof(RK_U32));
+
+    return errinfo;
+}
+
 MPP_RET hal_jpegd_vdpu2_init(void *hal, MppHalCfg *cfg)
 {
     MPP_RET ret = MPP_OK;
@@ -776,6 +936,19 @@ MPP_RET hal_jpegd_vdpu2_init(void *hal, MppHalCfg *cfg)
     JpegHalCtx->output_fmt = MPP_FMT_YUV420SP;
     JpegHalCtx->set_output_fmt_flag = 0;
 
+    {
+        RK_U32 strip_max = 0;
+
+        mpp_env_get_u32("jpegd_multi_core", &strip_max, 0);
+        if (strip_max > 1) {
+            JpegdMultiCoreCtx *ctx_ext = mpp_calloc(JpegdMultiCoreCtx, 1);
+
+            if (ctx_ext)
+                ctx_ext->strip_max = MPP_MIN(strip_max, JPEGD_STRIP_MAX);
+            JpegHalCtx->ctx_ext = ctx_ext;
+        }
+    }
+
     //init dbg stuff
     JpegHalCtx->hal_debug_enable = 0;
     JpegHalCtx->frame_count = 0;
@@ -826,6 +999,8 @@ MPP_RET hal_jpegd_vdpu2_deinit(void *hal)
         JpegHalCtx->regs = NULL;
     }
 
+    MPP_FREE(JpegHalCtx->ctx_ext);
+
     JpegHalCtx->set_output_fmt_flag = 0;
     JpegHalCtx->hal_debug_enable = 0;
     JpegHalCtx->frame_count = 0;
@@ -876,6 +1051,8 @@ MPP_RET hal_jpegd_vdpu2_gen_regs(void *hal,  HalTaskInfo *syn)
             mpp_err_f("generate registers failed\n");
             goto RET;
         }
+
+        jpegd_setup_strips(JpegHalCtx, syntax, streambuf);
     }
 
 RET:
@@ -890,10 +1067,17 @@ MPP_RET hal_jpegd_vdpu2_start(void *hal, HalTaskInfo *task)
 {
     MPP_RET ret = MPP_OK;
     JpegdHalCtx *JpegHalCtx = (JpegdHalCtx *)hal;
+    JpegdMultiCoreCtx *ctx_ext = (JpegdMultiCoreCtx *)JpegHalCtx->ctx_ext;
     RK_U32 *regs = (RK_U32 *)JpegHalCtx->regs;
 
     jpegd_dbg_func("enter\n");
 
+    if (ctx_ext && ctx_ext->strip_cnt) {
+        ret = jpegd_start_strips(JpegHalCtx, (JpegdSyntax *)task->dec.syntax.data);
+        jpegd_dbg_func("exit\n");
+        return ret;
+    }
+
     do {
         MppDevRegWrCfg wr_cfg;
         MppDevRegRdCfg rd_cfg;
@@ -939,27 +1123,28 @@ MPP_RET hal_jpegd_vdpu2_wait(void *hal, HalTaskInfo *task)
 {
     MPP_RET ret = MPP_OK;
     JpegdHalCtx *JpegHalCtx = (JpegdHalCtx *)hal;
+    JpegdMultiCoreCtx *ctx_ext = (JpegdMultiCoreCtx *)JpegHalCtx->ctx_ext;
     JpegRegSet *reg_out = JpegHalCtx->regs;
-    RK_U32 errinfo = 1;
+    RK_U32 errinfo = 0;
     MppFrame tmp = NULL;
+    RK_S32 task_cnt = 1;
+    RK_S32 i;
 
     jpegd_dbg_func("enter\n");
 
-    ret = mpp_dev_ioctl(JpegHalCtx->dev, MPP_DEV_CMD_POLL, NULL);
-    if (ret)
-        mpp_err_f("poll cmd failed %d\n", ret);
+    if (ctx_ext && ctx_ext->strip_cnt)
+        task_cnt = ctx_ext->strip_cnt;
 
-    if (reg_out->reg55_Interrupt.sw_dec_bus_int) {
-        mpp_err_f("IRQ BUS ERROR!");
-    } else if (reg_out->reg55_Interrupt.sw_dec_error_int) {
-        mpp_err_f("IRQ STREAM ERROR!");
-    } else if (reg_out->reg55_Interrupt.sw_dec_timeout) {
-        mpp_err_f("IRQ TIMEOUT!");
-    } else if (reg_out->reg55_Interrupt.sw_dec_buffer_int) {
-        mpp_err_f("IRQ BUFFER EMPTY!");
-    } else if (reg_out->reg55_Interrupt.sw_dec_irq) {
-        errinfo = 0;
-        jpegd_dbg_result("DECODE SUCCESS!");
+    /* strips are returned in sending order */
+    for (i = 0; i < task_cnt; i++) {
+        ret = mpp_dev_ioctl(JpegHalCtx->dev, MPP_DEV_CMD_POLL, NULL);
+        if (ret)
+            mpp_err_f("poll cmd failed %d\n", ret);
+
+        if (task_cnt > 1)
+            reg_out = &ctx_ext->regs[i].regs;
+
+        errinfo |= jpegd_check_irq(reg_out);
     }
 
     mpp_buf_slot_get_prop(JpegHalCtx->frame_slots, task->dec.output,
@@ -993,8 +1178,6 @@ MPP_RET hal_jpegd_vdpu2_wait(void *hal, HalTaskInfo *task)
         }
     }
 
-    memset(&reg_out->reg55_Interrupt, 0, sizeof(RK_U32));
-
     (void)task;
     jpegd_dbg_func("exit\n");
     return ret;
@@ -0,0 +1,398 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "hal_jpegd_soft_test"
+
+#include <math.h>
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_debug.h"
+#include "mpp_common.h"
+
+#include "rk_mpi.h"
+
+/*
+ * The test builds a 4:2:0 baseline jpeg with restart intervals. Each block
+ * has a dc and at most one horizontal ac coefficient so the reference output
+ * is computed from the float idct directly.
+ */
+#define SOFT_TEST_WIDTH         128
+#define SOFT_TEST_HEIGHT        64
+/* mcus in one restart interval */
+#define SOFT_TEST_RESTART       2
+#define SOFT_TEST_STRM_SIZE     (64 * 1024)
+#define SOFT_TEST_FRAME_CNT     3
+
+typedef struct SoftTestBits_t {
+    RK_U8           *buf;
+    RK_S32          pos;
+    RK_U32          acc;
+    RK_S32          cnt;
+} SoftTestBits;
+
+static RK_S32 soft_test_val(RK_S32 comp, RK_S32 bx, RK_S32 by)
+{
+    return 20 + (bx * 37 + by * 23 + comp * 71) % 200;
+}
+
+static RK_S32 soft_test_ac(RK_S32 comp, RK_S32 bx, RK_S32 by)
+{
+    return ((bx + 2 * by + comp) % 3 - 1) * 8;
+}
+
+static void soft_test_byte(SoftTestBits *b, RK_U8 val)
+{
+    b->buf[b->pos++] = val;
+}
+
+static void soft_test_word(SoftTestBits *b, RK_U32 val)
+{
+    soft_test_byte(b, val >> 8);
+    soft_test_byte(b, val & 0xff);
+}
+
+static void soft_test_put(SoftTestBits *b, RK_U32 val, RK_S32 len)
+{
+    b->acc = (b->acc << len) | (val & ((1 << len) - 1));
+    b->cnt += len;
+
+    while (b->cnt >= 8) {
+        RK_U8 byte = (b->acc >> (b->cnt - 8)) & 0xff;
+
+        soft_test_byte(b, byte);
+        if (byte == 0xff)
+            soft_test_byte(b, 0);
+        b->cnt -= 8;
+    }
+}
+
+/* pad with one bits to the byte boundary */
+static void soft_test_flush(SoftTestBits *b)
+{
+    if (b->cnt)
+        soft_test_put(b, 0x7f, 8 - b->cnt);
+}
+
+static RK_S32 soft_test_cat(RK_S32 val)
+{
+    RK_S32 abs = MPP_ABS(val);
+    RK_S32 n = 0;
+
+    while (abs >> n)
+        n++;
+
+    return n;
+}
+
+static void soft_test_coef(SoftTestBits *b, RK_S32 val, RK_S32 cat)
+{
+    if (cat)
+        soft_test_put(b, (val < 0) ? val + (1 << cat) - 1 : val, cat);
+}
+
+/*
+ * dc table: category c has the 4 bit code c
+ * ac table: eob is 0 and run 0 size 4 is 10
+ */
+static void soft_test_block(SoftTestBits *b, RK_S32 diff, RK_S32 ac)
+{
+    RK_S32 cat = soft_test_cat(diff);
+
+    soft_test_put(b, cat, 4);
+    soft_test_coef(b, diff, cat);
+
+    if (ac) {
+        mpp_assert(soft_test_cat(ac) == 4);
+        soft_test_put(b, 2, 2);
+        soft_test_coef(b, ac, 4);
+    }
+
+    soft_test_put(b, 0, 1);
+}
+
+static RK_S32 soft_test_build(RK_U8 *buf, RK_S32 malformed)
+{
+    static const RK_U8 comp_hv[3] = { 0x22, 0x11, 0x11 };
+    SoftTestBits bits;
+    SoftTestBits *b = &bits;
+    RK_S32 mcus_x = SOFT_TEST_WIDTH / 16;
+    RK_S32 mcus_y = SOFT_TEST_HEIGHT / 16;
+    RK_S32 mcu_total = mcus_x * mcus_y;
+    RK_S32 pred[3];
+    RK_S32 mcu;
+    RK_S32 i;
+
+    memset(b, 0, sizeof(*b));
+    b->buf = buf;
+
+    /* SOI */
+    soft_test_word(b, 0xffd8);
+
+    /* DQT: all ones so the coefficients are the dequantized values */
+    soft_test_word(b, 0xffdb);
+    soft_test_word(b, 67);
+    soft_test_byte(b, 0);
+    for (i = 0; i < 64; i++)
+        soft_test_byte(b, 1);
+
+    /* SOF0 */
+    soft_test_word(b, 0xffc0);
+    soft_test_word(b, 17);
+    soft_test_byte(b, 8);
+    soft_test_word(b, SOFT_TEST_HEIGHT);
+    soft_test_word(b, SOFT_TEST_WIDTH);
+    soft_test_byte(b, 3);
+    for (i = 0; i < 3; i++) {
+        soft_test_byte(b, i + 1);
+        soft_test_byte(b, comp_hv[i]);
+        soft_test_byte(b, 0);
+    }
+
+    /* DHT: dc 12 codes of 4 bits, ac one code of 1 bit and one of 2 bits */
+    soft_test_word(b, 0xffc4);
+    soft_test_word(b, 2 + 17 + 12 + 17 + (malformed ? 3 : 2));
+    soft_test_byte(b, 0x00);
+    for (i = 0; i < 16; i++)
+        soft_test_byte(b, (i == 3) ? 12 : 0);
+    for (i = 0; i < 12; i++)
+        soft_test_byte(b, i);
+
+    soft_test_byte(b, 0x10);
+    if (malformed) {
+        /* three codes of 1 bit over-subscribe the code space */
+        for (i = 0; i < 16; i++)
+            soft_test_byte(b, i ? 0 : 3);
+        soft_test_byte(b, 0x00);
+        soft_test_byte(b, 0x04);
+        soft_test_byte(b, 0x01);
+    } else {
+        for (i = 0; i < 16; i++)
+            soft_test_byte(b, (i < 2) ? 1 : 0);
+        soft_test_byte(b, 0x00);
+        soft_test_byte(b, 0x04);
+    }
+
+    /* DRI */
+    soft_test_word(b, 0xffdd);
+    soft_test_word(b, 4);
+    soft_test_word(b, SOFT_TEST_RESTART);
+
+    /* SOS */
+    soft_test_word(b, 0xffda);
+    soft_test_word(b, 12);
+    soft_test_byte(b, 3);
+    for (i = 0; i < 3; i++) {
+        soft_test_byte(b, i + 1);
+        soft_test_byte(b, 0x00);
+    }
+    soft_test_byte(b, 0);
+    soft_test_byte(b, 63);
+    soft_test_byte(b, 0);
+
+    for (mcu = 0; mcu < mcu_total; mcu++) {
+        RK_S32 mx = mcu % mcus_x;
+        RK_S32 my = mcu / mcus_x;
+        RK_S32 c;
+
+        if (!(mcu % SOFT_TEST_RESTART)) {
+            if (mcu) {
+                soft_test_flush(b);
+                soft_test_word(b, 0xffd0 + (mcu / SOFT_TEST_RESTART - 1) % 8);
+            }
+            memset(pred, 0, sizeof(pred));
+        }
+
+        for (c = 0; c < 3; c++) {
+            RK_S32 blk = c ? 1 : 2;
+            RK_S32 h, v;
+
+            for (v = 0; v < blk; v++) {
+                for (h = 0; h < blk; h++) {
+                    RK_S32 bx = mx * blk + h;
+                    RK_S32 by = my * blk + v;
+                    RK_S32 dc = (soft_test_val(c, bx, by) - 128) * 8;
+
+                    soft_test_block(b, dc - pred[c], soft_test_ac(c, bx, by));
+                    pred[c] = dc;
+                }
+            }
+        }
+    }
+
+    soft_test_flush(b);
+    /* EOI */
+    soft_test_word(b, 0xffd9);
+
+    return b->pos;
+}
+
+static RK_S32 soft_test_check(MppFrame frame)
+{
+    RK_U8 *base = (RK_U8 *)mpp_buffer_get_ptr(mpp_frame_get_buffer(frame));
+    RK_S32 stride = mpp_frame_get_hor_stride(frame);
+    RK_U8 *uv = base + stride * mpp_frame_get_ver_stride(frame);
+    RK_S32 err_cnt = 0;
+    RK_S32 c, x, y;
+
+    for (c = 0; c < 3; c++) {
+        RK_S32 w = c ? SOFT_TEST_WIDTH / 2 : SOFT_TEST_WIDTH;
+        RK_S32 h = c ? SOFT_TEST_HEIGHT / 2 : SOFT_TEST_HEIGHT;
+
+        for (y = 0; y < h; y++) {
+            for (x = 0; x < w; x++) {
+                RK_S32 bx = x / 8;
+                RK_S32 by = y / 8;
+                double ref = soft_test_val(c, bx, by) + soft_test_ac(c, bx, by) *
+                             cos((2 * (x % 8) + 1) * M_PI / 16) / (4 * sqrt(2));
+                RK_S32 pix = c ? uv[y * stride + x * 2 + c - 1] : base[y * stride + x];
+                RK_S32 exp = (RK_S32)floor(ref + 0.5);
+
+                /* islow idct may differ from the float one by one */
+                if (MPP_ABS(pix - exp) > 1) {
+                    if (!err_cnt)
+                        mpp_err("comp %d pos %d,%d pixel %d expect %d\n",
+                                c, x, y, pix, exp);
+                    err_cnt++;
+                }
+            }
+        }
+    }
+
+    return err_cnt;
+}
+
+static MPP_RET soft_test_decode(MppCtx ctx, MppApi *mpi, MppBuffer strm,
+                                RK_S32 len, MppFrame frame, RK_U32 *errinfo)
+{
+    MppPacket packet = NULL;
+    MppFrame frame_out = NULL;
+    MppTask task = NULL;
+    MPP_RET ret;
+
+    mpp_packet_init_with_buffer(&packet, strm);
+    mpp_packet_set_length(packet, len);
+
+    ret = mpi->poll(ctx, MPP_PORT_INPUT, MPP_POLL_BLOCK);
+    if (!ret)
+        ret = mpi->dequeue(ctx, MPP_PORT_INPUT, &task);
+    if (ret || !task)
+        goto DONE;
+
+    mpp_task_meta_set_packet(task, KEY_INPUT_PACKET, packet);
+    mpp_task_meta_set_frame(task, KEY_OUTPUT_FRAME, frame);
+    ret = mpi->enqueue(ctx, MPP_PORT_INPUT, task);
+    if (ret)
+        goto DONE;
+
+    task = NULL;
+    ret = mpi->poll(ctx, MPP_PORT_OUTPUT, MPP_POLL_BLOCK);
+    if (!ret)
+        ret = mpi->dequeue(ctx, MPP_PORT_OUTPUT, &task);
+    if (ret || !task)
+        goto DONE;
+
+    mpp_task_meta_get_frame(task, KEY_OUTPUT_FRAME, &frame_out);
+    *errinfo = frame_out ? (mpp_frame_get_errinfo(frame_out) ||
+                            mpp_frame_get_discard(frame_out)) : 1;
+    mpi->enqueue(ctx, MPP_PORT_OUTPUT, task);
+
+    /* take the input task back to release the packet */
+    task = NULL;
+    ret = mpi->dequeue(ctx, MPP_PORT_INPUT, &task);
+    if (!ret && task)
+        mpi->enqueue(ctx, MPP_PORT_INPUT, task);
+
+DONE:
+    mpp_packet_deinit(&packet);
+    return ret;
+}
+
+int main()
+{
+    MppCtx ctx = NULL;
+    MppApi *mpi = NULL;
+    MppBufferGroup grp = NULL;
+    MppBuffer strm = NULL;
+    MppBuffer frm_buf = NULL;
+    MppFrame frame = NULL;
+    RK_U32 errinfo = 0;
+    RK_S32 len;
+    RK_S32 i;
+    MPP_RET ret = MPP_NOK;
+
+    mpp_env_set_u32("jpegd_soft", 1);
+    /* several restart intervals per thread so all workers are used */
+    mpp_env_set_u32("jpegd_soft_threads", 4);
+
+    if (mpp_buffer_group_get_internal(&grp, MPP_BUFFER_TYPE_NORMAL) ||
+        mpp_buffer_get(grp, &strm, SOFT_TEST_STRM_SIZE) ||
+        mpp_buffer_get(grp, &frm_buf, SOFT_TEST_WIDTH * SOFT_TEST_HEIGHT * 4)) {
+        mpp_err("failed to get buffer\n");
+        goto DONE;
+    }
+
+    mpp_frame_init(&frame);
+    mpp_frame_set_buffer(frame, frm_buf);
+
+    if (mpp_create(&ctx, &mpi) || mpp_init(ctx, MPP_CTX_DEC, MPP_VIDEO_CodingMJPEG)) {
+        mpp_err("failed to init jpeg decoder\n");
+        goto DONE;
+    }
+
+    /* same context decodes again on the persistent workers */
+    len = soft_test_build((RK_U8 *)mpp_buffer_get_ptr(strm), 0);
+    for (i = 0; i < SOFT_TEST_FRAME_CNT; i++) {
+        memset(mpp_buffer_get_ptr(frm_buf), 0, mpp_buffer_get_size(frm_buf));
+        if (soft_test_decode(ctx, mpi, strm, len, frame, &errinfo) || errinfo) {
+            mpp_err("decode frame %d failed errinfo %d\n", i, errinfo);
+            goto DONE;
+        }
+
+        if (soft_test_check(frame)) {
+            mpp_err("frame %d mismatch reference\n", i);
+            goto DONE;
+        }
+    }
+
+    /* over-subscribed huffman table is reported as error frame */
+    len = soft_test_build((RK_U8 *)mpp_buffer_get_ptr(strm), 1);
+    errinfo = 0;
+    if (soft_test_decode(ctx, mpi, strm, len, frame, &errinfo) || !errinfo) {
+        mpp_err("malformed dht is not rejected errinfo %d\n", errinfo);
+        goto DONE;
+    }
+
+    ret = MPP_OK;
+DONE:
+    if (ctx) {
+        mpi->reset(ctx);
+        mpp_destroy(ctx);
+    }
+    if (frame)
+        mpp_frame_deinit(&frame);
+    if (frm_buf)
+        mpp_buffer_put(frm_buf);
+    if (strm)
+        mpp_buffer_put(strm);
+    if (grp)
+        mpp_buffer_group_put(grp);
+
+    mpp_log("hal_jpegd_soft_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
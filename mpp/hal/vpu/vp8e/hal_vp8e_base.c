@@ -524,12 +524,14 @@ static MPP_RET set_new_frame(void *hal)
     if (hw_cfg->split_penalty[3] == 0)
         hw_cfg->split_penalty[3] = MPP_MIN(511, (8 * vp8_split_penalty_tbl[qp] + 500) / 16);
 
+    vp8e_calc_mv_cost(ctx);
+
     for (i = 0; i < 128; i++) {
         RK_S32 y, x;
 
         hw_cfg->dmv_penalty[i] = i * 2;
-        y = vp8e_calc_cost_mv(i * 2, ctx->entropy.mv_prob[0]); /* mv y */
-        x = vp8e_calc_cost_mv(i * 2, ctx->entropy.mv_prob[1]); /* mv x */
+        y = ctx->entropy.mv_cost[0][i]; /* mv y */
+        x = ctx->entropy.mv_cost[1][i]; /* mv x */
         hw_cfg->dmv_qpel_penalty[i] = MPP_MIN(255, (y + x + 1) / 2 * weight_tbl[qp] >> 8);
     }
 
@@ -164,6 +164,15 @@ typedef struct vp8e_hal_entropy_t {
     RK_S32 default_coeff_prob_flag;
     RK_S32 update_coeff_prob_flag;
     RK_S32 segment_prob[3];
+
+    /* hardware counts and coefficient update decision of last frame */
+    RK_U16 last_coeff_cnt[4][7][3][3];
+    RK_S32 coeff_upd[4][7][3][2];
+    RK_S32 coeff_cnt_valid;
+    /* mv bit cost of each mvd, updated when mv_prob changes */
+    RK_S32 mv_cost[2][128];
+    RK_S32 mv_cost_prob[2][19];
+    RK_S32 mv_cost_valid;
 } Vp8eHalEntropy;
 
 /**
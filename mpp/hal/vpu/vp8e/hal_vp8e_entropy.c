@@ -43,12 +43,17 @@ static RK_U32 calc_mvprob(RK_U32 left, RK_U32 right, RK_U32 prob)
     return p;
 }
 
-static RK_U32 update_prob(RK_U32 prob, RK_U32 left, RK_U32 right,
-                          RK_U32 old_prob, RK_U32 new_prob, RK_U32 fixed)
+/* extra bits to signal one probability update with update probability prob */
+static RK_S32 update_cost(RK_U32 prob, RK_U32 fixed)
 {
-    RK_S32 u, s;
+    return (RK_S32)fixed + ((vp8_prob_cost_tbl[255 - prob] - vp8_prob_cost_tbl[prob]) >> 8);
+}
+
+static RK_U32 update_prob(RK_S32 u, RK_U32 left, RK_U32 right,
+                          RK_U32 old_prob, RK_U32 new_prob)
+{
+    RK_S32 s;
 
-    u = (RK_S32)fixed + ((vp8_prob_cost_tbl[255 - prob] - vp8_prob_cost_tbl[prob]) >> 8);
     s = ((RK_S32)left * (vp8_prob_cost_tbl[old_prob] - vp8_prob_cost_tbl[new_prob]) +
          (RK_S32)right * (vp8_prob_cost_tbl[255 - old_prob] - vp8_prob_cost_tbl[255 - new_prob])) >> 8;
 
@@ -105,7 +110,9 @@ MPP_RET vp8e_init_entropy(void *hal)
         RK_S32 i, j, k, l;
 
         RK_U32 p, left, right;
-        RK_U32 old_p, upd_p = 0;
+        RK_U32 old_p;
+        /* the update probability of coefficient is fixed, so is the cost */
+        RK_S32 coeff_upd_cost = update_cost(0, 8);
 
         RK_U32 type;
         RK_U32 branch_cnt[2];
@@ -116,37 +123,51 @@ MPP_RET vp8e_init_entropy(void *hal)
         for (i = 0; i < 4; i++) {
             for (j = 0; j < 7; j++) {
                 for (k = 0; k < 3; k++) {
+                    RK_U16 cnt[3];
+                    RK_S32 *upd = entropy->coeff_upd[i][j][k];
                     RK_S32 tmp, ii;
 
                     tmp = i * 7 * 3 + j * 3 + k;
-                    tmp += 2 * 4 * 7 * 3;
-                    ii = offset_tbl[tmp];
-
-                    right = ii >= 0 ? p_cnt[ii] : 0;
-
-                    for (l = 2; l--;) {
-                        old_p = entropy->coeff_prob[i][j][k][l];
-                        old_p = coeff_update_prob_tbl[i][j][k][l];
-
-                        tmp -= 4 * 7 * 3;
-                        ii = offset_tbl[tmp];
-                        left = ii >= 0 ? p_cnt[ii] : 0;
-                        if (left + right) {
-                            p = ((left * 256) + ((left + right) >> 1)) / (left + right);
-                            if (p > 255) p = 255;
-                        } else
-                            p = old_p;
-
-                        if (update_prob(upd_p, left, right, old_p, p, 8)) {
-                            entropy->coeff_prob[i][j][k][l] = p;
+
+                    for (l = 0; l < 3; l++) {
+                        ii = offset_tbl[tmp + l * 4 * 7 * 3];
+                        cnt[l] = ii >= 0 ? p_cnt[ii] : 0;
+                    }
+
+                    /* same counts make the same decision as last time */
+                    if (!entropy->coeff_cnt_valid ||
+                        memcmp(cnt, entropy->last_coeff_cnt[i][j][k], sizeof(cnt))) {
+                        memcpy(entropy->last_coeff_cnt[i][j][k], cnt, sizeof(cnt));
+
+                        right = cnt[2];
+
+                        for (l = 2; l--;) {
+                            old_p = coeff_update_prob_tbl[i][j][k][l];
+                            left = cnt[l];
+
+                            if (left + right) {
+                                p = ((left * 256) + ((left + right) >> 1)) / (left + right);
+                                if (p > 255) p = 255;
+                            } else
+                                p = old_p;
+
+                            upd[l] = update_prob(coeff_upd_cost, left, right, old_p, p) ? (RK_S32)p : -1;
+                            right += left;
+                        }
+                    }
+
+                    for (l = 0; l < 2; l++) {
+                        if (upd[l] >= 0) {
+                            entropy->coeff_prob[i][j][k][l] = upd[l];
                             entropy->update_coeff_prob_flag = 1;
                         }
-                        right += left;
                     }
                 }
             }
         }
 
+        entropy->coeff_cnt_valid = 1;
+
         if (entropy->update_coeff_prob_flag)
             entropy->default_coeff_prob_flag = 0;
 
@@ -157,8 +178,8 @@ MPP_RET vp8e_init_entropy(void *hal)
 
             p = calc_mvprob(left, right, entropy->old_mv_prob[i][0]);
 
-            if (update_prob(mv_update_prob_tbl[i][0], left, right,
-                            entropy->old_mv_prob[i][0], p, 6))
+            if (update_prob(update_cost(mv_update_prob_tbl[i][0], 6), left, right,
+                            entropy->old_mv_prob[i][0], p))
                 entropy->mv_prob[i][0] = p;
 
             right += left;
@@ -166,23 +187,23 @@ MPP_RET vp8e_init_entropy(void *hal)
             right -= left - p_tmp[0];
 
             p = calc_mvprob(left, right, entropy->old_mv_prob[i][1]);
-            if (update_prob(mv_update_prob_tbl[i][1], left, right,
-                            entropy->old_mv_prob[i][1], p, 6))
+            if (update_prob(update_cost(mv_update_prob_tbl[i][1], 6), left, right,
+                            entropy->old_mv_prob[i][1], p))
                 entropy->mv_prob[i][1] = p;
 
             for (j = 0; j < 2; j++) {
                 left = *p_tmp++;
                 right = *p_tmp++;
                 p = calc_mvprob(left, right, entropy->old_mv_prob[i][4 + j]);
-                if (update_prob(mv_update_prob_tbl[i][4 + j], left, right,
-                                entropy->old_mv_prob[i][4 + j], p, 6))
+                if (update_prob(update_cost(mv_update_prob_tbl[i][4 + j], 6), left, right,
+                                entropy->old_mv_prob[i][4 + j], p))
                     entropy->mv_prob[i][4 + j] = p;
                 branch_cnt[j] = left + right;
             }
 
             p = calc_mvprob(branch_cnt[0], branch_cnt[1], entropy->old_mv_prob[i][3]);
-            if (update_prob(mv_update_prob_tbl[i][3], branch_cnt[0], branch_cnt[1],
-                            entropy->old_mv_prob[i][3], p, 6))
+            if (update_prob(update_cost(mv_update_prob_tbl[i][3], 6), branch_cnt[0], branch_cnt[1],
+                            entropy->old_mv_prob[i][3], p))
                 entropy->mv_prob[i][3] = p;
 
             type = branch_cnt[0] + branch_cnt[1];
@@ -191,21 +212,21 @@ MPP_RET vp8e_init_entropy(void *hal)
                 left = *p_tmp++;
                 right = *p_tmp++;
                 p = calc_mvprob(left, right, entropy->old_mv_prob[i][7 + j]);
-                if (update_prob(mv_update_prob_tbl[i][7 + j], left, right,
-                                entropy->old_mv_prob[i][7 + j], p, 6))
+                if (update_prob(update_cost(mv_update_prob_tbl[i][7 + j], 6), left, right,
+                                entropy->old_mv_prob[i][7 + j], p))
                     entropy->mv_prob[i][7 + j] = p;
                 branch_cnt[j] = left + right;
             }
 
             p = calc_mvprob(branch_cnt[0], branch_cnt[1], entropy->old_mv_prob[i][6]);
-            if (update_prob(mv_update_prob_tbl[i][6], branch_cnt[0], branch_cnt[1],
-                            entropy->old_mv_prob[i][6], p, 6))
+            if (update_prob(update_cost(mv_update_prob_tbl[i][6], 6), branch_cnt[0], branch_cnt[1],
+                            entropy->old_mv_prob[i][6], p))
                 entropy->mv_prob[i][6] = p;
 
             p = calc_mvprob(type, branch_cnt[0] + branch_cnt[1],
                             entropy->old_mv_prob[i][2]);
-            if (update_prob(mv_update_prob_tbl[i][2], type, branch_cnt[0] + branch_cnt[1],
-                            entropy->old_mv_prob[i][2], p, 6))
+            if (update_prob(update_cost(mv_update_prob_tbl[i][2], 6), type, branch_cnt[0] + branch_cnt[1],
+                            entropy->old_mv_prob[i][2], p))
                 entropy->mv_prob[i][2] = p;
         }
     }
@@ -379,6 +400,26 @@ RK_S32 vp8e_calc_cost_mv(RK_S32 mvd, RK_S32 *mv_prob)
     return bit_cost;
 }
 
+MPP_RET vp8e_calc_mv_cost(void *hal)
+{
+    HalVp8eCtx *ctx = (HalVp8eCtx *)hal;
+    Vp8eHalEntropy *entropy = &ctx->entropy;
+    RK_S32 i, j;
+
+    if (entropy->mv_cost_valid &&
+        !memcmp(entropy->mv_cost_prob, entropy->mv_prob, sizeof(entropy->mv_prob)))
+        return MPP_OK;
+
+    for (i = 0; i < 2; i++)
+        for (j = 0; j < 128; j++)
+            entropy->mv_cost[i][j] = vp8e_calc_cost_mv(j * 2, entropy->mv_prob[i]);
+
+    memcpy(entropy->mv_cost_prob, entropy->mv_prob, sizeof(entropy->mv_prob));
+    entropy->mv_cost_valid = 1;
+
+    return MPP_OK;
+}
+
 MPP_RET vp8e_calc_coeff_prob(Vp8ePutBitBuf *bitbuf, RK_S32 (*curr)[4][8][3][11],
                              RK_S32 (*prev)[4][8][3][11])
 {
@@ -388,6 +429,12 @@ MPP_RET vp8e_calc_coeff_prob(Vp8ePutBitBuf *bitbuf, RK_S32 (*curr)[4][8][3][11],
     for (i = 0; i < 4; i++) {
         for (j = 0; j < 8; j++) {
             for (k = 0; k < 3; k++) {
+                /* most sets are not updated, put their no update flags at once */
+                if (!memcmp((*curr)[i][j][k], (*prev)[i][j][k], sizeof((*curr)[i][j][k]))) {
+                    vp8e_put_bools(bitbuf, coeff_update_prob_tbl[i][j][k], 0, 11);
+                    continue;
+                }
+
                 for (l = 0; l < 11; l++) {
                     prob = coeff_update_prob_tbl[i][j][k][l];
                     old = (RK_S32) (*prev)[i][j][k][l];
@@ -413,6 +460,11 @@ MPP_RET vp8e_calc_mv_prob(Vp8ePutBitBuf *bitbuf, RK_S32 (*curr)[2][19],
     RK_S32 prob, new, old;
 
     for (i = 0; i < 2; i++) {
+        if (!memcmp((*curr)[i], (*prev)[i], sizeof((*curr)[i]))) {
+            vp8e_put_bools(bitbuf, mv_update_prob_tbl[i], 0, 19);
+            continue;
+        }
+
         for (j = 0; j < 19; j++) {
             prob = mv_update_prob_tbl[i][j];
             old = (RK_S32) (*prev)[i][j];
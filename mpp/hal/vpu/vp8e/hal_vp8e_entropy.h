@@ -28,6 +28,7 @@ extern "C" {
 MPP_RET vp8e_init_entropy(void *hal);
 MPP_RET vp8e_write_entropy_tables(void *hal);
 RK_S32  vp8e_calc_cost_mv(RK_S32 mvd, RK_S32 *mv_prob);
+MPP_RET vp8e_calc_mv_cost(void *hal);
 MPP_RET vp8e_calc_coeff_prob(Vp8ePutBitBuf *bitbuf,
                              RK_S32 (*curr)[4][8][3][11], RK_S32 (*prev)[4][8][3][11]);
 MPP_RET vp8e_calc_mv_prob(Vp8ePutBitBuf *bitbuf,
@@ -16,6 +16,8 @@
 
 #define MODULE_TAG "hal_vp8e_putbit"
 
+#include "mpp_common.h"
+
 #include "hal_vp8e_base.h"
 #include "hal_vp8e_putbit.h"
 
@@ -40,42 +42,105 @@ MPP_RET vp8e_set_buffer(Vp8ePutBitBuf *bitbuf, RK_U8 *data, RK_S32 size)
     return MPP_OK;
 }
 
-MPP_RET vp8e_put_bool(Vp8ePutBitBuf *bitbuf, RK_S32 prob, RK_S32 bool_value)
+/* left shift to normalize range back to [128, 255] */
+static const RK_U8 vp8e_norm_tbl[256] = {
+    0, 7, 6, 6, 5, 5, 5, 5, 4, 4, 4, 4, 4, 4, 4, 4,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+/* shift out normalized bits in chunks up to the next output byte */
+static void put_shift(Vp8ePutBitBuf *bitbuf, RK_S32 shift)
 {
-    RK_S32 bits = 0;
-    RK_S32 length_bits = 0;
-
-    RK_S32 split = 1 + ((bitbuf->range - 1) * prob >> 8);
-
-    if (bool_value) {
-        bitbuf->bottom += split;
-        bitbuf->range -= split;
-    } else {
-        bitbuf->range = split;
-    }
+    while (shift) {
+        RK_S32 cnt = MPP_MIN(shift, bitbuf->bits_left);
+        RK_U32 bottom = (RK_U32)bitbuf->bottom;
 
-    while (bitbuf->range < 128) {
-        if (bitbuf->bottom < 0) {
+        /* carry out of the bits shifted out goes to the written bytes */
+        if (bottom >> (32 - cnt)) {
             RK_U8 *data = bitbuf->data;
             while (*--data == 255) {
                 *data = 0;
             }
             (*data)++;
         }
-        bitbuf->range <<= 1;
-        bitbuf->bottom <<= 1;
-
-        if (!--bitbuf->bits_left) {
-            length_bits += 8;
-            bits <<= 8;
-            bits |= (bitbuf->bottom >> 24) & 0xff;
-            TRACE_BIT_STREAM(bits & 0xff, 8);
+
+        bitbuf->bottom = (RK_S32)(bottom << cnt);
+        bitbuf->bits_left -= cnt;
+        shift -= cnt;
+
+        if (!bitbuf->bits_left) {
+            TRACE_BIT_STREAM((bitbuf->bottom >> 24) & 0xff, 8);
             *bitbuf->data++ = (bitbuf->bottom >> 24) & 0xff;
             bitbuf->byte_cnt++;
             bitbuf->bottom &= 0xffffff;     /* Keep 3 bytes */
             bitbuf->bits_left = 8;
         }
     }
+}
+
+static void put_bool(Vp8ePutBitBuf *bitbuf, RK_S32 prob, RK_S32 bool_value)
+{
+    RK_S32 split = 1 + ((bitbuf->range - 1) * prob >> 8);
+    RK_S32 shift;
+
+    if (bool_value) {
+        bitbuf->bottom += split;
+        bitbuf->range -= split;
+    } else {
+        bitbuf->range = split;
+    }
+
+    shift = vp8e_norm_tbl[bitbuf->range];
+    bitbuf->range <<= shift;
+    put_shift(bitbuf, shift);
+}
+
+MPP_RET vp8e_put_bool(Vp8ePutBitBuf *bitbuf, RK_S32 prob, RK_S32 bool_value)
+{
+    put_bool(bitbuf, prob, bool_value);
+    return MPP_OK;
+}
+
+MPP_RET vp8e_put_bools(Vp8ePutBitBuf *bitbuf, const RK_S32 *prob,
+                       RK_S32 bool_value, RK_S32 number)
+{
+    RK_S32 range = bitbuf->range;
+    RK_S32 shift = 0;
+    RK_S32 i;
+
+    if (bool_value) {
+        for (i = 0; i < number; i++)
+            put_bool(bitbuf, prob[i], 1);
+
+        return MPP_OK;
+    }
+
+    /* zero only narrows range, so the shifts of the whole run go out at once */
+    for (i = 0; i < number; i++) {
+        RK_S32 split = 1 + ((range - 1) * prob[i] >> 8);
+        RK_S32 norm = vp8e_norm_tbl[split];
+
+        range = split << norm;
+        shift += norm;
+    }
+
+    bitbuf->range = range;
+    put_shift(bitbuf, shift);
+
     return MPP_OK;
 }
 
@@ -83,7 +148,7 @@ MPP_RET vp8e_put_lit(Vp8ePutBitBuf *bitbuf, RK_S32 value,
                      RK_S32 number)
 {
     while (number--) {
-        vp8e_put_bool(bitbuf, 128, (value >> number) & 0x1);
+        put_bool(bitbuf, 128, (value >> number) & 0x1);
     }
     return MPP_OK;
 }
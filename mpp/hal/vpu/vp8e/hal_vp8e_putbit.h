@@ -46,6 +46,9 @@ MPP_RET vp8e_buffer_gap(Vp8ePutBitBuf *bitbuf, RK_S32 gap);
 MPP_RET vp8e_buffer_overflow(Vp8ePutBitBuf *bitbuf);
 MPP_RET vp8e_put_byte(Vp8ePutBitBuf *bitbuf, RK_S32 byte);
 MPP_RET vp8e_put_bool(Vp8ePutBitBuf *bitbuf, RK_S32 prob, RK_S32 boolValue);
+/* put number bools of the same value with probability array prob */
+MPP_RET vp8e_put_bools(Vp8ePutBitBuf *bitbuf, const RK_S32 *prob,
+                       RK_S32 bool_value, RK_S32 number);
 MPP_RET vp8e_set_buffer(Vp8ePutBitBuf *bitbuf, RK_U8 *data, RK_S32 size);
 
 #ifdef __cplusplus
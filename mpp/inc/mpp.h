@@ -19,6 +19,7 @@
 
 #include "mpp_queue.h"
 #include "mpp_task_impl.h"
+#include "mpp_buffer_impl.h"
 
 #include "mpp_dec.h"
 #include "mpp_enc.h"
@@ -129,6 +130,17 @@ public:
     MPP_RET notify(RK_U32 flag);
     MPP_RET notify(MppBufferGroup group);
 
+    /*
+     * context recycling, see mpp_ctx_pool.h
+     * park  - reset the context and drop all user state for reuse
+     * match - check whether this parked context equals a new context with
+     *         its config before init
+     * reuse - attach the parked context to the new mpi context
+     */
+    MPP_RET park();
+    RK_U32  match(Mpp *mpp, MppCtxType type, MppCodingType coding);
+    void    reuse(MppCtx ctx);
+
     mpp_list        *mPktIn;
     mpp_list        *mPktOut;
     mpp_list        *mFrmIn;
@@ -151,6 +163,12 @@ public:
     MppBufferGroup  mFrameGroup;
     RK_U32          mExternalFrameGroup;
 
+    /*
+     * buffer account of this context
+     *      - charged by all internal groups created on init and in mpp threads
+     */
+    MppBufAccount   *mBufAccount;
+
     /*
      * Mpp task queue for advance task mode
      */
@@ -201,6 +219,10 @@ private:
 
     /* decoder paramter before init */
     MppDecCfgSet    mDecInitcfg;
+    /* config before init for matching on context recycling */
+    MppDecCfgSet    mRecycleCfg;
+    MppPollType     mRecycleInTimeout;
+    MppPollType     mRecycleOutTimeout;
     RK_U32          mParserFastMode;
     RK_U32          mParserNeedSplit;
     RK_U32          mParserInternalPts;     /* for MPEG2/MPEG4 */
@@ -217,6 +239,7 @@ private:
     MPP_RET control_dec(MpiCmd cmd, MppParam param);
     MPP_RET control_enc(MpiCmd cmd, MppParam param);
     MPP_RET control_isp(MpiCmd cmd, MppParam param);
+    MPP_RET get_mem_usage(MppMemUsage *usage);
 
     /* for special encoder async io mode */
     MPP_RET put_frame_async(MppFrame frame);
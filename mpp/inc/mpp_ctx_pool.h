@@ -0,0 +1,41 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_CTX_POOL_H__
+#define __MPP_CTX_POOL_H__
+
+#include "mpp.h"
+
+/*
+ * Process-wide pool of initialized contexts
+ *
+ * mpp_destroy parks the context into the pool instead of destroying it.
+ * The parked context is reset with its threads idle, device opened and the
+ * internal buffers retained. mpp_init reuses a parked context with the same
+ * type, coding and config set before init.
+ *
+ * env mpp_ctx_pool sets the max parked context count, 0 disables the pool.
+ * Only decoder context can be parked now. Contexts still parked at process
+ * exit are left to the system.
+ *
+ * mpp_ctx_pool_get - return a parked context matching mpp or NULL
+ * mpp_ctx_pool_put - return MPP_OK when mpp is parked, otherwise the caller
+ *                    should destroy it
+ */
+MPP_RET mpp_ctx_pool_put(Mpp *mpp);
+Mpp *mpp_ctx_pool_get(Mpp *mpp, MppCtxType type, MppCodingType coding);
+
+#endif /* __MPP_CTX_POOL_H__ */
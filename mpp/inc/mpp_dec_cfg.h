@@ -35,6 +35,7 @@ typedef enum MppDecCfgChange_e {
     MPP_DEC_CFG_CHANGE_DISABLE_ERROR    = (1 << 14),
     MPP_DEC_CFG_CHANGE_ENABLE_VPROC     = (1 << 15),
     MPP_DEC_CFG_CHANGE_ENABLE_FAST_PLAY = (1 << 16),
+    MPP_DEC_CFG_CHANGE_FAST_RECOVERY    = (1 << 17),
 
     MPP_DEC_CFG_CHANGE_ALL              = (0xFFFFFFFF),
 } MppDecCfgChange;
@@ -56,6 +57,12 @@ typedef struct MppDecBaseCfg_t {
     RK_U32              disable_error;
     RK_U32              enable_vproc;
     RK_U32              enable_fast_play;
+    /*
+     * keep decoding on reference loss instead of waiting for next IRAP
+     * lost reference is concealed by nearest decoded frame and the damage
+     * is reported by mpp_frame_get_damage until the next recovery point
+     */
+    RK_U32              fast_recovery;
 } MppDecBaseCfg;
 
 typedef enum MppDecCbCfgChange_e {
@@ -79,6 +86,39 @@ typedef struct MppDecCbCfg_t {
     RK_S32              frm_rdy_cmd;
 } MppDecCbCfg;
 
+typedef enum MppDecThreadCfgChange_e {
+    MPP_DEC_THREAD_CFG_CHANGE_PARSER    = (1 << 0),
+    MPP_DEC_THREAD_CFG_CHANGE_HAL       = (1 << 1),
+    MPP_DEC_THREAD_CFG_CHANGE_VPROC     = (1 << 2),
+
+    MPP_DEC_THREAD_CFG_CHANGE_ALL       = (0xFFFFFFFF),
+} MppDecThreadCfgChange;
+
+/*
+ * decoder thread placement, see MppThreadPolicy in mpp_thread.h
+ * cpu is affinity bit mask, nice is -20 ~ 19, fifo is SCHED_FIFO priority
+ * zero value keeps the env default of the thread role
+ * *_time returns the thread cpu time in us on get
+ */
+typedef struct MppDecThreadCfg_t {
+    RK_U64              change;
+
+    RK_U32              parser_cpu;
+    RK_S32              parser_nice;
+    RK_S32              parser_fifo;
+    RK_S64              parser_time;
+
+    RK_U32              hal_cpu;
+    RK_S32              hal_nice;
+    RK_S32              hal_fifo;
+    RK_S64              hal_time;
+
+    RK_U32              vproc_cpu;
+    RK_S32              vproc_nice;
+    RK_S32              vproc_fifo;
+    RK_S64              vproc_time;
+} MppDecThreadCfg;
+
 typedef struct MppDecStatusCfg_t {
     RK_U32              hal_support_fast_mode;
     RK_U32              hal_task_count;
@@ -89,6 +129,7 @@ typedef struct MppDecCfgSet_t {
     MppDecBaseCfg       base;
     MppDecStatusCfg     status;
     MppDecCbCfg         cb;
+    MppDecThreadCfg     thread;
 } MppDecCfgSet;
 
 /*
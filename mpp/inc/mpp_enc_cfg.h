@@ -21,6 +21,10 @@
 #include "rk_venc_ref.h"
 #include "rc_data.h"
 
+/* frames in hardware of non-block input encoder, see base:pipe_depth */
+#define MPP_ENC_PIPE_DEPTH_DEFAULT      2
+#define MPP_ENC_PIPE_DEPTH_MAX          4
+
 /*
  * MppEncCfgSet shows the relationship between different configuration
  * Due to the huge amount of configurable parameters we need to setup
@@ -27,6 +27,8 @@
 
 #include "mpi_impl.h"
 #include "mpp_info.h"
+#include "mpp_ctx_pool.h"
+#include "mpp_cap_cache.h"
 
 RK_U32 mpi_debug = 0;
 
@@ -495,7 +497,16 @@ MPP_RET mpp_init(MppCtx ctx, MppCtxType type, MppCodingType coding)
             break;
         }
 
-        ret = p->ctx->init(type, coding);
+        Mpp *parked = mpp_ctx_pool_get(p->ctx, type, coding);
+        if (parked) {
+            mpi_dbg_func("reuse parked mpp %p\n", parked);
+            delete p->ctx;
+            p->ctx = parked;
+            p->ctx->reuse(p);
+            ret = MPP_OK;
+        } else {
+            ret = p->ctx->init(type, coding);
+        }
         p->type     = type;
         p->coding   = coding;
     } while (0);
@@ -516,7 +527,7 @@ MPP_RET mpp_destroy(MppCtx ctx)
         if (ret)
             return ret;
 
-        if (p->ctx)
+        if (p->ctx && mpp_ctx_pool_put(p->ctx))
             delete p->ctx;
 
         mpp_free(p);
@@ -601,3 +612,8 @@ void mpp_show_color_format()
                 info->format, info->format, info->name);
     }
 }
+
+MPP_RET mpp_preload_capability(void)
+{
+    return mpp_cap_cache_preload();
+}
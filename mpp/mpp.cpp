@@ -37,6 +37,7 @@
 #include "mpp_packet_impl.h"
 
 #include "mpp_dec_cfg_impl.h"
+#include "mpp_enc_cfg.h"
 
 #define MPP_TEST_FRAME_SIZE     SZ_1M
 #define MPP_TEST_PACKET_SIZE    SZ_512K
@@ -87,6 +88,7 @@ Mpp::Mpp(MppCtx ctx)
       mPacketGroup(NULL),
       mFrameGroup(NULL),
       mExternalFrameGroup(0),
+      mBufAccount(NULL),
       mUsrInPort(NULL),
       mUsrOutPort(NULL),
       mMppInPort(NULL),
@@ -107,24 +109,32 @@ Mpp::Mpp(MppCtx ctx)
       mCoding(MPP_VIDEO_CodingUnused),
       mInitDone(0),
       mStatus(0),
+      mRecycleInTimeout(MPP_POLL_BUTT),
+      mRecycleOutTimeout(MPP_POLL_BUTT),
       mExtraPacket(NULL),
       mDump(NULL)
 {
     mpp_env_get_u32("mpp_debug", &mpp_debug, 0);
 
     memset(&mDecInitcfg, 0, sizeof(mDecInitcfg));
+    memset(&mRecycleCfg, 0, sizeof(mRecycleCfg));
     mpp_dec_cfg_set_default(&mDecInitcfg);
     mDecInitcfg.base.enable_vproc = 1;
     mDecInitcfg.base.change  |= MPP_DEC_CFG_CHANGE_ENABLE_VPROC;
 
+    mpp_buf_account_init(&mBufAccount, "mpp_ctx");
     mpp_dump_init(&mDump);
 }
 
 MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
 {
     MPP_RET ret = MPP_NOK;
+    RK_U32 hal_dummy = 0;
 
-    if (!mpp_check_soc_cap(type, coding)) {
+    /* dummy hal runs without hardware, see mpp_hal_init / mpp_enc_hal_init */
+    mpp_env_get_u32("mpp_hal_dummy", &hal_dummy, 0);
+
+    if (!hal_dummy && !mpp_check_soc_cap(type, coding)) {
         mpp_err("unable to create %s %s for soc %s unsupported\n",
                 strof_ctx_type(type), strof_coding_type(coding),
                 mpp_get_soc_info()->compatible);
@@ -142,6 +152,14 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
     mType = type;
     mCoding = coding;
 
+    memcpy(&mRecycleCfg, &mDecInitcfg, sizeof(mRecycleCfg));
+    mRecycleInTimeout = mInputTimeout;
+    mRecycleOutTimeout = mOutputTimeout;
+
+    /* charge all the groups created on init to this context */
+    MppBufAccount *prev_account = mpp_buf_account_attach(mBufAccount);
+    RK_U32 low_mem = mBufAccount && mBufAccount->budget;
+
     mpp_task_queue_init(&mInputTaskQueue, this, "input");
     mpp_task_queue_init(&mOutputTaskQueue, this, "output");
 
@@ -158,7 +176,7 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
 
         if (mCoding != MPP_VIDEO_CodingMJPEG) {
             mpp_buffer_group_get_internal(&mPacketGroup, MPP_BUFFER_TYPE_ION);
-            mpp_buffer_group_limit_config(mPacketGroup, 0, 3);
+            mpp_buffer_group_limit_config(mPacketGroup, 0, low_mem ? 2 : 3);
 
             mpp_task_queue_setup(mInputTaskQueue, 4);
             mpp_task_queue_setup(mOutputTaskQueue, 4);
@@ -172,6 +190,13 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
         mMppInPort  = mpp_task_queue_get_port(mInputTaskQueue,  MPP_PORT_OUTPUT);
         mMppOutPort = mpp_task_queue_get_port(mOutputTaskQueue, MPP_PORT_INPUT);
 
+        /* fast parse takes one more hal task and packet buffer */
+        if (low_mem) {
+            RK_U32 fast_parse = 0;
+
+            mpp_dec_set_cfg_by_cmd(&mDecInitcfg, MPP_DEC_SET_PARSER_FAST_MODE, &fast_parse);
+        }
+
         MppDecInitCfg cfg = {
             coding,
             this,
@@ -217,7 +242,7 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
 
         MppEncInitCfg cfg = {
             coding,
-            (mInputTimeout) ? (1) : (2),
+            (mInputTimeout || low_mem) ? (1) : (MPP_ENC_PIPE_DEPTH_MAX),
             this,
         };
 
@@ -247,12 +272,19 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
         clear();
     }
 
+    mpp_buf_account_attach(prev_account);
+
     return ret;
 }
 
 Mpp::~Mpp ()
 {
     clear();
+
+    if (mBufAccount) {
+        mpp_buf_account_deinit(mBufAccount);
+        mBufAccount = NULL;
+    }
 }
 
 void Mpp::clear()
@@ -954,6 +986,81 @@ MPP_RET Mpp::reset()
     return MPP_OK;
 }
 
+MPP_RET Mpp::park()
+{
+    MPP_RET ret;
+
+    /* encoder keeps codec and rate control state which can not be restored */
+    if (!mInitDone || mType != MPP_CTX_DEC)
+        return MPP_NOK;
+
+    reset();
+
+    /* restore the config applied on init */
+    ret = mpp_dec_recycle(mDec, &mDecInitcfg);
+    if (ret)
+        return ret;
+
+    /* external frame group belongs to the leaving user */
+    if (mFrameGroup && mExternalFrameGroup) {
+        mpp_buffer_group_set_callback((MppBufferGroupImpl *)mFrameGroup,
+                                      NULL, NULL);
+        mFrameGroup = NULL;
+        mExternalFrameGroup = 0;
+    }
+
+    if (mExtraPacket) {
+        mpp_packet_deinit(&mExtraPacket);
+        mExtraPacket = NULL;
+    }
+
+    mPacketPutCount = 0;
+    mPacketGetCount = 0;
+    mFramePutCount = 0;
+    mFrameGetCount = 0;
+    mTaskPutCount = 0;
+    mTaskGetCount = 0;
+
+    mInputTimeout = (mRecycleInTimeout == MPP_POLL_BUTT) ?
+                    MPP_POLL_NON_BLOCK : mRecycleInTimeout;
+    mOutputTimeout = (mRecycleOutTimeout == MPP_POLL_BUTT) ?
+                     MPP_POLL_NON_BLOCK : mRecycleOutTimeout;
+    mIoMode = MPP_IO_MODE_DEFAULT;
+    mCtx = NULL;
+
+    return MPP_OK;
+}
+
+RK_U32 Mpp::match(Mpp *mpp, MppCtxType type, MppCodingType coding)
+{
+    MppDecCfgSet cfg0;
+    MppDecCfgSet cfg1;
+    size_t budget0 = mBufAccount ? mBufAccount->budget : 0;
+    size_t budget1 = mpp->mBufAccount ? mpp->mBufAccount->budget : 0;
+
+    if (mType != type || mCoding != coding || budget0 != budget1)
+        return 0;
+
+    if (mpp->mExternalFrameGroup ||
+        mpp->mInputTimeout != mRecycleInTimeout ||
+        mpp->mOutputTimeout != mRecycleOutTimeout)
+        return 0;
+
+    memcpy(&cfg0, &mRecycleCfg, sizeof(cfg0));
+    memcpy(&cfg1, &mpp->mDecInitcfg, sizeof(cfg1));
+    cfg0.base.change = cfg1.base.change = 0;
+    cfg0.cb.change = cfg1.cb.change = 0;
+    cfg0.thread.change = cfg1.thread.change = 0;
+
+    return !memcmp(&cfg0, &cfg1, sizeof(cfg0));
+}
+
+void Mpp::reuse(MppCtx ctx)
+{
+    mCtx = ctx;
+    mpp_ops_reset(mDump);
+}
+
 MPP_RET Mpp::control_mpp(MpiCmd cmd, MppParam param)
 {
     MPP_RET ret = MPP_OK;
@@ -1010,6 +1117,24 @@ MPP_RET Mpp::control_mpp(MpiCmd cmd, MppParam param)
         resume();
     } break;
 
+    case MPP_SET_MEM_BUDGET : {
+        RK_S64 budget = (param) ? *((RK_S64 *)param) : 0;
+
+        if (NULL == mBufAccount || budget < 0) {
+            mpp_err("invalid memory budget %lld\n", budget);
+            ret = MPP_ERR_VALUE;
+            break;
+        }
+
+        if (mInitDone)
+            mpp_log("memory budget set after init only limits the buffer allocation\n");
+
+        mBufAccount->budget = (size_t)budget;
+    } break;
+    case MPP_GET_MEM_USAGE : {
+        ret = get_mem_usage((MppMemUsage *)param);
+    } break;
+
     default : {
         ret = MPP_NOK;
     } break;
@@ -1017,6 +1142,39 @@ MPP_RET Mpp::control_mpp(MpiCmd cmd, MppParam param)
     return ret;
 }
 
+MPP_RET Mpp::get_mem_usage(MppMemUsage *usage)
+{
+    MppBufAccount *account = mBufAccount;
+    RK_S64 internal;
+
+    if (NULL == usage || NULL == account) {
+        mpp_err("invalid memory usage query %p account %p\n", usage, account);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    memset(usage, 0, sizeof(*usage));
+
+    usage->budget       = account->budget;
+    usage->total        = account->usage;
+    usage->total_max    = account->usage_max;
+    usage->group_count  = account->group_count;
+    usage->buffer_count = account->buffer_count;
+    usage->refused      = account->refused;
+
+    if (mFrameGroup)
+        usage->frame = mpp_buffer_group_usage(mFrameGroup);
+    if (mPacketGroup)
+        usage->packet = mpp_buffer_group_usage(mPacketGroup);
+
+    internal = usage->packet;
+    if (!mExternalFrameGroup)
+        internal += usage->frame;
+
+    usage->scratch = MPP_MAX(usage->total - internal, 0);
+
+    return MPP_OK;
+}
+
 MPP_RET Mpp::control_osal(MpiCmd cmd, MppParam param)
 {
     MPP_RET ret = MPP_NOK;
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_ctx_pool"
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_list.h"
+#include "mpp_debug.h"
+#include "mpp_common.h"
+
+#include "mpp_ctx_pool.h"
+
+#define CTX_POOL_DBG_FLOW           (0x00000001)
+
+#define ctx_pool_dbg(flag, fmt, ...) _mpp_dbg_f(mpp_ctx_pool_debug, flag, fmt, ## __VA_ARGS__)
+#define ctx_pool_dbg_flow(fmt, ...) ctx_pool_dbg(CTX_POOL_DBG_FLOW, fmt, ## __VA_ARGS__)
+
+static RK_U32 mpp_ctx_pool_debug = 0;
+
+typedef struct MppCtxPoolNode_t {
+    struct list_head    list;
+    Mpp                 *mpp;
+} MppCtxPoolNode;
+
+class MppCtxPoolService
+{
+private:
+    MppCtxPoolService();
+    ~MppCtxPoolService();
+    MppCtxPoolService(const MppCtxPoolService &);
+    MppCtxPoolService &operator=(const MppCtxPoolService &);
+
+    Mutex               mLock;
+    struct list_head    mList;
+    RK_U32              mMax;
+    RK_U32              mCount;
+
+public:
+    static MppCtxPoolService *get_inst() {
+        static MppCtxPoolService inst;
+        return &inst;
+    }
+
+    MPP_RET put(Mpp *mpp);
+    Mpp *get(Mpp *mpp, MppCtxType type, MppCodingType coding);
+};
+
+MppCtxPoolService::MppCtxPoolService()
+    : mMax(0),
+      mCount(0)
+{
+    mpp_env_get_u32("mpp_ctx_pool_debug", &mpp_ctx_pool_debug, 0);
+    mpp_env_get_u32("mpp_ctx_pool", &mMax, 0);
+
+    INIT_LIST_HEAD(&mList);
+}
+
+/*
+ * NOTE: parked contexts are NOT destroyed here. The pool is constructed
+ * before the buffer / memory services used by Mpp, so those services are
+ * already destroyed when this static destructor runs. The process is
+ * exiting and its memory, threads and device handles are released by the
+ * system anyway.
+ */
+MppCtxPoolService::~MppCtxPoolService()
+{
+}
+
+MPP_RET MppCtxPoolService::put(Mpp *mpp)
+{
+    MppCtxPoolNode *node;
+
+    if (!mMax)
+        return MPP_NOK;
+
+    {
+        AutoMutex auto_lock(&mLock);
+
+        if (mCount >= mMax)
+            return MPP_NOK;
+    }
+
+    /* park outside the pool lock for it waits the decoder threads */
+    if (mpp->park())
+        return MPP_NOK;
+
+    node = mpp_calloc(MppCtxPoolNode, 1);
+    if (NULL == node)
+        return MPP_NOK;
+
+    AutoMutex auto_lock(&mLock);
+
+    if (mCount >= mMax) {
+        mpp_free(node);
+        return MPP_NOK;
+    }
+
+    INIT_LIST_HEAD(&node->list);
+    node->mpp = mpp;
+    list_add_tail(&node->list, &mList);
+    mCount++;
+
+    ctx_pool_dbg_flow("park mpp %p count %d\n", mpp, mCount);
+
+    return MPP_OK;
+}
+
+Mpp *MppCtxPoolService::get(Mpp *mpp, MppCtxType type, MppCodingType coding)
+{
+    MppCtxPoolNode *pos, *n;
+    Mpp *ret = NULL;
+
+    AutoMutex auto_lock(&mLock);
+
+    list_for_each_entry_safe(pos, n, &mList, MppCtxPoolNode, list) {
+        if (!pos->mpp->match(mpp, type, coding))
+            continue;
+
+        ret = pos->mpp;
+        list_del_init(&pos->list);
+        mpp_free(pos);
+        mCount--;
+        break;
+    }
+
+    ctx_pool_dbg_flow("reuse mpp %p count %d\n", ret, mCount);
+
+    return ret;
+}
+
+MPP_RET mpp_ctx_pool_put(Mpp *mpp)
+{
+    if (NULL == mpp)
+        return MPP_ERR_NULL_PTR;
+
+    return MppCtxPoolService::get_inst()->put(mpp);
+}
+
+Mpp *mpp_ctx_pool_get(Mpp *mpp, MppCtxType type, MppCodingType coding)
+{
+    if (NULL == mpp)
+        return NULL;
+
+    return MppCtxPoolService::get_inst()->get(mpp, type, coding);
+}
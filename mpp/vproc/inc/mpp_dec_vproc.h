@@ -17,6 +17,7 @@
 #ifndef __MPP_DEC_VPROC_H__
 #define __MPP_DEC_VPROC_H__
 
+#include "mpp_thread.h"
 #include "hal_dec_task.h"
 
 typedef struct MppDecVprocCfg_t {
@@ -38,6 +39,8 @@ extern "C" {
  * dec_vproc_start  - start thread processing
  * dec_vproc_signal - signal thread that one frame has be pushed for process
  * dec_vproc_reset  - reset process thread and discard all input
+ * dec_vproc_set_policy   - set process thread placement policy
+ * dec_vproc_get_cpu_time - get process thread cpu time in us
  */
 
 MPP_RET dec_vproc_init(MppDecVprocCtx *ctx, MppDecVprocCfg *cfg);
@@ -47,6 +50,8 @@ MPP_RET dec_vproc_start(MppDecVprocCtx ctx);
 MPP_RET dec_vproc_stop(MppDecVprocCtx ctx);
 MPP_RET dec_vproc_signal(MppDecVprocCtx ctx);
 MPP_RET dec_vproc_reset(MppDecVprocCtx ctx);
+MPP_RET dec_vproc_set_policy(MppDecVprocCtx ctx, const MppThreadPolicy *policy);
+RK_S64 dec_vproc_get_cpu_time(MppDecVprocCtx ctx);
 
 #ifdef __cplusplus
 }
@@ -461,6 +461,8 @@ static void *dec_vproc_thread(void *data)
 
     mpp_dbg_info("mpp_dec_post_proc_thread started\n");
 
+    mpp_buf_account_attach(mpp->mBufAccount);
+
     while (1) {
         MPP_RET ret = MPP_OK;
 
@@ -590,7 +592,8 @@ MPP_RET dec_vproc_init(MppDecVprocCtx *ctx, MppDecVprocCfg *cfg)
 
     p->mpp = (Mpp *)cfg->mpp;
     p->slots = ((MppDecImpl *)p->mpp->mDec)->frame_slots;
-    p->thd = new MppThread(dec_vproc_thread, p, "mpp_dec_vproc");
+    p->thd = new MppThread(dec_vproc_thread, p, "mpp_dec_vproc",
+                           MPP_THREAD_ROLE_VPROC);
     sem_init(&p->reset_sem, 0, 0);
     ret = hal_task_group_init(&p->task_group, TASK_BUTT, 4, sizeof(HalDecVprocTask));
     if (ret) {
@@ -786,3 +789,25 @@ MPP_RET dec_vproc_reset(MppDecVprocCtx ctx)
     vproc_dbg_func("out\n");
     return MPP_OK;
 }
+
+MPP_RET dec_vproc_set_policy(MppDecVprocCtx ctx, const MppThreadPolicy *policy)
+{
+    MppDecVprocCtxImpl *p = (MppDecVprocCtxImpl *)ctx;
+
+    if (NULL == p || NULL == policy) {
+        mpp_err_f("found NULL input ctx %p policy %p\n", p, policy);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if (p->thd)
+        p->thd->set_policy(policy);
+
+    return MPP_OK;
+}
+
+RK_S64 dec_vproc_get_cpu_time(MppDecVprocCtx ctx)
+{
+    MppDecVprocCtxImpl *p = (MppDecVprocCtxImpl *)ctx;
+
+    return (p && p->thd) ? p->thd->get_cpu_time() : 0;
+}
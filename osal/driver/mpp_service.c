@@ -25,6 +25,7 @@
 #include "mpp_mem.h"
 #include "mpp_debug.h"
 #include "mpp_common.h"
+#include "mpp_cap_cache.h"
 #include "osal_2str.h"
 
 #include "mpp_device_debug.h"
@@ -47,23 +48,38 @@ static const MppServiceQueryCfg query_cfg[] = {
 
 static const RK_U32 query_count = MPP_ARRAY_ELEMS(query_cfg);
 
-const char *mpp_get_mpp_service_name(void)
+static const char *mpp_service_dev[] = {
+    "/dev/mpp_service",
+    "/dev/mpp-service",
+};
+
+RK_U32 mpp_get_mpp_service_node(void)
 {
-    static const char *mpp_service_name = NULL;
-    static const char *mpp_service_dev[] = {
-        "/dev/mpp_service",
-        "/dev/mpp-service",
-    };
+    static RK_S32 mpp_service_node = -1;
+    const MppCapSnapshot *cache = NULL;
 
-    if (mpp_service_name)
-        return mpp_service_name;
+    if (mpp_service_node >= 0)
+        return mpp_service_node;
 
-    if (!access(mpp_service_dev[0], F_OK | R_OK | W_OK)) {
-        mpp_service_name = mpp_service_dev[0];
+    cache = mpp_cap_cache_get();
+    if (cache) {
+        mpp_service_node = cache->service_node;
+    } else if (!access(mpp_service_dev[0], F_OK | R_OK | W_OK)) {
+        mpp_service_node = 1;
     } else if (!access(mpp_service_dev[1], F_OK | R_OK | W_OK))
-        mpp_service_name = mpp_service_dev[1];
+        mpp_service_node = 2;
+    else
+        mpp_service_node = 0;
+
+    return mpp_service_node;
+}
+
+const char *mpp_get_mpp_service_name(void)
+{
+    RK_U32 node = mpp_get_mpp_service_node();
 
-    return mpp_service_name;
+    return (node && node <= MPP_ARRAY_ELEMS(mpp_service_dev)) ?
+           mpp_service_dev[node - 1] : NULL;
 }
 
 RK_S32 mpp_service_ioctl(RK_S32 fd, RK_U32 cmd, RK_U32 size, void *param)
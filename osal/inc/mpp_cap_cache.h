@@ -0,0 +1,87 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_CAP_CACHE_H__
+#define __MPP_CAP_CACHE_H__
+
+#include "mpp_buffer.h"
+#include "mpp_service.h"
+
+/*
+ * Capability snapshot of soc / platform / runtime probing.
+ *
+ * MppSocService, MppPlatformService and MppRuntimeService probe device tree,
+ * device nodes, kernel version and mpp_service capability on first use. The
+ * result of all three is stored in a cache file once and the following
+ * processes load it with a few syscalls instead of probing again.
+ *
+ * The cache file is keyed by kernel boot id, kernel release and the modify
+ * time of /dev, so reboot, kernel update or driver (un)loading invalidates it.
+ * The key also has the caller uid / gid / groups and the owner and mode of
+ * the probed device nodes, for the probing checks the access permission.
+ *
+ * env mpp_cap_cache       - 1 enable the cache file, default 0
+ * env mpp_cap_cache_path  - cache file path, default is mpp_cap_cache.bin in
+ *                           $XDG_RUNTIME_DIR or in private /tmp/mpp-<euid>
+ * env mpp_cap_cache_debug - debug flag
+ */
+#define MPP_CAP_PART_SOC            (0x00000001)
+#define MPP_CAP_PART_PLATFORM       (0x00000002)
+#define MPP_CAP_PART_RUNTIME        (0x00000004)
+#define MPP_CAP_PART_ALL            (0x00000007)
+
+#define MPP_CAP_SOC_NAME_LEN        128
+
+typedef struct MppCapSnapshot_t {
+    /* MPP_CAP_PART_SOC */
+    char                soc_name[MPP_CAP_SOC_NAME_LEN];
+
+    /* MPP_CAP_PART_PLATFORM */
+    RK_U32              ioctl_version;
+    RK_U32              kernel_version;
+    RK_U32              vcodec_type;
+    RK_U32              hw_ids[32];
+    MppServiceCmdCap    cmd_cap;
+    /* 0 - no mpp_service, 1 - /dev/mpp_service, 2 - /dev/mpp-service */
+    RK_U32              service_node;
+    RK_U32              flag_2d;
+
+    /* MPP_CAP_PART_RUNTIME */
+    RK_U32              allocator_valid[MPP_BUFFER_TYPE_BUTT];
+} MppCapSnapshot;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* return the snapshot loaded from cache file or NULL when it is not valid */
+const MppCapSnapshot *mpp_cap_cache_get(void);
+/*
+ * store the probed part from src. The cache file is written when all parts
+ * have been probed by current process.
+ */
+void mpp_cap_cache_update(RK_U32 part, const MppCapSnapshot *src);
+/*
+ * load cache file or probe all capabilities and write the cache file.
+ * Call it early at startup to move the probing out of the first mpp_init.
+ */
+MPP_RET mpp_cap_cache_preload(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MPP_CAP_CACHE_H__ */
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_LOG_ASYNC_H__
+#define __MPP_LOG_ASYNC_H__
+
+#include <stdio.h>
+#include <stdarg.h>
+
+#include "rk_type.h"
+
+/*
+ * Asynchronous log backend selected by env mpp_log_mode:
+ *
+ * 0 - sync, message is formatted and printed on the calling thread
+ * 1 - async text, the calling thread only copies the format pointer and the
+ *     raw arguments into its own lock-free ring buffer. A background thread
+ *     formats and prints them with the same layout as sync mode.
+ * 2 - async binary, same recording as mode 1 but the background thread
+ *     writes the raw records to the file set by env mpp_log_file
+ *     (default /tmp/mpp_log.bin). Use mpp_log_bin_decode to format it.
+ *
+ * With env mpp_log_crash_dump set to 1 records still pending in the ring
+ * buffers on a fatal signal are dumped to <mpp_log_file>.crash in the binary
+ * format, then the signal goes on to the handler installed before.
+ *
+ * env mpp_log_ring_size sets the per-thread ring buffer size in bytes.
+ * Messages are dropped and counted when a ring is full.
+ */
+#define MPP_LOG_MODE_SYNC       0
+#define MPP_LOG_MODE_ASYNC      1
+#define MPP_LOG_MODE_BIN        2
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+RK_S32 mpp_log_async_mode(void);
+/* return MPP_OK when the message is taken by async backend */
+RK_S32 mpp_log_async_write(int level, const char *tag, const char *fmt,
+                           const char *func, va_list args);
+/* drain all pending records on the calling thread */
+void mpp_log_async_flush(void);
+
+/* format binary log file to out, return record count or negative on error */
+RK_S32 mpp_log_bin_decode(const char *file, FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MPP_LOG_ASYNC_H__ */
@@ -59,6 +59,32 @@ void mpp_show_mem_status();
 RK_U32 mpp_mem_total_now();
 RK_U32 mpp_mem_total_max();
 
+/*
+ * mpp memory per caller statistic report
+ *
+ * Allocation tracking is enabled by env mpp_mem_debug. Env mpp_mem_sample=N
+ * tracks one of every N allocations only and env mpp_mem_report=ms calls the
+ * report hook periodically from the allocating thread.
+ * The default hook logs the callers with the most live memory.
+ * Statistic is sorted by live size. Count and size are scaled down by sample.
+ */
+typedef struct MppMemStat_t {
+    const char  *caller;
+    /* live allocation count and size */
+    RK_U32      count;
+    RK_U32      size;
+    RK_U32      size_max;
+    /* allocation count since start */
+    RK_U32      total;
+} MppMemStat;
+
+typedef void (*MppMemReport)(void *ctx, const MppMemStat *stats, RK_S32 count, RK_U32 sample);
+
+/* NULL report restores the default log hook, zero period disables timer */
+void mpp_mem_set_report(MppMemReport report, void *ctx, RK_U32 period_ms);
+/* call the report hook now */
+void mpp_mem_report(void);
+
 /*
  * mpp memory usage snapshot tool
  *
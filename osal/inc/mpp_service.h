@@ -124,6 +124,8 @@ extern "C" {
 void check_mpp_service_cap(RK_U32 *codec_type, RK_U32 *hw_ids, MppServiceCmdCap *cap);
 const MppServiceCmdCap *mpp_get_mpp_service_cmd_cap(void);
 const char *mpp_get_mpp_service_name(void);
+/* 0 - no mpp_service, 1 - /dev/mpp_service, 2 - /dev/mpp-service */
+RK_U32 mpp_get_mpp_service_node(void);
 
 #ifdef  __cplusplus
 }
@@ -52,6 +52,8 @@ int pthread_setname_np(pthread_t thread, const char *name);
 
 #endif
 
+#include "rk_type.h"
+
 #define THREAD_NAME_LEN 16
 
 typedef void *(*MppThreadFunc)(void *);
@@ -63,6 +65,31 @@ typedef enum {
     MPP_THREAD_STOPPING,
 } MppThreadStatus;
 
+/*
+ * Thread role selects the default placement policy of a thread.
+ * The defaults come from env:
+ * mpp_thread_<role>_cpu  - cpu affinity bit mask, 0x30 for cpu 4 and 5
+ * mpp_thread_<role>_nice - nice value -20 ~ 19
+ * mpp_thread_<role>_fifo - SCHED_FIFO priority 1 ~ 99
+ * role name is parser / hal / enc / vproc / timer.
+ */
+typedef enum MppThreadRole_e {
+    MPP_THREAD_ROLE_DEFAULT,
+    MPP_THREAD_ROLE_PARSER,
+    MPP_THREAD_ROLE_HAL,
+    MPP_THREAD_ROLE_ENC,
+    MPP_THREAD_ROLE_VPROC,
+    MPP_THREAD_ROLE_TIMER,
+    MPP_THREAD_ROLE_BUTT,
+} MppThreadRole;
+
+/* zero value field keeps the inherited setting */
+typedef struct MppThreadPolicy_t {
+    RK_U32          cpu_mask;
+    RK_S32          nice;
+    RK_S32          fifo;
+} MppThreadPolicy;
+
 #ifdef __cplusplus
 
 #include "mpp_debug.h"
@@ -236,7 +263,8 @@ typedef enum MppThreadSignal_e {
 class MppThread
 {
 public:
-    MppThread(MppThreadFunc func, void *ctx, const char *name = NULL);
+    MppThread(MppThreadFunc func, void *ctx, const char *name = NULL,
+              MppThreadRole role = MPP_THREAD_ROLE_DEFAULT);
     ~MppThread() {};
 
     MppThreadStatus get_status(MppThreadSignal id = THREAD_WORK);
@@ -246,6 +274,14 @@ public:
     void start();
     void stop();
 
+    /*
+     * non-zero fields of policy override the role default
+     * it takes effect immediately on running thread
+     */
+    void set_policy(const MppThreadPolicy *policy);
+    /* cpu time consumed by the thread in us */
+    RK_S64 get_cpu_time();
+
     void lock(MppThreadSignal id = THREAD_WORK) {
         mpp_assert(id < THREAD_SIGNAL_BUTT);
         mMutexCond[id].lock();
@@ -287,6 +323,16 @@ private:
     char            mName[THREAD_NAME_LEN];
     void            *mContext;
 
+    MppThreadRole   mRole;
+    MppThreadPolicy mPolicy;
+    /* kernel thread id while the thread function is running */
+    volatile RK_S32 mTid;
+    /* cpu time of finished thread function in us */
+    RK_S64          mCpuTime;
+
+    static void *thread_entry(void *arg);
+    void apply_policy();
+
     MppThread();
     MppThread(const MppThread &);
     MppThread &operator=(const MppThread &);
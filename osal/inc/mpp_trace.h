@@ -29,6 +29,15 @@ void mpp_trace_async_begin(const char* name, RK_S32 cookie);
 void mpp_trace_async_end(const char* name, RK_S32 cookie);
 void mpp_trace_int32(const char* name, RK_S32 value);
 void mpp_trace_int64(const char* name, RK_S64 value);
+/* non-zero when ftrace marker or in-memory recorder takes the events */
+RK_S32 mpp_trace_enabled(void);
+
+/*
+ * Save events recorded in memory (env mpp_trace_mem=1) to file.
+ * *.pftrace / *.pb is saved as perfetto protobuf, others as chrome json.
+ * NULL file uses env mpp_trace_file. Return saved event count.
+ */
+RK_S32 mpp_trace_dump(const char *file);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,380 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_cap_cache"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+
+#include "mpp_env.h"
+#include "mpp_debug.h"
+#include "mpp_common.h"
+#include "mpp_thread.h"
+
+#include "mpp_soc.h"
+#include "mpp_runtime.h"
+#include "mpp_platform.h"
+#include "mpp_cap_cache.h"
+
+#define CAP_CACHE_DBG_FLOW          (0x00000001)
+
+#define cap_cache_dbg(flag, fmt, ...) _mpp_dbg_f(mpp_cap_cache_debug, flag, fmt, ## __VA_ARGS__)
+#define cap_cache_dbg_flow(fmt, ...) cap_cache_dbg(CAP_CACHE_DBG_FLOW, fmt, ## __VA_ARGS__)
+
+#define CAP_CACHE_MAGIC             (0x5041434d)    /* "MCAP" */
+#define CAP_CACHE_VERSION           2
+#define CAP_CACHE_PATH_LEN          256
+#define CAP_CACHE_BOOT_ID_LEN       40
+#define CAP_CACHE_RELEASE_LEN       68
+#define CAP_CACHE_FILE_NAME         "mpp_cap_cache.bin"
+
+/* device nodes checked by access() in probing, the result depends on them */
+static const char *cap_cache_nodes[] = {
+    "/dev/ion",
+    "/dev/dri/card0",
+    "/dev/dma_heap",
+    "/dev/mpp_service",
+    "/dev/mpp-service",
+};
+
+typedef struct MppCapCacheNode_t {
+    RK_U32              mode;
+    RK_U32              uid;
+    RK_U32              gid;
+} MppCapCacheNode;
+
+typedef struct MppCapCacheKey_t {
+    char                boot_id[CAP_CACHE_BOOT_ID_LEN];
+    char                release[CAP_CACHE_RELEASE_LEN];
+    RK_S64              dev_mtime;
+    /* permission probing result depends on the caller credential */
+    RK_U32              uid;
+    RK_U32              gid;
+    RK_U32              euid;
+    RK_U32              egid;
+    RK_U32              groups;
+    MppCapCacheNode     nodes[MPP_ARRAY_ELEMS(cap_cache_nodes)];
+} MppCapCacheKey;
+
+typedef struct MppCapCacheFile_t {
+    RK_U32              magic;
+    RK_U32              version;
+    RK_U32              size;
+    RK_U32              checksum;
+    MppCapCacheKey      key;
+    MppCapSnapshot      snapshot;
+} MppCapCacheFile;
+
+static RK_U32 mpp_cap_cache_debug = 0;
+
+static RK_U32 cap_cache_checksum(const void *data, size_t size)
+{
+    const RK_U8 *p = (const RK_U8 *)data;
+    RK_U32 hash = 2166136261u;
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static void cap_cache_read_key(MppCapCacheKey *key)
+{
+    struct utsname uts;
+    struct stat st;
+    gid_t groups[64];
+    RK_S32 cnt;
+    RK_U32 i;
+    RK_S32 fd;
+
+    memset(key, 0, sizeof(*key));
+
+    fd = open("/proc/sys/kernel/random/boot_id", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ssize_t len = read(fd, key->boot_id, sizeof(key->boot_id) - 1);
+
+        if (len > 0 && key->boot_id[len - 1] == '\n')
+            key->boot_id[len - 1] = '\0';
+        close(fd);
+    }
+
+    if (!uname(&uts))
+        strncpy(key->release, uts.release, sizeof(key->release) - 1);
+
+    /* device node creation and removal updates /dev */
+    if (!stat("/dev", &st))
+        key->dev_mtime = (RK_S64)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+
+    key->uid = getuid();
+    key->gid = getgid();
+    key->euid = geteuid();
+    key->egid = getegid();
+
+    cnt = getgroups(MPP_ARRAY_ELEMS(groups), groups);
+    key->groups = (cnt > 0) ? cap_cache_checksum(groups, cnt * sizeof(groups[0])) : (RK_U32)cnt;
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(cap_cache_nodes); i++) {
+        if (stat(cap_cache_nodes[i], &st))
+            continue;
+
+        key->nodes[i].mode = st.st_mode;
+        key->nodes[i].uid = st.st_uid;
+        key->nodes[i].gid = st.st_gid;
+    }
+}
+
+/*
+ * default to $XDG_RUNTIME_DIR or a private per user directory in /tmp,
+ * never a shared file in a world writable directory
+ */
+static void cap_cache_default_path(char *path, size_t size)
+{
+    const char *runtime = getenv("XDG_RUNTIME_DIR");
+    char dir[32];
+    struct stat st;
+
+    path[0] = '\0';
+
+    if (runtime && runtime[0] == '/') {
+        snprintf(path, size, "%s/%s", runtime, CAP_CACHE_FILE_NAME);
+        return;
+    }
+
+    snprintf(dir, sizeof(dir), "/tmp/mpp-%d", (RK_S32)geteuid());
+    /* bypass the mpp_common.h mkdir macro for it sets 0755 */
+    if ((mkdir)(dir, S_IRWXU) && errno != EEXIST)
+        return;
+
+    if (lstat(dir, &st) || !S_ISDIR(st.st_mode) || st.st_uid != geteuid() ||
+        (st.st_mode & (S_IRWXG | S_IRWXO))) {
+        mpp_log("ignore unsafe cache directory %s\n", dir);
+        return;
+    }
+
+    snprintf(path, size, "%s/%s", dir, CAP_CACHE_FILE_NAME);
+}
+
+class MppCapCacheService
+{
+private:
+    MppCapCacheService();
+    ~MppCapCacheService() {};
+    MppCapCacheService(const MppCapCacheService &);
+    MppCapCacheService &operator=(const MppCapCacheService &);
+
+    Mutex               mLock;
+    RK_U32              mEnable;
+    RK_U32              mLoaded;
+    RK_U32              mWritten;
+    RK_U32              mParts;
+    char                mPath[CAP_CACHE_PATH_LEN];
+    MppCapCacheFile     mFile;
+
+    void                load();
+    void                write();
+
+public:
+    static MppCapCacheService *get_inst() {
+        static MppCapCacheService inst;
+        return &inst;
+    }
+
+    const MppCapSnapshot *get() { return mLoaded ? &mFile.snapshot : NULL; };
+    void update(RK_U32 part, const MppCapSnapshot *src);
+};
+
+MppCapCacheService::MppCapCacheService()
+    : mEnable(0),
+      mLoaded(0),
+      mWritten(0),
+      mParts(0)
+{
+    const char *path = NULL;
+
+    mpp_env_get_u32("mpp_cap_cache_debug", &mpp_cap_cache_debug, 0);
+    mpp_env_get_u32("mpp_cap_cache", &mEnable, 0);
+    mpp_env_get_str("mpp_cap_cache_path", &path, NULL);
+
+    memset(&mFile, 0, sizeof(mFile));
+    mFile.magic = CAP_CACHE_MAGIC;
+    mFile.version = CAP_CACHE_VERSION;
+    mFile.size = sizeof(mFile);
+    if (mEnable) {
+        if (path)
+            snprintf(mPath, sizeof(mPath), "%s", path);
+        else
+            cap_cache_default_path(mPath, sizeof(mPath));
+    }
+
+    if (!mEnable || !mPath[0]) {
+        mEnable = 0;
+        return;
+    }
+
+    load();
+}
+
+void MppCapCacheService::load()
+{
+    MppCapCacheFile file;
+    MppCapCacheKey key;
+    struct stat st;
+    RK_S32 fd;
+    ssize_t len;
+
+    fd = open(mPath, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd < 0) {
+        cap_cache_dbg_flow("no cache file %s\n", mPath);
+        return;
+    }
+
+    /* only trust a regular file written by ourself or root */
+    if (fstat(fd, &st) || !S_ISREG(st.st_mode) ||
+        (st.st_uid != geteuid() && st.st_uid != 0)) {
+        mpp_log("ignore untrusted cache file %s\n", mPath);
+        close(fd);
+        return;
+    }
+
+    len = read(fd, &file, sizeof(file));
+    close(fd);
+
+    if (len != (ssize_t)sizeof(file) || file.magic != CAP_CACHE_MAGIC ||
+        file.version != CAP_CACHE_VERSION || file.size != sizeof(file)) {
+        cap_cache_dbg_flow("cache file %s format mismatch\n", mPath);
+        return;
+    }
+
+    if (file.checksum != cap_cache_checksum(&file.snapshot, sizeof(file.snapshot))) {
+        mpp_log("cache file %s checksum mismatch\n", mPath);
+        return;
+    }
+
+    cap_cache_read_key(&key);
+    if (memcmp(&key, &file.key, sizeof(key))) {
+        cap_cache_dbg_flow("cache file %s is stale\n", mPath);
+        return;
+    }
+
+    file.snapshot.soc_name[MPP_CAP_SOC_NAME_LEN - 1] = '\0';
+    memcpy(&mFile, &file, sizeof(mFile));
+    mLoaded = 1;
+    mParts = MPP_CAP_PART_ALL;
+
+    cap_cache_dbg_flow("load cache file %s soc %s\n", mPath, mFile.snapshot.soc_name);
+}
+
+void MppCapCacheService::write()
+{
+    char tmp[CAP_CACHE_PATH_LEN + 16];
+    RK_S32 fd;
+    ssize_t len;
+
+    /* magic, version and size are constant and set on init */
+    mFile.checksum = cap_cache_checksum(&mFile.snapshot, sizeof(mFile.snapshot));
+    cap_cache_read_key(&mFile.key);
+
+    /*
+     * write to a new exclusive file then rename for concurrent starting
+     * processes, mkstemp never follows an existing file or symlink
+     */
+    snprintf(tmp, sizeof(tmp), "%s.XXXXXX", mPath);
+
+    fd = mkstemp(tmp);
+    if (fd < 0) {
+        cap_cache_dbg_flow("can not create cache file %s\n", tmp);
+        return;
+    }
+
+    len = ::write(fd, &mFile, sizeof(mFile));
+    close(fd);
+
+    if (len != (ssize_t)sizeof(mFile) || rename(tmp, mPath)) {
+        mpp_err_f("failed to write cache file %s\n", mPath);
+        unlink(tmp);
+        return;
+    }
+
+    cap_cache_dbg_flow("write cache file %s\n", mPath);
+}
+
+void MppCapCacheService::update(RK_U32 part, const MppCapSnapshot *src)
+{
+    MppCapSnapshot *dst = &mFile.snapshot;
+
+    if (!mEnable || mLoaded)
+        return;
+
+    AutoMutex auto_lock(&mLock);
+
+    if (part & MPP_CAP_PART_SOC)
+        memcpy(dst->soc_name, src->soc_name, sizeof(dst->soc_name));
+
+    if (part & MPP_CAP_PART_PLATFORM) {
+        dst->ioctl_version = src->ioctl_version;
+        dst->kernel_version = src->kernel_version;
+        dst->vcodec_type = src->vcodec_type;
+        memcpy(dst->hw_ids, src->hw_ids, sizeof(dst->hw_ids));
+        memcpy(&dst->cmd_cap, &src->cmd_cap, sizeof(dst->cmd_cap));
+        dst->service_node = src->service_node;
+        dst->flag_2d = src->flag_2d;
+    }
+
+    if (part & MPP_CAP_PART_RUNTIME)
+        memcpy(dst->allocator_valid, src->allocator_valid, sizeof(dst->allocator_valid));
+
+    mParts |= part;
+
+    if (mParts == MPP_CAP_PART_ALL && !mWritten) {
+        write();
+        mWritten = 1;
+    }
+}
+
+const MppCapSnapshot *mpp_cap_cache_get(void)
+{
+    return MppCapCacheService::get_inst()->get();
+}
+
+void mpp_cap_cache_update(RK_U32 part, const MppCapSnapshot *src)
+{
+    if (NULL == src)
+        return;
+
+    MppCapCacheService::get_inst()->update(part, src);
+}
+
+MPP_RET mpp_cap_cache_preload(void)
+{
+    /* touch all services, each of them loads or stores its own part */
+    mpp_get_soc_name();
+    mpp_get_vcodec_type();
+    mpp_get_2d_hw_flag();
+    mpp_rt_allcator_is_valid(MPP_BUFFER_TYPE_NORMAL);
+
+    cap_cache_dbg_flow("preload from %s\n", mpp_cap_cache_get() ? "cache" : "probing");
+
+    return MPP_OK;
+}
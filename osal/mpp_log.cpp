@@ -23,6 +23,7 @@
 #include "mpp_env.h"
 #include "mpp_debug.h"
 #include "mpp_common.h"
+#include "mpp_log_async.h"
 
 #include "os_log.h"
 
@@ -83,7 +84,8 @@ void _mpp_log(const char *tag, const char *fmt, const char *fname, ...)
     mpp_logw("warning: use new logx function\n");
 
     va_start(args, fname);
-    __mpp_log(os_log_info, tag, fmt, fname, args);
+    if (mpp_log_async_write(MPP_LOG_INFO, tag, fmt, fname, args))
+        __mpp_log(os_log_info, tag, fmt, fname, args);
     va_end(args);
 }
 
@@ -94,7 +96,8 @@ void _mpp_err(const char *tag, const char *fmt, const char *fname, ...)
     mpp_logw("warning: use new logx function\n");
 
     va_start(args, fname);
-    __mpp_log(os_log_error, tag, fmt, fname, args);
+    if (mpp_log_async_write(MPP_LOG_ERROR, tag, fmt, fname, args))
+        __mpp_log(os_log_error, tag, fmt, fname, args);
     va_end(args);
 }
 
@@ -125,7 +128,8 @@ void _mpp_log_l(int level, const char *tag, const char *fmt, const char *fname,
         return;
 
     va_start(args, fname);
-    __mpp_log(log_func[level], tag, fmt, fname, args);
+    if (mpp_log_async_write(level, tag, fmt, fname, args))
+        __mpp_log(log_func[level], tag, fmt, fname, args);
     va_end(args);
 }
 
@@ -0,0 +1,1553 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_log_async"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mpp_err.h"
+#include "mpp_common.h"
+#include "mpp_log_def.h"
+#include "mpp_log_async.h"
+
+/*
+ * NOTE: nothing in this file may call mpp_log, the log functions route back
+ * here. Errors are printed with plain fprintf to stderr.
+ */
+
+#define LOG_REC_MAX             2048
+/* max length of an inlined string including the terminator */
+#define LOG_STR_MAX             256
+#define LOG_LINE_MAX            1024
+#define LOG_CHUNK_MAX           (1024 * 1024)
+
+/* string word with this bit set is followed by the string bytes */
+#define LOG_STR_INLINE          (1ULL << 63)
+
+#define LOG_BIN_MAGIC           "MPPLOGB1"
+#define LOG_BIN_VERSION         1
+#define LOG_CHUNK_STR           1
+#define LOG_CHUNK_REC           2
+
+/*
+ * record layout, every field is 8 byte aligned:
+ * LogRecHdr | tag | fmt | func | args...
+ *
+ * tag / fmt / func is either a pointer word to a read-only string or an
+ * inlined string. Each argument takes one 64bit word except %s which is
+ * always inlined. Arguments are decoded by walking the format again.
+ */
+typedef struct LogRecHdr_t {
+    RK_U32          size;
+    RK_U16          level;
+    RK_U16          arg_cnt;
+    RK_S32          tid;
+    RK_U32          reserved;
+    RK_S64          time;
+} LogRecHdr;
+
+/* binary file: LogBinHdr followed by chunks of LogChunk + payload */
+typedef struct LogBinHdr_t {
+    char            magic[8];
+    RK_U32          version;
+    RK_U32          ptr_size;
+} LogBinHdr;
+
+typedef struct LogChunk_t {
+    RK_U32          type;
+    RK_U32          size;
+} LogChunk;
+
+typedef enum LogArgLen_e {
+    LOG_LEN_NONE,
+    LOG_LEN_HH,
+    LOG_LEN_H,
+    LOG_LEN_L,
+    LOG_LEN_LL,
+    LOG_LEN_J,
+    LOG_LEN_Z,
+    LOG_LEN_T,
+    LOG_LEN_LD,
+} LogArgLen;
+
+typedef enum LogArgType_e {
+    LOG_ARG_BAD,
+    LOG_ARG_INT,
+    LOG_ARG_UINT,
+    LOG_ARG_CHAR,
+    LOG_ARG_DBL,
+    LOG_ARG_PTR,
+    LOG_ARG_STR,
+    LOG_ARG_NUM,
+} LogArgType;
+
+typedef struct LogSpec_t {
+    const char      *start;     /* the '%' */
+    const char      *end;       /* next char after the conversion */
+    RK_S32          star_cnt;
+    LogArgLen       len;
+    char            conv;
+} LogSpec;
+
+typedef struct LogRecInfo_t {
+    RK_S32          level;
+    RK_S32          tid;
+    RK_S64          time;
+    const char      *tag;
+    const char      *fmt;
+    const char      *func;
+} LogRecInfo;
+
+typedef struct LogOut_t {
+    char            *buf;
+    size_t          size;
+    size_t          pos;
+} LogOut;
+
+typedef struct LogPtrTab_t {
+    RK_U64          *keys;
+    char            **vals;
+    RK_U32          size;
+    RK_U32          cnt;
+} LogPtrTab;
+
+typedef const char *(*LogStrResolve)(void *ctx, RK_U64 ptr);
+
+static RK_S32 log_spec_next(const char *fmt, LogSpec *spec)
+{
+    const char *p = fmt;
+
+    while (*p) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            p += 2;
+            continue;
+        }
+        break;
+    }
+
+    if (!*p)
+        return 0;
+
+    spec->start = p++;
+    spec->star_cnt = 0;
+    spec->len = LOG_LEN_NONE;
+
+    while (*p && strchr("-+ #0'", *p))
+        p++;
+
+    if (*p == '*') {
+        spec->star_cnt++;
+        p++;
+    } else {
+        while (*p >= '0' && *p <= '9')
+            p++;
+    }
+
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->star_cnt++;
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9')
+                p++;
+        }
+    }
+
+    switch (*p) {
+    case 'h' : {
+        p++;
+        if (*p == 'h') {
+            spec->len = LOG_LEN_HH;
+            p++;
+        } else
+            spec->len = LOG_LEN_H;
+    } break;
+    case 'l' : {
+        p++;
+        if (*p == 'l') {
+            spec->len = LOG_LEN_LL;
+            p++;
+        } else
+            spec->len = LOG_LEN_L;
+    } break;
+    case 'q' : {
+        spec->len = LOG_LEN_LL;
+        p++;
+    } break;
+    case 'L' : {
+        spec->len = LOG_LEN_LD;
+        p++;
+    } break;
+    case 'j' : {
+        spec->len = LOG_LEN_J;
+        p++;
+    } break;
+    case 'z' : {
+        spec->len = LOG_LEN_Z;
+        p++;
+    } break;
+    case 't' : {
+        spec->len = LOG_LEN_T;
+        p++;
+    } break;
+    default : {
+    } break;
+    }
+
+    spec->conv = *p;
+    if (*p)
+        p++;
+    spec->end = p;
+
+    return 1;
+}
+
+static LogArgType log_arg_type(const LogSpec *spec)
+{
+    switch (spec->conv) {
+    case 'd' :
+    case 'i' :
+        return LOG_ARG_INT;
+    case 'u' :
+    case 'o' :
+    case 'x' :
+    case 'X' :
+        return LOG_ARG_UINT;
+    case 'c' :
+        return (spec->len == LOG_LEN_NONE) ? LOG_ARG_CHAR : LOG_ARG_BAD;
+    case 'e' :
+    case 'E' :
+    case 'f' :
+    case 'F' :
+    case 'g' :
+    case 'G' :
+    case 'a' :
+    case 'A' :
+        return LOG_ARG_DBL;
+    case 'p' :
+        return LOG_ARG_PTR;
+    case 's' :
+        return (spec->len == LOG_LEN_NONE) ? LOG_ARG_STR : LOG_ARG_BAD;
+    case 'n' :
+        return LOG_ARG_NUM;
+    default :
+        break;
+    }
+
+    return LOG_ARG_BAD;
+}
+
+static RK_U8 *log_put_u64(RK_U8 *p, RK_U8 *end, RK_U64 val)
+{
+    if (NULL == p || p + sizeof(val) > end)
+        return NULL;
+
+    memcpy(p, &val, sizeof(val));
+    return p + sizeof(val);
+}
+
+static RK_U8 *log_put_inline(RK_U8 *p, RK_U8 *end, const char *str)
+{
+    size_t len = strnlen(str, LOG_STR_MAX - 1);
+    size_t avail;
+
+    if (NULL == p || p + 16 > end)
+        return NULL;
+
+    /* truncate to the room left in the record */
+    avail = end - p - 8;
+    if (len + 1 > avail)
+        len = avail - 1;
+
+    p = log_put_u64(p, end, LOG_STR_INLINE | (len + 1));
+    memcpy(p, str, len);
+    memset(p + len, 0, MPP_ALIGN(len + 1, 8) - len);
+
+    return p + MPP_ALIGN(len + 1, 8);
+}
+
+static const RK_U8 *log_get_u64(const RK_U8 *p, const RK_U8 *end, RK_U64 *val)
+{
+    if (NULL == p || p + sizeof(*val) > end)
+        return NULL;
+
+    memcpy(val, p, sizeof(*val));
+    return p + sizeof(*val);
+}
+
+static const RK_U8 *log_get_str(const RK_U8 *p, const RK_U8 *end, LogStrResolve resolve,
+                                void *ctx, const char **str)
+{
+    RK_U64 val;
+    size_t len;
+
+    p = log_get_u64(p, end, &val);
+    if (NULL == p)
+        return NULL;
+
+    if (!(val & LOG_STR_INLINE)) {
+        *str = val ? resolve(ctx, val) : NULL;
+        return p;
+    }
+
+    len = (size_t)(val & 0xffffffff);
+    if (!len || p + MPP_ALIGN(len, 8) > end || p[len - 1])
+        return NULL;
+
+    *str = (const char *)p;
+    return p + MPP_ALIGN(len, 8);
+}
+
+static void log_out_printf(LogOut *out, const char *fmt, ...)
+{
+    va_list args;
+    int len;
+
+    if (out->pos + 1 >= out->size)
+        return;
+
+    va_start(args, fmt);
+    len = vsnprintf(out->buf + out->pos, out->size - out->pos, fmt, args);
+    va_end(args);
+
+    if (len > 0)
+        out->pos = MPP_MIN(out->pos + len, out->size - 1);
+}
+
+/* copy literal format text and fold %% */
+static void log_out_text(LogOut *out, const char *start, const char *end)
+{
+    while (start < end && out->pos + 1 < out->size) {
+        if (start[0] == '%' && start + 1 < end && start[1] == '%')
+            start++;
+
+        out->buf[out->pos++] = *start++;
+    }
+    out->buf[out->pos] = '\0';
+}
+
+/* rebuild single conversion with 64bit length and resolved '*' */
+static RK_S32 log_spec_build(const LogSpec *spec, const RK_S32 *star, LogArgType type,
+                             char *buf, size_t size)
+{
+    const char *p = spec->start + 1;
+    const char *conv = spec->end - 1;
+    size_t pos = 0;
+    RK_S32 i = 0;
+
+    buf[pos++] = '%';
+
+    for (; p < conv; p++) {
+        if (pos + 16 > size)
+            return -1;
+
+        if (strchr("hlqLjzt", *p))
+            continue;
+
+        if (*p == '*')
+            pos += snprintf(buf + pos, size - pos, "%d", star[i++]);
+        else
+            buf[pos++] = *p;
+    }
+
+    if (type == LOG_ARG_INT || type == LOG_ARG_UINT) {
+        buf[pos++] = 'l';
+        buf[pos++] = 'l';
+    }
+
+    buf[pos++] = *conv;
+    buf[pos] = '\0';
+
+    return 0;
+}
+
+static RK_U32 log_rec_encode(RK_U8 *rec, RK_U32 size, int level, RK_S32 tid,
+                             RK_S64 time, const char *tag, const char *fmt,
+                             const char *func, va_list args,
+                             RK_S32 (*is_static)(const void *))
+{
+    LogRecHdr *hdr = (LogRecHdr *)rec;
+    RK_U8 *end = rec + size;
+    RK_U8 *p = rec + sizeof(*hdr);
+    RK_U8 *next = NULL;
+    const char *cur = fmt;
+    RK_U32 arg_cnt = 0;
+    LogSpec spec;
+    va_list ap;
+
+    p = (tag && is_static(tag)) ? log_put_u64(p, end, (uintptr_t)tag) :
+        tag ? log_put_inline(p, end, tag) : log_put_u64(p, end, 0);
+    p = (fmt && is_static(fmt)) ? log_put_u64(p, end, (uintptr_t)fmt) :
+        fmt ? log_put_inline(p, end, fmt) : log_put_u64(p, end, 0);
+    p = (func && is_static(func)) ? log_put_u64(p, end, (uintptr_t)func) :
+        func ? log_put_inline(p, end, func) : log_put_u64(p, end, 0);
+
+    if (NULL == p)
+        return 0;
+
+    va_copy(ap, args);
+
+    while (cur && log_spec_next(cur, &spec)) {
+        LogArgType type = log_arg_type(&spec);
+        RK_U64 val = 0;
+        RK_S32 i;
+
+        if (type == LOG_ARG_BAD)
+            break;
+
+        for (i = 0; i < spec.star_cnt; i++) {
+            next = log_put_u64(p, end, (RK_U64)(RK_S64)va_arg(ap, int));
+            if (NULL == next)
+                goto DONE;
+            p = next;
+        }
+
+        switch (type) {
+        case LOG_ARG_INT : {
+            RK_S64 v;
+
+            switch (spec.len) {
+            case LOG_LEN_HH : v = (signed char)va_arg(ap, int); break;
+            case LOG_LEN_H  : v = (short)va_arg(ap, int); break;
+            case LOG_LEN_L  : v = va_arg(ap, long); break;
+            case LOG_LEN_LL : v = va_arg(ap, long long); break;
+            case LOG_LEN_J  : v = va_arg(ap, intmax_t); break;
+            case LOG_LEN_Z  : v = (ptrdiff_t)va_arg(ap, size_t); break;
+            case LOG_LEN_T  : v = va_arg(ap, ptrdiff_t); break;
+            default         : v = va_arg(ap, int); break;
+            }
+            val = (RK_U64)v;
+        } break;
+        case LOG_ARG_UINT : {
+            switch (spec.len) {
+            case LOG_LEN_HH : val = (unsigned char)va_arg(ap, unsigned int); break;
+            case LOG_LEN_H  : val = (unsigned short)va_arg(ap, unsigned int); break;
+            case LOG_LEN_L  : val = va_arg(ap, unsigned long); break;
+            case LOG_LEN_LL : val = va_arg(ap, unsigned long long); break;
+            case LOG_LEN_J  : val = va_arg(ap, uintmax_t); break;
+            case LOG_LEN_Z  : val = va_arg(ap, size_t); break;
+            case LOG_LEN_T  : val = (size_t)va_arg(ap, ptrdiff_t); break;
+            default         : val = va_arg(ap, unsigned int); break;
+            }
+        } break;
+        case LOG_ARG_CHAR : {
+            val = (RK_U64)(RK_S64)va_arg(ap, int);
+        } break;
+        case LOG_ARG_DBL : {
+            double d = (spec.len == LOG_LEN_LD) ?
+                       (double)va_arg(ap, long double) : va_arg(ap, double);
+
+            memcpy(&val, &d, sizeof(val));
+        } break;
+        case LOG_ARG_PTR : {
+            val = (uintptr_t)va_arg(ap, void *);
+        } break;
+        case LOG_ARG_NUM : {
+            /* never write back from a log */
+            va_arg(ap, void *);
+            cur = spec.end;
+            continue;
+        } break;
+        case LOG_ARG_STR : {
+            const char *str = va_arg(ap, const char *);
+
+            next = str ? log_put_inline(p, end, str) : log_put_u64(p, end, 0);
+        } break;
+        default : {
+        } break;
+        }
+
+        if (type != LOG_ARG_STR)
+            next = log_put_u64(p, end, val);
+
+        if (NULL == next)
+            break;
+
+        p = next;
+        arg_cnt++;
+        cur = spec.end;
+    }
+
+DONE:
+    va_end(ap);
+
+    hdr->size = (RK_U32)(p - rec);
+    hdr->level = (RK_U16)level;
+    hdr->arg_cnt = (RK_U16)arg_cnt;
+    hdr->tid = tid;
+    hdr->reserved = 0;
+    hdr->time = time;
+
+    return hdr->size;
+}
+
+/* format one record to msg with the same layout as __mpp_log */
+static RK_S32 log_rec_format(const RK_U8 *rec, LogStrResolve resolve, void *ctx,
+                             LogRecInfo *info, char *msg, size_t size)
+{
+    const LogRecHdr *hdr = (const LogRecHdr *)rec;
+    const RK_U8 *end = rec + hdr->size;
+    const RK_U8 *p = rec + sizeof(*hdr);
+    const char *cur;
+    LogOut out;
+    LogSpec spec;
+
+    info->level = hdr->level;
+    info->tid = hdr->tid;
+    info->time = hdr->time;
+
+    p = log_get_str(p, end, resolve, ctx, &info->tag);
+    p = log_get_str(p, end, resolve, ctx, &info->fmt);
+    p = log_get_str(p, end, resolve, ctx, &info->func);
+    if (NULL == p)
+        return MPP_NOK;
+
+    if (NULL == info->tag)
+        info->tag = "mpp_log";
+
+    out.buf = msg;
+    out.size = size;
+    out.pos = 0;
+    msg[0] = '\0';
+
+    if (info->func && info->func[0])
+        log_out_printf(&out, "%s ", info->func);
+
+    cur = info->fmt ? info->fmt : "";
+
+    while (log_spec_next(cur, &spec)) {
+        LogArgType type = log_arg_type(&spec);
+        RK_S32 star[2] = {0, 0};
+        const char *str = NULL;
+        char conv[64];
+        RK_U64 val = 0;
+        RK_S32 i;
+
+        log_out_text(&out, cur, spec.start);
+
+        if (type == LOG_ARG_BAD) {
+            cur = spec.start;
+            break;
+        }
+
+        cur = spec.end;
+
+        if (type == LOG_ARG_NUM)
+            continue;
+
+        for (i = 0; i < spec.star_cnt; i++) {
+            p = log_get_u64(p, end, &val);
+            star[i] = (RK_S32)val;
+        }
+
+        if (type == LOG_ARG_STR)
+            p = log_get_str(p, end, resolve, ctx, &str);
+        else
+            p = log_get_u64(p, end, &val);
+
+        if (NULL == p || log_spec_build(&spec, star, type, conv, sizeof(conv))) {
+            log_out_printf(&out, "<?>");
+            continue;
+        }
+
+        switch (type) {
+        case LOG_ARG_INT :
+        case LOG_ARG_UINT : {
+            log_out_printf(&out, conv, (long long)val);
+        } break;
+        case LOG_ARG_CHAR : {
+            log_out_printf(&out, conv, (int)val);
+        } break;
+        case LOG_ARG_DBL : {
+            double d;
+
+            memcpy(&d, &val, sizeof(d));
+            log_out_printf(&out, conv, d);
+        } break;
+        case LOG_ARG_PTR : {
+            log_out_printf(&out, conv, (void *)(uintptr_t)val);
+        } break;
+        case LOG_ARG_STR : {
+            log_out_printf(&out, conv, str ? str : "(null)");
+        } break;
+        default : {
+        } break;
+        }
+    }
+
+    log_out_text(&out, cur, cur + strlen(cur));
+
+    if (!out.pos || msg[out.pos - 1] != '\n') {
+        if (out.pos + 1 >= size)
+            out.pos = size - 2;
+        msg[out.pos++] = '\n';
+        msg[out.pos] = '\0';
+    }
+
+    return MPP_OK;
+}
+
+static RK_U32 log_ptr_hash(RK_U64 key, RK_U32 size)
+{
+    return (RK_U32)((key >> 3) * 0x9E3779B97F4A7C15ULL >> 32) & (size - 1);
+}
+
+static RK_S32 log_tab_find(LogPtrTab *tab, RK_U64 key)
+{
+    RK_U32 i;
+
+    if (!tab->size)
+        return -1;
+
+    i = log_ptr_hash(key, tab->size);
+    while (tab->keys[i]) {
+        if (tab->keys[i] == key)
+            return (RK_S32)i;
+        i = (i + 1) & (tab->size - 1);
+    }
+
+    return -1;
+}
+
+static RK_S32 log_tab_add(LogPtrTab *tab, RK_U64 key, char *val)
+{
+    RK_U32 i;
+
+    if ((tab->cnt + 1) * 2 > tab->size) {
+        LogPtrTab grow;
+        RK_U32 j;
+
+        grow.size = tab->size ? tab->size * 2 : 1024;
+        grow.cnt = 0;
+        grow.keys = (RK_U64 *)calloc(grow.size, sizeof(*grow.keys));
+        grow.vals = (char **)calloc(grow.size, sizeof(*grow.vals));
+        if (NULL == grow.keys || NULL == grow.vals) {
+            free(grow.keys);
+            free(grow.vals);
+            return MPP_ERR_MALLOC;
+        }
+
+        for (j = 0; j < tab->size; j++) {
+            if (!tab->keys[j])
+                continue;
+
+            i = log_ptr_hash(tab->keys[j], grow.size);
+            while (grow.keys[i])
+                i = (i + 1) & (grow.size - 1);
+
+            grow.keys[i] = tab->keys[j];
+            grow.vals[i] = tab->vals[j];
+            grow.cnt++;
+        }
+
+        free(tab->keys);
+        free(tab->vals);
+        *tab = grow;
+    }
+
+    i = log_ptr_hash(key, tab->size);
+    while (tab->keys[i] && tab->keys[i] != key)
+        i = (i + 1) & (tab->size - 1);
+
+    if (!tab->keys[i])
+        tab->cnt++;
+    else
+        free(tab->vals[i]);
+
+    tab->keys[i] = key;
+    tab->vals[i] = val;
+
+    return MPP_OK;
+}
+
+static void log_tab_deinit(LogPtrTab *tab)
+{
+    RK_U32 i;
+
+    for (i = 0; i < tab->size; i++)
+        free(tab->vals[i]);
+
+    free(tab->keys);
+    free(tab->vals);
+    memset(tab, 0, sizeof(*tab));
+}
+
+static const char *log_resolve_tab(void *ctx, RK_U64 ptr)
+{
+    LogPtrTab *tab = (LogPtrTab *)ctx;
+    RK_S32 idx = log_tab_find(tab, ptr);
+
+    return (idx < 0) ? "<unknown>" : tab->vals[idx];
+}
+
+RK_S32 mpp_log_bin_decode(const char *file, FILE *out)
+{
+    static const char level_char[] = "?FEWIDVI";
+    LogPtrTab tab;
+    LogBinHdr hdr;
+    LogChunk chunk;
+    RK_U8 *buf = NULL;
+    RK_U32 buf_size = 0;
+    RK_S32 cnt = 0;
+    char msg[LOG_LINE_MAX];
+    FILE *fp;
+
+    if (NULL == file || NULL == out)
+        return MPP_ERR_NULL_PTR;
+
+    fp = fopen(file, "rb");
+    if (NULL == fp) {
+        fprintf(stderr, "%s: failed to open %s\n", MODULE_TAG, file);
+        return MPP_ERR_OPEN_FILE;
+    }
+
+    if (fread(&hdr, sizeof(hdr), 1, fp) != 1 ||
+        memcmp(hdr.magic, LOG_BIN_MAGIC, sizeof(hdr.magic)) ||
+        hdr.version != LOG_BIN_VERSION) {
+        fprintf(stderr, "%s: %s is not a mpp binary log\n", MODULE_TAG, file);
+        fclose(fp);
+        return MPP_ERR_VALUE;
+    }
+
+    memset(&tab, 0, sizeof(tab));
+
+    while (fread(&chunk, sizeof(chunk), 1, fp) == 1) {
+        if (chunk.size > LOG_CHUNK_MAX)
+            break;
+
+        if (chunk.size + 1 > buf_size) {
+            RK_U8 *tmp = (RK_U8 *)realloc(buf, MPP_ALIGN(chunk.size + 1, 4096));
+
+            if (NULL == tmp)
+                break;
+            buf = tmp;
+            buf_size = MPP_ALIGN(chunk.size + 1, 4096);
+        }
+
+        /* a truncated tail chunk is expected after a crash */
+        if (fread(buf, 1, chunk.size, fp) != chunk.size)
+            break;
+
+        buf[chunk.size] = '\0';
+
+        if (chunk.type == LOG_CHUNK_STR) {
+            RK_U64 ptr;
+
+            if (chunk.size <= sizeof(ptr))
+                continue;
+
+            memcpy(&ptr, buf, sizeof(ptr));
+            if (ptr && log_tab_find(&tab, ptr) < 0)
+                log_tab_add(&tab, ptr, strdup((char *)buf + sizeof(ptr)));
+        } else if (chunk.type == LOG_CHUNK_REC) {
+            LogRecHdr *rec = (LogRecHdr *)buf;
+            LogRecInfo info;
+
+            if (chunk.size < sizeof(*rec) || rec->size != chunk.size)
+                continue;
+
+            if (log_rec_format(buf, log_resolve_tab, &tab, &info, msg, sizeof(msg)))
+                continue;
+
+            fprintf(out, "%lld.%06lld %5d %c %s: %s",
+                    (long long)(info.time / 1000000), (long long)(info.time % 1000000),
+                    info.tid, level_char[MPP_MIN((RK_U32)info.level, sizeof(level_char) - 2)],
+                    info.tag, msg);
+            cnt++;
+        }
+    }
+
+    log_tab_deinit(&tab);
+    free(buf);
+    fclose(fp);
+
+    return cnt;
+}
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+
+#include "mpp_env.h"
+#include "mpp_lock.h"
+#include "mpp_time.h"
+
+#include "os_log.h"
+
+#define LOG_RING_SIZE_DEF       (256 * 1024)
+#define LOG_RING_SIZE_MIN       (16 * 1024)
+#define LOG_DRAIN_PERIOD_US     10000
+#define LOG_RO_RANGE_MAX        512
+#define LOG_WBUF_SIZE           (64 * 1024)
+#define LOG_PATH_MAX            256
+
+/* single producer single consumer ring, one per logging thread */
+typedef struct LogRing_t {
+    struct LogRing_t    *next;
+    RK_U8               *buf;
+    RK_U32              size;
+    volatile RK_U32     head;
+    volatile RK_U32     tail;
+    volatile RK_U32     dropped;
+    volatile RK_U32     dead;
+    RK_U32              dropped_done;
+    RK_U32              snap;
+    RK_S32              tid;
+} LogRing;
+
+typedef struct LogRange_t {
+    uintptr_t           start;
+    uintptr_t           end;
+} LogRange;
+
+static const int log_crash_sigs[] = { SIGSEGV, SIGBUS, SIGABRT, SIGFPE, SIGILL };
+static struct sigaction log_crash_old[MPP_ARRAY_ELEMS(log_crash_sigs)];
+
+/*
+ * read-only mappings of libmpp and the executable, strings inside live as
+ * long as the process. Strings of other libraries are copied inline since
+ * the library may be unloaded before the record is drained.
+ */
+static LogRange log_ro_ranges[LOG_RO_RANGE_MAX];
+static RK_S32 log_ro_count = 0;
+
+static RK_S32 log_is_static(const void *ptr)
+{
+    uintptr_t addr = (uintptr_t)ptr;
+    RK_S32 lo = 0;
+    RK_S32 hi = log_ro_count - 1;
+
+    while (lo <= hi) {
+        RK_S32 mid = (lo + hi) / 2;
+
+        if (addr < log_ro_ranges[mid].start)
+            hi = mid - 1;
+        else if (addr >= log_ro_ranges[mid].end)
+            lo = mid + 1;
+        else
+            return 1;
+    }
+
+    return 0;
+}
+
+static const char *log_resolve_direct(void *ctx, RK_U64 ptr)
+{
+    (void)ctx;
+    return (const char *)(uintptr_t)ptr;
+}
+
+static void log_ring_read(LogRing *ring, RK_U32 pos, void *dst, RK_U32 size)
+{
+    RK_U32 off = pos & (ring->size - 1);
+    RK_U32 first = MPP_MIN(size, ring->size - off);
+
+    memcpy(dst, ring->buf + off, first);
+    if (first < size)
+        memcpy((RK_U8 *)dst + first, ring->buf, size - first);
+}
+
+static void log_ring_write(LogRing *ring, RK_U32 pos, const void *src, RK_U32 size)
+{
+    RK_U32 off = pos & (ring->size - 1);
+    RK_U32 first = MPP_MIN(size, ring->size - off);
+
+    memcpy(ring->buf + off, src, first);
+    if (first < size)
+        memcpy(ring->buf, (const RK_U8 *)src + first, size - first);
+}
+
+static void log_print(os_log_callback func, const char *tag, const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    func(tag, fmt, args);
+    va_end(args);
+}
+
+static RK_U32 log_rec_make(RK_U8 *rec, int level, RK_S32 tid, const char *fmt, ...)
+{
+    va_list args;
+    RK_U32 size;
+
+    va_start(args, fmt);
+    size = log_rec_encode(rec, LOG_REC_MAX, level, tid, mpp_time(), MODULE_TAG,
+                          fmt, NULL, args, log_is_static);
+    va_end(args);
+
+    return size;
+}
+
+class MppLogAsyncService
+{
+private:
+    // avoid any unwanted function
+    MppLogAsyncService();
+    ~MppLogAsyncService();
+    MppLogAsyncService(const MppLogAsyncService &);
+    MppLogAsyncService &operator=(const MppLogAsyncService &);
+
+    static void *drain_loop(void *ctx);
+    static void ring_release(void *ctx);
+    static void crash_handler(int sig, siginfo_t *info, void *uctx);
+
+    void load_ro_ranges();
+    LogRing *get_ring();
+    void output(const RK_U8 *rec);
+    void wbuf_write(const void *data, RK_U32 size);
+    void wbuf_flush();
+    void write_refs(const RK_U8 *rec, int fd);
+    void crash_dump();
+
+    RK_S32              mMode;
+    RK_U32              mRingSize;
+    volatile RK_U32     mRunning;
+    RK_S32              mThreadValid;
+    pthread_t           mThread;
+    pthread_mutex_t     mCondLock;
+    pthread_cond_t      mCond;
+
+    /* protect ring list and serialize consumers */
+    pthread_mutex_t     mListLock;
+    pthread_key_t       mKey;
+    LogRing             *mRings;
+
+    RK_S32              mFd;
+    char                mCrashPath[LOG_PATH_MAX];
+    LogPtrTab           mSeen;
+    RK_U8               mRec[LOG_REC_MAX];
+    RK_U8               mCrashRec[LOG_REC_MAX];
+    char                mMsg[LOG_LINE_MAX];
+    RK_U8               mWbuf[LOG_WBUF_SIZE];
+    RK_U32              mWbufPos;
+
+    static MppLogAsyncService *mCrashInst;
+
+public:
+    static MppLogAsyncService *get_inst() {
+        static MppLogAsyncService inst;
+        return &inst;
+    }
+
+    RK_S32 get_mode() { return mMode; }
+    RK_S32 write(int level, const char *tag, const char *fmt, const char *func, va_list args);
+    void flush();
+};
+
+MppLogAsyncService *MppLogAsyncService::mCrashInst = NULL;
+
+MppLogAsyncService::MppLogAsyncService()
+    : mMode(MPP_LOG_MODE_SYNC),
+      mRingSize(LOG_RING_SIZE_DEF),
+      mRunning(0),
+      mThreadValid(0),
+      mRings(NULL),
+      mFd(-1),
+      mWbufPos(0)
+{
+    RK_U32 mode = 0;
+    RK_U32 ring_size = 0;
+    RK_U32 crash_dump = 0;
+    const char *path = NULL;
+    RK_U32 i;
+
+    memset(&mSeen, 0, sizeof(mSeen));
+    mCrashPath[0] = '\0';
+
+    mpp_env_get_u32("mpp_log_mode", &mode, MPP_LOG_MODE_SYNC);
+    if (mode != MPP_LOG_MODE_ASYNC && mode != MPP_LOG_MODE_BIN)
+        return;
+
+    mpp_env_get_u32("mpp_log_ring_size", &ring_size, LOG_RING_SIZE_DEF);
+    mpp_env_get_str("mpp_log_file", &path, "/tmp/mpp_log.bin");
+    mpp_env_get_u32("mpp_log_crash_dump", &crash_dump, 0);
+
+    mRingSize = LOG_RING_SIZE_MIN;
+    while (mRingSize < ring_size && mRingSize < (1u << 30))
+        mRingSize <<= 1;
+
+    snprintf(mCrashPath, sizeof(mCrashPath), "%s.crash", path);
+
+    if (mode == MPP_LOG_MODE_BIN) {
+        LogBinHdr hdr;
+
+        mFd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (mFd < 0) {
+            fprintf(stderr, "%s: failed to open %s fallback to sync log\n", MODULE_TAG, path);
+            return;
+        }
+
+        memcpy(hdr.magic, LOG_BIN_MAGIC, sizeof(hdr.magic));
+        hdr.version = LOG_BIN_VERSION;
+        hdr.ptr_size = sizeof(void *);
+        wbuf_write(&hdr, sizeof(hdr));
+        wbuf_flush();
+    }
+
+    load_ro_ranges();
+
+    pthread_mutex_init(&mListLock, NULL);
+    pthread_mutex_init(&mCondLock, NULL);
+    pthread_cond_init(&mCond, NULL);
+    pthread_key_create(&mKey, ring_release);
+
+    mRunning = 1;
+    mThreadValid = !pthread_create(&mThread, NULL, drain_loop, this);
+    if (!mThreadValid) {
+        fprintf(stderr, "%s: failed to create drain thread fallback to sync log\n", MODULE_TAG);
+        mRunning = 0;
+        return;
+    }
+
+    if (crash_dump) {
+        mCrashInst = this;
+        for (i = 0; i < MPP_ARRAY_ELEMS(log_crash_sigs); i++) {
+            struct sigaction sa;
+
+            memset(&sa, 0, sizeof(sa));
+            sa.sa_sigaction = crash_handler;
+            sigemptyset(&sa.sa_mask);
+            sa.sa_flags = SA_SIGINFO;
+            sigaction(log_crash_sigs[i], &sa, &log_crash_old[i]);
+        }
+    }
+
+    mMode = mode;
+}
+
+MppLogAsyncService::~MppLogAsyncService()
+{
+    if (!mThreadValid)
+        return;
+
+    /* later message goes back to sync path */
+    mMode = MPP_LOG_MODE_SYNC;
+
+    pthread_mutex_lock(&mCondLock);
+    mRunning = 0;
+    pthread_cond_signal(&mCond);
+    pthread_mutex_unlock(&mCondLock);
+    pthread_join(mThread, NULL);
+    mThreadValid = 0;
+
+    flush();
+
+    if (mFd >= 0) {
+        close(mFd);
+        mFd = -1;
+    }
+
+    /* rings may still be referenced by running threads, leave them */
+}
+
+void MppLogAsyncService::load_ro_ranges()
+{
+    FILE *fp = fopen("/proc/self/maps", "r");
+    uintptr_t self = (uintptr_t)&log_is_static;
+    unsigned long self_inode = 0;
+    unsigned int self_dev = 0;
+    unsigned long exe_inode = 0;
+    unsigned int exe_dev = 0;
+    struct stat st;
+    char line[512];
+
+    if (NULL == fp)
+        return;
+
+    if (!stat("/proc/self/exe", &st)) {
+        exe_inode = st.st_ino;
+        exe_dev = makedev(major(st.st_dev), minor(st.st_dev));
+    }
+
+    /* find the file of libmpp itself first */
+    while (fgets(line, sizeof(line), fp)) {
+        unsigned long start, end, offset, inode;
+        char perm[8];
+        unsigned int dev_major, dev_minor;
+
+        if (sscanf(line, "%lx-%lx %7s %lx %x:%x %lu", &start, &end, perm,
+                   &offset, &dev_major, &dev_minor, &inode) != 7)
+            continue;
+
+        if (self >= start && self < end) {
+            self_inode = inode;
+            self_dev = makedev(dev_major, dev_minor);
+            break;
+        }
+    }
+
+    rewind(fp);
+
+    while (fgets(line, sizeof(line), fp) && log_ro_count < LOG_RO_RANGE_MAX) {
+        unsigned long start, end, offset, inode;
+        char perm[8];
+        unsigned int dev_major, dev_minor;
+        unsigned int dev;
+
+        if (sscanf(line, "%lx-%lx %7s %lx %x:%x %lu", &start, &end, perm,
+                   &offset, &dev_major, &dev_minor, &inode) != 7)
+            continue;
+
+        if (perm[0] != 'r' || perm[1] != '-' || !inode)
+            continue;
+
+        dev = makedev(dev_major, dev_minor);
+        if (!(inode == self_inode && dev == self_dev) &&
+            !(inode == exe_inode && dev == exe_dev))
+            continue;
+
+        log_ro_ranges[log_ro_count].start = start;
+        log_ro_ranges[log_ro_count].end = end;
+        log_ro_count++;
+    }
+
+    fclose(fp);
+}
+
+void MppLogAsyncService::ring_release(void *ctx)
+{
+    LogRing *ring = (LogRing *)ctx;
+
+    MPP_SYNC();
+    ring->dead = 1;
+}
+
+LogRing *MppLogAsyncService::get_ring()
+{
+    LogRing *ring = (LogRing *)pthread_getspecific(mKey);
+
+    if (ring)
+        return ring;
+
+    /*
+     * rings are never freed as crash handler walks the list without lock,
+     * take over a drained ring of an exited thread first
+     */
+    pthread_mutex_lock(&mListLock);
+    for (ring = mRings; ring; ring = ring->next) {
+        if (ring->dead && ring->tail == ring->head) {
+            ring->tid = (RK_S32)syscall(SYS_gettid);
+            ring->dropped = ring->dropped_done;
+            ring->dead = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&mListLock);
+
+    if (ring) {
+        pthread_setspecific(mKey, ring);
+        return ring;
+    }
+
+    ring = (LogRing *)calloc(1, sizeof(*ring));
+    if (NULL == ring)
+        return NULL;
+
+    ring->buf = (RK_U8 *)malloc(mRingSize);
+    if (NULL == ring->buf) {
+        free(ring);
+        return NULL;
+    }
+
+    ring->size = mRingSize;
+    ring->tid = (RK_S32)syscall(SYS_gettid);
+
+    pthread_mutex_lock(&mListLock);
+    ring->next = mRings;
+    MPP_SYNC();
+    mRings = ring;
+    pthread_mutex_unlock(&mListLock);
+
+    pthread_setspecific(mKey, ring);
+
+    return ring;
+}
+
+RK_S32 MppLogAsyncService::write(int level, const char *tag, const char *fmt,
+                                 const char *func, va_list args)
+{
+    RK_U8 rec[LOG_REC_MAX];
+    LogRing *ring;
+    RK_U32 size;
+    RK_U32 head;
+
+    if (mMode == MPP_LOG_MODE_SYNC || !mRunning)
+        return MPP_NOK;
+
+    ring = get_ring();
+    if (NULL == ring)
+        return MPP_NOK;
+
+    size = log_rec_encode(rec, sizeof(rec), level, ring->tid, mpp_time(),
+                          tag, fmt, func, args, log_is_static);
+    if (!size)
+        return MPP_NOK;
+
+    head = ring->head;
+    if (size > ring->size - (head - ring->tail)) {
+        ring->dropped++;
+        return MPP_OK;
+    }
+
+    log_ring_write(ring, head, rec, size);
+    MPP_SYNC();
+    ring->head = head + size;
+
+    return MPP_OK;
+}
+
+void MppLogAsyncService::wbuf_flush()
+{
+    RK_U8 *p = mWbuf;
+
+    while (mWbufPos) {
+        ssize_t len = ::write(mFd, p, mWbufPos);
+
+        if (len <= 0)
+            break;
+
+        p += len;
+        mWbufPos -= len;
+    }
+    mWbufPos = 0;
+}
+
+void MppLogAsyncService::wbuf_write(const void *data, RK_U32 size)
+{
+    if (mWbufPos + size > sizeof(mWbuf))
+        wbuf_flush();
+
+    memcpy(mWbuf + mWbufPos, data, size);
+    mWbufPos += size;
+}
+
+/*
+ * Write string definition for tag / fmt / func pointers of the record.
+ * fd < 0 writes to the drain buffer once per pointer, otherwise every
+ * pointer is written to fd directly from crash handler.
+ */
+void MppLogAsyncService::write_refs(const RK_U8 *rec, int fd)
+{
+    const RK_U8 *end = rec + ((const LogRecHdr *)rec)->size;
+    const RK_U8 *p = rec + sizeof(LogRecHdr);
+    RK_S32 i;
+
+    for (i = 0; i < 3; i++) {
+        const char *str = NULL;
+        RK_U64 ptr;
+        LogChunk chunk;
+
+        if (NULL == log_get_u64(p, end, &ptr))
+            return;
+
+        p = log_get_str(p, end, log_resolve_direct, NULL, &str);
+        if (NULL == p)
+            return;
+
+        if (!ptr || (ptr & LOG_STR_INLINE))
+            continue;
+
+        chunk.type = LOG_CHUNK_STR;
+        chunk.size = sizeof(ptr) + strlen(str) + 1;
+
+        if (fd >= 0) {
+            if (::write(fd, &chunk, sizeof(chunk)) < 0 ||
+                ::write(fd, &ptr, sizeof(ptr)) < 0 ||
+                ::write(fd, str, chunk.size - sizeof(ptr)) < 0)
+                return;
+            continue;
+        }
+
+        if (log_tab_find(&mSeen, ptr) >= 0 || chunk.size > LOG_WBUF_SIZE / 2)
+            continue;
+
+        log_tab_add(&mSeen, ptr, NULL);
+        wbuf_write(&chunk, sizeof(chunk));
+        wbuf_write(&ptr, sizeof(ptr));
+        wbuf_write(str, chunk.size - sizeof(ptr));
+    }
+}
+
+void MppLogAsyncService::output(const RK_U8 *rec)
+{
+    static os_log_callback log_func[] = {
+        os_log_info,    /* MPP_LOG_UNKNOWN */
+        os_log_fatal,   /* MPP_LOG_FATAL   */
+        os_log_error,   /* MPP_LOG_ERROR   */
+        os_log_warn,    /* MPP_LOG_WARN    */
+        os_log_info,    /* MPP_LOG_INFO    */
+        os_log_debug,   /* MPP_LOG_DEBUG   */
+        os_log_trace,   /* MPP_LOG_VERBOSE */
+        os_log_info,    /* MPP_LOG_SILENT  */
+    };
+    const LogRecHdr *hdr = (const LogRecHdr *)rec;
+
+    if (mFd >= 0) {
+        LogChunk chunk;
+
+        write_refs(rec, -1);
+
+        chunk.type = LOG_CHUNK_REC;
+        chunk.size = hdr->size;
+        wbuf_write(&chunk, sizeof(chunk));
+        wbuf_write(rec, hdr->size);
+    } else {
+        LogRecInfo info;
+
+        if (log_rec_format(rec, log_resolve_direct, NULL, &info, mMsg, sizeof(mMsg)))
+            return;
+
+        log_print(log_func[MPP_MIN(hdr->level, MPP_ARRAY_ELEMS(log_func) - 1)],
+                  info.tag, "%s", mMsg);
+    }
+}
+
+void MppLogAsyncService::flush()
+{
+    LogRing *ring;
+
+    if (!mThreadValid && !mRings)
+        return;
+
+    pthread_mutex_lock(&mListLock);
+
+    for (ring = mRings; ring; ring = ring->next) {
+        ring->snap = ring->head;
+
+        if (ring->dropped != ring->dropped_done) {
+            RK_U32 dropped = ring->dropped;
+
+            log_rec_make(mRec, MPP_LOG_WARN, ring->tid,
+                         "dropped %u messages on thread %d\n",
+                         dropped - ring->dropped_done, ring->tid);
+            output(mRec);
+            ring->dropped_done = dropped;
+        }
+    }
+    MPP_SYNC();
+
+    /* merge all threads in time order */
+    while (1) {
+        LogRing *sel = NULL;
+        LogRecHdr sel_hdr;
+        LogRecHdr hdr;
+
+        for (ring = mRings; ring; ring = ring->next) {
+            if (ring->tail == ring->snap)
+                continue;
+
+            log_ring_read(ring, ring->tail, &hdr, sizeof(hdr));
+            if (hdr.size < sizeof(hdr) || hdr.size > LOG_REC_MAX ||
+                hdr.size > ring->snap - ring->tail) {
+                /* should never happen, drop the broken ring content */
+                ring->tail = ring->snap;
+                continue;
+            }
+
+            if (NULL == sel || hdr.time < sel_hdr.time) {
+                sel = ring;
+                sel_hdr = hdr;
+            }
+        }
+
+        if (NULL == sel)
+            break;
+
+        log_ring_read(sel, sel->tail, mRec, sel_hdr.size);
+        output(mRec);
+        MPP_SYNC();
+        sel->tail += sel_hdr.size;
+    }
+
+    if (mFd >= 0)
+        wbuf_flush();
+
+    pthread_mutex_unlock(&mListLock);
+}
+
+void *MppLogAsyncService::drain_loop(void *ctx)
+{
+    MppLogAsyncService *srv = (MppLogAsyncService *)ctx;
+
+    pthread_mutex_lock(&srv->mCondLock);
+    while (srv->mRunning) {
+        struct timespec ts;
+
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += LOG_DRAIN_PERIOD_US * 1000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&srv->mCond, &srv->mCondLock, &ts);
+        pthread_mutex_unlock(&srv->mCondLock);
+
+        srv->flush();
+
+        pthread_mutex_lock(&srv->mCondLock);
+    }
+    pthread_mutex_unlock(&srv->mCondLock);
+
+    return NULL;
+}
+
+/* only async-signal-safe calls from here */
+void MppLogAsyncService::crash_dump()
+{
+    static const char note[] = "mpp_log_async: crash, pending log dumped\n";
+    LogBinHdr hdr;
+    LogRing *ring;
+    int fd;
+
+    fd = open(mCrashPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return;
+
+    memcpy(hdr.magic, LOG_BIN_MAGIC, sizeof(hdr.magic));
+    hdr.version = LOG_BIN_VERSION;
+    hdr.ptr_size = sizeof(void *);
+    if (::write(fd, &hdr, sizeof(hdr)) < 0)
+        goto DONE;
+
+    for (ring = mRings; ring; ring = ring->next) {
+        RK_U32 pos = ring->tail;
+        RK_U32 head = ring->head;
+
+        while (pos != head) {
+            LogRecHdr *rec = (LogRecHdr *)mCrashRec;
+            LogChunk chunk;
+
+            log_ring_read(ring, pos, rec, sizeof(*rec));
+            if (rec->size < sizeof(*rec) || rec->size > LOG_REC_MAX ||
+                rec->size > head - pos)
+                break;
+
+            log_ring_read(ring, pos, mCrashRec, rec->size);
+            write_refs(mCrashRec, fd);
+
+            chunk.type = LOG_CHUNK_REC;
+            chunk.size = rec->size;
+            if (::write(fd, &chunk, sizeof(chunk)) < 0 ||
+                ::write(fd, mCrashRec, rec->size) < 0)
+                goto DONE;
+
+            pos += rec->size;
+        }
+    }
+
+    if (::write(STDERR_FILENO, note, sizeof(note) - 1) < 0)
+        goto DONE;
+
+DONE:
+    close(fd);
+}
+
+void MppLogAsyncService::crash_handler(int sig, siginfo_t *info, void *uctx)
+{
+    MppLogAsyncService *inst = mCrashInst;
+    struct sigaction dfl;
+    RK_U32 i;
+
+    /* only the first crashing thread dumps */
+    if (inst && MPP_BOOL_CAS(&mCrashInst, inst, NULL))
+        inst->crash_dump();
+
+    /* chain to the handler installed before */
+    for (i = 0; i < MPP_ARRAY_ELEMS(log_crash_sigs); i++) {
+        struct sigaction *old = &log_crash_old[i];
+
+        if (log_crash_sigs[i] != sig)
+            continue;
+
+        if (old->sa_flags & SA_SIGINFO) {
+            old->sa_sigaction(sig, info, uctx);
+            return;
+        }
+
+        if (old->sa_handler == SIG_IGN)
+            return;
+
+        if (old->sa_handler != SIG_DFL) {
+            old->sa_handler(sig);
+            return;
+        }
+        break;
+    }
+
+    /* default action is taken when the handler returns */
+    memset(&dfl, 0, sizeof(dfl));
+    dfl.sa_handler = SIG_DFL;
+    sigemptyset(&dfl.sa_mask);
+    sigaction(sig, &dfl, NULL);
+    raise(sig);
+}
+
+RK_S32 mpp_log_async_mode(void)
+{
+    return MppLogAsyncService::get_inst()->get_mode();
+}
+
+RK_S32 mpp_log_async_write(int level, const char *tag, const char *fmt,
+                           const char *func, va_list args)
+{
+    return MppLogAsyncService::get_inst()->write(level, tag, fmt, func, args);
+}
+
+void mpp_log_async_flush(void)
+{
+    MppLogAsyncService::get_inst()->flush();
+}
+
+#else
+
+RK_S32 mpp_log_async_mode(void)
+{
+    return MPP_LOG_MODE_SYNC;
+}
+
+RK_S32 mpp_log_async_write(int level, const char *tag, const char *fmt,
+                           const char *func, va_list args)
+{
+    (void)level;
+    (void)tag;
+    (void)fmt;
+    (void)func;
+    (void)args;
+
+    return MPP_NOK;
+}
+
+void mpp_log_async_flush(void)
+{
+}
+
+#endif
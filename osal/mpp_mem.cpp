@@ -21,6 +21,8 @@
 #include "mpp_env.h"
 #include "mpp_mem.h"
 #include "mpp_list.h"
+#include "mpp_lock.h"
+#include "mpp_time.h"
 #include "mpp_debug.h"
 #include "mpp_common.h"
 
@@ -33,25 +35,34 @@
 #define MEM_NODE_LOG            (0x00000004)
 #define MEM_EXT_ROOM            (0x00000010)
 #define MEM_POISON              (0x00000020)
+// NOTE: internal flag, sampled mode keeps a tracked mark in head room
+#define MEM_SAMPLE_ROOM         (0x00000100)
 
 // default memory align size is set to 32
 #define MEM_MAX_INDEX           (0x7fffffff)
 #define MEM_ALIGN               32
 #define MEM_ALIGN_MASK          (MEM_ALIGN - 1)
 #define MEM_ALIGNED(x)          (((x) + MEM_ALIGN) & (~MEM_ALIGN_MASK))
-#define MEM_HEAD_ROOM(debug)    ((debug & MEM_EXT_ROOM) ? (MEM_ALIGN) : (0))
+#define MEM_HEAD_ROOM(debug)    ((debug & (MEM_EXT_ROOM | MEM_SAMPLE_ROOM)) ? (MEM_ALIGN) : (0))
+#define MEM_TAIL_ROOM(debug)    ((debug & MEM_EXT_ROOM) ? (MEM_ALIGN) : (0))
 #define MEM_NODE_MAX            (1024)
 #define MEM_FREE_MAX            (512)
 #define MEM_LOG_MAX             (1024)
 #define MEM_CHECK_MARK          (0xdd)
 #define MEM_HEAD_MASK           (0xab)
 #define MEM_TAIL_MASK           (0xcd)
+/* first head room byte of a sampled block, untracked ones keep MEM_HEAD_MASK */
+#define MEM_SAMPLE_MARK         (0x5a)
+#define MEM_CALLER_MAX          (1024)
+#define MEM_REPORT_TOP          (16)
+/* check report period once every these tracked operations */
+#define MEM_REPORT_CHECK        (256)
 
 #define MPP_MEM_ASSERT(cond) \
     do { \
         if (!(cond)) { \
             mpp_err("found mpp_mem assert failed, start dumping:\n"); \
-            service.dump(__FUNCTION__); \
+            dump(__FUNCTION__); \
             mpp_assert(cond); \
         } \
     } while (0)
@@ -93,6 +104,15 @@ typedef struct MppMemLog_s {
 class MppMemService
 {
 public:
+    /*
+     * NOTE: other static constructors may allocate before this file is
+     * initialized so the service is created on first use.
+     */
+    static MppMemService *getInstance() {
+        static MppMemService mem_service;
+        return &mem_service;
+    }
+
     // avoid any unwanted function
     MppMemService();
     ~MppMemService();
@@ -107,6 +127,9 @@ public:
     /*
      */
     void    del_node(const char *caller, void *ptr, size_t *size);
+    /* node is always found in full tracking, maybe not in sampled mode */
+    RK_S32  has_node(void *ptr) { return hash_find(ptr) >= 0; }
+    RK_S32  is_sampled(void);
     void*   delay_del_node(const char *caller, void *ptr, size_t *size);
     void    reset_node(const char *caller, void *ptr, void *ret, size_t size);
 
@@ -121,8 +144,16 @@ public:
     RK_U32  total_now(void) { return m_total_size; }
     RK_U32  total_max(void) { return m_total_max; }
 
+    /* per caller statistic and periodic report */
+    RK_S32  get_stats(MppMemStat **stats);
+    void    set_report(MppMemReport report, void *ctx, RK_U32 period);
+    void    report(void);
+    RK_S32  report_due(void) { return MPP_BOOL_CAS(&report_flag, 1, 0); }
+
     Mutex       lock;
     RK_U32      debug;
+    /* track 1 in sample allocations */
+    RK_U32      sample;
 
 private:
     // data for node record and delay free check
@@ -146,11 +177,40 @@ private:
     RK_U32      m_total_size;
     RK_U32      m_total_max;
 
+    // pointer to node index hash with linear probing, -1 for empty
+    RK_S32      *hash;
+    RK_U32      hash_mask;
+    // stack of unused node index
+    RK_S32      *slots;
+    RK_S32      slots_cnt;
+
+    // caller statistic hash, the last entry collects overflow callers
+    MppMemStat  *callers;
+    RK_S32      callers_cnt;
+
+    volatile RK_U32 sample_cnt;
+    RK_U32      untracked;
+
+    MppMemReport report_cb;
+    void        *report_ctx;
+    RK_U32      report_period;
+    RK_U32      report_ops;
+    RK_S64      report_last;
+    volatile RK_U32 report_flag;
+
+    RK_U32  hash_pos(void *ptr) {
+        return (RK_U32)(((size_t)ptr >> 4) * 0x9E3779B1u) & hash_mask;
+    }
+    RK_S32  hash_find(void *ptr);
+    void    hash_add(void *ptr, RK_S32 idx);
+    void    hash_del(void *ptr);
+    void    stat_update(const char *caller, RK_S32 count, RK_S64 size);
+    void    report_check(void);
+
     MppMemService(const MppMemService &);
     MppMemService &operator=(const MppMemService &);
 };
 
-static MppMemService service;
 
 static const char *ops2str[MEM_OPS_BUTT] = {
     "malloc",
@@ -193,6 +253,23 @@ static void set_mem_ext_room(void *p, size_t size)
     memset((RK_U8 *)p + size,      MEM_TAIL_MASK, MEM_ALIGN);
 }
 
+static void set_mem_sample_mark(void *p, RK_S32 tracked)
+{
+    ((RK_U8 *)p)[-MEM_ALIGN] = tracked ? MEM_SAMPLE_MARK : MEM_HEAD_MASK;
+}
+
+/* check whether a block may have a node without taking the service lock */
+static RK_S32 mem_tracked(RK_U32 debug, void *p)
+{
+    if (!(debug & MEM_DEBUG_EN))
+        return 0;
+
+    if (debug & MEM_SAMPLE_ROOM)
+        return ((RK_U8 *)p)[-MEM_ALIGN] == MEM_SAMPLE_MARK;
+
+    return 1;
+}
+
 MppMemService::MppMemService()
     : debug(0),
       nodes_max(MEM_NODE_MAX),
@@ -209,21 +286,69 @@ MppMemService::MppMemService()
       log_cnt(0),
       logs(NULL),
       m_total_size(0),
-      m_total_max(0)
+      m_total_max(0),
+      hash(NULL),
+      hash_mask(0),
+      slots(NULL),
+      slots_cnt(0),
+      callers(NULL),
+      callers_cnt(0),
+      sample_cnt(0),
+      untracked(0),
+      report_cb(NULL),
+      report_ctx(NULL),
+      report_period(0),
+      report_ops(0),
+      report_last(0),
+      report_flag(0)
 {
     mpp_env_get_u32("mpp_mem_debug", &debug, 0);
+    /* env mpp_mem_sample / mpp_mem_report alone enables tracking */
+    mpp_env_get_u32("mpp_mem_sample", &sample, 1);
+    mpp_env_get_u32("mpp_mem_report", &report_period, 0);
+
+    if (!sample)
+        sample = 1;
 
     // add more flag if debug enabled
-    if (debug)
+    if (debug || sample > 1 || report_period)
         debug |= MEM_DEBUG_EN;
 
+    if (sample > 1)
+        debug |= MEM_SAMPLE_ROOM;
+
     if (debug & MEM_DEBUG_EN) {
+        RK_U32 hash_size = 1;
+        RK_S32 i;
+
         mpp_env_get_u32("mpp_mem_node_max", (RK_U32 *)&nodes_max, MEM_NODE_MAX);
 
-        mpp_log_f("mpp_mem_debug enabled %x max node %d\n",
-                  debug, nodes_max);
+        mpp_log_f("mpp_mem_debug enabled %x max node %d sample %d report %d ms\n",
+                  debug, nodes_max, sample, report_period);
+
+        while (hash_size < (RK_U32)nodes_max * 2)
+            hash_size <<= 1;
+        hash_mask = hash_size - 1;
+
+        size_t size = hash_size * sizeof(RK_S32);
+        os_malloc((void **)&hash, MEM_ALIGN, size);
+        mpp_assert(hash);
+        memset(hash, 0xff, size);
 
-        size_t size = nodes_max * sizeof(MppMemNode);
+        size = nodes_max * sizeof(RK_S32);
+        os_malloc((void **)&slots, MEM_ALIGN, size);
+        mpp_assert(slots);
+        for (i = nodes_max - 1; i >= 0; i--)
+            slots[slots_cnt++] = i;
+
+        size = MEM_CALLER_MAX * sizeof(MppMemStat);
+        os_malloc((void **)&callers, MEM_ALIGN, size);
+        mpp_assert(callers);
+        memset(callers, 0, size);
+
+        report_last = mpp_time();
+
+        size = nodes_max * sizeof(MppMemNode);
         os_malloc((void **)&nodes, MEM_ALIGN, size);
         mpp_assert(nodes);
         memset(nodes, 0xff, size);
@@ -295,7 +420,210 @@ MppMemService::~MppMemService()
         os_free(nodes);
         os_free(frees);
         os_free(logs);
+        os_free(hash);
+        os_free(slots);
+        os_free(callers);
+
+        // NOTE: buffers freed by later static destructors skip tracking
+        debug &= MEM_EXT_ROOM | MEM_SAMPLE_ROOM;
+    }
+}
+
+RK_S32 MppMemService::hash_find(void *ptr)
+{
+    RK_U32 pos = hash_pos(ptr);
+
+    while (hash[pos] >= 0) {
+        if (nodes[hash[pos]].ptr == ptr)
+            return hash[pos];
+
+        pos = (pos + 1) & hash_mask;
+    }
+
+    return -1;
+}
+
+void MppMemService::hash_add(void *ptr, RK_S32 idx)
+{
+    RK_U32 pos = hash_pos(ptr);
+
+    while (hash[pos] >= 0)
+        pos = (pos + 1) & hash_mask;
+
+    hash[pos] = idx;
+}
+
+/* backward shift deletion keeps probe chains without tombstone */
+void MppMemService::hash_del(void *ptr)
+{
+    RK_U32 pos = hash_pos(ptr);
+    RK_U32 next;
+
+    while (hash[pos] >= 0 && nodes[hash[pos]].ptr != ptr)
+        pos = (pos + 1) & hash_mask;
+
+    if (hash[pos] < 0)
+        return;
+
+    next = pos;
+    while (1) {
+        RK_U32 home;
+
+        next = (next + 1) & hash_mask;
+        if (hash[next] < 0)
+            break;
+
+        /* move the entry back when its home is not in (pos, next] */
+        home = hash_pos(nodes[hash[next]].ptr);
+        if (((next - home) & hash_mask) >= ((next - pos) & hash_mask)) {
+            hash[pos] = hash[next];
+            pos = next;
+        }
     }
+
+    hash[pos] = -1;
+}
+
+void MppMemService::stat_update(const char *caller, RK_S32 count, RK_S64 size)
+{
+    RK_U32 pos = (RK_U32)(((size_t)caller >> 2) * 0x9E3779B1u) % (MEM_CALLER_MAX - 1);
+    MppMemStat *stat = NULL;
+
+    /* only fill 3/4 of the table to keep the probe short */
+    while (callers[pos].caller) {
+        if (callers[pos].caller == caller) {
+            stat = &callers[pos];
+            break;
+        }
+        pos = (pos + 1) % (MEM_CALLER_MAX - 1);
+    }
+
+    if (NULL == stat) {
+        if (callers_cnt < MEM_CALLER_MAX * 3 / 4) {
+            stat = &callers[pos];
+            stat->caller = caller;
+            callers_cnt++;
+        } else {
+            stat = &callers[MEM_CALLER_MAX - 1];
+            stat->caller = "others";
+        }
+    }
+
+    stat->count += count;
+    stat->size += size;
+    if (count > 0)
+        stat->total++;
+    if (stat->size > stat->size_max)
+        stat->size_max = stat->size;
+}
+
+RK_S32 MppMemService::is_sampled(void)
+{
+    if (sample <= 1)
+        return 1;
+
+    return !(MPP_FETCH_ADD(&sample_cnt, 1) % sample);
+}
+
+void MppMemService::report_check(void)
+{
+    RK_S64 now;
+
+    if (!report_period || (++report_ops % MEM_REPORT_CHECK))
+        return;
+
+    now = mpp_time();
+    if (now - report_last < (RK_S64)report_period * 1000)
+        return;
+
+    report_last = now;
+    report_flag = 1;
+}
+
+static int mem_stat_cmp(const void *a, const void *b)
+{
+    const MppMemStat *sa = (const MppMemStat *)a;
+    const MppMemStat *sb = (const MppMemStat *)b;
+
+    if (sa->size != sb->size)
+        return (sa->size < sb->size) ? 1 : -1;
+
+    return (sa->count < sb->count) ? 1 : (sa->count > sb->count) ? -1 : 0;
+}
+
+/* copy caller statistic sorted by live size, caller frees stats by os_free */
+RK_S32 MppMemService::get_stats(MppMemStat **stats)
+{
+    MppMemStat *tmp = NULL;
+    RK_S32 cnt = 0;
+    RK_S32 i;
+
+    *stats = NULL;
+    if (!(debug & MEM_DEBUG_EN))
+        return 0;
+
+    os_malloc((void **)&tmp, MEM_ALIGN, MEM_CALLER_MAX * sizeof(MppMemStat));
+    if (NULL == tmp)
+        return 0;
+
+    for (i = 0; i < MEM_CALLER_MAX; i++) {
+        if (callers[i].caller)
+            tmp[cnt++] = callers[i];
+    }
+
+    qsort(tmp, cnt, sizeof(*tmp), mem_stat_cmp);
+    *stats = tmp;
+
+    return cnt;
+}
+
+void MppMemService::set_report(MppMemReport cb, void *ctx, RK_U32 period)
+{
+    report_cb = cb;
+    report_ctx = ctx;
+    report_period = period;
+    report_ops = 0;
+    report_last = mpp_time();
+}
+
+/* called without lock */
+void MppMemService::report(void)
+{
+    MppMemReport cb;
+    MppMemStat *stats = NULL;
+    void *ctx;
+    RK_U32 now;
+    RK_U32 max;
+    RK_U32 lost;
+    RK_S32 cnt;
+    RK_S32 i;
+
+    {
+        AutoMutex auto_lock(&lock);
+
+        cnt = get_stats(&stats);
+        cb = report_cb;
+        ctx = report_ctx;
+        now = m_total_size;
+        max = m_total_max;
+        lost = untracked;
+    }
+
+    if (NULL == stats)
+        return;
+
+    if (cb) {
+        cb(ctx, stats, cnt, sample);
+    } else {
+        mpp_log("mpp_mem report: total %u max %u sample 1/%u untracked %u callers %d\n",
+                now, max, sample, lost, cnt);
+        for (i = 0; i < cnt && i < MEM_REPORT_TOP; i++)
+            mpp_log("mpp_mem report: %-32s count %6u size %10u max %10u alloc %u\n",
+                    stats[i].caller, stats[i].count, stats[i].size,
+                    stats[i].size_max, stats[i].total);
+    }
+
+    os_free(stats);
 }
 
 void MppMemService::add_node(const char *caller, void *ptr, size_t size)
@@ -306,6 +634,12 @@ void MppMemService::add_node(const char *caller, void *ptr, size_t size)
         mpp_log("mem cnt: %5d total %8d inc size %8d at %s\n",
                 nodes_cnt, m_total_size, size, caller);
 
+    if (nodes_cnt >= nodes_max && sample > 1) {
+        /* sampled tracking is best effort, never abort */
+        untracked++;
+        return;
+    }
+
     if (nodes_cnt >= nodes_max) {
         mpp_err("******************************************************\n");
         mpp_err("* Reach max limit of mpp_mem counter %5d           *\n", nodes_max);
@@ -315,39 +649,39 @@ void MppMemService::add_node(const char *caller, void *ptr, size_t size)
         mpp_abort();
     }
 
-    MppMemNode *node = nodes;
-    for (i = 0; i < nodes_max; i++, node++) {
-        if (node->index < 0) {
-            node->index = nodes_idx++;
-            node->size  = size;
-            node->ptr   = ptr;
-            node->caller = caller;
-
-            // NOTE: reset node index on revert
-            if (nodes_idx < 0)
-                nodes_idx = 0;
-
-            nodes_cnt++;
-            m_total_size += size;
-            if (m_total_size > m_total_max)
-                m_total_max = m_total_size;
-            break;
-        }
-    }
+    i = slots[--slots_cnt];
+    MppMemNode *node = &nodes[i];
+
+    mpp_assert(node->index < 0);
+    node->index = nodes_idx++;
+    node->size  = size;
+    node->ptr   = ptr;
+    node->caller = caller;
+
+    // NOTE: reset node index on revert
+    if (nodes_idx < 0)
+        nodes_idx = 0;
+
+    hash_add(ptr, i);
+    stat_update(caller, 1, size);
+    report_check();
+
+    nodes_cnt++;
+    m_total_size += size;
+    if (m_total_size > m_total_max)
+        m_total_max = m_total_size;
 }
 
 RK_S32 MppMemService::find_node(const char *caller, void *ptr, size_t *size, RK_S32 *idx)
 {
     RK_S32 i = 0;
-    MppMemNode *node = nodes;
 
     MPP_MEM_ASSERT(nodes_cnt <= nodes_max);
-    for (i = 0; i < nodes_max; i++, node++) {
-        if (node->index >= 0 && node->ptr == ptr) {
-            *size = node->size;
-            *idx  = i;
-            return 1;
-        }
+    i = hash_find(ptr);
+    if (i >= 0) {
+        *size = nodes[i].size;
+        *idx  = i;
+        return 1;
     }
 
     mpp_err("%s can NOT found node with ptr %p\n", caller, ptr);
@@ -358,22 +692,26 @@ RK_S32 MppMemService::find_node(const char *caller, void *ptr, size_t *size, RK_
 void MppMemService::del_node(const char *caller, void *ptr, size_t *size)
 {
     RK_S32 i = 0;
-    MppMemNode *node = nodes;
+    MppMemNode *node;
 
     MPP_MEM_ASSERT(nodes_cnt <= nodes_max);
 
-    for (i = 0; i < nodes_max; i++, node++) {
-        if (node->index >= 0 && node->ptr == ptr) {
-            *size = node->size;
-            node->index = ~node->index;
-            nodes_cnt--;
-            m_total_size -= node->size;
-
-            if (debug & MEM_NODE_LOG)
-                mpp_log("mem cnt: %5d total %8d dec size %8d at %s\n",
-                        nodes_cnt, m_total_size, node->size, caller);
-            return ;
-        }
+    i = hash_find(ptr);
+    if (i >= 0) {
+        node = &nodes[i];
+        *size = node->size;
+        hash_del(ptr);
+        stat_update(node->caller, -1, -(RK_S64)node->size);
+        report_check();
+        node->index = ~node->index;
+        slots[slots_cnt++] = i;
+        nodes_cnt--;
+        m_total_size -= node->size;
+
+        if (debug & MEM_NODE_LOG)
+            mpp_log("mem cnt: %5d total %8d dec size %8d at %s\n",
+                    nodes_cnt, m_total_size, node->size, caller);
+        return ;
     }
 
     mpp_err("%s fail to find node with ptr %p\n", caller, ptr);
@@ -384,7 +722,8 @@ void MppMemService::del_node(const char *caller, void *ptr, size_t *size)
 void *MppMemService::delay_del_node(const char *caller, void *ptr, size_t *size)
 {
     RK_S32 i = 0;
-    MppMemNode *node = nodes;
+    RK_S32 node_idx;
+    MppMemNode *node;
 
     // clear output first
     void *ret = NULL;
@@ -392,14 +731,10 @@ void *MppMemService::delay_del_node(const char *caller, void *ptr, size_t *size)
 
     // find the node to save
     MPP_MEM_ASSERT(nodes_cnt <= nodes_max);
-    for (i = 0; i < nodes_max; i++, node++) {
-        if (node->index >= 0 && node->ptr == ptr) {
-            chk_node(caller, node);
-            break;
-        }
-    }
-
-    MPP_MEM_ASSERT(i < nodes_max);
+    node_idx = hash_find(ptr);
+    MPP_MEM_ASSERT(node_idx >= 0);
+    node = &nodes[node_idx];
+    chk_node(caller, node);
     if (debug & MEM_NODE_LOG)
         mpp_log("mem cnt: %5d total %8d dec size %8d at %s\n",
                 nodes_cnt, m_total_size, node->size, caller);
@@ -450,12 +785,15 @@ void *MppMemService::delay_del_node(const char *caller, void *ptr, size_t *size)
 
     MPP_MEM_ASSERT(frees_cnt <= frees_max);
 
-    memcpy(&frees[frees_idx], node, sizeof(*node));
+    memcpy(free_node, node, sizeof(*node));
 
     if ((debug & MEM_POISON) && (node->size < 1024))
         memset(node->ptr, MEM_CHECK_MARK, node->size);
 
+    hash_del(ptr);
+    stat_update(node->caller, -1, -(RK_S64)node->size);
     node->index = ~node->index;
+    slots[slots_cnt++] = node_idx;
     m_total_size -= node->size;
     nodes_cnt--;
 
@@ -475,10 +813,11 @@ void MppMemService::chk_mem(const char *caller, void *ptr, size_t size)
     if ((debug & MEM_EXT_ROOM) == 0)
         return ;
 
-    RK_S32 i = 0;
+    // NOTE: skip the tracked mark in sampled mode
+    RK_S32 i = (debug & MEM_SAMPLE_ROOM) ? 1 : 0;
     RK_U8 *p = (RK_U8 *)ptr - MEM_ALIGN;
 
-    for (i = 0; i < MEM_ALIGN; i++) {
+    for (; i < MEM_ALIGN; i++) {
         if (p[i] != MEM_HEAD_MASK) {
             mpp_err("%s checking ptr %p head room found error!\n", caller, ptr);
             dump(caller);
@@ -542,19 +881,25 @@ void MppMemService::reset_node(const char *caller, void *ptr, void *ret, size_t
 
     MPP_MEM_ASSERT(nodes_cnt <= nodes_max);
 
-    for (i = 0; i < nodes_max; i++, node++) {
-        if (node->index >= 0 && node->ptr == ptr) {
-            m_total_size += size;
-            m_total_size -= node->size;
-
-            node->ptr   = ret;
-            node->size  = size;
-            node->caller = caller;
-
-            if (debug & MEM_EXT_ROOM)
-                set_mem_ext_room(ret, size);
-            break;
-        }
+    i = hash_find(ptr);
+    if (i >= 0) {
+        node = &nodes[i];
+        m_total_size += size;
+        m_total_size -= node->size;
+
+        hash_del(ptr);
+        stat_update(node->caller, -1, -(RK_S64)node->size);
+        stat_update(caller, 1, size);
+
+        node->ptr   = ret;
+        node->size  = size;
+        node->caller = caller;
+        hash_add(ret, i);
+
+        if (debug & MEM_EXT_ROOM)
+            set_mem_ext_room(ret, size);
+        if (debug & MEM_SAMPLE_ROOM)
+            set_mem_sample_mark(ret, 1);
     }
 }
 
@@ -563,7 +908,7 @@ void MppMemService::add_log(MppMemOps ops, const char *caller,
 {
     MppMemLog *log = &logs[log_idx];
 
-    if (service.debug & MEM_RUNTIME_LOG)
+    if (debug & MEM_RUNTIME_LOG)
         mpp_log("%-7s ptr %010p %010p size %8u %8u at %s\n",
                 ops2str[ops], ptr, ret, size_0, size_1, caller);
 
@@ -639,26 +984,41 @@ void MppMemService::dump(const char *caller)
 
 void *mpp_osal_malloc(const char *caller, size_t size)
 {
-    RK_U32 debug = service.debug;
+    MppMemService *srv = MppMemService::getInstance();
+    RK_U32 debug = srv->debug;
     size_t size_align = MEM_ALIGNED(size);
-    size_t size_real = (debug & MEM_EXT_ROOM) ? (size_align + 2 * MEM_ALIGN) :
-                       (size_align);
+    size_t size_real = size_align + MEM_HEAD_ROOM(debug) + MEM_TAIL_ROOM(debug);
     void *ptr;
 
     os_malloc(&ptr, MEM_ALIGN, size_real);
 
     if (debug) {
-        AutoMutex auto_lock(&service.lock);
-        service.add_log(MEM_MALLOC, caller, NULL, ptr, size, size_real);
+        void *ptr_real = ptr;
+        RK_S32 sampled = (debug & MEM_DEBUG_EN) && srv->is_sampled();
+        RK_S32 report = 0;
 
-        if (ptr) {
-            if (debug & MEM_EXT_ROOM) {
-                ptr = (RK_U8 *)ptr + MEM_ALIGN;
-                set_mem_ext_room(ptr, size);
-            }
+        if (ptr && MEM_HEAD_ROOM(debug))
+            ptr = (RK_U8 *)ptr + MEM_ALIGN;
+
+        if (ptr && (debug & MEM_EXT_ROOM))
+            set_mem_ext_room(ptr, size);
+
+        if (ptr && (debug & MEM_SAMPLE_ROOM))
+            set_mem_sample_mark(ptr, sampled);
+
+        // NOTE: unsampled allocation does not touch the lock
+        if (sampled) {
+            AutoMutex auto_lock(&srv->lock);
+            srv->add_log(MEM_MALLOC, caller, NULL, ptr_real, size, size_real);
 
-            service.add_node(caller, ptr, size);
+            if (ptr)
+                srv->add_node(caller, ptr, size);
+
+            report = srv->report_due();
         }
+
+        if (report)
+            srv->report();
     }
 
     return ptr;
@@ -674,7 +1034,8 @@ void *mpp_osal_calloc(const char *caller, size_t size)
 
 void *mpp_osal_realloc(const char *caller, void *ptr, size_t size)
 {
-    RK_U32 debug = service.debug;
+    MppMemService *srv = MppMemService::getInstance();
+    RK_U32 debug = srv->debug;
     void *ret;
 
     if (NULL == ptr)
@@ -686,27 +1047,38 @@ void *mpp_osal_realloc(const char *caller, void *ptr, size_t size)
     }
 
     size_t size_align = MEM_ALIGNED(size);
-    size_t size_real = (debug & MEM_EXT_ROOM) ? (size_align + 2 * MEM_ALIGN) :
-                       (size_align);
+    size_t size_real = size_align + MEM_HEAD_ROOM(debug) + MEM_TAIL_ROOM(debug);
     void *ptr_real = (RK_U8 *)ptr - MEM_HEAD_ROOM(debug);
+    RK_S32 tracked = mem_tracked(debug, ptr);
 
-    os_realloc(ptr_real, &ret, MEM_ALIGN, size_align);
+    os_realloc(ptr_real, &ret, MEM_ALIGN, size_real);
 
     if (NULL == ret) {
         // if realloc fail the original buffer will be kept the same.
         mpp_err("mpp_realloc ptr %p to size %d failed\n", ptr, size);
-    } else {
-        AutoMutex auto_lock(&service.lock);
-
-        // if realloc success reset the node and record
-        if (debug) {
-            void *ret_ptr = (debug & MEM_EXT_ROOM) ?
-                            ((RK_U8 *)ret + MEM_ALIGN) : (ret);
+    } else if (debug) {
+        void *ret_ptr = MEM_HEAD_ROOM(debug) ?
+                        ((RK_U8 *)ret + MEM_ALIGN) : (ret);
+
+        if (tracked) {
+            AutoMutex auto_lock(&srv->lock);
+
+            // if realloc success reset the node and record
+            tracked = srv->has_node(ptr);
+            if (tracked) {
+                srv->reset_node(caller, ptr, ret_ptr, size);
+                srv->add_log(MEM_REALLOC, caller, ptr, ret_ptr, size, size_real);
+            }
+        }
 
-            service.reset_node(caller, ptr, ret_ptr, size);
-            service.add_log(MEM_REALLOC, caller, ptr, ret_ptr, size, size_real);
-            ret = ret_ptr;
+        if (!tracked) {
+            // untracked buffer still has extra room
+            if (debug & MEM_EXT_ROOM)
+                set_mem_ext_room(ret_ptr, size);
+            if (debug & MEM_SAMPLE_ROOM)
+                set_mem_sample_mark(ret_ptr, 0);
         }
+        ret = ret_ptr;
     }
 
     return ret;
@@ -714,7 +1086,8 @@ void *mpp_osal_realloc(const char *caller, void *ptr, size_t size)
 
 void mpp_osal_free(const char *caller, void *ptr)
 {
-    RK_U32 debug = service.debug;
+    MppMemService *srv = MppMemService::getInstance();
+    RK_U32 debug = srv->debug;
     if (NULL == ptr)
         return;
 
@@ -723,42 +1096,80 @@ void mpp_osal_free(const char *caller, void *ptr)
         return ;
     }
 
+    // NOTE: unsampled buffer does not touch the lock
+    if (!mem_tracked(debug, ptr)) {
+        os_free((RK_U8 *)ptr - MEM_HEAD_ROOM(debug));
+        return ;
+    }
+
     size_t size = 0;
+    RK_S32 report = 0;
 
-    AutoMutex auto_lock(&service.lock);
-    if (debug & MEM_POISON) {
-        // NODE: keep this node and  delete delay node
-        void *ret = service.delay_del_node(caller, ptr, &size);
-        if (ret)
-            os_free((RK_U8 *)ret - MEM_ALIGN);
+    {
+        AutoMutex auto_lock(&srv->lock);
 
-        service.add_log(MEM_FREE_DELAY, caller, ptr, ret, size, 0);
-    } else {
-        void *ptr_real = (RK_U8 *)ptr - MEM_HEAD_ROOM(debug);
-        // NODE: delete node and return size here
-        service.del_node(caller, ptr, &size);
-        service.chk_mem(caller, ptr, size);
-        os_free(ptr_real);
-        service.add_log(MEM_FREE, caller, ptr, ptr_real, size, 0);
+        if (srv->sample > 1 && !srv->has_node(ptr)) {
+            // NODE: sampled buffer dropped on full node table
+            os_free((RK_U8 *)ptr - MEM_HEAD_ROOM(debug));
+            return ;
+        }
+
+        if (debug & MEM_POISON) {
+            // NODE: keep this node and  delete delay node
+            void *ret = srv->delay_del_node(caller, ptr, &size);
+            if (ret)
+                os_free((RK_U8 *)ret - MEM_HEAD_ROOM(debug));
+
+            srv->add_log(MEM_FREE_DELAY, caller, ptr, ret, size, 0);
+        } else {
+            void *ptr_real = (RK_U8 *)ptr - MEM_HEAD_ROOM(debug);
+            // NODE: delete node and return size here
+            srv->del_node(caller, ptr, &size);
+            srv->chk_mem(caller, ptr, size);
+            os_free(ptr_real);
+            srv->add_log(MEM_FREE, caller, ptr, ptr_real, size, 0);
+        }
+
+        report = srv->report_due();
     }
+
+    if (report)
+        srv->report();
 }
 
 /* dump memory status */
 void mpp_show_mem_status()
 {
-    AutoMutex auto_lock(&service.lock);
-    if (service.debug & MEM_DEBUG_EN)
-        service.dump(__FUNCTION__);
+    MppMemService *srv = MppMemService::getInstance();
+    AutoMutex auto_lock(&srv->lock);
+    if (srv->debug & MEM_DEBUG_EN)
+        srv->dump(__FUNCTION__);
 }
 
 RK_U32 mpp_mem_total_now()
 {
-    AutoMutex auto_lock(&service.lock);
-    return service.total_now();
+    MppMemService *srv = MppMemService::getInstance();
+    AutoMutex auto_lock(&srv->lock);
+    return srv->total_now();
 }
 
 RK_U32 mpp_mem_total_max()
 {
-    AutoMutex auto_lock(&service.lock);
-    return service.total_max();
+    MppMemService *srv = MppMemService::getInstance();
+    AutoMutex auto_lock(&srv->lock);
+    return srv->total_max();
+}
+
+void mpp_mem_set_report(MppMemReport report, void *ctx, RK_U32 period_ms)
+{
+    MppMemService *srv = MppMemService::getInstance();
+    AutoMutex auto_lock(&srv->lock);
+    srv->set_report(report, ctx, period_ms);
+}
+
+void mpp_mem_report(void)
+{
+    MppMemService *srv = MppMemService::getInstance();
+    if (srv->debug & MEM_DEBUG_EN)
+        srv->report();
 }
@@ -23,6 +23,7 @@
 #include "mpp_common.h"
 #include "mpp_platform.h"
 #include "mpp_service.h"
+#include "mpp_cap_cache.h"
 
 static MppKernelVersion check_kernel_version(void)
 {
@@ -76,6 +77,7 @@ private:
     MppIoctlVersion     ioctl_version;
     MppKernelVersion    kernel_version;
     RK_U32              vcodec_type;
+    RK_U32              flag_2d;
     RK_U32              hw_ids[32];
     MppServiceCmdCap    mpp_service_cmd_cap;
     const MppSocInfo    *soc_info;
@@ -93,17 +95,34 @@ public:
     MppServiceCmdCap    *get_mpp_service_cmd_cap() { return &mpp_service_cmd_cap; };
     RK_U32              get_hw_id(RK_S32 client_type);
     RK_U32              get_vcodec_type(void) { return vcodec_type; };
+    RK_U32              get_2d_hw_flag(void) { return flag_2d; };
 };
 
+static RK_U32 check_2d_hw_flag(void)
+{
+    RK_U32 flag = 0;
+
+    if (!access("/dev/rga", F_OK))
+        flag |= HAVE_RGA;
+
+    if (!access("/dev/iep", F_OK))
+        flag |= HAVE_IEP;
+
+    return flag;
+}
+
 MppPlatformService::MppPlatformService()
     : ioctl_version(IOCTL_MPP_SERVICE_V1),
       kernel_version(KERNEL_UNKNOWN),
       vcodec_type(0),
+      flag_2d(0),
       soc_info(NULL),
       soc_name(NULL)
 {
     /* judge vdpu support version */
     MppServiceCmdCap *cap = &mpp_service_cmd_cap;
+    const MppCapSnapshot *cache = NULL;
+    MppCapSnapshot snapshot;
 
     /* default value */
     cap->support_cmd = 0;
@@ -122,6 +141,18 @@ MppPlatformService::MppPlatformService()
     if (soc_info->soc_type == ROCKCHIP_SOC_AUTO)
         mpp_log("can not found match soc name: %s\n", soc_name);
 
+    cache = mpp_cap_cache_get();
+    if (cache) {
+        ioctl_version = (MppIoctlVersion)cache->ioctl_version;
+        kernel_version = (MppKernelVersion)cache->kernel_version;
+        vcodec_type = cache->vcodec_type;
+        flag_2d = cache->flag_2d;
+        memcpy(hw_ids, cache->hw_ids, sizeof(hw_ids));
+        memcpy(cap, &cache->cmd_cap, sizeof(*cap));
+        return;
+    }
+
+    memset(hw_ids, 0, sizeof(hw_ids));
     ioctl_version = IOCTL_VCODEC_SERVICE;
     if (mpp_get_mpp_service_name()) {
         ioctl_version = IOCTL_MPP_SERVICE_V1;
@@ -130,6 +161,16 @@ MppPlatformService::MppPlatformService()
     kernel_version = check_kernel_version();
     if (!vcodec_type)
         vcodec_type = soc_info->vcodec_type;
+    flag_2d = check_2d_hw_flag();
+
+    snapshot.ioctl_version = ioctl_version;
+    snapshot.kernel_version = kernel_version;
+    snapshot.vcodec_type = vcodec_type;
+    memcpy(snapshot.hw_ids, hw_ids, sizeof(snapshot.hw_ids));
+    memcpy(&snapshot.cmd_cap, cap, sizeof(snapshot.cmd_cap));
+    snapshot.service_node = mpp_get_mpp_service_node();
+    snapshot.flag_2d = flag_2d;
+    mpp_cap_cache_update(MPP_CAP_PART_PLATFORM, &snapshot);
 }
 
 RK_U32 MppPlatformService::get_hw_id(RK_S32 client_type)
@@ -154,15 +195,7 @@ MppKernelVersion mpp_get_kernel_version(void)
 
 RK_U32 mpp_get_2d_hw_flag(void)
 {
-    RK_U32 flag = 0;
-
-    if (!access("/dev/rga", F_OK))
-        flag |= HAVE_RGA;
-
-    if (!access("/dev/iep", F_OK))
-        flag |= HAVE_IEP;
-
-    return flag;
+    return MppPlatformService::get_instance()->get_2d_hw_flag();
 }
 
 const MppServiceCmdCap *mpp_get_mpp_service_cmd_cap(void)
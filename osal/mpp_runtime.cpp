@@ -17,12 +17,14 @@
 #define MODULE_TAG "mpp_rt"
 
 #include <fcntl.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "mpp_env.h"
 #include "mpp_log.h"
 #include "mpp_common.h"
 #include "mpp_runtime.h"
+#include "mpp_cap_cache.h"
 
 #define MAX_DTS_PATH_LEN        256
 
@@ -64,6 +66,8 @@ private:
 
     RK_U32  allocator_valid[MPP_BUFFER_TYPE_BUTT];
 
+    void    check_allocator();
+
 public:
     static MppRuntimeService *get_instance() {
         static MppRuntimeService instance;
@@ -81,8 +85,25 @@ RK_U32 MppRuntimeService::get_allocator_valid(MppBufferType type)
 
 MppRuntimeService::MppRuntimeService()
 {
+    const MppCapSnapshot *cache = NULL;
+    MppCapSnapshot snapshot;
+
     mpp_env_get_u32("mpp_rt_debug", &mpp_rt_debug, 0);
 
+    cache = mpp_cap_cache_get();
+    if (cache) {
+        memcpy(allocator_valid, cache->allocator_valid, sizeof(allocator_valid));
+        return;
+    }
+
+    check_allocator();
+
+    memcpy(snapshot.allocator_valid, allocator_valid, sizeof(snapshot.allocator_valid));
+    mpp_cap_cache_update(MPP_CAP_PART_RUNTIME, &snapshot);
+}
+
+void MppRuntimeService::check_allocator()
+{
     allocator_valid[MPP_BUFFER_TYPE_NORMAL] = 1;
     allocator_valid[MPP_BUFFER_TYPE_ION] = !access("/dev/ion", F_OK | R_OK | W_OK);
     allocator_valid[MPP_BUFFER_TYPE_DRM] = !access("/dev/dri/card0", F_OK | R_OK | W_OK);
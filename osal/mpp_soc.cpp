@@ -26,8 +26,9 @@
 
 #include "mpp_soc.h"
 #include "mpp_platform.h"
+#include "mpp_cap_cache.h"
 
-#define MAX_SOC_NAME_LENGTH     128
+#define MAX_SOC_NAME_LENGTH     MPP_CAP_SOC_NAME_LEN
 
 #define CODING_TO_IDX(type)   \
     ((RK_U32)(type) >= (RK_U32)MPP_VIDEO_CodingKhronosExtensions) ? \
@@ -760,10 +761,20 @@ MppSocService::MppSocService()
       dec_coding_cap(0),
       enc_coding_cap(0)
 {
+    const MppCapSnapshot *cache = mpp_cap_cache_get();
     RK_U32 i;
     RK_U32 vcodec_type = 0;
 
-    read_soc_name(soc_name, sizeof(soc_name));
+    if (cache) {
+        snprintf(soc_name, sizeof(soc_name), "%s", cache->soc_name);
+    } else {
+        MppCapSnapshot snapshot;
+
+        read_soc_name(soc_name, sizeof(soc_name));
+        memcpy(snapshot.soc_name, soc_name, sizeof(snapshot.soc_name));
+        mpp_cap_cache_update(MPP_CAP_PART_SOC, &snapshot);
+    }
+
     soc_info = check_soc_info(soc_name);
     if (NULL == soc_info) {
         mpp_dbg_platform("use default chip info\n");
@@ -18,20 +18,74 @@
 
 #include <string.h>
 
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#endif
+
+#include "mpp_env.h"
 #include "mpp_log.h"
 #include "mpp_common.h"
 #include "mpp_thread.h"
 
 #define MPP_THREAD_DBG_FUNCTION     (0x00000001)
+#define MPP_THREAD_DBG_POLICY       (0x00000002)
 
 static RK_U32 thread_debug = 0;
 
 #define thread_dbg(flag, fmt, ...)  _mpp_dbg(thread_debug, flag, fmt, ## __VA_ARGS__)
 
-MppThread::MppThread(MppThreadFunc func, void *ctx, const char *name)
+static const char *role_str[MPP_THREAD_ROLE_BUTT] = {
+    "default",
+    "parser",
+    "hal",
+    "enc",
+    "vproc",
+    "timer",
+};
+
+static MppThreadPolicy role_policy[MPP_THREAD_ROLE_BUTT];
+static pthread_once_t role_policy_once = PTHREAD_ONCE_INIT;
+
+static void role_policy_init(void)
+{
+    char name[64];
+    RK_S32 i;
+
+    mpp_env_get_u32("mpp_thread_debug", &thread_debug, 0);
+
+    for (i = MPP_THREAD_ROLE_PARSER; i < MPP_THREAD_ROLE_BUTT; i++) {
+        MppThreadPolicy *p = &role_policy[i];
+
+        snprintf(name, sizeof(name), "mpp_thread_%s_cpu", role_str[i]);
+        mpp_env_get_u32(name, &p->cpu_mask, 0);
+        snprintf(name, sizeof(name), "mpp_thread_%s_nice", role_str[i]);
+        mpp_env_get_u32(name, (RK_U32 *)&p->nice, 0);
+        snprintf(name, sizeof(name), "mpp_thread_%s_fifo", role_str[i]);
+        mpp_env_get_u32(name, (RK_U32 *)&p->fifo, 0);
+    }
+}
+
+static void get_role_policy(MppThreadRole role, MppThreadPolicy *policy)
+{
+    pthread_once(&role_policy_once, role_policy_init);
+    *policy = role_policy[role];
+}
+
+MppThread::MppThread(MppThreadFunc func, void *ctx, const char *name,
+                     MppThreadRole role)
     : mFunction(func),
-      mContext(ctx)
+      mContext(ctx),
+      mRole(role),
+      mTid(0),
+      mCpuTime(0)
 {
+    if (mRole >= MPP_THREAD_ROLE_BUTT)
+        mRole = MPP_THREAD_ROLE_DEFAULT;
+
+    get_role_policy(mRole, &mPolicy);
+
     mStatus[THREAD_WORK]    = MPP_THREAD_UNINITED;
     mStatus[THREAD_INPUT]   = MPP_THREAD_RUNNING;
     mStatus[THREAD_OUTPUT]  = MPP_THREAD_RUNNING;
@@ -69,7 +123,7 @@ void MppThread::start()
     if (MPP_THREAD_UNINITED == get_status()) {
         // NOTE: set status here first to avoid unexpected loop quit racing condition
         set_status(MPP_THREAD_RUNNING);
-        if (0 == pthread_create(&mThread, &attr, mFunction, mContext)) {
+        if (0 == pthread_create(&mThread, &attr, thread_entry, this)) {
 #ifndef ARMLINUX
             RK_S32 ret = pthread_setname_np(mThread, mName);
             if (ret)
@@ -103,6 +157,100 @@ void MppThread::stop()
     }
 }
 
+void *MppThread::thread_entry(void *arg)
+{
+    MppThread *thd = (MppThread *)arg;
+    void *ret;
+
+#if defined(__linux__)
+    thd->mTid = (RK_S32)syscall(SYS_gettid);
+    thd->apply_policy();
+#endif
+
+    ret = thd->mFunction(thd->mContext);
+
+#if defined(__linux__)
+    {
+        struct timespec ts;
+
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        thd->mCpuTime += (RK_S64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+        thd->mTid = 0;
+    }
+#endif
+
+    return ret;
+}
+
+void MppThread::apply_policy()
+{
+#if defined(__linux__)
+    RK_S32 tid = mTid;
+
+    if (!tid)
+        return;
+
+    if (mPolicy.cpu_mask) {
+        cpu_set_t set;
+        RK_U32 i;
+
+        CPU_ZERO(&set);
+        for (i = 0; i < 32; i++) {
+            if (mPolicy.cpu_mask & (1u << i))
+                CPU_SET(i, &set);
+        }
+
+        if (sched_setaffinity(tid, sizeof(set), &set))
+            mpp_err("thread %s set cpu mask %x failed\n", mName, mPolicy.cpu_mask);
+    }
+
+    if (mPolicy.fifo) {
+        struct sched_param param;
+
+        param.sched_priority = mPolicy.fifo;
+        if (sched_setscheduler(tid, SCHED_FIFO, &param))
+            mpp_err("thread %s set fifo priority %d failed\n", mName, mPolicy.fifo);
+    } else if (mPolicy.nice) {
+        if (setpriority(PRIO_PROCESS, tid, mPolicy.nice))
+            mpp_err("thread %s set nice %d failed\n", mName, mPolicy.nice);
+    }
+
+    thread_dbg(MPP_THREAD_DBG_POLICY, "thread %s role %s tid %d cpu %x nice %d fifo %d\n",
+               mName, role_str[mRole], tid, mPolicy.cpu_mask, mPolicy.nice,
+               mPolicy.fifo);
+#endif
+}
+
+void MppThread::set_policy(const MppThreadPolicy *policy)
+{
+    MppThreadPolicy dft;
+
+    get_role_policy(mRole, &dft);
+
+    mPolicy.cpu_mask = policy->cpu_mask ? policy->cpu_mask : dft.cpu_mask;
+    mPolicy.nice = policy->nice ? policy->nice : dft.nice;
+    mPolicy.fifo = policy->fifo ? policy->fifo : dft.fifo;
+
+    apply_policy();
+}
+
+RK_S64 MppThread::get_cpu_time()
+{
+    RK_S64 time = mCpuTime;
+
+#if defined(__linux__)
+    if (mTid) {
+        struct timespec ts;
+        clockid_t clk;
+
+        if (!pthread_getcpuclockid(mThread, &clk) && !clock_gettime(clk, &ts))
+            time += (RK_S64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    }
+#endif
+
+    return time;
+}
+
 #if defined(_WIN32) && !defined(__MINGW32CE__)
 //
 // Usage: SetThreadName ((DWORD)-1, "MainThread");
@@ -378,7 +378,8 @@ void mpp_timer_set_enable(MppTimer timer, RK_S32 enable)
 
     if (enable) {
         if (!impl->enabled && NULL == impl->thd) {
-            MppThread *thd = new MppThread(mpp_timer_thread, impl, impl->name);
+            MppThread *thd = new MppThread(mpp_timer_thread, impl, impl->name,
+                                           MPP_THREAD_ROLE_TIMER);
             if (thd) {
                 impl->thd = thd;
                 impl->enabled = 1;
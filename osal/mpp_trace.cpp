@@ -16,14 +16,67 @@
 
 #define MODULE_TAG "mpp_trace"
 
+#include <time.h>
 #include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdarg.h>
-
+#include <pthread.h>
+
+#if defined(__linux__)
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "mpp_env.h"
+#include "mpp_err.h"
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_lock.h"
 #include "mpp_common.h"
 #include "mpp_trace.h"
 
 #define ATRACE_MESSAGE_LENGTH 256
 
+#define TRACE_NAME_LEN          40
+#define TRACE_RING_SIZE_DEF     16384
+#define TRACE_RING_MAX          64
+#define TRACE_PB_BUF_SIZE       256
+
+typedef enum MppTraceType_e {
+    TRACE_BEGIN,
+    TRACE_END,
+    TRACE_ASYNC_BEGIN,
+    TRACE_ASYNC_END,
+    TRACE_COUNTER,
+} MppTraceType;
+
+/* 64 byte event, seq is the index + 1 of the write which filled it */
+typedef struct MppTraceEvent_t {
+    RK_S64              time;
+    RK_S64              value;
+    volatile RK_U32     seq;
+    RK_U32              type;
+    char                name[TRACE_NAME_LEN];
+} MppTraceEvent;
+
+/* per thread flight recorder, the oldest event is overwritten */
+typedef struct MppTraceRing_t {
+    struct MppTraceRing_t *next;
+    MppTraceEvent       *events;
+    RK_U32              size;
+    volatile RK_U32     idx;
+    volatile RK_U32     dead;
+    RK_S32              tid;
+    char                name[16];
+} MppTraceRing;
+
+typedef struct MppTracePb_t {
+    RK_U8               buf[TRACE_PB_BUF_SIZE];
+    RK_U32              pos;
+} MppTracePb;
+
 class MppTraceService
 {
 private:
@@ -34,24 +87,81 @@ private:
     MppTraceService &operator=(const MppTraceService &);
 
     void trace_write(const char *fmt, ...);
+    void trace_record(MppTraceType type, const char *name, RK_S64 value);
+    MppTraceRing *get_ring();
+    static void ring_release(void *ctx);
+
+    RK_S32 dump_json(FILE *fp);
+    RK_S32 dump_pftrace(FILE *fp);
 
     RK_S32 mTraceFd;
 
+    /* in-memory recorder */
+    RK_U32              mMemSize;
+    RK_S32              mRingCnt;
+    MppTraceRing        *mRings;
+    pthread_key_t       mKey;
+    pthread_mutex_t     mLock;
+    const char          *mFile;
+
 public:
     static MppTraceService *get_inst() {
         static MppTraceService inst;
         return &inst;
     }
 
+    RK_S32 enabled() { return mTraceFd >= 0 || mMemSize; }
     void trace_begin(const char* name);
     void trace_end(const char* name);
     void trace_async_begin(const char* name, RK_S32 cookie);
     void trace_async_end(const char* name, RK_S32 cookie);
     void trace_int32(const char* name, RK_S32 val);
     void trace_int64(const char* name, RK_S64 val);
+    RK_S32 trace_dump(const char *file);
 };
 
+static RK_S64 trace_time_ns(void)
+{
+    struct timespec ts = {0, 0};
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (RK_S64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static RK_S32 trace_get_tid(void)
+{
+#if defined(__linux__)
+    return (RK_S32)syscall(SYS_gettid);
+#else
+    return 0;
+#endif
+}
+
+/* thread may be renamed after its first event so read the name again */
+static void trace_update_name(MppTraceRing *ring)
+{
+#if defined(__linux__)
+    char path[64];
+    FILE *fp;
+
+    snprintf(path, sizeof(path), "/proc/self/task/%d/comm", ring->tid);
+    fp = fopen(path, "r");
+    if (fp) {
+        if (fgets(ring->name, sizeof(ring->name), fp))
+            ring->name[strcspn(ring->name, "\n")] = '\0';
+        fclose(fp);
+    }
+#else
+    (void)ring;
+#endif
+}
+
 MppTraceService::MppTraceService()
+    : mTraceFd(-1),
+      mMemSize(0),
+      mRingCnt(0),
+      mRings(NULL),
+      mFile(NULL)
 {
     static const char *ftrace_paths[] = {
         "/sys/kernel/debug/tracing/trace_marker",
@@ -59,6 +169,7 @@ MppTraceService::MppTraceService()
         "/debugfs/tracing/trace_marker",
     };
 
+    RK_U32 mem = 0;
     RK_U32 i;
 
     for (i = 0; i < MPP_ARRAY_ELEMS(ftrace_paths); i++) {
@@ -68,6 +179,26 @@ MppTraceService::MppTraceService()
                 break;
         }
     }
+
+    /*
+     * mpp_trace_mem      - 1 record events in memory
+     * mpp_trace_mem_size - events kept per thread, rounded up to power of 2
+     * mpp_trace_file     - file written at exit, *.pftrace / *.pb for perfetto
+     *                      protobuf, otherwise chrome json
+     */
+    mpp_env_get_u32("mpp_trace_mem", &mem, 0);
+    if (!mem)
+        return;
+
+    mpp_env_get_u32("mpp_trace_mem_size", &mem, TRACE_RING_SIZE_DEF);
+    mpp_env_get_str("mpp_trace_file", &mFile, "/tmp/mpp_trace.json");
+
+    mMemSize = 256;
+    while (mMemSize < mem && mMemSize < (1u << 22))
+        mMemSize <<= 1;
+
+    pthread_mutex_init(&mLock, NULL);
+    pthread_key_create(&mKey, ring_release);
 }
 
 MppTraceService::~MppTraceService()
@@ -76,6 +207,12 @@ MppTraceService::~MppTraceService()
         close(mTraceFd);
         mTraceFd = -1;
     }
+
+    if (mMemSize) {
+        trace_dump(mFile);
+        /* threads may still record, keep the rings */
+        mMemSize = 0;
+    }
 }
 
 void MppTraceService::trace_write(const char *fmt, ...)
@@ -91,8 +228,97 @@ void MppTraceService::trace_write(const char *fmt, ...)
     (void)!write(mTraceFd, buf, len);
 }
 
+void MppTraceService::ring_release(void *ctx)
+{
+    MppTraceRing *ring = (MppTraceRing *)ctx;
+
+    trace_update_name(ring);
+    MPP_SYNC();
+    ring->dead = 1;
+}
+
+MppTraceRing *MppTraceService::get_ring()
+{
+    MppTraceRing *ring = (MppTraceRing *)pthread_getspecific(mKey);
+    MppTraceRing *pos;
+
+    if (ring)
+        return ring;
+
+    pthread_mutex_lock(&mLock);
+
+    /* reuse the ring of an exited thread when there are too many */
+    if (mRingCnt >= TRACE_RING_MAX) {
+        for (pos = mRings; pos; pos = pos->next) {
+            if (pos->dead) {
+                ring = pos;
+                break;
+            }
+        }
+    }
+
+    if (ring) {
+        ring->idx = 0;
+        ring->dead = 0;
+    } else {
+        ring = mpp_calloc(MppTraceRing, 1);
+        if (ring)
+            ring->events = mpp_calloc(MppTraceEvent, mMemSize);
+
+        if (NULL == ring || NULL == ring->events) {
+            MPP_FREE(ring);
+            pthread_mutex_unlock(&mLock);
+            return NULL;
+        }
+
+        ring->size = mMemSize;
+        ring->next = mRings;
+        mRings = ring;
+        mRingCnt++;
+    }
+
+    ring->tid = trace_get_tid();
+    ring->name[0] = '\0';
+#if defined(__linux__)
+    prctl(PR_GET_NAME, ring->name);
+#endif
+
+    pthread_mutex_unlock(&mLock);
+
+    pthread_setspecific(mKey, ring);
+
+    return ring;
+}
+
+void MppTraceService::trace_record(MppTraceType type, const char *name, RK_S64 value)
+{
+    MppTraceRing *ring = get_ring();
+    MppTraceEvent *ev;
+    RK_U32 idx;
+
+    if (NULL == ring)
+        return;
+
+    idx = ring->idx;
+    ev = &ring->events[idx & (ring->size - 1)];
+
+    ev->seq = 0;
+    MPP_SYNC();
+    ev->time = trace_time_ns();
+    ev->value = value;
+    ev->type = type;
+    strncpy(ev->name, name, sizeof(ev->name) - 1);
+    ev->name[sizeof(ev->name) - 1] = '\0';
+    MPP_SYNC();
+    ev->seq = idx + 1;
+    ring->idx = idx + 1;
+}
+
 void MppTraceService::trace_begin(const char* name)
 {
+    if (mMemSize)
+        trace_record(TRACE_BEGIN, name, 0);
+
     if (mTraceFd < 0)
         return;
 
@@ -101,6 +327,9 @@ void MppTraceService::trace_begin(const char* name)
 
 void MppTraceService::trace_end(const char* name)
 {
+    if (mMemSize)
+        trace_record(TRACE_END, name, 0);
+
     if (mTraceFd < 0)
         return;
 
@@ -109,6 +338,9 @@ void MppTraceService::trace_end(const char* name)
 
 void MppTraceService::trace_async_begin(const char* name, RK_S32 cookie)
 {
+    if (mMemSize)
+        trace_record(TRACE_ASYNC_BEGIN, name, cookie);
+
     if (mTraceFd < 0)
         return;
 
@@ -117,6 +349,9 @@ void MppTraceService::trace_async_begin(const char* name, RK_S32 cookie)
 
 void MppTraceService::trace_async_end(const char* name, RK_S32 cookie)
 {
+    if (mMemSize)
+        trace_record(TRACE_ASYNC_END, name, cookie);
+
     if (mTraceFd < 0)
         return;
 
@@ -125,6 +360,9 @@ void MppTraceService::trace_async_end(const char* name, RK_S32 cookie)
 
 void MppTraceService::trace_int32(const char* name, RK_S32 value)
 {
+    if (mMemSize)
+        trace_record(TRACE_COUNTER, name, value);
+
     if (mTraceFd < 0)
         return;
 
@@ -133,12 +371,347 @@ void MppTraceService::trace_int32(const char* name, RK_S32 value)
 
 void MppTraceService::trace_int64(const char* name, RK_S64 value)
 {
+    if (mMemSize)
+        trace_record(TRACE_COUNTER, name, value);
+
     if (mTraceFd < 0)
         return;
 
     trace_write("C|%d|%s|%lld", getpid(), name, value);
 }
 
+/* copy event out of a ring which may be written at the same time */
+static RK_S32 trace_read_event(MppTraceRing *ring, RK_U32 idx, MppTraceEvent *ev)
+{
+    MppTraceEvent *src = &ring->events[idx & (ring->size - 1)];
+
+    if (src->seq != idx + 1)
+        return 0;
+
+    MPP_SYNC();
+    memcpy(ev, src, sizeof(*ev));
+    MPP_SYNC();
+
+    return src->seq == idx + 1;
+}
+
+static void trace_json_str(FILE *fp, const char *str)
+{
+    fputc('"', fp);
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\')
+            fprintf(fp, "\\%c", *str);
+        else if ((RK_U8)*str < 0x20)
+            fprintf(fp, "\\u%04x", *str);
+        else
+            fputc(*str, fp);
+    }
+    fputc('"', fp);
+}
+
+RK_S32 MppTraceService::dump_json(FILE *fp)
+{
+    static const char *ph[] = { "B", "E", "b", "e", "C" };
+    MppTraceRing *ring;
+    RK_S32 pid = getpid();
+    RK_S32 cnt = 0;
+    RK_S32 first = 1;
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+    for (ring = mRings; ring; ring = ring->next) {
+        RK_U32 end = ring->idx;
+        RK_U32 idx = (end > ring->size) ? end - ring->size : 0;
+        MppTraceEvent ev;
+
+        if (!ring->dead)
+            trace_update_name(ring);
+
+        fprintf(fp, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+                first ? "" : ",\n", pid, ring->tid);
+        trace_json_str(fp, ring->name);
+        fprintf(fp, "}}");
+        first = 0;
+
+        for (; idx != end; idx++) {
+            if (!trace_read_event(ring, idx, &ev))
+                continue;
+
+            fprintf(fp, ",\n{\"ph\":\"%s\",\"name\":", ph[ev.type]);
+            trace_json_str(fp, ev.name);
+            fprintf(fp, ",\"cat\":\"mpp\",\"pid\":%d,\"tid\":%d,\"ts\":%lld.%03lld",
+                    pid, ring->tid, (long long)(ev.time / 1000), (long long)(ev.time % 1000));
+
+            if (ev.type == TRACE_ASYNC_BEGIN || ev.type == TRACE_ASYNC_END)
+                fprintf(fp, ",\"id\":%lld", (long long)ev.value);
+            else if (ev.type == TRACE_COUNTER)
+                fprintf(fp, ",\"args\":{\"value\":%lld}", (long long)ev.value);
+
+            fprintf(fp, "}");
+            cnt++;
+        }
+    }
+
+    fprintf(fp, "\n]}\n");
+
+    return cnt;
+}
+
+/* minimal protobuf writer for perfetto TracePacket */
+static void pb_varint(MppTracePb *pb, RK_U64 val)
+{
+    while (pb->pos < sizeof(pb->buf)) {
+        RK_U8 byte = val & 0x7f;
+
+        val >>= 7;
+        pb->buf[pb->pos++] = byte | (val ? 0x80 : 0);
+        if (!val)
+            break;
+    }
+}
+
+static void pb_uint(MppTracePb *pb, RK_U32 field, RK_U64 val)
+{
+    pb_varint(pb, (RK_U64)field << 3);
+    pb_varint(pb, val);
+}
+
+static RK_U32 pb_varint_len(RK_U64 val)
+{
+    RK_U32 len = 1;
+
+    while (val >>= 7)
+        len++;
+
+    return len;
+}
+
+/* payload is truncated to the buffer and the length matches the payload */
+static void pb_bytes(MppTracePb *pb, RK_U32 field, const void *data, RK_U32 size)
+{
+    RK_U32 pos = pb->pos;
+    RK_U32 left;
+
+    pb_varint(pb, ((RK_U64)field << 3) | 2);
+
+    left = sizeof(pb->buf) - pb->pos;
+    if (!left) {
+        /* no room for the length, drop the whole field */
+        pb->pos = pos;
+        return;
+    }
+
+    if (pb_varint_len(size) + size > left)
+        size = left - pb_varint_len(left);
+
+    pb_varint(pb, size);
+    memcpy(pb->buf + pb->pos, data, size);
+    pb->pos += size;
+}
+
+static void pb_str(MppTracePb *pb, RK_U32 field, const char *str)
+{
+    pb_bytes(pb, field, str, strlen(str));
+}
+
+static void pb_msg(MppTracePb *pb, RK_U32 field, MppTracePb *msg)
+{
+    pb_bytes(pb, field, msg->buf, msg->pos);
+}
+
+/* Trace.packet = 1 */
+static void pb_write_packet(FILE *fp, MppTracePb *packet)
+{
+    MppTracePb hdr;
+
+    hdr.pos = 0;
+    pb_varint(&hdr, (1 << 3) | 2);
+    pb_varint(&hdr, packet->pos);
+    fwrite(hdr.buf, 1, hdr.pos, fp);
+    fwrite(packet->buf, 1, packet->pos, fp);
+}
+
+/*
+ * TrackDescriptor packet
+ * kind 0 - thread track, 1 - named child track, 2 - counter track
+ */
+static void pb_write_track(FILE *fp, RK_U64 uuid, RK_U64 parent, RK_S32 kind,
+                           RK_S32 pid, RK_S32 tid, const char *name)
+{
+    MppTracePb packet;
+    MppTracePb track;
+    MppTracePb desc;
+
+    packet.pos = 0;
+    track.pos = 0;
+    desc.pos = 0;
+
+    pb_uint(&track, 1, uuid);
+    if (kind == 0) {
+        pb_uint(&desc, 1, pid);
+        pb_uint(&desc, 2, tid);
+        pb_str(&desc, 5, name);
+        pb_msg(&track, 4, &desc);
+    } else {
+        pb_str(&track, 2, name);
+        pb_uint(&track, 5, parent);
+        if (kind == 2)
+            pb_msg(&track, 8, &desc);
+    }
+
+    pb_uint(&packet, 10, 1);
+    pb_msg(&packet, 60, &track);
+    pb_write_packet(fp, &packet);
+}
+
+static RK_U64 trace_name_hash(const char *name, RK_S64 salt)
+{
+    RK_U64 hash = 0xcbf29ce484222325ULL;
+
+    for (; *name; name++)
+        hash = (hash ^ (RK_U8) * name) * 0x100000001b3ULL;
+
+    hash ^= (RK_U64)salt * 0x9E3779B97F4A7C15ULL;
+
+    /* keep away from the thread track uuid space */
+    return hash | (1ULL << 63);
+}
+
+static RK_S32 trace_uuid_add(RK_U64 **uuids, RK_S32 *cnt, RK_U64 uuid)
+{
+    RK_S32 i;
+
+    for (i = 0; i < *cnt; i++)
+        if ((*uuids)[i] == uuid)
+            return 0;
+
+    if (!(*cnt & 63)) {
+        RK_U64 *tmp = mpp_realloc(*uuids, RK_U64, *cnt + 64);
+
+        if (NULL == tmp)
+            return 0;
+        *uuids = tmp;
+    }
+
+    (*uuids)[(*cnt)++] = uuid;
+
+    return 1;
+}
+
+RK_S32 MppTraceService::dump_pftrace(FILE *fp)
+{
+    MppTraceRing *ring;
+    RK_U64 *uuids = NULL;
+    RK_S32 uuid_cnt = 0;
+    RK_S32 pid = getpid();
+    RK_U64 pid_uuid = (RK_U64)pid << 32;
+    RK_S32 first = 1;
+    RK_S32 cnt = 0;
+
+    for (ring = mRings; ring; ring = ring->next) {
+        RK_U32 end = ring->idx;
+        RK_U32 idx = (end > ring->size) ? end - ring->size : 0;
+        RK_U64 tid_uuid = pid_uuid | (RK_U32)ring->tid;
+        MppTraceEvent ev;
+
+        if (!ring->dead)
+            trace_update_name(ring);
+
+        pb_write_track(fp, tid_uuid, 0, 0, pid, ring->tid, ring->name);
+
+        for (; idx != end; idx++) {
+            MppTracePb packet;
+            MppTracePb event;
+            RK_U64 uuid = tid_uuid;
+
+            if (!trace_read_event(ring, idx, &ev))
+                continue;
+
+            packet.pos = 0;
+            event.pos = 0;
+
+            /* async slice and counter get their own track */
+            if (ev.type == TRACE_ASYNC_BEGIN || ev.type == TRACE_ASYNC_END) {
+                uuid = trace_name_hash(ev.name, ev.value);
+                if (trace_uuid_add(&uuids, &uuid_cnt, uuid))
+                    pb_write_track(fp, uuid, pid_uuid, 1, pid, 0, ev.name);
+            } else if (ev.type == TRACE_COUNTER) {
+                uuid = trace_name_hash(ev.name, -1);
+                if (trace_uuid_add(&uuids, &uuid_cnt, uuid))
+                    pb_write_track(fp, uuid, pid_uuid, 2, pid, 0, ev.name);
+            }
+
+            /* TrackEvent type SLICE_BEGIN 1 SLICE_END 2 COUNTER 4 */
+            switch (ev.type) {
+            case TRACE_BEGIN :
+            case TRACE_ASYNC_BEGIN : {
+                pb_uint(&event, 9, 1);
+                pb_str(&event, 23, ev.name);
+            } break;
+            case TRACE_END :
+            case TRACE_ASYNC_END : {
+                pb_uint(&event, 9, 2);
+            } break;
+            default : {
+                pb_uint(&event, 9, 4);
+                pb_uint(&event, 30, (RK_U64)ev.value);
+            } break;
+            }
+            pb_uint(&event, 11, uuid);
+
+            /* timestamp, clock MONOTONIC 3, sequence id, incremental state cleared */
+            pb_uint(&packet, 8, (RK_U64)ev.time);
+            pb_uint(&packet, 58, 3);
+            pb_uint(&packet, 10, 1);
+            if (first) {
+                pb_uint(&packet, 13, 1);
+                first = 0;
+            }
+            pb_msg(&packet, 11, &event);
+            pb_write_packet(fp, &packet);
+            cnt++;
+        }
+    }
+
+    MPP_FREE(uuids);
+
+    return cnt;
+}
+
+RK_S32 MppTraceService::trace_dump(const char *file)
+{
+    const char *ext;
+    RK_S32 cnt;
+    FILE *fp;
+
+    if (!mMemSize)
+        return MPP_NOK;
+
+    if (NULL == file)
+        file = mFile;
+
+    fp = fopen(file, "wb");
+    if (NULL == fp) {
+        mpp_err_f("failed to open %s\n", file);
+        return MPP_ERR_OPEN_FILE;
+    }
+
+    ext = strrchr(file, '.');
+
+    pthread_mutex_lock(&mLock);
+    if (ext && (!strcmp(ext, ".pftrace") || !strcmp(ext, ".pb")))
+        cnt = dump_pftrace(fp);
+    else
+        cnt = dump_json(fp);
+    pthread_mutex_unlock(&mLock);
+
+    fclose(fp);
+
+    mpp_log_f("%d events saved to %s\n", cnt, file);
+
+    return cnt;
+}
+
 void mpp_trace_begin(const char* name)
 {
     MppTraceService::get_inst()->trace_begin(name);
@@ -168,3 +741,13 @@ void mpp_trace_int64(const char* name, RK_S64 value)
 {
     MppTraceService::get_inst()->trace_int64(name, value);
 }
+
+RK_S32 mpp_trace_enabled(void)
+{
+    return MppTraceService::get_inst()->enabled();
+}
+
+RK_S32 mpp_trace_dump(const char *file)
+{
+    return MppTraceService::get_inst()->trace_dump(file);
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_cap_cache_test"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_platform.h"
+#include "mpp_cap_cache.h"
+
+static RK_S32 cap_cache_file_size(const char *path)
+{
+    struct stat st;
+
+    return stat(path, &st) ? -1 : (RK_S32)st.st_size;
+}
+
+static RK_S32 cap_cache_run(char *prog, const char *mode, const char *arg0,
+                            const char *arg1)
+{
+    pid_t pid;
+    int status = 0;
+
+    pid = fork();
+    if (!pid) {
+        execl(prog, prog, mode, arg0, arg1, (char *)NULL);
+        _exit(-1);
+    }
+
+    if (pid < 0 || waitpid(pid, &status, 0) != pid ||
+        !WIFEXITED(status) || WEXITSTATUS(status)) {
+        mpp_err("cache %s process failed status %d\n", mode, status);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * usage: mpp_cap_cache_test
+ * a child process checks the cache is off by default, then the first run
+ * probes and writes the cache file, then another child process is started
+ * to load the cache file and compare with the probed result.
+ */
+int main(int argc, char **argv)
+{
+    char path[] = "/tmp/mpp_cap_cache_test_XXXXXX";
+    char vcodec[16];
+    char soc_name[MPP_CAP_SOC_NAME_LEN];
+    RK_U32 vcodec_type;
+    RK_S32 ret = -1;
+    int fd;
+
+    if (argc > 1 && !strcmp(argv[1], "off")) {
+        mpp_cap_cache_preload();
+        if (mpp_cap_cache_get() || cap_cache_file_size(getenv("mpp_cap_cache_path"))) {
+            mpp_err("cache should be disabled by default\n");
+            return -1;
+        }
+
+        return 0;
+    }
+
+    if (argc > 3 && !strcmp(argv[1], "check")) {
+        mpp_cap_cache_preload();
+        if (NULL == mpp_cap_cache_get()) {
+            mpp_err("cache file is not loaded\n");
+            return -1;
+        }
+
+        snprintf(vcodec, sizeof(vcodec), "%08x", mpp_get_vcodec_type());
+        if (strcmp(mpp_get_soc_name(), argv[2]) || strcmp(vcodec, argv[3])) {
+            mpp_err("cache mismatch soc %s vcodec %s\n", mpp_get_soc_name(), vcodec);
+            return -1;
+        }
+
+        return 0;
+    }
+
+    /* empty file is ignored on load and replaced on write */
+    fd = mkstemp(path);
+    if (fd < 0) {
+        mpp_log("can not create cache file, skip\n");
+        return 0;
+    }
+    close(fd);
+
+    mpp_env_set_str("mpp_cap_cache_path", path);
+    if (cap_cache_run(argv[0], "off", NULL, NULL))
+        goto DONE;
+
+    mpp_env_set_u32("mpp_cap_cache", 1);
+    mpp_cap_cache_preload();
+    if (mpp_cap_cache_get()) {
+        mpp_err("cache should not be loaded on first run\n");
+        goto DONE;
+    }
+
+    if (cap_cache_file_size(path) <= 0) {
+        mpp_log("cache file is not writable, skip\n");
+        ret = 0;
+        goto DONE;
+    }
+
+    vcodec_type = mpp_get_vcodec_type();
+    snprintf(vcodec, sizeof(vcodec), "%08x", vcodec_type);
+    snprintf(soc_name, sizeof(soc_name), "%s", mpp_get_soc_name());
+
+    if (cap_cache_run(argv[0], "check", soc_name, vcodec))
+        goto DONE;
+
+    ret = 0;
+    mpp_log("mpp cap cache test done\n");
+DONE:
+    unlink(path);
+
+    return ret;
+}
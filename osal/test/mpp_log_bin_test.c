@@ -0,0 +1,206 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_log_bin_test"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_log_async.h"
+
+#define TEST_LOG_FILE       "/tmp/mpp_log_bin_test.bin"
+#define TEST_THREAD_CNT     4
+#define TEST_MSG_CNT        1000
+#define TEST_CRASH_EXIT     3
+
+static void *log_thread(void *arg)
+{
+    RK_S32 id = *(RK_S32 *)arg;
+    RK_S32 i;
+
+    for (i = 0; i < TEST_MSG_CNT; i++)
+        mpp_logi_f("thread %d msg %d name %s\n", id, i, "worker");
+
+    return NULL;
+}
+
+static void crash_prev_handler(int sig, siginfo_t *info, void *uctx)
+{
+    (void)sig;
+    (void)info;
+    (void)uctx;
+    _exit(TEST_CRASH_EXIT);
+}
+
+/*
+ * Child process crashes with crash dump enabled. The dump must be written
+ * and the handler installed before must still be called.
+ */
+static RK_S32 crash_test(void)
+{
+    char name[] = "/tmp/mpp_log_bin_crash_XXXXXX";
+    char crash[sizeof(name) + 8];
+    FILE *fp;
+    RK_S32 status = 0;
+    RK_S32 cnt;
+    pid_t pid;
+    int fd;
+
+    fd = mkstemp(name);
+    if (fd < 0)
+        return -1;
+    close(fd);
+    snprintf(crash, sizeof(crash), "%s.crash", name);
+
+    pid = fork();
+    if (pid < 0)
+        return -1;
+
+    if (!pid) {
+        struct sigaction sa;
+        RK_S32 i;
+
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_sigaction = crash_prev_handler;
+        sa.sa_flags = SA_SIGINFO;
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGABRT, &sa, NULL);
+
+        mpp_env_set_u32("mpp_log_mode", MPP_LOG_MODE_BIN);
+        mpp_env_set_u32("mpp_log_crash_dump", 1);
+        mpp_env_set_str("mpp_log_file", name);
+
+        if (mpp_log_async_mode() != MPP_LOG_MODE_BIN)
+            _exit(TEST_CRASH_EXIT);
+
+        for (i = 0; i < TEST_MSG_CNT; i++)
+            mpp_logi("crash msg %d\n", i);
+
+        abort();
+    }
+
+    waitpid(pid, &status, 0);
+
+    fp = fopen("/dev/null", "w");
+    cnt = fp ? mpp_log_bin_decode(crash, fp) : -1;
+    if (fp)
+        fclose(fp);
+
+    unlink(name);
+    unlink(crash);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != TEST_CRASH_EXIT) {
+        printf("%s: previous crash handler is not called status %x\n", MODULE_TAG, status);
+        return -1;
+    }
+
+    /* records may all be drained before the crash */
+    if (cnt < 0) {
+        printf("%s: crash dump %s is missing\n", MODULE_TAG, crash);
+        return -1;
+    }
+
+    printf("%s: crash dump %d records success\n", MODULE_TAG, cnt);
+
+    return 0;
+}
+
+/*
+ * usage: mpp_log_bin_test [binary log file]
+ * with a file the test only decodes it to stdout
+ */
+int main(int argc, char **argv)
+{
+    pthread_t thd[TEST_THREAD_CNT];
+    RK_S32 ids[TEST_THREAD_CNT];
+    struct sigaction sa;
+    char expect[256];
+    char line[1024];
+    RK_S32 found = 0;
+    RK_S32 cnt;
+    RK_S32 i;
+    FILE *fp;
+
+    if (argc > 1)
+        return mpp_log_bin_decode(argv[1], stdout) < 0;
+
+    if (crash_test())
+        return -1;
+
+    mpp_env_set_u32("mpp_log_mode", MPP_LOG_MODE_BIN);
+    mpp_env_set_u32("mpp_log_ring_size", 1024 * 1024);
+    mpp_env_set_str("mpp_log_file", TEST_LOG_FILE);
+
+    if (mpp_log_async_mode() != MPP_LOG_MODE_BIN) {
+        printf("%s: async log is not available, skip\n", MODULE_TAG);
+        return 0;
+    }
+
+    /* crash dump is opt-in, no handler without env */
+    sigaction(SIGSEGV, NULL, &sa);
+    if (sa.sa_handler != SIG_DFL) {
+        printf("%s: crash handler installed without env\n", MODULE_TAG);
+        return -1;
+    }
+
+    for (i = 0; i < TEST_THREAD_CNT; i++) {
+        ids[i] = i;
+        pthread_create(&thd[i], NULL, log_thread, &ids[i]);
+    }
+
+    mpp_logi("check %d %s %5.1f %-4x|%c|%%|%*d|%lld|%zu\n",
+             -7, "str", 3.14159, 0xab, 'z', 6, 42, -1234567890123LL, (size_t)99);
+
+    for (i = 0; i < TEST_THREAD_CNT; i++)
+        pthread_join(thd[i], NULL);
+
+    mpp_log_async_flush();
+
+    snprintf(expect, sizeof(expect), "check %d %s %5.1f %-4x|%c|%%|%*d|%lld|%zu\n",
+             -7, "str", 3.14159, 0xab, 'z', 6, 42, -1234567890123LL, (size_t)99);
+
+    fp = tmpfile();
+    if (NULL == fp)
+        return -1;
+
+    cnt = mpp_log_bin_decode(TEST_LOG_FILE, fp);
+
+    rewind(fp);
+    while (fgets(line, sizeof(line), fp)) {
+        char *msg = strstr(line, MODULE_TAG ": ");
+
+        if (msg && !strcmp(msg + strlen(MODULE_TAG ": "), expect))
+            found = 1;
+    }
+    fclose(fp);
+
+    if (cnt != TEST_THREAD_CNT * TEST_MSG_CNT + 1 || !found) {
+        printf("%s: decode %d records expect %d found %d\n", MODULE_TAG,
+               cnt, TEST_THREAD_CNT * TEST_MSG_CNT + 1, found);
+        return -1;
+    }
+
+    printf("%s: decode %d records success\n", MODULE_TAG, cnt);
+
+    return 0;
+}
@@ -16,15 +16,164 @@
 
 #define MODULE_TAG "mpp_mem_test"
 
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
 #include "mpp_log.h"
 #include "mpp_env.h"
 #include "mpp_mem.h"
 
-// TODO: need to add pressure test case and parameter scan case
+#define MEM_TEST_CNT    512
+
+#define MEM_TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            mpp_err("check %s failed at line %d\n", #cond, __LINE__); \
+            ret = MPP_NOK; \
+            goto DONE; \
+        } \
+    } while (0)
+
+// TODO: need to add parameter scan case
 
-int main()
+static void mem_test_report(void *ctx, const MppMemStat *stats, RK_S32 count, RK_U32 sample)
+{
+    RK_S32 i;
+
+    *(RK_S32 *)ctx = count;
+    for (i = 0; i < count; i++)
+        mpp_log("caller %-24s count %5u size %8u max %8u total %5u sample %u\n",
+                stats[i].caller, stats[i].count, stats[i].size,
+                stats[i].size_max, stats[i].total, sample);
+}
+
+/* run with env mpp_mem_debug / mpp_mem_sample to check the tracking */
+static MPP_RET mem_pressure_test(void)
+{
+    void **ptrs = mpp_calloc(void *, MEM_TEST_CNT);
+    RK_U32 debug = 0;
+    RK_U32 sample = 1;
+    RK_U32 base;
+    RK_U32 total = 0;
+    RK_U32 now;
+    RK_S32 callers = 0;
+    MPP_RET ret = MPP_OK;
+    RK_S32 i;
+
+    if (NULL == ptrs)
+        return MPP_NOK;
+
+    base = mpp_mem_total_now();
+
+    mpp_env_get_u32("mpp_mem_debug", &debug, 0);
+    mpp_env_get_u32("mpp_mem_sample", &sample, 1);
+    if (!sample)
+        sample = 1;
+    /* same rule as mpp_mem: any debug flag or sampling enables tracking */
+    if (debug || sample > 1)
+        debug |= 1;
+
+    for (i = 0; i < MEM_TEST_CNT; i++) {
+        ptrs[i] = mpp_malloc_size(void, 16 + (i & 255));
+        MEM_TEST_CHECK(ptrs[i]);
+        total += 16 + (i & 255);
+    }
+
+    now = mpp_mem_total_now() - base;
+    if (!(debug & 1))
+        MEM_TEST_CHECK(now == 0);
+    else if (sample == 1)
+        MEM_TEST_CHECK(now == total);
+    else
+        MEM_TEST_CHECK(now > 0 && now < total);
+
+    // grow every other buffer, sampled and unsampled ones keep their state
+    for (i = 0; i < MEM_TEST_CNT; i += 2) {
+        void *tmp = mpp_realloc(ptrs[i], RK_U8, 512 + i);
+
+        MEM_TEST_CHECK(tmp);
+        ptrs[i] = tmp;
+    }
+
+    if ((debug & 1) && sample == 1)
+        MEM_TEST_CHECK(mpp_mem_total_now() - base > total);
+
+    // free in reverse order to walk the tracking table backward
+    for (i = MEM_TEST_CNT - 1; i >= 0; i -= 2)
+        MPP_FREE(ptrs[i]);
+
+    mpp_mem_set_report(mem_test_report, &callers, 0);
+    mpp_mem_report();
+    mpp_mem_set_report(NULL, NULL, 0);
+
+    if (debug & 1)
+        MEM_TEST_CHECK(callers > 0);
+    else
+        MEM_TEST_CHECK(callers == 0);
+
+DONE:
+    for (i = 0; i < MEM_TEST_CNT; i++)
+        MPP_FREE(ptrs[i]);
+
+    /* every tracked buffer is released */
+    if (!ret && mpp_mem_total_now() != base) {
+        mpp_err("total now %u mismatch base %u\n", mpp_mem_total_now(), base);
+        ret = MPP_NOK;
+    }
+
+    mpp_free(ptrs);
+
+    mpp_log("pressure test debug %x sample %u %s total now %u max %u callers %d\n",
+            debug, sample, ret ? "failed" : "success",
+            mpp_mem_total_now(), mpp_mem_total_max(), callers);
+
+    return ret;
+}
+
+/* tracking mode is fixed on library load so run again with env set */
+static MPP_RET mem_env_test(char *prog, const char *debug, const char *sample)
+{
+    char *argv[] = { prog, (char *)"child", NULL };
+    int status = 0;
+    pid_t pid;
+
+    pid = fork();
+    if (pid < 0)
+        return MPP_NOK;
+
+    if (!pid) {
+        setenv("mpp_mem_debug", debug, 1);
+        setenv("mpp_mem_sample", sample, 1);
+        execv("/proc/self/exe", argv);
+        _exit(-1);
+    }
+
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+        mpp_err("run with debug %s sample %s failed status %x\n", debug, sample, status);
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+int main(int argc, char **argv)
 {
     void *tmp = NULL;
+    MPP_RET ret = MPP_OK;
+
+    ret = mem_pressure_test();
+
+    if (argc > 1)
+        return ret ? -1 : 0;
+
+    ret |= mem_env_test(argv[0], "1", "1");
+    /* extra room checks the sampled mark does not break guard check */
+    ret |= mem_env_test(argv[0], "0x11", "1");
+    ret |= mem_env_test(argv[0], "0", "4");
+    ret |= mem_env_test(argv[0], "0x10", "4");
+    ret |= mem_env_test(argv[0], "0x30", "4");
 
     tmp = mpp_calloc(int, 100);
     if (tmp) {
@@ -41,7 +190,7 @@ int main()
         }
     }
     mpp_free(tmp);
-    mpp_log("mpp_mem_test done\n");
+    mpp_log("mpp_mem_test %s\n", ret ? "failed" : "done");
 
-    return 0;
+    return ret ? -1 : 0;
 }
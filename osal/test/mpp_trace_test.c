@@ -16,14 +16,54 @@
 
 #define MODULE_TAG "mpp_trace_test"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mpp_env.h"
 #include "mpp_log.h"
 
 #include "mpp_trace.h"
 
+/* dump to a unique temporary file, suffix selects the format */
+static RK_S32 trace_dump_tmp(const char *suffix)
+{
+    char name[64];
+    RK_S32 cnt;
+    int fd;
+
+    snprintf(name, sizeof(name), "/tmp/mpp_trace_test_XXXXXX%s", suffix);
+    fd = mkstemps(name, strlen(suffix));
+    if (fd < 0) {
+        mpp_err("failed to create temporary file for %s\n", suffix);
+        return -1;
+    }
+    close(fd);
+
+    cnt = mpp_trace_dump(name);
+    unlink(name);
+
+    return cnt;
+}
+
 int main(void)
 {
+    RK_S32 json_cnt;
+    RK_S32 pb_cnt;
+
     mpp_log("mpp trace test start\n");
 
+    /* record in memory as well for the dump test below */
+    mpp_env_set_u32("mpp_trace_mem", 1);
+    /* no file left behind by the dump at exit */
+    mpp_env_set_str("mpp_trace_file", "/dev/null");
+
+    if (!mpp_trace_enabled()) {
+        mpp_err("mpp trace is not enabled with memory recorder\n");
+        return -1;
+    }
+
     mpp_trace_begin("mpp_trace_test");
     mpp_trace_end("mpp_trace_test");
 
@@ -33,6 +73,14 @@ int main(void)
     mpp_trace_int32("mpp_trace_test int32", 256);
     mpp_trace_int64("mpp_trace_test int64", 100000000);
 
+    json_cnt = trace_dump_tmp(".json");
+    pb_cnt = trace_dump_tmp(".pftrace");
+    if (json_cnt != 6 || pb_cnt != 6) {
+        mpp_err("mpp trace dump json %d pftrace %d events, expect 6\n",
+                json_cnt, pb_cnt);
+        return -1;
+    }
+
     mpp_log("mpp trace test done\n");
 
     return 0;
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2026 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "frm_check_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_common.h"
+
+#include "utils.h"
+
+#define FRM_CHECK_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            mpp_err("check %s failed at line %d\n", #cond, __LINE__); \
+            ret = MPP_NOK; \
+            goto DONE; \
+        } \
+    } while (0)
+
+static MppFrame frm_check_alloc(MppBufferGroup grp, RK_U32 width, RK_U32 height,
+                                RK_U32 hor_stride, RK_U32 ver_stride)
+{
+    MppFrame frame = NULL;
+    MppBuffer buf = NULL;
+    RK_U8 *base;
+    RK_U32 x, y;
+
+    mpp_buffer_get(grp, &buf, hor_stride * ver_stride * 3 / 2);
+    if (NULL == buf)
+        return NULL;
+
+    mpp_frame_init(&frame);
+    mpp_frame_set_width(frame, width);
+    mpp_frame_set_height(frame, height);
+    mpp_frame_set_hor_stride(frame, hor_stride);
+    mpp_frame_set_ver_stride(frame, ver_stride);
+    mpp_frame_set_fmt(frame, MPP_FMT_YUV420SP);
+    mpp_frame_set_buffer(frame, buf);
+    /* frame holds its own reference */
+    mpp_buffer_put(buf);
+
+    /* same pattern for any stride, padding is filled with garbage */
+    base = (RK_U8 *)mpp_buffer_get_ptr(buf);
+    memset(base, 0xa5, hor_stride * ver_stride * 3 / 2);
+    for (y = 0; y < height; y++)
+        for (x = 0; x < width; x++)
+            base[y * hor_stride + x] = (RK_U8)(x * 3 + y * 7);
+
+    base += hor_stride * ver_stride;
+    for (y = 0; y < height / 2; y++)
+        for (x = 0; x < width; x++)
+            base[y * hor_stride + x] = (RK_U8)(x * 5 + y * 11 + 128);
+
+    return frame;
+}
+
+/* change one pixel by delta without wrapping around */
+static void frm_check_modify(MppFrame frame, RK_U32 plane, RK_U32 x, RK_U32 y, RK_S32 delta)
+{
+    RK_U8 *base = (RK_U8 *)mpp_buffer_get_ptr(mpp_frame_get_buffer(frame));
+    RK_U32 stride = mpp_frame_get_hor_stride(frame);
+    RK_U8 *pix;
+
+    if (plane)
+        base += stride * mpp_frame_get_ver_stride(frame);
+
+    pix = base + y * stride + x;
+    *pix = (*pix < 128) ? *pix + delta : *pix - delta;
+}
+
+static MPP_RET frm_check_hash(MppBufferGroup grp)
+{
+    MPP_RET ret = MPP_OK;
+    MppFrame a = frm_check_alloc(grp, 176, 144, 176, 144);
+    MppFrame b = frm_check_alloc(grp, 176, 144, 192, 160);
+    FILE *fp = tmpfile();
+    FrmHash hash_a;
+    FrmHash hash_b;
+    FrmHash hash_rd;
+
+    FRM_CHECK_CHECK(a && b && fp);
+
+    /* hash only covers visible pixels so stride does not matter */
+    calc_frm_hash(a, &hash_a);
+    calc_frm_hash(b, &hash_b);
+    FRM_CHECK_CHECK(hash_a.luma == hash_b.luma);
+    FRM_CHECK_CHECK(hash_a.chroma == hash_b.chroma);
+
+    /* round trip through the verify file format */
+    write_frm_hash(fp, &hash_a);
+    frm_check_modify(b, 1, 10, 10, 1);
+    calc_frm_hash(b, &hash_b);
+    write_frm_hash(fp, &hash_b);
+    rewind(fp);
+
+    memset(&hash_rd, 0, sizeof(hash_rd));
+    read_frm_hash(fp, &hash_rd);
+    FRM_CHECK_CHECK(hash_rd.luma == hash_a.luma && hash_rd.chroma == hash_a.chroma);
+
+    read_frm_hash(fp, &hash_rd);
+    FRM_CHECK_CHECK(hash_rd.luma == hash_b.luma && hash_rd.chroma == hash_b.chroma);
+    FRM_CHECK_CHECK(hash_b.luma == hash_a.luma);
+    FRM_CHECK_CHECK(hash_b.chroma != hash_a.chroma);
+
+DONE:
+    if (fp)
+        fclose(fp);
+    if (a)
+        mpp_frame_deinit(&a);
+    if (b)
+        mpp_frame_deinit(&b);
+
+    mpp_log("frame hash check %s\n", ret ? "failed" : "success");
+    return ret;
+}
+
+static MPP_RET frm_check_diff(MppBufferGroup grp, RK_U32 width, RK_U32 height)
+{
+    MPP_RET ret = MPP_OK;
+    MppFrame a = frm_check_alloc(grp, width, height, width, height);
+    MppFrame b = frm_check_alloc(grp, width, height, width + 64, height + 16);
+    MppFrame c = frm_check_alloc(grp, width / 2, height, width / 2, height);
+    FrmDiff diff;
+
+    FRM_CHECK_CHECK(a && b && c);
+
+    FRM_CHECK_CHECK(!calc_frm_diff(a, b, &diff));
+    FRM_CHECK_CHECK(diff.comp_cnt == 3);
+    FRM_CHECK_CHECK(!diff.sse[0] && !diff.sse[1] && !diff.sse[2]);
+    FRM_CHECK_CHECK(diff.pixel_cnt[0] == (RK_U64)width * height);
+    FRM_CHECK_CHECK(diff.pixel_cnt[1] == (RK_U64)width * height / 4);
+    FRM_CHECK_CHECK(diff.psnr_avg == 100.0);
+
+    /* one luma pixel in the last line, one u pixel and two v pixels */
+    frm_check_modify(b, 0, width - 1, height - 1, 10);
+    frm_check_modify(b, 1, 0, 0, 3);
+    frm_check_modify(b, 1, 1, 1, 2);
+    frm_check_modify(b, 1, width - 1, height / 2 - 1, 2);
+
+    FRM_CHECK_CHECK(!calc_frm_diff(a, b, &diff));
+    FRM_CHECK_CHECK(diff.sse[0] == 100 && diff.diff_cnt[0] == 1 && diff.max_diff[0] == 10);
+    FRM_CHECK_CHECK(diff.sse[1] == 9 && diff.diff_cnt[1] == 1 && diff.max_diff[1] == 3);
+    FRM_CHECK_CHECK(diff.sse[2] == 8 && diff.diff_cnt[2] == 2 && diff.max_diff[2] == 2);
+    FRM_CHECK_CHECK(diff.psnr[0] < 100.0 && diff.psnr_avg < 100.0);
+    show_frm_diff(&diff);
+
+    /* size mismatch is rejected */
+    FRM_CHECK_CHECK(calc_frm_diff(a, c, &diff));
+    FRM_CHECK_CHECK(calc_frm_diff(a, NULL, &diff));
+
+DONE:
+    if (a)
+        mpp_frame_deinit(&a);
+    if (b)
+        mpp_frame_deinit(&b);
+    if (c)
+        mpp_frame_deinit(&c);
+
+    mpp_log("frame diff check %dx%d %s\n", width, height, ret ? "failed" : "success");
+    return ret;
+}
+
+int main()
+{
+    MppBufferGroup grp = NULL;
+    MPP_RET ret = MPP_OK;
+
+    mpp_log("frame check test start\n");
+
+    mpp_buffer_group_get_internal(&grp, MPP_BUFFER_TYPE_NORMAL);
+    if (NULL == grp) {
+        mpp_err("failed to get buffer group\n");
+        return -1;
+    }
+
+    ret |= frm_check_hash(grp);
+    ret |= frm_check_diff(grp, 176, 144);
+    /* large frame runs on the worker threads */
+    ret |= frm_check_diff(grp, 3840, 2160);
+    frm_check_deinit();
+
+    /* workers are created again after teardown */
+    ret |= frm_check_diff(grp, 3840, 2160);
+    frm_check_deinit();
+
+    mpp_buffer_group_put(grp);
+
+    mpp_log("frame check test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -0,0 +1,1814 @@
+/*
+ * Copyright 2022 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpi_bench_test"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/resource.h>
+
+#include "rk_mpi.h"
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_debug.h"
+#include "mpp_common.h"
+#include "mpp_mem_pool.h"
+
+#include "mpp_bitread.h"
+#include "mpp_buf_slot.h"
+
+#include "mpp_opt.h"
+#include "utils.h"
+#include "mpi_dec_utils.h"
+
+#define BENCH_MAX_ITEM          8
+#define BENCH_FRM_BUF_CNT       4
+#define BENCH_MAX_TIMEOUT_CNT   100
+/* operations of one timed batch in micro benchmark */
+#define BENCH_BATCH_OPS         1024
+
+typedef enum BenchIoMode_e {
+    BENCH_IO_SYNC,          /* blocking put and get in one thread */
+    BENCH_IO_ASYNC,         /* non-blocking put with get in another thread */
+    BENCH_IO_TASK,          /* poll / dequeue / enqueue task interface */
+    BENCH_IO_BUTT,
+} BenchIoMode;
+
+typedef enum BenchStage_e {
+    BENCH_STAGE_PUT,        /* time spent in put call */
+    BENCH_STAGE_GET,        /* time spent in get call which returns output */
+    BENCH_STAGE_E2E,        /* from put start to output of the same pts */
+    BENCH_STAGE_OP,         /* one operation of micro benchmark */
+    BENCH_STAGE_BUTT,
+} BenchStage;
+
+typedef enum BenchMicro_e {
+    BENCH_MICRO_BITREAD,
+    BENCH_MICRO_SCAN,
+    BENCH_MICRO_SLOT,
+    BENCH_MICRO_BUFFER,
+    BENCH_MICRO_POOL,
+    BENCH_MICRO_BUTT,
+} BenchMicro;
+
+static const char *io_mode_names[BENCH_IO_BUTT] = {
+    "sync",
+    "async",
+    "task",
+};
+
+static const char *stage_names[BENCH_STAGE_BUTT] = {
+    "put",
+    "get",
+    "e2e",
+    "op",
+};
+
+static const char *micro_names[BENCH_MICRO_BUTT] = {
+    "bitread",
+    "scan",
+    "slot",
+    "buffer",
+    "pool",
+};
+
+typedef struct BenchCodec_t {
+    const char      *name;
+    MppCodingType   type;
+} BenchCodec;
+
+static BenchCodec bench_codecs[] = {
+    {   "h264",     MPP_VIDEO_CodingAVC,    },
+    {   "h265",     MPP_VIDEO_CodingHEVC,   },
+    {   "mjpeg",    MPP_VIDEO_CodingMJPEG,  },
+    {   "vp8",      MPP_VIDEO_CodingVP8,    },
+};
+
+typedef struct BenchSamples_t {
+    RK_S64          *val;
+    RK_S32          cnt;
+    RK_S32          max;
+} BenchSamples;
+
+/* percentiles in us for codec stage, in ns for micro benchmark operation */
+typedef struct BenchLatency_t {
+    RK_S32          cnt;
+    RK_S64          p50;
+    RK_S64          p90;
+    RK_S64          p99;
+    RK_S64          max;
+} BenchLatency;
+
+typedef struct BenchResult_t {
+    const char      *kind;
+    const char      *name;
+    const char      *mode;
+    RK_S32          width;
+    RK_S32          height;
+    RK_S32          channels;
+    const char      *status;
+
+    RK_S64          count;
+    double          fps;
+    double          wall_ms;
+    double          cpu_ms;
+    /* micro benchmark only */
+    double          ns_per_op;
+    double          mb_per_s;
+
+    BenchLatency    lat[BENCH_STAGE_BUTT];
+
+    /* mpp context buffer peak summed over channels */
+    RK_S64          mem_peak;
+    /* peak resident size in KB since the case start, -1 when unsupported */
+    RK_S64          rss_peak_kb;
+} BenchResult;
+
+/* one frame per packet stream captured from encoder for decoder cases */
+typedef struct BenchStream_t {
+    RK_S32          cnt;
+    RK_U8           **data;
+    size_t          *size;
+    size_t          max_size;
+} BenchStream;
+
+typedef struct BenchCmd_t {
+    RK_S32          enc;
+    RK_S32          dec;
+
+    RK_S32          codec_cnt;
+    RK_S32          codecs[BENCH_MAX_ITEM];
+    RK_S32          res_cnt;
+    RK_S32          widths[BENCH_MAX_ITEM];
+    RK_S32          heights[BENCH_MAX_ITEM];
+    RK_S32          chn_cnt;
+    RK_S32          chns[BENCH_MAX_ITEM];
+    RK_S32          mode_cnt;
+    RK_S32          modes[BENCH_MAX_ITEM];
+    RK_S32          micro_cnt;
+    RK_S32          micros[BENCH_MICRO_BUTT];
+
+    RK_S32          frames;
+    RK_S32          loops;
+    RK_S32          csv;
+    /* run codec cases on dummy hal for hosts without codec hardware */
+    RK_S32          dummy;
+    char            *file_out;
+    char            *tmp_dir;
+} BenchCmd;
+
+typedef struct BenchCase_t {
+    BenchCmd        *cmd;
+    RK_S32          dec;
+    MppCodingType   type;
+    BenchIoMode     mode;
+    RK_S32          width;
+    RK_S32          height;
+    RK_S32          hor_stride;
+    RK_S32          ver_stride;
+    RK_S32          frames;
+    /* decoder input or encoder capture target */
+    BenchStream     *stream;
+} BenchCase;
+
+typedef struct BenchChn_t {
+    BenchCase       *cs;
+    RK_S32          idx;
+    pthread_t       thd;
+    pthread_t       out_thd;
+
+    MppCtx          ctx;
+    MppApi          *mpi;
+    MppBufferGroup  grp;
+    MppBuffer       frm_bufs[BENCH_FRM_BUF_CNT];
+    MppBuffer       pkt_buf;
+    /* decoder task mode input buffers and output frame */
+    MppBuffer       *strm_bufs;
+    MppFrame        dec_frm;
+
+    /* put start time indexed by pts */
+    RK_S64          *put_time;
+    BenchSamples    samples[BENCH_STAGE_BUTT];
+    RK_S32          out_cnt;
+    RK_S32          out_eos;
+    RK_S32          capture;
+
+    MPP_RET         ret;
+    MppMemUsage     usage;
+} BenchChn;
+
+static RK_S64 get_cpu_time(void)
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    return (RK_S64)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+/*
+ * ru_maxrss is the peak of the whole process and never goes down, so the
+ * resident size watermark (VmHWM) is reset on each case start instead.
+ */
+static MPP_RET reset_rss_peak(void)
+{
+    FILE *fp = fopen("/proc/self/clear_refs", "w");
+    RK_S32 err;
+
+    if (NULL == fp)
+        return MPP_NOK;
+
+    /* 5 resets the watermark to current resident size */
+    err = fputs("5", fp) < 0;
+    err |= fclose(fp) != 0;
+
+    return err ? MPP_NOK : MPP_OK;
+}
+
+static RK_S64 get_rss_peak(MPP_RET reset)
+{
+    char line[128];
+    RK_S64 peak = -1;
+    FILE *fp;
+
+    if (reset)
+        return -1;
+
+    fp = fopen("/proc/self/status", "r");
+    if (NULL == fp)
+        return -1;
+
+    while (fgets(line, sizeof(line), fp)) {
+        if (!strncmp(line, "VmHWM:", 6)) {
+            peak = strtoll(line + 6, NULL, 10);
+            break;
+        }
+    }
+
+    fclose(fp);
+
+    return peak;
+}
+
+static MPP_RET samples_init(BenchSamples *s, RK_S32 max)
+{
+    s->val = mpp_calloc(RK_S64, max);
+    s->cnt = 0;
+    s->max = s->val ? max : 0;
+
+    return s->val ? MPP_OK : MPP_ERR_MALLOC;
+}
+
+static void samples_add(BenchSamples *s, RK_S64 val)
+{
+    if (s->cnt < s->max)
+        s->val[s->cnt++] = val;
+}
+
+static int cmp_s64(const void *a, const void *b)
+{
+    RK_S64 x = *(const RK_S64 *)a;
+    RK_S64 y = *(const RK_S64 *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void samples_calc(BenchSamples *s, BenchLatency *lat)
+{
+    memset(lat, 0, sizeof(*lat));
+
+    if (!s->cnt)
+        return;
+
+    qsort(s->val, s->cnt, sizeof(s->val[0]), cmp_s64);
+
+    lat->cnt = s->cnt;
+    lat->p50 = s->val[(s->cnt - 1) * 50 / 100];
+    lat->p90 = s->val[(s->cnt - 1) * 90 / 100];
+    lat->p99 = s->val[(s->cnt - 1) * 99 / 100];
+    lat->max = s->val[s->cnt - 1];
+}
+
+/* ------------------------------------------------------------------------
+ * result output
+ * ------------------------------------------------------------------------ */
+static void output_result(BenchCmd *cmd, FILE *fp, BenchResult *r, RK_S32 first)
+{
+    RK_S32 i;
+
+    /* silent run for decoder input capture */
+    if (NULL == fp)
+        return;
+
+    if (cmd->csv) {
+        if (first) {
+            fprintf(fp, "kind,name,mode,width,height,channels,status,count,fps,"
+                    "wall_ms,cpu_ms,ns_per_op,mb_per_s");
+            for (i = 0; i < BENCH_STAGE_BUTT; i++)
+                fprintf(fp, ",%s_p50,%s_p90,%s_p99,%s_max", stage_names[i],
+                        stage_names[i], stage_names[i], stage_names[i]);
+            fprintf(fp, ",mem_peak,rss_peak_kb\n");
+        }
+
+        fprintf(fp, "%s,%s,%s,%d,%d,%d,%s,%lld,%.2f,%.3f,%.3f,%.2f,%.2f",
+                r->kind, r->name, r->mode, r->width, r->height, r->channels,
+                r->status, r->count, r->fps, r->wall_ms, r->cpu_ms,
+                r->ns_per_op, r->mb_per_s);
+        for (i = 0; i < BENCH_STAGE_BUTT; i++)
+            fprintf(fp, ",%lld,%lld,%lld,%lld", r->lat[i].p50, r->lat[i].p90,
+                    r->lat[i].p99, r->lat[i].max);
+        fprintf(fp, ",%lld,%lld\n", r->mem_peak, r->rss_peak_kb);
+    } else {
+        fprintf(fp, "%s  {\"kind\": \"%s\", \"name\": \"%s\", \"mode\": \"%s\", "
+                "\"width\": %d, \"height\": %d, \"channels\": %d, "
+                "\"status\": \"%s\", \"count\": %lld, \"fps\": %.2f, "
+                "\"wall_ms\": %.3f, \"cpu_ms\": %.3f, "
+                "\"ns_per_op\": %.2f, \"mb_per_s\": %.2f, \"latency\": {",
+                first ? "" : ",\n", r->kind, r->name, r->mode,
+                r->width, r->height, r->channels, r->status, r->count, r->fps,
+                r->wall_ms, r->cpu_ms, r->ns_per_op, r->mb_per_s);
+        for (i = 0; i < BENCH_STAGE_BUTT; i++)
+            fprintf(fp, "%s\"%s\": {\"p50\": %lld, \"p90\": %lld, \"p99\": %lld, \"max\": %lld}",
+                    i ? ", " : "", stage_names[i], r->lat[i].p50, r->lat[i].p90,
+                    r->lat[i].p99, r->lat[i].max);
+        fprintf(fp, "}, \"mem_peak\": %lld, \"rss_peak_kb\": %lld}",
+                r->mem_peak, r->rss_peak_kb);
+    }
+
+    fflush(fp);
+}
+
+/* ------------------------------------------------------------------------
+ * micro benchmark
+ * ------------------------------------------------------------------------ */
+typedef struct BenchMicroCtx_t {
+    BenchCmd        *cmd;
+    RK_U8           *data;
+    RK_S32          size;
+} BenchMicroCtx;
+
+/* return processed bytes, batch samples are ns per operation */
+typedef RK_S64 (*BenchMicroFunc)(BenchMicroCtx *ctx, BenchSamples *s, RK_S64 *ops);
+
+static void batch_add(BenchSamples *s, RK_S64 start, RK_S32 ops)
+{
+    samples_add(s, (mpp_time() - start) * 1000 / ops);
+}
+
+static RK_S64 micro_bitread(BenchMicroCtx *ctx, BenchSamples *s, RK_S64 *ops)
+{
+    BitReadCtx_t bit;
+    RK_S64 bytes = 0;
+    RK_S32 loop;
+
+    for (loop = 0; loop < ctx->cmd->loops; loop++) {
+        RK_S32 done = 0;
+
+        mpp_set_bitread_ctx(&bit, ctx->data, ctx->size);
+        mpp_set_bitread_pseudo_code_type(&bit, PSEUDO_CODE_H264_H265);
+
+        while (!done) {
+            RK_S64 start = mpp_time();
+            RK_S32 i;
+
+            for (i = 0; i < BENCH_BATCH_OPS; i++) {
+                RK_U32 ue;
+                RK_S32 val;
+
+                /* mixed syntax elements as in slice header */
+                if (mpp_read_ue(&bit, &ue) || mpp_read_bits(&bit, 5, &val) ||
+                    mpp_read_bits(&bit, 1, &val)) {
+                    done = 1;
+                    break;
+                }
+            }
+
+            if (i) {
+                batch_add(s, start, i);
+                *ops += i;
+            }
+        }
+
+        bytes += ctx->size;
+    }
+
+    return bytes;
+}
+
+static RK_S64 micro_scan(BenchMicroCtx *ctx, BenchSamples *s, RK_S64 *ops)
+{
+    BenchCmd *cmd = ctx->cmd;
+    char name[256];
+    RK_S64 bytes = 0;
+    RK_S32 loop;
+    FILE *fp;
+
+    /* file reader splits mmapped stream into access units by start code scan */
+    mpp_env_set_u32("reader_mmap", 1);
+    snprintf(name, sizeof(name) - 1, "%s/mpi_bench_%d.h264", cmd->tmp_dir, getpid());
+
+    fp = fopen(name, "wb");
+    if (NULL == fp) {
+        mpp_err("failed to open %s\n", name);
+        return -1;
+    }
+    fwrite(ctx->data, 1, ctx->size, fp);
+    fclose(fp);
+
+    for (loop = 0; loop < cmd->loops; loop++) {
+        FileReader reader = NULL;
+        FileBufSlot *slot = NULL;
+        RK_S32 cnt = 0;
+        RK_S64 start = mpp_time();
+
+        /* split is done in reader thread, then the slots are counted */
+        reader_init(&reader, name);
+        if (NULL == reader)
+            break;
+
+        reader_sync(reader);
+        start = mpp_time() - start;
+
+        while (!reader_read(reader, &slot) && slot) {
+            cnt++;
+            if (slot->eos)
+                break;
+        }
+
+        reader_deinit(reader);
+
+        if (cnt)
+            samples_add(s, start * 1000 / cnt);
+
+        *ops += cnt;
+        bytes += ctx->size;
+    }
+
+    remove(name);
+
+    return bytes;
+}
+
+static RK_S64 micro_slot(BenchMicroCtx *ctx, BenchSamples *s, RK_S64 *ops)
+{
+    MppBufSlots slots = NULL;
+    RK_S32 total = ctx->cmd->loops * 64;
+    RK_S32 cnt;
+
+    if (mpp_buf_slot_init(&slots))
+        return -1;
+
+    mpp_buf_slot_setup(slots, 16);
+
+    for (cnt = 0; cnt < total; cnt++) {
+        RK_S64 start = mpp_time();
+        RK_S32 i;
+
+        /* decoder slot life cycle: decode, reference, display and release */
+        for (i = 0; i < BENCH_BATCH_OPS; i++) {
+            RK_S32 idx = -1;
+
+            mpp_buf_slot_get_unused(slots, &idx);
+            mpp_buf_slot_set_flag(slots, idx, SLOT_CODEC_USE);
+            mpp_buf_slot_set_flag(slots, idx, SLOT_HAL_OUTPUT);
+            mpp_buf_slot_set_flag(slots, idx, SLOT_QUEUE_USE);
+            mpp_buf_slot_enqueue(slots, idx, QUEUE_DISPLAY);
+            mpp_buf_slot_clr_flag(slots, idx, SLOT_HAL_OUTPUT);
+            mpp_buf_slot_dequeue(slots, &idx, QUEUE_DISPLAY);
+            mpp_buf_slot_clr_flag(slots, idx, SLOT_QUEUE_USE);
+            mpp_buf_slot_clr_flag(slots, idx, SLOT_CODEC_USE);
+        }
+
+        batch_add(s, start, BENCH_BATCH_OPS);
+    }
+
+    mpp_buf_slot_deinit(slots);
+
+    *ops += (RK_S64)total * BENCH_BATCH_OPS;
+
+    return 0;
+}
+
+static RK_S64 micro_buffer(BenchMicroCtx *ctx, BenchSamples *s, RK_S64 *ops)
+{
+    static const size_t sizes[] = { SZ_4K, SZ_64K, SZ_1M, SZ_4K * 1000 };
+    MppBufferGroup grp = NULL;
+    RK_S32 total = ctx->cmd->loops * 16;
+    RK_S64 bytes = 0;
+    RK_S32 cnt;
+
+    if (mpp_buffer_group_get_internal(&grp, MPP_BUFFER_TYPE_NORMAL))
+        return -1;
+
+    for (cnt = 0; cnt < total; cnt++) {
+        RK_S64 start = mpp_time();
+        RK_S32 i;
+
+        for (i = 0; i < BENCH_BATCH_OPS; i++) {
+            size_t size = sizes[i % MPP_ARRAY_ELEMS(sizes)];
+            MppBuffer buf = NULL;
+
+            mpp_buffer_get(grp, &buf, size);
+            if (NULL == buf) {
+                mpp_buffer_group_put(grp);
+                return -1;
+            }
+
+            mpp_buffer_put(buf);
+            bytes += size;
+        }
+
+        batch_add(s, start, BENCH_BATCH_OPS);
+    }
+
+    mpp_buffer_group_put(grp);
+
+    *ops += (RK_S64)total * BENCH_BATCH_OPS;
+
+    return bytes;
+}
+
+static RK_S64 micro_pool(BenchMicroCtx *ctx, BenchSamples *s, RK_S64 *ops)
+{
+    MppMemPool pool = mpp_mem_pool_init(256);
+    void *ptrs[16];
+    RK_S32 total = ctx->cmd->loops * 64;
+    RK_S32 cnt;
+
+    if (NULL == pool)
+        return -1;
+
+    for (cnt = 0; cnt < total; cnt++) {
+        RK_S64 start = mpp_time();
+        RK_S32 i, j;
+
+        for (i = 0; i < BENCH_BATCH_OPS; i += MPP_ARRAY_ELEMS(ptrs)) {
+            for (j = 0; j < (RK_S32)MPP_ARRAY_ELEMS(ptrs); j++)
+                ptrs[j] = mpp_mem_pool_get(pool);
+            for (j = 0; j < (RK_S32)MPP_ARRAY_ELEMS(ptrs); j++)
+                mpp_mem_pool_put(pool, ptrs[j]);
+        }
+
+        batch_add(s, start, BENCH_BATCH_OPS);
+    }
+
+    mpp_mem_pool_deinit(pool);
+
+    *ops += (RK_S64)total * BENCH_BATCH_OPS;
+
+    return 0;
+}
+
+static BenchMicroFunc micro_funcs[BENCH_MICRO_BUTT] = {
+    micro_bitread,
+    micro_scan,
+    micro_slot,
+    micro_buffer,
+    micro_pool,
+};
+
+/* annex-b avc stream with random payload for bit reader and start code scan */
+static RK_U8 *gen_micro_stream(RK_S32 size)
+{
+    RK_U8 *buf = mpp_malloc(RK_U8, size);
+    RK_U32 seed = 0x12345678;
+    RK_S32 frm_idx = 0;
+    RK_S32 pos = 0;
+
+    if (NULL == buf)
+        return NULL;
+
+    while (pos < size) {
+        RK_S32 idr = !(frm_idx % 30);
+        RK_S32 k;
+
+        /* sps before idr slice then one slice per frame */
+        for (k = idr ? 0 : 1; k < 2; k++) {
+            RK_S32 end;
+
+            seed = seed * 1103515245 + 12345;
+            end = MPP_MIN(size, pos + 6 + (k ? 512 + (RK_S32)((seed >> 16) % 8192) : 16));
+            /* tail shorter than a nal header */
+            if (pos + 6 > end) {
+                memset(buf + pos, 0xff, size - pos);
+                return buf;
+            }
+
+            buf[pos++] = 0;
+            buf[pos++] = 0;
+            buf[pos++] = 0;
+            buf[pos++] = 1;
+            buf[pos++] = k ? (idr ? 0x65 : 0x41) : 0x67;
+            /* first_mb_in_slice 0 starts a new access unit */
+            buf[pos++] = 0x80 | (seed >> 25);
+
+            /* no zero byte in payload avoids emulation prevention */
+            while (pos < end) {
+                seed = seed * 1103515245 + 12345;
+                buf[pos++] = (seed >> 24) | 1;
+            }
+        }
+
+        frm_idx++;
+    }
+
+    return buf;
+}
+
+static void run_micro(BenchCmd *cmd, BenchMicro idx, FILE *fp, RK_S32 *first)
+{
+    BenchMicroCtx ctx;
+    BenchSamples s;
+    BenchResult r;
+    RK_S64 ops = 0;
+    RK_S64 bytes;
+    RK_S64 wall;
+    RK_S64 cpu;
+    MPP_RET rss = reset_rss_peak();
+
+    memset(&r, 0, sizeof(r));
+    r.kind = "micro";
+    r.name = micro_names[idx];
+    r.mode = "-";
+    r.channels = 1;
+
+    ctx.cmd = cmd;
+    ctx.size = 8 * SZ_1M;
+    ctx.data = gen_micro_stream(ctx.size);
+    if (NULL == ctx.data || samples_init(&s, cmd->loops * 16384)) {
+        MPP_FREE(ctx.data);
+        return;
+    }
+
+    wall = mpp_time();
+    cpu = get_cpu_time();
+
+    bytes = micro_funcs[idx](&ctx, &s, &ops);
+
+    wall = mpp_time() - wall;
+    cpu = get_cpu_time() - cpu;
+
+    r.status = bytes < 0 ? "fail" : "ok";
+    r.count = ops;
+    r.wall_ms = wall / 1000.0;
+    r.cpu_ms = cpu / 1000.0;
+    if (ops)
+        r.ns_per_op = wall * 1000.0 / ops;
+    if (bytes > 0 && wall)
+        r.mb_per_s = (double)bytes / wall;
+    samples_calc(&s, &r.lat[BENCH_STAGE_OP]);
+    r.rss_peak_kb = get_rss_peak(rss);
+
+    output_result(cmd, fp, &r, *first);
+    *first = 0;
+
+    MPP_FREE(s.val);
+    MPP_FREE(ctx.data);
+}
+
+/* ------------------------------------------------------------------------
+ * codec benchmark
+ * ------------------------------------------------------------------------ */
+static void stream_deinit(BenchStream *strm)
+{
+    RK_S32 i;
+
+    if (NULL == strm)
+        return;
+
+    for (i = 0; i < strm->cnt; i++)
+        MPP_FREE(strm->data[i]);
+
+    MPP_FREE(strm->data);
+    MPP_FREE(strm->size);
+    strm->cnt = 0;
+    strm->max_size = 0;
+}
+
+static void stream_add(BenchStream *strm, MppPacket pkt, RK_S32 max)
+{
+    size_t len = mpp_packet_get_length(pkt);
+
+    if (NULL == strm->data) {
+        strm->data = mpp_calloc(RK_U8 *, max);
+        strm->size = mpp_calloc(size_t, max);
+        if (NULL == strm->data || NULL == strm->size)
+            return;
+    }
+
+    if (strm->cnt >= max || !len)
+        return;
+
+    strm->data[strm->cnt] = mpp_malloc(RK_U8, len);
+    if (NULL == strm->data[strm->cnt])
+        return;
+
+    memcpy(strm->data[strm->cnt], mpp_packet_get_pos(pkt), len);
+    strm->size[strm->cnt] = len;
+    strm->max_size = MPP_MAX(strm->max_size, len);
+    strm->cnt++;
+}
+
+/* record output of pts and return 1 on eos */
+static RK_S32 chn_output(BenchChn *chn, RK_S64 pts, RK_S64 start, RK_S64 end, RK_S32 eos)
+{
+    if (pts >= 0 && pts < chn->cs->frames) {
+        samples_add(&chn->samples[BENCH_STAGE_E2E], end - chn->put_time[pts]);
+        chn->out_cnt++;
+    }
+
+    if (start)
+        samples_add(&chn->samples[BENCH_STAGE_GET], end - start);
+
+    if (eos)
+        chn->out_eos = 1;
+
+    return eos;
+}
+
+static MPP_RET enc_chn_cfg(BenchChn *chn)
+{
+    BenchCase *cs = chn->cs;
+    MppEncCfg cfg = NULL;
+    MppEncHeaderMode header_mode = MPP_ENC_HEADER_MODE_EACH_IDR;
+    MPP_RET ret;
+
+    if (mpp_enc_cfg_init(&cfg))
+        return MPP_NOK;
+
+    mpp_enc_cfg_set_s32(cfg, "prep:width", cs->width);
+    mpp_enc_cfg_set_s32(cfg, "prep:height", cs->height);
+    mpp_enc_cfg_set_s32(cfg, "prep:hor_stride", cs->hor_stride);
+    mpp_enc_cfg_set_s32(cfg, "prep:ver_stride", cs->ver_stride);
+    mpp_enc_cfg_set_s32(cfg, "prep:format", MPP_FMT_YUV420SP);
+
+    mpp_enc_cfg_set_s32(cfg, "rc:fps_in_num", 30);
+    mpp_enc_cfg_set_s32(cfg, "rc:fps_in_denorm", 1);
+    mpp_enc_cfg_set_s32(cfg, "rc:fps_out_num", 30);
+    mpp_enc_cfg_set_s32(cfg, "rc:fps_out_denorm", 1);
+    mpp_enc_cfg_set_s32(cfg, "rc:gop", 60);
+    mpp_enc_cfg_set_u32(cfg, "rc:drop_mode", MPP_ENC_RC_DROP_FRM_DISABLED);
+
+    if (cs->type == MPP_VIDEO_CodingMJPEG) {
+        mpp_enc_cfg_set_s32(cfg, "rc:mode", MPP_ENC_RC_MODE_FIXQP);
+        mpp_enc_cfg_set_s32(cfg, "jpeg:q_factor", 80);
+        mpp_enc_cfg_set_s32(cfg, "jpeg:qf_max", 99);
+        mpp_enc_cfg_set_s32(cfg, "jpeg:qf_min", 1);
+    } else {
+        RK_S32 bps = cs->width * cs->height / 8 * 30;
+
+        mpp_enc_cfg_set_s32(cfg, "rc:mode", MPP_ENC_RC_MODE_CBR);
+        mpp_enc_cfg_set_s32(cfg, "rc:bps_target", bps);
+        mpp_enc_cfg_set_s32(cfg, "rc:bps_max", bps * 17 / 16);
+        mpp_enc_cfg_set_s32(cfg, "rc:bps_min", bps * 15 / 16);
+
+        if (cs->type == MPP_VIDEO_CodingVP8) {
+            mpp_enc_cfg_set_s32(cfg, "rc:qp_init", 40);
+            mpp_enc_cfg_set_s32(cfg, "rc:qp_max", 127);
+            mpp_enc_cfg_set_s32(cfg, "rc:qp_min", 0);
+            mpp_enc_cfg_set_s32(cfg, "rc:qp_max_i", 127);
+            mpp_enc_cfg_set_s32(cfg, "rc:qp_min_i", 0);
+            mpp_enc_cfg_set_s32(cfg, "rc:qp_ip", 6);
+        }
+    }
+
+    mpp_enc_cfg_set_s32(cfg, "codec:type", cs->type);
+
+    ret = chn->mpi->control(chn->ctx, MPP_ENC_SET_CFG, cfg);
+    mpp_enc_cfg_deinit(cfg);
+    if (ret)
+        return ret;
+
+    /* packets of idr frame carry parameter sets for decoder case */
+    if (cs->type == MPP_VIDEO_CodingAVC || cs->type == MPP_VIDEO_CodingHEVC)
+        ret = chn->mpi->control(chn->ctx, MPP_ENC_SET_HEADER_MODE, &header_mode);
+
+    return ret;
+}
+
+static MPP_RET enc_chn_init(BenchChn *chn)
+{
+    BenchCase *cs = chn->cs;
+    size_t frm_size = cs->hor_stride * cs->ver_stride * 3 / 2;
+    RK_S64 in_timeout = cs->mode == BENCH_IO_ASYNC ? MPP_POLL_NON_BLOCK : MPP_POLL_BLOCK;
+    RK_S64 out_timeout = MPP_POLL_BLOCK;
+    RK_S32 i;
+
+    chn->mpi->control(chn->ctx, MPP_SET_INPUT_TIMEOUT, &in_timeout);
+    chn->mpi->control(chn->ctx, MPP_SET_OUTPUT_TIMEOUT, &out_timeout);
+
+    if (mpp_init(chn->ctx, MPP_CTX_ENC, cs->type))
+        return MPP_NOK;
+
+    if (enc_chn_cfg(chn))
+        return MPP_ERR_VALUE;
+
+    if (mpp_buffer_group_get_internal(&chn->grp, MPP_BUFFER_TYPE_DRM))
+        return MPP_ERR_NOMEM;
+
+    /* input pictures are generated before timing */
+    for (i = 0; i < BENCH_FRM_BUF_CNT; i++) {
+        if (mpp_buffer_get(chn->grp, &chn->frm_bufs[i], frm_size))
+            return MPP_ERR_NOMEM;
+
+        fill_image((RK_U8 *)mpp_buffer_get_ptr(chn->frm_bufs[i]), cs->width,
+                   cs->height, cs->hor_stride, cs->ver_stride, MPP_FMT_YUV420SP, i);
+    }
+
+    if (cs->mode == BENCH_IO_TASK &&
+        mpp_buffer_get(chn->grp, &chn->pkt_buf, frm_size))
+        return MPP_ERR_NOMEM;
+
+    return MPP_OK;
+}
+
+static MppFrame enc_get_frame(BenchChn *chn, RK_S32 idx)
+{
+    BenchCase *cs = chn->cs;
+    MppFrame frame = NULL;
+
+    if (mpp_frame_init(&frame))
+        return NULL;
+
+    mpp_frame_set_width(frame, cs->width);
+    mpp_frame_set_height(frame, cs->height);
+    mpp_frame_set_hor_stride(frame, cs->hor_stride);
+    mpp_frame_set_ver_stride(frame, cs->ver_stride);
+    mpp_frame_set_fmt(frame, MPP_FMT_YUV420SP);
+    mpp_frame_set_buffer(frame, chn->frm_bufs[idx % BENCH_FRM_BUF_CNT]);
+    mpp_frame_set_pts(frame, idx);
+    mpp_frame_set_eos(frame, idx == cs->frames - 1);
+
+    return frame;
+}
+
+static RK_S32 enc_put_packet(BenchChn *chn, MppPacket pkt, RK_S64 start)
+{
+    RK_S64 end = mpp_time();
+    RK_S64 pts = mpp_packet_get_pts(pkt);
+    RK_S32 eos = mpp_packet_get_eos(pkt);
+
+    if (chn->capture)
+        stream_add(chn->cs->stream, pkt, chn->cs->frames);
+
+    mpp_packet_deinit(&pkt);
+
+    return chn_output(chn, pts, start, end, eos);
+}
+
+static void *enc_output_thread(void *arg)
+{
+    BenchChn *chn = (BenchChn *)arg;
+    RK_S32 timeout = 0;
+
+    while (!chn->out_eos && timeout < BENCH_MAX_TIMEOUT_CNT) {
+        MppPacket pkt = NULL;
+        RK_S64 start = mpp_time();
+
+        if (chn->mpi->encode_get_packet(chn->ctx, &pkt) || NULL == pkt) {
+            timeout++;
+            msleep(1);
+            continue;
+        }
+
+        timeout = 0;
+        enc_put_packet(chn, pkt, start);
+    }
+
+    return NULL;
+}
+
+static MPP_RET enc_task_once(BenchChn *chn, MppFrame frame, RK_S64 *put)
+{
+    MppCtx ctx = chn->ctx;
+    MppApi *mpi = chn->mpi;
+    MppPacket pkt = NULL;
+    MppTask task = NULL;
+    RK_S64 start = mpp_time();
+    MPP_RET ret;
+
+    mpp_packet_init_with_buffer(&pkt, chn->pkt_buf);
+    mpp_packet_set_length(pkt, 0);
+
+    ret = mpi->poll(ctx, MPP_PORT_INPUT, MPP_POLL_BLOCK);
+    if (!ret)
+        ret = mpi->dequeue(ctx, MPP_PORT_INPUT, &task);
+    if (ret || NULL == task) {
+        mpp_packet_deinit(&pkt);
+        return MPP_NOK;
+    }
+
+    mpp_task_meta_set_frame(task, KEY_INPUT_FRAME, frame);
+    mpp_task_meta_set_packet(task, KEY_OUTPUT_PACKET, pkt);
+
+    ret = mpi->enqueue(ctx, MPP_PORT_INPUT, task);
+    *put = mpp_time() - start;
+    if (ret)
+        return ret;
+
+    start = mpp_time();
+    ret = mpi->poll(ctx, MPP_PORT_OUTPUT, MPP_POLL_BLOCK);
+    if (!ret)
+        ret = mpi->dequeue(ctx, MPP_PORT_OUTPUT, &task);
+    if (ret || NULL == task)
+        return MPP_NOK;
+
+    pkt = NULL;
+    mpp_task_meta_get_packet(task, KEY_OUTPUT_PACKET, &pkt);
+    ret = mpi->enqueue(ctx, MPP_PORT_OUTPUT, task);
+
+    if (pkt)
+        enc_put_packet(chn, pkt, start);
+
+    return ret;
+}
+
+static void enc_chn_run(BenchChn *chn)
+{
+    BenchCase *cs = chn->cs;
+    RK_S32 i;
+
+    if (cs->mode == BENCH_IO_ASYNC)
+        pthread_create(&chn->out_thd, NULL, enc_output_thread, chn);
+
+    for (i = 0; i < cs->frames && !chn->ret; i++) {
+        MppFrame frame = enc_get_frame(chn, i);
+        RK_S64 start = mpp_time();
+        RK_S64 put = 0;
+
+        if (NULL == frame) {
+            chn->ret = MPP_ERR_MALLOC;
+            break;
+        }
+
+        chn->put_time[i] = start;
+
+        switch (cs->mode) {
+        case BENCH_IO_SYNC : {
+            MppPacket pkt = NULL;
+
+            chn->ret = chn->mpi->encode_put_frame(chn->ctx, frame);
+            put = mpp_time() - start;
+            if (chn->ret)
+                break;
+
+            start = mpp_time();
+            chn->ret = chn->mpi->encode_get_packet(chn->ctx, &pkt);
+            if (pkt)
+                enc_put_packet(chn, pkt, start);
+        } break;
+        case BENCH_IO_ASYNC : {
+            /* queue full is not counted as put latency */
+            while (chn->mpi->encode_put_frame(chn->ctx, frame)) {
+                msleep(1);
+                start = mpp_time();
+            }
+            put = mpp_time() - start;
+        } break;
+        case BENCH_IO_TASK : {
+            chn->ret = enc_task_once(chn, frame, &put);
+        } break;
+        default : {
+        } break;
+        }
+
+        samples_add(&chn->samples[BENCH_STAGE_PUT], put);
+        mpp_frame_deinit(&frame);
+    }
+
+    if (cs->mode == BENCH_IO_ASYNC)
+        pthread_join(chn->out_thd, NULL);
+}
+
+static MPP_RET dec_chn_init(BenchChn *chn)
+{
+    BenchCase *cs = chn->cs;
+    BenchStream *strm = cs->stream;
+    RK_S64 out_timeout = cs->mode == BENCH_IO_ASYNC ? 100 : MPP_POLL_NON_BLOCK;
+    RK_U32 split = 0;
+    RK_S32 i;
+
+    /* jpeg decoder only works frame in frame out on task interface */
+    if ((cs->type == MPP_VIDEO_CodingMJPEG) != (cs->mode == BENCH_IO_TASK))
+        return MPP_NOK;
+
+    if (cs->mode == BENCH_IO_TASK) {
+        MppBuffer buf = NULL;
+
+        out_timeout = MPP_POLL_BLOCK;
+
+        if (mpp_buffer_group_get_internal(&chn->grp, MPP_BUFFER_TYPE_DRM))
+            return MPP_NOK;
+
+        chn->strm_bufs = mpp_calloc(MppBuffer, strm->cnt);
+        if (NULL == chn->strm_bufs)
+            return MPP_NOK;
+
+        for (i = 0; i < strm->cnt; i++) {
+            if (mpp_buffer_get(chn->grp, &chn->strm_bufs[i], strm->size[i]))
+                return MPP_NOK;
+
+            memcpy(mpp_buffer_get_ptr(chn->strm_bufs[i]), strm->data[i], strm->size[i]);
+        }
+
+        /* jpeg output in yuv422 at most */
+        if (mpp_buffer_get(chn->grp, &buf, cs->hor_stride * cs->ver_stride * 2) ||
+            mpp_frame_init(&chn->dec_frm))
+            return MPP_NOK;
+
+        mpp_frame_set_buffer(chn->dec_frm, buf);
+        mpp_buffer_put(buf);
+    }
+
+    chn->mpi->control(chn->ctx, MPP_SET_OUTPUT_TIMEOUT, &out_timeout);
+
+    /* input packets are already one frame each */
+    chn->mpi->control(chn->ctx, MPP_DEC_SET_PARSER_SPLIT_MODE, &split);
+
+    if (mpp_init(chn->ctx, MPP_CTX_DEC, cs->type))
+        return MPP_NOK;
+
+    return MPP_OK;
+}
+
+/* return 1 when frame is consumed as output */
+static RK_S32 dec_put_frame(BenchChn *chn, MppFrame frame, RK_S64 start)
+{
+    RK_S64 end = mpp_time();
+    RK_S32 eos = mpp_frame_get_eos(frame);
+    RK_S32 ret = 0;
+
+    if (mpp_frame_get_info_change(frame)) {
+        chn->mpi->control(chn->ctx, MPP_DEC_SET_INFO_CHANGE_READY, NULL);
+    } else if (mpp_frame_get_buffer(frame)) {
+        chn_output(chn, mpp_frame_get_pts(frame), start, end, eos);
+        ret = 1;
+    } else if (eos) {
+        chn_output(chn, -1, 0, end, eos);
+    }
+
+    mpp_frame_deinit(&frame);
+
+    return ret;
+}
+
+static void dec_get_frames(BenchChn *chn)
+{
+    while (!chn->out_eos) {
+        MppFrame frame = NULL;
+        RK_S64 start = mpp_time();
+
+        if (chn->mpi->decode_get_frame(chn->ctx, &frame) || NULL == frame)
+            break;
+
+        dec_put_frame(chn, frame, start);
+    }
+}
+
+static void *dec_output_thread(void *arg)
+{
+    BenchChn *chn = (BenchChn *)arg;
+    RK_S32 timeout = 0;
+
+    while (!chn->out_eos && timeout < BENCH_MAX_TIMEOUT_CNT) {
+        MppFrame frame = NULL;
+        RK_S64 start = mpp_time();
+
+        if (chn->mpi->decode_get_frame(chn->ctx, &frame) || NULL == frame) {
+            timeout++;
+            continue;
+        }
+
+        timeout = 0;
+        dec_put_frame(chn, frame, start);
+    }
+
+    return NULL;
+}
+
+static MPP_RET dec_task_once(BenchChn *chn, MppPacket pkt, RK_S64 *put)
+{
+    MppCtx ctx = chn->ctx;
+    MppApi *mpi = chn->mpi;
+    MppFrame frame = NULL;
+    MppTask task = NULL;
+    RK_S64 start = mpp_time();
+    MPP_RET ret;
+
+    ret = mpi->poll(ctx, MPP_PORT_INPUT, MPP_POLL_BLOCK);
+    if (!ret)
+        ret = mpi->dequeue(ctx, MPP_PORT_INPUT, &task);
+    if (ret || NULL == task)
+        return MPP_NOK;
+
+    mpp_task_meta_set_packet(task, KEY_INPUT_PACKET, pkt);
+    mpp_task_meta_set_frame(task, KEY_OUTPUT_FRAME, chn->dec_frm);
+
+    ret = mpi->enqueue(ctx, MPP_PORT_INPUT, task);
+    *put = mpp_time() - start;
+    if (ret)
+        return ret;
+
+    start = mpp_time();
+    ret = mpi->poll(ctx, MPP_PORT_OUTPUT, MPP_POLL_BLOCK);
+    if (!ret)
+        ret = mpi->dequeue(ctx, MPP_PORT_OUTPUT, &task);
+    if (ret || NULL == task)
+        return MPP_NOK;
+
+    mpp_task_meta_get_frame(task, KEY_OUTPUT_FRAME, &frame);
+    if (frame)
+        chn_output(chn, mpp_packet_get_pts(pkt), start, mpp_time(),
+                   mpp_packet_get_eos(pkt));
+
+    ret = mpi->enqueue(ctx, MPP_PORT_OUTPUT, task);
+
+    /* take back the input task to release the packet */
+    if (!mpi->poll(ctx, MPP_PORT_INPUT, MPP_POLL_BLOCK)) {
+        task = NULL;
+        mpi->dequeue(ctx, MPP_PORT_INPUT, &task);
+        if (task)
+            mpi->enqueue(ctx, MPP_PORT_INPUT, task);
+    }
+
+    return ret;
+}
+
+static void dec_chn_run(BenchChn *chn)
+{
+    BenchCase *cs = chn->cs;
+    BenchStream *strm = cs->stream;
+    RK_S32 timeout = 0;
+    RK_S32 i;
+
+    if (cs->mode == BENCH_IO_ASYNC)
+        pthread_create(&chn->out_thd, NULL, dec_output_thread, chn);
+
+    for (i = 0; i < strm->cnt && !chn->ret; i++) {
+        MppPacket pkt = NULL;
+        RK_S64 start;
+        RK_S64 put = 0;
+
+        if (cs->mode == BENCH_IO_TASK)
+            mpp_packet_init_with_buffer(&pkt, chn->strm_bufs[i]);
+        else
+            mpp_packet_init(&pkt, strm->data[i], strm->size[i]);
+
+        mpp_packet_set_length(pkt, strm->size[i]);
+        mpp_packet_set_pts(pkt, i);
+        if (i == strm->cnt - 1)
+            mpp_packet_set_eos(pkt);
+
+        start = mpp_time();
+        chn->put_time[i] = start;
+
+        if (cs->mode == BENCH_IO_TASK) {
+            chn->ret = dec_task_once(chn, pkt, &put);
+        } else {
+            /* input queue full is not counted as put latency */
+            while (chn->mpi->decode_put_packet(chn->ctx, pkt)) {
+                if (cs->mode == BENCH_IO_SYNC)
+                    dec_get_frames(chn);
+                msleep(1);
+                start = mpp_time();
+            }
+            put = mpp_time() - start;
+
+            if (cs->mode == BENCH_IO_SYNC)
+                dec_get_frames(chn);
+        }
+
+        samples_add(&chn->samples[BENCH_STAGE_PUT], put);
+        mpp_packet_deinit(&pkt);
+    }
+
+    if (cs->mode == BENCH_IO_SYNC) {
+        while (!chn->out_eos && timeout < BENCH_MAX_TIMEOUT_CNT) {
+            RK_S32 cnt = chn->out_cnt;
+
+            dec_get_frames(chn);
+            if (cnt == chn->out_cnt) {
+                timeout++;
+                msleep(1);
+            }
+        }
+    } else if (cs->mode == BENCH_IO_ASYNC) {
+        pthread_join(chn->out_thd, NULL);
+    }
+}
+
+static void *chn_thread(void *arg)
+{
+    BenchChn *chn = (BenchChn *)arg;
+
+    if (chn->cs->dec)
+        dec_chn_run(chn);
+    else
+        enc_chn_run(chn);
+
+    chn->mpi->reset(chn->ctx);
+
+    return NULL;
+}
+
+static MPP_RET chn_init(BenchChn *chn, BenchCase *cs, RK_S32 idx)
+{
+    RK_S32 frames = cs->dec ? cs->stream->cnt : cs->frames;
+    RK_S32 i;
+
+    chn->cs = cs;
+    chn->idx = idx;
+
+    chn->put_time = mpp_calloc(RK_S64, frames);
+    if (NULL == chn->put_time)
+        return MPP_ERR_MALLOC;
+
+    for (i = 0; i < BENCH_STAGE_BUTT; i++) {
+        if (samples_init(&chn->samples[i], frames + 1))
+            return MPP_ERR_MALLOC;
+    }
+
+    if (mpp_create(&chn->ctx, &chn->mpi))
+        return MPP_NOK;
+
+    return cs->dec ? dec_chn_init(chn) : enc_chn_init(chn);
+}
+
+static void chn_deinit(BenchChn *chn)
+{
+    RK_S32 i;
+
+    if (chn->ctx) {
+        chn->mpi->control(chn->ctx, MPP_GET_MEM_USAGE, &chn->usage);
+        mpp_destroy(chn->ctx);
+        chn->ctx = NULL;
+    }
+
+    for (i = 0; i < BENCH_FRM_BUF_CNT; i++) {
+        if (chn->frm_bufs[i])
+            mpp_buffer_put(chn->frm_bufs[i]);
+    }
+
+    if (chn->pkt_buf)
+        mpp_buffer_put(chn->pkt_buf);
+
+    if (chn->strm_bufs) {
+        for (i = 0; i < chn->cs->stream->cnt; i++) {
+            if (chn->strm_bufs[i])
+                mpp_buffer_put(chn->strm_bufs[i]);
+        }
+        MPP_FREE(chn->strm_bufs);
+    }
+
+    if (chn->dec_frm)
+        mpp_frame_deinit(&chn->dec_frm);
+
+    if (chn->grp)
+        mpp_buffer_group_put(chn->grp);
+
+    for (i = 0; i < BENCH_STAGE_BUTT; i++)
+        MPP_FREE(chn->samples[i].val);
+
+    MPP_FREE(chn->put_time);
+}
+
+static void run_case(BenchCase *cs, RK_S32 chn_cnt, FILE *fp, RK_S32 *first)
+{
+    BenchChn *chns = mpp_calloc(BenchChn, chn_cnt);
+    BenchSamples merge[BENCH_STAGE_BUTT];
+    BenchResult r;
+    RK_S64 wall = 0;
+    RK_S64 cpu = 0;
+    RK_S32 i, j;
+    MPP_RET rss = reset_rss_peak();
+
+    memset(&r, 0, sizeof(r));
+    memset(merge, 0, sizeof(merge));
+    r.kind = cs->dec ? "dec" : "enc";
+    r.mode = io_mode_names[cs->mode];
+    r.width = cs->width;
+    r.height = cs->height;
+    r.channels = chn_cnt;
+    r.status = "ok";
+
+    for (i = 0; i < (RK_S32)MPP_ARRAY_ELEMS(bench_codecs); i++) {
+        if (bench_codecs[i].type == cs->type)
+            r.name = bench_codecs[i].name;
+    }
+
+    if (NULL == chns) {
+        r.status = "fail";
+        goto DONE;
+    }
+
+    if (cs->dec && !cs->stream->cnt) {
+        r.status = "skip";
+        goto DONE;
+    }
+
+    for (i = 0; i < chn_cnt; i++) {
+        MPP_RET ret = chn_init(&chns[i], cs, i);
+
+        if (ret) {
+            /* unsupported codec, io mode or platform */
+            r.status = (ret == MPP_NOK) ? "skip" : "fail";
+            chn_cnt = i + 1;
+            goto DONE;
+        }
+    }
+
+    /* the first encoder run of each codec and size provides decoder input */
+    if (!cs->dec && !cs->stream->cnt)
+        chns[0].capture = 1;
+
+    wall = mpp_time();
+    cpu = get_cpu_time();
+
+    for (i = 0; i < chn_cnt; i++)
+        pthread_create(&chns[i].thd, NULL, chn_thread, &chns[i]);
+
+    for (i = 0; i < chn_cnt; i++) {
+        pthread_join(chns[i].thd, NULL);
+        if (chns[i].ret || !chns[i].out_eos)
+            r.status = "fail";
+    }
+
+    wall = mpp_time() - wall;
+    cpu = get_cpu_time() - cpu;
+
+    for (i = 0; i < BENCH_STAGE_BUTT; i++) {
+        if (samples_init(&merge[i], chn_cnt * (cs->frames + 1)))
+            break;
+
+        for (j = 0; j < chn_cnt; j++) {
+            BenchSamples *s = &chns[j].samples[i];
+
+            memcpy(merge[i].val + merge[i].cnt, s->val, s->cnt * sizeof(s->val[0]));
+            merge[i].cnt += s->cnt;
+        }
+
+        samples_calc(&merge[i], &r.lat[i]);
+        MPP_FREE(merge[i].val);
+    }
+
+    for (i = 0; i < chn_cnt; i++)
+        r.count += chns[i].out_cnt;
+
+    r.wall_ms = wall / 1000.0;
+    r.cpu_ms = cpu / 1000.0;
+    if (wall)
+        r.fps = r.count * 1000000.0 / wall;
+
+DONE:
+    for (i = 0; chns && i < chn_cnt; i++) {
+        chn_deinit(&chns[i]);
+        r.mem_peak += chns[i].usage.total_max;
+    }
+
+    /* drop partial capture of failed case */
+    if (!cs->dec && strcmp(r.status, "ok"))
+        stream_deinit(cs->stream);
+
+    r.rss_peak_kb = get_rss_peak(rss);
+
+    output_result(cs->cmd, fp, &r, *first);
+    if (fp)
+        *first = 0;
+
+    MPP_FREE(chns);
+}
+
+/* ------------------------------------------------------------------------
+ * command line
+ * ------------------------------------------------------------------------ */
+typedef RK_S32 (*BenchParseItem)(BenchCmd *cmd, const char *item, RK_S32 idx);
+
+/* split comma separated list and return item count */
+static RK_S32 parse_list(BenchCmd *cmd, const char *next, BenchParseItem func, RK_S32 max)
+{
+    char buf[256];
+    char *item;
+    char *save = NULL;
+    RK_S32 cnt = 0;
+
+    if (NULL == next)
+        return 0;
+
+    strncpy(buf, next, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+
+    for (item = strtok_r(buf, ",", &save); item && cnt < max;
+         item = strtok_r(NULL, ",", &save)) {
+        if (func(cmd, item, cnt)) {
+            mpp_err("invalid option item %s\n", item);
+            return 0;
+        }
+        cnt++;
+    }
+
+    return cnt;
+}
+
+static RK_S32 parse_type(BenchCmd *cmd, const char *item, RK_S32 idx)
+{
+    (void)idx;
+
+    if (!strcmp(item, "enc"))
+        cmd->enc = 1;
+    else if (!strcmp(item, "dec"))
+        cmd->dec = 1;
+    else
+        return -1;
+
+    return 0;
+}
+
+static RK_S32 parse_codec(BenchCmd *cmd, const char *item, RK_S32 idx)
+{
+    RK_U32 i;
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(bench_codecs); i++) {
+        if (!strcmp(item, bench_codecs[i].name)) {
+            cmd->codecs[idx] = i;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static RK_S32 parse_res(BenchCmd *cmd, const char *item, RK_S32 idx)
+{
+    RK_S32 w = 0;
+    RK_S32 h = 0;
+
+    if (sscanf(item, "%dx%d", &w, &h) != 2 || w < 16 || h < 16)
+        return -1;
+
+    cmd->widths[idx] = w;
+    cmd->heights[idx] = h;
+
+    return 0;
+}
+
+static RK_S32 parse_chn(BenchCmd *cmd, const char *item, RK_S32 idx)
+{
+    cmd->chns[idx] = atoi(item);
+
+    return cmd->chns[idx] > 0 ? 0 : -1;
+}
+
+static RK_S32 parse_mode(BenchCmd *cmd, const char *item, RK_S32 idx)
+{
+    RK_S32 i;
+
+    for (i = 0; i < BENCH_IO_BUTT; i++) {
+        if (!strcmp(item, io_mode_names[i])) {
+            cmd->modes[idx] = i;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static RK_S32 parse_micro(BenchCmd *cmd, const char *item, RK_S32 idx)
+{
+    RK_S32 i;
+
+    for (i = 0; i < BENCH_MICRO_BUTT; i++) {
+        if (!strcmp(item, micro_names[i])) {
+            cmd->micros[idx] = i;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static RK_S32 bench_opt_t(void *ctx, const char *next)
+{
+    BenchCmd *cmd = (BenchCmd *)ctx;
+
+    cmd->enc = 0;
+    cmd->dec = 0;
+    return parse_list(cmd, next, parse_type, 2) ? 1 : -1;
+}
+
+static RK_S32 bench_opt_c(void *ctx, const char *next)
+{
+    BenchCmd *cmd = (BenchCmd *)ctx;
+
+    cmd->codec_cnt = parse_list(cmd, next, parse_codec, BENCH_MAX_ITEM);
+    return cmd->codec_cnt ? 1 : -1;
+}
+
+static RK_S32 bench_opt_r(void *ctx, const char *next)
+{
+    BenchCmd *cmd = (BenchCmd *)ctx;
+
+    cmd->res_cnt = parse_list(cmd, next, parse_res, BENCH_MAX_ITEM);
+    return cmd->res_cnt ? 1 : -1;
+}
+
+static RK_S32 bench_opt_n(void *ctx, const char *next)
+{
+    BenchCmd *cmd = (BenchCmd *)ctx;
+
+    cmd->chn_cnt = parse_list(cmd, next, parse_chn, BENCH_MAX_ITEM);
+    return cmd->chn_cnt ? 1 : -1;
+}
+
+static RK_S32 bench_opt_m(void *ctx, const char *next)
+{
+    BenchCmd *cmd = (BenchCmd *)ctx;
+
+    cmd->mode_cnt = parse_list(cmd, next, parse_mode, BENCH_MAX_ITEM);
+    return cmd->mode_cnt ? 1 : -1;
+}
+
+static RK_S32 bench_opt_u(void *ctx, const char *next)
+{
+    BenchCmd *cmd = (BenchCmd *)ctx;
+
+    if (next && !strcmp(next, "none")) {
+        cmd->micro_cnt = 0;
+        return 1;
+    }
+
+    cmd->micro_cnt = parse_list(cmd, next, parse_micro, BENCH_MICRO_BUTT);
+    return cmd->micro_cnt ? 1 : -1;
+}
+
+static RK_S32 bench_opt_f(void *ctx, const char *next)
+{
+    BenchCmd *cmd = (BenchCmd *)ctx;
+
+    if (next) {
+        cmd->frames = atoi(next);
+        if (cmd->frames > 0)
+            return 1;
+    }
+
+    mpp_err("invalid frame count\n");
+    return -1;
+}
+
+static RK_S32 bench_opt_l(void *ctx, const char *next)
+{
+    BenchCmd *cmd = (BenchCmd *)ctx;
+
+    if (next) {
+        cmd->loops = atoi(next);
+        if (cmd->loops > 0)
+            return 1;
+    }
+
+    mpp_err("invalid loop count\n");
+    return -1;
+}
+
+static RK_S32 bench_opt_x(void *ctx, const char *next)
+{
+    BenchCmd *cmd = (BenchCmd *)ctx;
+
+    if (next && !strcmp(next, "csv")) {
+        cmd->csv = 1;
+        return 1;
+    }
+
+    if (next && !strcmp(next, "json")) {
+        cmd->csv = 0;
+        return 1;
+    }
+
+    mpp_err("invalid output format\n");
+    return -1;
+}
+
+static RK_S32 bench_opt_o(void *ctx, const char *next)
+{
+    BenchCmd *cmd = (BenchCmd *)ctx;
+
+    cmd->file_out = (char *)next;
+    return next ? 1 : -1;
+}
+
+static RK_S32 bench_opt_d(void *ctx, const char *next)
+{
+    BenchCmd *cmd = (BenchCmd *)ctx;
+
+    cmd->tmp_dir = (char *)next;
+    return next ? 1 : -1;
+}
+
+static RK_S32 bench_opt_s(void *ctx, const char *next)
+{
+    BenchCmd *cmd = (BenchCmd *)ctx;
+
+    (void)next;
+    cmd->dummy = 1;
+    return 0;
+}
+
+static RK_S32 bench_opt_help(void *ctx, const char *next)
+{
+    (void)ctx;
+    (void)next;
+    return -1;
+}
+
+static MppOptInfo bench_opts[] = {
+    {"t",   "type",     "benchmark type list: enc,dec",                 bench_opt_t},
+    {"c",   "codec",    "codec list: h264,h265,mjpeg,vp8",              bench_opt_c},
+    {"r",   "res",      "resolution list: 1280x720,1920x1080",          bench_opt_r},
+    {"n",   "channel",  "channel count list: 1,4",                      bench_opt_n},
+    {"m",   "mode",     "io mode list: sync,async,task",                bench_opt_m},
+    {"f",   "frames",   "frame count of each channel",                  bench_opt_f},
+    {"u",   "micro",    "micro list: bitread,scan,slot,buffer,pool or none", bench_opt_u},
+    {"l",   "loops",    "loop count of micro benchmark",                bench_opt_l},
+    {"x",   "format",   "output format: json or csv",                   bench_opt_x},
+    {"o",   "output",   "output file, - for stdout",                  bench_opt_o},
+    {"d",   "tmp_dir",  "directory for temporary stream file",          bench_opt_d},
+    {"s",   "dummy",    "run codec cases on dummy hal without hardware", bench_opt_s},
+    {"h",   "help",     "help info",                                    bench_opt_help},
+};
+
+static void bench_show_help(void)
+{
+    RK_U32 i;
+
+    mpp_log("usage: mpi_bench_test [options]\n");
+    for (i = 0; i < MPP_ARRAY_ELEMS(bench_opts); i++)
+        mpp_log("-%-2s %-8s %s\n", bench_opts[i].name, bench_opts[i].full_name,
+                bench_opts[i].help);
+}
+
+static void bench_cmd_default(BenchCmd *cmd)
+{
+    RK_S32 i;
+
+    memset(cmd, 0, sizeof(*cmd));
+
+    cmd->enc = 1;
+    cmd->dec = 1;
+    cmd->codec_cnt = 2;
+    cmd->codecs[0] = 0;
+    cmd->codecs[1] = 1;
+    cmd->res_cnt = 2;
+    cmd->widths[0] = 1280;
+    cmd->heights[0] = 720;
+    cmd->widths[1] = 1920;
+    cmd->heights[1] = 1080;
+    cmd->chn_cnt = 1;
+    cmd->chns[0] = 1;
+    cmd->mode_cnt = BENCH_IO_BUTT;
+    for (i = 0; i < BENCH_IO_BUTT; i++)
+        cmd->modes[i] = i;
+    cmd->micro_cnt = BENCH_MICRO_BUTT;
+    for (i = 0; i < BENCH_MICRO_BUTT; i++)
+        cmd->micros[i] = i;
+    cmd->frames = 60;
+    cmd->loops = 4;
+    cmd->tmp_dir = "/tmp";
+}
+
+static MPP_RET bench_cmd_parse(BenchCmd *cmd, int argc, char **argv)
+{
+    MppOpt opts = NULL;
+    MPP_RET ret;
+    RK_U32 i;
+
+    bench_cmd_default(cmd);
+
+    if (argc < 2)
+        return MPP_OK;
+
+    mpp_opt_init(&opts);
+    /* should change node count when option increases */
+    mpp_opt_setup(opts, cmd, 16, MPP_ARRAY_ELEMS(bench_opts));
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(bench_opts); i++)
+        mpp_opt_add(opts, &bench_opts[i]);
+
+    /* mark option end */
+    mpp_opt_add(opts, NULL);
+
+    ret = mpp_opt_parse(opts, argc, argv);
+
+    mpp_opt_deinit(opts);
+
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    BenchCmd cmd;
+    BenchStream *streams = NULL;
+    FILE *fp = stdout;
+    RK_S32 first = 1;
+    RK_S32 c, r, n, m, d, i;
+
+    if (bench_cmd_parse(&cmd, argc, argv)) {
+        bench_show_help();
+        return -1;
+    }
+
+    /*
+     * dummy hal skips the soc check and hardware access so the codec flow
+     * latency and fps can be measured on build hosts. Decoders also switch
+     * to the dummy parser and jpeg decoder still needs hardware.
+     */
+    if (cmd.dummy)
+        mpp_env_set_u32("mpp_hal_dummy", 1);
+
+    /* mpp log also goes to stdout so result is saved to file by default */
+    if (NULL == cmd.file_out)
+        cmd.file_out = cmd.csv ? "mpi_bench.csv" : "mpi_bench.json";
+
+    if (strcmp(cmd.file_out, "-")) {
+        fp = fopen(cmd.file_out, "w");
+        if (NULL == fp) {
+            mpp_err("failed to open output file %s\n", cmd.file_out);
+            return -1;
+        }
+    }
+
+    streams = mpp_calloc(BenchStream, cmd.codec_cnt * cmd.res_cnt);
+    if (NULL == streams) {
+        if (fp != stdout)
+            fclose(fp);
+        return -1;
+    }
+
+    if (!cmd.csv)
+        fprintf(fp, "[\n");
+
+    for (i = 0; i < cmd.micro_cnt; i++)
+        run_micro(&cmd, cmd.micros[i], fp, &first);
+
+    for (c = 0; c < cmd.codec_cnt; c++) {
+        for (r = 0; r < cmd.res_cnt; r++) {
+            BenchCase cs;
+
+            memset(&cs, 0, sizeof(cs));
+            cs.cmd = &cmd;
+            cs.type = bench_codecs[cmd.codecs[c]].type;
+            cs.width = cmd.widths[r];
+            cs.height = cmd.heights[r];
+            cs.hor_stride = MPP_ALIGN(cs.width, 16);
+            cs.ver_stride = MPP_ALIGN(cs.height, 16);
+            cs.frames = cmd.frames;
+            cs.stream = &streams[c * cmd.res_cnt + r];
+
+            /* encoder cases run first to provide the decoder input stream */
+            if (cmd.dec && !cmd.enc) {
+                cs.mode = BENCH_IO_SYNC;
+                run_case(&cs, 1, NULL, &first);
+            }
+
+            for (d = 0; d < 2; d++) {
+                if ((d && !cmd.dec) || (!d && !cmd.enc))
+                    continue;
+
+                cs.dec = d;
+
+                for (n = 0; n < cmd.chn_cnt; n++) {
+                    for (m = 0; m < cmd.mode_cnt; m++) {
+                        cs.mode = cmd.modes[m];
+                        run_case(&cs, cmd.chns[n], fp, &first);
+                    }
+                }
+            }
+        }
+    }
+
+    if (!cmd.csv)
+        fprintf(fp, "\n]\n");
+
+    for (i = 0; i < cmd.codec_cnt * cmd.res_cnt; i++)
+        stream_deinit(&streams[i]);
+    MPP_FREE(streams);
+
+    if (fp != stdout)
+        fclose(fp);
+
+    return 0;
+}
@@ -272,10 +272,14 @@ static int multi_dec_advanced(MpiDecMultiCtx *data)
     RK_U32 quiet = data->quiet;
     FileBufSlot *slot = NULL;
 
-    ret = reader_index_read(cmd->reader, 0, &slot);
+    ret = reader_index_read(cmd->reader, data->packet_count++, &slot);
     mpp_assert(ret == MPP_OK);
     mpp_assert(slot);
 
+    /* mjpeg file may be indexed into multiple frames, loop from the first one */
+    if (slot->eos)
+        data->packet_count = 0;
+
     mpp_packet_init_with_buffer(&packet, slot->buf);
 
     // setup eos flag
@@ -59,8 +59,119 @@ typedef struct {
     RK_S64          delay;
     FILE            *fp_verify;
     FrmCrc          checkcrc;
+    /* write xxh64 frame hash instead of legacy crc to verify file */
+    RK_U32          verify_hash;
+
+    /* reference check */
+    FILE            *fp_ref_hash;
+    FILE            *fp_ref_yuv;
+    MppBufferGroup  ref_grp;
+    MppBuffer       ref_buf;
+    MppFrame        ref_frm;
+    RK_S32          ref_err_cnt;
 } MpiDecLoopData;
 
+static void dec_verify_frame(MpiDecLoopData *data, MppFrame frame)
+{
+    if (data->verify_hash) {
+        FrmHash hash;
+
+        calc_frm_hash(frame, &hash);
+        write_frm_hash(data->fp_verify, &hash);
+    } else {
+        calc_frm_crc(frame, &data->checkcrc);
+        write_frm_crc(data->fp_verify, &data->checkcrc);
+    }
+}
+
+/* reference yuv is written by -o option without stride */
+static MPP_RET dec_read_ref_frame(MpiDecLoopData *data, MppFrame frame)
+{
+    MppFrameFormat fmt = mpp_frame_get_fmt(frame);
+    RK_U32 width = mpp_frame_get_width(frame);
+    RK_U32 height = mpp_frame_get_height(frame);
+    size_t size = width * height;
+
+    switch (fmt & MPP_FRAME_FMT_MASK) {
+    case MPP_FMT_YUV420SP :
+    case MPP_FMT_YUV420SP_VU :
+    case MPP_FMT_YUV420P : {
+        size = size * 3 / 2;
+    } break;
+    case MPP_FMT_YUV400 : {
+    } break;
+    default : {
+        mpp_err("reference check does not support format %x\n", fmt);
+        return MPP_NOK;
+    } break;
+    }
+
+    if (data->ref_buf && mpp_buffer_get_size(data->ref_buf) < size) {
+        mpp_buffer_put(data->ref_buf);
+        data->ref_buf = NULL;
+    }
+
+    if (NULL == data->ref_buf) {
+        if (NULL == data->ref_grp)
+            mpp_buffer_group_get_internal(&data->ref_grp, MPP_BUFFER_TYPE_NORMAL);
+
+        mpp_buffer_get(data->ref_grp, &data->ref_buf, size);
+        if (NULL == data->ref_buf)
+            return MPP_NOK;
+    }
+
+    if (fread(mpp_buffer_get_ptr(data->ref_buf), 1, size, data->fp_ref_yuv) != size) {
+        mpp_err("reference yuv file is too short\n");
+        return MPP_NOK;
+    }
+
+    if (NULL == data->ref_frm)
+        mpp_frame_init(&data->ref_frm);
+
+    mpp_frame_set_width(data->ref_frm, width);
+    mpp_frame_set_height(data->ref_frm, height);
+    mpp_frame_set_hor_stride(data->ref_frm, width);
+    mpp_frame_set_ver_stride(data->ref_frm, height);
+    mpp_frame_set_fmt(data->ref_frm, fmt);
+    mpp_frame_set_buffer(data->ref_frm, data->ref_buf);
+
+    return MPP_OK;
+}
+
+static void dec_check_frame(MpiDecLoopData *data, MppFrame frame)
+{
+    RK_U32 mismatch = 0;
+
+    if (data->fp_ref_hash) {
+        FrmHash hash;
+        FrmHash ref;
+
+        memset(&ref, 0, sizeof(ref));
+        calc_frm_hash(frame, &hash);
+        read_frm_hash(data->fp_ref_hash, &ref);
+
+        if (hash.luma != ref.luma || hash.chroma != ref.chroma)
+            mismatch = 1;
+    }
+
+    if (data->fp_ref_yuv) {
+        FrmDiff diff;
+
+        if (dec_read_ref_frame(data, frame) ||
+            calc_frm_diff(data->ref_frm, frame, &diff)) {
+            mismatch = 1;
+        } else if (diff.diff_cnt[0] || diff.diff_cnt[1] || diff.diff_cnt[2]) {
+            mismatch = 1;
+            show_frm_diff(&diff);
+        }
+    }
+
+    if (mismatch) {
+        mpp_err("frame %d mismatch with reference\n", data->frame_count);
+        data->ref_err_cnt++;
+    }
+}
+
 static int dec_simple(MpiDecLoopData *data)
 {
     RK_U32 pkt_done = 0;
@@ -72,7 +183,6 @@ static int dec_simple(MpiDecLoopData *data)
     MppPacket packet = data->packet;
     FileBufSlot *slot = NULL;
     RK_U32 quiet = data->quiet;
-    FrmCrc *checkcrc = &data->checkcrc;
 
     // when packet size is valid read the input binary file
     ret = reader_read(cmd->reader, &slot);
@@ -252,6 +362,7 @@ static int dec_simple(MpiDecLoopData *data)
                     RK_S32 log_len = 0;
                     RK_U32 err_info = mpp_frame_get_errinfo(frame);
                     RK_U32 discard = mpp_frame_get_discard(frame);
+                    RK_U32 damage = mpp_frame_get_damage(frame);
 
                     if (!data->first_frm)
                         data->first_frm = mpp_time();
@@ -273,16 +384,23 @@ static int dec_simple(MpiDecLoopData *data)
                         log_len += snprintf(log_buf + log_len, log_size - log_len,
                                             " err %x discard %x", err_info, discard);
                     }
+
+                    if (damage) {
+                        log_len += snprintf(log_buf + log_len, log_size - log_len,
+                                            " damage %d", damage);
+                    }
                     mpp_log_q(quiet, "%p %s\n", ctx, log_buf);
 
-                    data->frame_count++;
                     if (data->fp_output && !err_info)
                         dump_mpp_frame_to_file(frame, data->fp_output);
 
-                    if (data->fp_verify) {
-                        calc_frm_crc(frame, checkcrc);
-                        write_frm_crc(data->fp_verify, checkcrc);
-                    }
+                    if (data->fp_verify)
+                        dec_verify_frame(data, frame);
+
+                    if ((data->fp_ref_hash || data->fp_ref_yuv) && !err_info)
+                        dec_check_frame(data, frame);
+
+                    data->frame_count++;
 
                     fps_calc_inc(cmd->fps);
                 }
@@ -351,12 +469,15 @@ static int dec_advanced(MpiDecLoopData *data)
     MppTask task = NULL;
     RK_U32 quiet = data->quiet;
     FileBufSlot *slot = NULL;
-    FrmCrc *checkcrc = &data->checkcrc;
 
-    ret = reader_index_read(cmd->reader, 0, &slot);
+    ret = reader_read(cmd->reader, &slot);
     mpp_assert(ret == MPP_OK);
     mpp_assert(slot);
 
+    /* mjpeg file may be indexed into multiple frames, loop from the first one */
+    if (slot->eos)
+        reader_rewind(cmd->reader);
+
     mpp_packet_init_with_buffer(&packet, slot->buf);
 
     // setup eos flag
@@ -417,10 +538,11 @@ static int dec_advanced(MpiDecLoopData *data)
             if (data->fp_output)
                 dump_mpp_frame_to_file(frame, data->fp_output);
 
-            if (data->fp_verify) {
-                calc_frm_crc(frame, checkcrc);
-                write_frm_crc(data->fp_verify, checkcrc);
-            }
+            if (data->fp_verify)
+                dec_verify_frame(data, frame);
+
+            if (data->fp_ref_hash || data->fp_ref_yuv)
+                dec_check_frame(data, frame);
 
             mpp_log_q(quiet, "%p decoded frame %d\n", ctx, data->frame_count);
             data->frame_count++;
@@ -571,6 +693,24 @@ int dec_decode(MpiDecTestCmd *cmd)
         data.fp_verify = fopen(cmd->file_slt, "wt");
         if (!data.fp_verify)
             mpp_err("failed to open verify file %s\n", cmd->file_slt);
+
+        mpp_env_get_u32("mpi_dec_verify_hash", &data.verify_hash, 0);
+    }
+
+    if (cmd->file_ref_hash) {
+        data.fp_ref_hash = fopen(cmd->file_ref_hash, "rt");
+        if (NULL == data.fp_ref_hash) {
+            mpp_err("failed to open reference hash file %s\n", cmd->file_ref_hash);
+            goto MPP_TEST_OUT;
+        }
+    }
+
+    if (cmd->file_ref_yuv) {
+        data.fp_ref_yuv = fopen(cmd->file_ref_yuv, "rb");
+        if (NULL == data.fp_ref_yuv) {
+            mpp_err("failed to open reference yuv file %s\n", cmd->file_ref_yuv);
+            goto MPP_TEST_OUT;
+        }
     }
 
     if (cmd->simple) {
@@ -684,6 +824,11 @@ int dec_decode(MpiDecTestCmd *cmd)
 
     cmd->max_usage = data.max_usage;
 
+    if (data.ref_err_cnt) {
+        mpp_err("%d frames mismatch with reference\n", data.ref_err_cnt);
+        ret = MPP_NOK;
+    }
+
     ret = mpi->reset(ctx);
     if (ret) {
         mpp_err("%p mpi->reset failed\n", ctx);
@@ -728,6 +873,31 @@ MPP_TEST_OUT:
         data.fp_verify = NULL;
     }
 
+    if (data.fp_ref_hash) {
+        fclose(data.fp_ref_hash);
+        data.fp_ref_hash = NULL;
+    }
+
+    if (data.fp_ref_yuv) {
+        fclose(data.fp_ref_yuv);
+        data.fp_ref_yuv = NULL;
+    }
+
+    if (data.ref_frm) {
+        mpp_frame_deinit(&data.ref_frm);
+        data.ref_frm = NULL;
+    }
+
+    if (data.ref_buf) {
+        mpp_buffer_put(data.ref_buf);
+        data.ref_buf = NULL;
+    }
+
+    if (data.ref_grp) {
+        mpp_buffer_group_put(data.ref_grp);
+        data.ref_grp = NULL;
+    }
+
     if (cfg) {
         mpp_dec_cfg_deinit(cfg);
         cfg = NULL;
@@ -763,6 +933,7 @@ int main(int argc, char **argv)
 
 RET:
     mpi_dec_test_cmd_deinit(cmd);
+    frm_check_deinit();
 
     return ret;
 }
@@ -18,6 +18,9 @@
 
 #include <string.h>
 #include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 #include "rk_mpi.h"
 
@@ -38,6 +41,32 @@
 
 #define DEFAULT_PACKET_SIZE         SZ_4K
 
+/*
+ * reader_mmap env:
+ * 0 - always read file into malloc buffer
+ * 1 - always mmap file and hand out zero-copy slices
+ * 2 - mmap file larger than READER_MMAP_AUTO_SIZE
+ */
+#define READER_MMAP_OFF             0
+#define READER_MMAP_ON              1
+#define READER_MMAP_AUTO            2
+#define READER_MMAP_AUTO_SIZE       (64 * SZ_1M)
+/* window for madvise prefetch and drop */
+#define READER_MMAP_WINDOW          (8 * SZ_1M)
+/* jpeg hardware buffer cached for the latest slots of each reader */
+#define READER_JPEG_BUF_KEEP        4
+/*
+ * mmap mode keeps slot index in a ring, worker scans half ring ahead of the
+ * readers and index older than the ring is scanned again from file start
+ */
+#define READER_MMAP_SLOT_MAX        1024
+
+typedef enum {
+    STREAM_UNKNOWN,
+    STREAM_AVC,
+    STREAM_HEVC,
+} StreamType;
+
 typedef enum {
     FILE_NORMAL_TYPE,
     FILE_JPEG_TYPE,
@@ -66,6 +95,18 @@ typedef struct FileReader_t {
     pthread_t       thd;
     volatile RK_U32 thd_stop;
 
+    /* mmap mode with frame index */
+    RK_U32          use_mmap;
+    RK_U8           *map_base;
+    size_t          map_size;
+    size_t          map_pos;
+    StreamType      stream_type;
+    RK_S32          scan_window;
+    RK_S32          read_window;
+    RK_U32          scan_eos;
+    RK_U32          slot_req;
+    pthread_mutex_t lock;
+
     RK_U32          slot_max;
     RK_U32          slot_cnt;
     RK_U32          slot_rd_idx;
@@ -206,6 +247,427 @@ static FileBufSlot *read_normal_file(FileReader data)
     return slot;
 }
 
+static void reader_mmap_advise(FileReaderImpl *impl, size_t pos, RK_S32 *window)
+{
+    RK_S32 idx = pos / READER_MMAP_WINDOW;
+    size_t start;
+
+    if (idx == *window)
+        return;
+
+    /* prefetch next window and drop the window before previous one */
+    start = (size_t)(idx + 1) * READER_MMAP_WINDOW;
+    if (start < impl->map_size)
+        madvise(impl->map_base + start,
+                MPP_MIN(READER_MMAP_WINDOW, impl->map_size - start), MADV_WILLNEED);
+
+    if (idx >= 2) {
+        start = (size_t)(idx - 2) * READER_MMAP_WINDOW;
+        madvise(impl->map_base + start, READER_MMAP_WINDOW, MADV_DONTNEED);
+    }
+
+    *window = idx;
+}
+
+static FileBufSlot *map_new_slot(FileReaderImpl *impl, size_t pos, size_t size)
+{
+    FileBufSlot *slot = mpp_calloc(FileBufSlot, 1);
+
+    if (NULL == slot)
+        return NULL;
+
+    slot->data = (char *)impl->map_base + pos;
+    slot->size = size;
+    slot->buf = NULL;
+
+    impl->map_pos = pos + size;
+    impl->read_total = impl->map_pos;
+    impl->read_size = size;
+
+    if (impl->map_pos >= impl->map_size)
+        slot->eos = 1;
+
+    reader_mmap_advise(impl, impl->map_pos, &impl->scan_window);
+
+    return slot;
+}
+
+static FileBufSlot *map_ivf_file(FileReader data)
+{
+    FileReaderImpl *impl = (FileReaderImpl*)data;
+    RK_U8 *ivf_data = impl->map_base + impl->map_pos;
+    size_t remain = impl->map_size - impl->map_pos;
+    size_t data_size;
+    FileBufSlot *slot;
+
+    if (remain < IVF_FRAME_HEADER_LENGTH) {
+        /* end of frame queue */
+        slot = mpp_calloc(FileBufSlot, 1);
+        slot->eos = 1;
+
+        return slot;
+    }
+
+    data_size = ivf_data[0] | (ivf_data[1] << 8) | (ivf_data[2] << 16) | (ivf_data[3] << 24);
+    remain -= IVF_FRAME_HEADER_LENGTH;
+    if (!data_size)
+        mpp_err("data_size is zero! offset %ld\n", (long)impl->map_pos);
+    if (data_size > remain) {
+        mpp_err("frame size %d larger than file remain %d\n", (RK_S32)data_size, (RK_S32)remain);
+        data_size = remain;
+    }
+
+    slot = map_new_slot(impl, impl->map_pos + IVF_FRAME_HEADER_LENGTH, data_size);
+    if (slot && !data_size)
+        slot->eos = 1;
+
+    return slot;
+}
+
+/* return offset of next start code prefix, including the leading zero of 4 byte prefix */
+static size_t find_start_code(const RK_U8 *buf, size_t pos, size_t end)
+{
+    while (pos + 3 <= end) {
+        if (buf[pos + 2] > 1) {
+            pos += 3;
+        } else if (!buf[pos] && !buf[pos + 1] && buf[pos + 2] == 1) {
+            if (pos && !buf[pos - 1])
+                pos--;
+            return pos;
+        } else {
+            pos++;
+        }
+    }
+
+    return end;
+}
+
+static size_t skip_start_code(const RK_U8 *buf, size_t pos, size_t end)
+{
+    while (pos < end && !buf[pos])
+        pos++;
+
+    return (pos < end) ? pos + 1 : end;
+}
+
+/*
+ * check whether nal starts a new access unit. Parameter set, sei and aud
+ * after a vcl nal or a vcl nal with first slice flag both start a new one.
+ */
+static RK_U32 nal_is_au_start(StreamType type, const RK_U8 *nal, size_t size, RK_U32 *has_vcl)
+{
+    RK_U32 vcl = 0;
+    RK_U32 first = 0;
+    RK_U32 prefix = 0;
+
+    if (type == STREAM_AVC) {
+        RK_U32 nal_type = nal[0] & 0x1f;
+        /* mvc slice extension has 3 bytes nal header extension */
+        RK_U32 hdr = (nal_type == 20) ? 4 : 1;
+
+        vcl = (nal_type >= 1 && nal_type <= 5) || nal_type == 20;
+        first = size > hdr && (nal[hdr] & 0x80);
+        prefix = (nal_type >= 6 && nal_type <= 9) || (nal_type >= 14 && nal_type <= 18);
+    } else {
+        RK_U32 nal_type = (nal[0] >> 1) & 0x3f;
+
+        vcl = nal_type <= 31;
+        first = size > 2 && (nal[2] & 0x80);
+        prefix = (nal_type >= 32 && nal_type <= 35) || nal_type == 39 ||
+                 (nal_type >= 41 && nal_type <= 44) || (nal_type >= 48 && nal_type <= 55);
+    }
+
+    if (vcl) {
+        RK_U32 start = *has_vcl && first;
+
+        *has_vcl = 1;
+        return start;
+    }
+
+    return prefix && *has_vcl;
+}
+
+static FileBufSlot *map_annexb_file(FileReader data)
+{
+    FileReaderImpl *impl = (FileReaderImpl*)data;
+    const RK_U8 *buf = impl->map_base;
+    size_t start = impl->map_pos;
+    size_t end = impl->map_size;
+    size_t pos = skip_start_code(buf, find_start_code(buf, start, end), end);
+    RK_U32 has_vcl = 0;
+
+    if (start >= end) {
+        FileBufSlot *slot = mpp_calloc(FileBufSlot, 1);
+
+        slot->eos = 1;
+        return slot;
+    }
+
+    if (impl->stream_type != STREAM_UNKNOWN && pos < end)
+        nal_is_au_start(impl->stream_type, buf + pos, end - pos, &has_vcl);
+
+    while (pos < end) {
+        size_t next = find_start_code(buf, pos, end);
+        size_t nal = skip_start_code(buf, next, end);
+
+        if (nal >= end) {
+            pos = end;
+            break;
+        }
+
+        if (impl->stream_type == STREAM_UNKNOWN) {
+            /* no codec info, cut at the first start code after buf_size */
+            if (next - start >= impl->buf_size) {
+                pos = next;
+                break;
+            }
+        } else if (nal_is_au_start(impl->stream_type, buf + nal, end - nal, &has_vcl)) {
+            pos = next;
+            break;
+        }
+
+        pos = nal;
+    }
+
+    return map_new_slot(impl, start, pos - start);
+}
+
+/* walk jpeg markers from SOI to EOI, thumbnail in APPn segment is skipped */
+static size_t find_jpeg_end(const RK_U8 *buf, size_t pos, size_t end)
+{
+    if (pos + 2 > end || buf[pos] != 0xff || buf[pos + 1] != 0xd8)
+        return end;
+
+    pos += 2;
+    while (pos + 2 <= end) {
+        RK_U8 marker;
+
+        if (buf[pos] != 0xff) {
+            pos++;
+            continue;
+        }
+
+        marker = buf[pos + 1];
+        /* stuffing, restart marker and fill byte inside scan data */
+        if (marker == 0x00 || marker == 0xff || (marker >= 0xd0 && marker <= 0xd7)) {
+            pos += (marker == 0xff) ? 1 : 2;
+            continue;
+        }
+
+        if (marker == 0xd9)
+            return pos + 2;
+
+        if (pos + 4 > end)
+            break;
+
+        /* skip marker segment, entropy data after SOS is walked byte by byte */
+        pos += 2 + ((buf[pos + 2] << 8) | buf[pos + 3]);
+    }
+
+    return end;
+}
+
+static FileBufSlot *map_jpeg_file(FileReader data)
+{
+    FileReaderImpl *impl = (FileReaderImpl*)data;
+    size_t start = impl->map_pos;
+    size_t end;
+
+    if (start >= impl->map_size) {
+        FileBufSlot *slot = mpp_calloc(FileBufSlot, 1);
+
+        slot->eos = 1;
+        return slot;
+    }
+
+    end = find_jpeg_end(impl->map_base, start, impl->map_size);
+    /* skip padding between frames */
+    while (end + 1 < impl->map_size &&
+           !(impl->map_base[end] == 0xff && impl->map_base[end + 1] == 0xd8))
+        end++;
+    if (end + 1 >= impl->map_size)
+        end = impl->map_size;
+
+    return map_new_slot(impl, start, end - start);
+}
+
+/* jpeg hardware needs the packet in dma buffer, copy on first read */
+static MPP_RET map_jpeg_fill(FileReaderImpl *impl, FileBufSlot *slot)
+{
+    MppBuffer buf = NULL;
+
+    if (impl->file_type != FILE_JPEG_TYPE || !slot->size)
+        return MPP_OK;
+
+    if (NULL == slot->buf) {
+        mpp_buffer_get(impl->group, &buf, slot->size);
+        if (buf) {
+            memcpy(mpp_buffer_get_ptr(buf), slot->data, slot->size);
+            slot->buf = buf;
+        }
+    }
+
+    return slot->buf ? MPP_OK : MPP_NOK;
+}
+
+static void map_jpeg_drop(FileReaderImpl *impl, RK_U32 index)
+{
+    FileBufSlot *slot;
+
+    /* only the index still kept in the ring */
+    if (index >= impl->slot_cnt || index + impl->slot_max < impl->slot_cnt)
+        return;
+
+    slot = impl->slots[index % impl->slot_max];
+    if (slot && slot->buf) {
+        mpp_buffer_put(slot->buf);
+        slot->buf = NULL;
+    }
+}
+
+/* scan one more slot into the ring, called with lock held */
+static MPP_RET map_scan_slot(FileReaderImpl *impl)
+{
+    FileBufSlot **entry;
+    FileBufSlot *slot;
+
+    if (impl->scan_eos)
+        return MPP_NOK;
+
+    slot = impl->read_func(impl);
+    if (NULL == slot)
+        return MPP_NOK;
+
+    entry = &impl->slots[impl->slot_cnt % impl->slot_max];
+    if (*entry) {
+        /* overwrite evicted entry in place, slot pointer handed out stays valid */
+        if ((*entry)->buf)
+            mpp_buffer_put((*entry)->buf);
+
+        **entry = *slot;
+        MPP_FREE(slot);
+    } else {
+        *entry = slot;
+    }
+
+    (*entry)->index = impl->slot_cnt++;
+    impl->scan_eos = (*entry)->eos;
+
+    return MPP_OK;
+}
+
+/*
+ * Get the slot of index from the ring. The returned slot is valid until the
+ * ring wraps over it and its jpeg buffer until the caller reads
+ * READER_JPEG_BUF_KEEP index later, packet should hold its own reference.
+ */
+static FileBufSlot *map_get_slot(FileReaderImpl *impl, RK_U32 index)
+{
+    FileBufSlot *slot = NULL;
+
+    pthread_mutex_lock(&impl->lock);
+
+    if (index + impl->slot_max < impl->slot_cnt) {
+        /* evicted index, scan again from file start */
+        impl->map_pos = impl->seek_base;
+        impl->read_total = impl->seek_base;
+        impl->scan_window = -1;
+        impl->scan_eos = 0;
+        impl->slot_cnt = 0;
+        impl->slot_req = 0;
+    }
+
+    while (index >= impl->slot_cnt && !map_scan_slot(impl))
+        ;
+
+    if (index < impl->slot_cnt) {
+        slot = impl->slots[index % impl->slot_max];
+        impl->slot_req = MPP_MAX(impl->slot_req, index + 1);
+
+        if (slot->data)
+            reader_mmap_advise(impl, slot->data - (char *)impl->map_base, &impl->read_window);
+
+        /* caller is done with the jpeg copy of older slot */
+        if (index >= READER_JPEG_BUF_KEEP)
+            map_jpeg_drop(impl, index - READER_JPEG_BUF_KEEP);
+
+        if (map_jpeg_fill(impl, slot))
+            slot = NULL;
+    }
+
+    pthread_mutex_unlock(&impl->lock);
+
+    return slot;
+}
+
+static StreamType check_stream_type(FileReaderImpl *impl, char *file_in)
+{
+    const RK_U8 *buf = impl->map_base;
+    size_t pos;
+
+    if (strstr(file_in, ".h264") || strstr(file_in, ".264") || strstr(file_in, ".avc"))
+        return STREAM_AVC;
+
+    if (strstr(file_in, ".h265") || strstr(file_in, ".265") || strstr(file_in, ".hevc"))
+        return STREAM_HEVC;
+
+    /* sniff the first nal: hevc vps or avc sps / aud */
+    pos = skip_start_code(buf, find_start_code(buf, 0, impl->map_size), impl->map_size);
+    if (pos + 1 < impl->map_size) {
+        if (buf[pos] == 0x40 && buf[pos + 1] == 0x01)
+            return STREAM_HEVC;
+
+        if ((buf[pos] & 0x1f) == 7 || (buf[pos] & 0x1f) == 9)
+            return STREAM_AVC;
+    }
+
+    return STREAM_UNKNOWN;
+}
+
+static void check_file_mmap(FileReaderImpl *impl, char *file_in)
+{
+    RK_U32 mode = READER_MMAP_AUTO;
+    void *ptr;
+
+    mpp_env_get_u32("reader_mmap", &mode, READER_MMAP_AUTO);
+
+    if (mode == READER_MMAP_OFF || !impl->file_size ||
+        (mode == READER_MMAP_AUTO && impl->file_size < READER_MMAP_AUTO_SIZE))
+        return;
+
+    ptr = mmap(NULL, impl->file_size, PROT_READ, MAP_PRIVATE, fileno(impl->fp_input), 0);
+    if (ptr == MAP_FAILED) {
+        mpp_err("failed to mmap %s size %ld, fallback to read\n", file_in, (long)impl->file_size);
+        return;
+    }
+
+    madvise(ptr, impl->file_size, MADV_SEQUENTIAL);
+
+    impl->use_mmap = 1;
+    impl->map_base = (RK_U8 *)ptr;
+    impl->map_size = impl->file_size;
+    impl->scan_window = -1;
+    impl->read_window = -1;
+
+    switch (impl->file_type) {
+    case FILE_IVF_TYPE : {
+        impl->read_func = map_ivf_file;
+    } break;
+    case FILE_JPEG_TYPE : {
+        impl->read_func = map_jpeg_file;
+    } break;
+    default : {
+        impl->read_func = map_annexb_file;
+        impl->stream_type = check_stream_type(impl, file_in);
+    } break;
+    }
+
+    impl->slot_max = READER_MMAP_SLOT_MAX;
+    impl->map_pos = impl->seek_base;
+    impl->read_total = impl->seek_base;
+    reader_mmap_advise(impl, impl->map_pos, &impl->scan_window);
+}
+
 static void check_file_type(FileReader data, char *file_in)
 {
     FileReaderImpl *impl = (FileReaderImpl*)data;
@@ -269,6 +731,17 @@ MPP_RET reader_read(FileReader reader, FileBufSlot **buf)
         return MPP_NOK;
     }
 
+    if (impl->use_mmap) {
+        slot = map_get_slot(impl, impl->slot_rd_idx);
+        if (NULL == slot)
+            return MPP_NOK;
+
+        *buf  = slot;
+        impl->slot_rd_idx++;
+
+        return MPP_OK;
+    }
+
     if (impl->slot_rd_idx >= impl->slot_max) {
         mpp_log_f("invalid read index % max %d\n", impl->slot_rd_idx, impl->slot_max);
         return MPP_NOK;
@@ -298,6 +771,16 @@ MPP_RET reader_index_read(FileReader reader, RK_S32 index, FileBufSlot **buf)
         return MPP_NOK;
     }
 
+    if (impl->use_mmap) {
+        slot = map_get_slot(impl, index);
+        if (NULL == slot)
+            return MPP_NOK;
+
+        *buf  = slot;
+
+        return MPP_OK;
+    }
+
     if (index >= (RK_S32)impl->slot_max) {
         mpp_log_f("invalid read index % max %d\n", index, impl->slot_max);
         return MPP_NOK;
@@ -343,6 +826,8 @@ void reader_init(FileReader* reader, char* file_in)
     fseek(fp_input, 0L, SEEK_SET);
 
     check_file_type(impl, file_in);
+    check_file_mmap(impl, file_in);
+    pthread_mutex_init(&impl->lock, NULL);
 
     impl->slots = mpp_calloc(FileBufSlot*, impl->slot_max);
 
@@ -354,17 +839,21 @@ void reader_init(FileReader* reader, char* file_in)
 void reader_deinit(FileReader reader)
 {
     FileReaderImpl *impl = (FileReaderImpl*)(reader);
+    RK_U32 slot_cnt;
     RK_U32 i;
 
     mpp_assert(impl);
     reader_stop(impl);
 
+    /* mmap ring entries stay allocated after rescan */
+    slot_cnt = impl->use_mmap ? impl->slot_max : impl->slot_cnt;
+
     if (impl->fp_input) {
         fclose(impl->fp_input);
         impl->fp_input = NULL;
     }
 
-    for (i = 0; i < impl->slot_cnt; i++) {
+    for (i = 0; i < slot_cnt; i++) {
         FileBufSlot *slot = impl->slots[i];
         if (!slot)
             continue;
@@ -381,15 +870,46 @@ void reader_deinit(FileReader reader)
         impl->group = NULL;
     }
 
+    if (impl->map_base) {
+        munmap(impl->map_base, impl->map_size);
+        impl->map_base = NULL;
+    }
+    pthread_mutex_destroy(&impl->lock);
+
     MPP_FREE(impl->slots);
     MPP_FREE(impl);
 }
 
+/* scan ahead of the readers by half ring, readers scan on demand after eos */
+static void map_worker(FileReaderImpl *impl)
+{
+    while (!impl->thd_stop) {
+        RK_U32 scanned = 0;
+
+        pthread_mutex_lock(&impl->lock);
+        if (impl->scan_eos) {
+            pthread_mutex_unlock(&impl->lock);
+            break;
+        }
+        if (impl->slot_cnt < impl->slot_req + impl->slot_max / 2)
+            scanned = !map_scan_slot(impl);
+        pthread_mutex_unlock(&impl->lock);
+
+        if (!scanned)
+            msleep(1);
+    }
+}
+
 static void* reader_worker(void *param)
 {
     FileReaderImpl *impl = (FileReaderImpl*)param;
     RK_U32 eos = 0;
 
+    if (impl->use_mmap) {
+        map_worker(impl);
+        return NULL;
+    }
+
     while (!impl->thd_stop && !eos) {
         FileBufSlot *slot = impl->read_func(impl);
 
@@ -415,6 +935,12 @@ void reader_sync(FileReader reader)
 {
     FileReaderImpl *impl = (FileReaderImpl*)reader;
 
+    /* mmap ring is bounded, remaining slots are scanned by the readers */
+    if (impl->use_mmap) {
+        reader_stop(reader);
+        return;
+    }
+
     pthread_join(impl->thd, NULL);
     impl->thd_stop = 1;
 }
@@ -592,6 +1118,42 @@ RK_S32 mpi_dec_opt_slt(void *ctx, const char *next)
     return 0;
 }
 
+RK_S32 mpi_dec_opt_ref_hash(void *ctx, const char *next)
+{
+    MpiDecTestCmd *cmd = (MpiDecTestCmd *)ctx;
+
+    if (next) {
+        size_t len = strnlen(next, MAX_FILE_NAME_LENGTH);
+        if (len) {
+            cmd->file_ref_hash = mpp_calloc(char, len + 1);
+            strncpy(cmd->file_ref_hash, next, len);
+
+            return 1;
+        }
+    }
+
+    mpp_err("input reference hash file is invalid\n");
+    return 0;
+}
+
+RK_S32 mpi_dec_opt_ref_yuv(void *ctx, const char *next)
+{
+    MpiDecTestCmd *cmd = (MpiDecTestCmd *)ctx;
+
+    if (next) {
+        size_t len = strnlen(next, MAX_FILE_NAME_LENGTH);
+        if (len) {
+            cmd->file_ref_yuv = mpp_calloc(char, len + 1);
+            strncpy(cmd->file_ref_yuv, next, len);
+
+            return 1;
+        }
+    }
+
+    mpp_err("input reference yuv file is invalid\n");
+    return 0;
+}
+
 RK_S32 mpi_dec_opt_help(void *ctx, const char *next)
 {
     (void)ctx;
@@ -611,6 +1173,8 @@ static MppOptInfo dec_opts[] = {
     {"s",       "instance_nb",  "number of instances",              mpi_dec_opt_s},
     {"v",       "trace option", "q - quiet f - show fps",           mpi_dec_opt_v},
     {"slt",     "slt file",     "slt verify data file",             mpi_dec_opt_slt},
+    {"ref_hash", "hash file",   "reference xxh64 hash file to check", mpi_dec_opt_ref_hash},
+    {"ref_yuv", "yuv file",     "reference yuv file to check psnr", mpi_dec_opt_ref_yuv},
     {"help",    "help",         "show help",                        mpi_dec_opt_help},
 };
 
@@ -716,6 +1280,8 @@ RK_S32 mpi_dec_test_cmd_deinit(MpiDecTestCmd* cmd)
     }
 
     MPP_FREE(cmd->file_slt);
+    MPP_FREE(cmd->file_ref_hash);
+    MPP_FREE(cmd->file_ref_yuv);
 
     if (cmd->fps) {
         fps_calc_deinit(cmd->fps);
@@ -739,4 +1305,8 @@ void mpi_dec_test_cmd_options(MpiDecTestCmd* cmd)
     mpp_log("max frames : %4d\n", cmd->frame_num);
     if (cmd->file_slt)
         mpp_log("verify     : %s\n", cmd->file_slt);
+    if (cmd->file_ref_hash)
+        mpp_log("ref hash   : %s\n", cmd->file_ref_hash);
+    if (cmd->file_ref_yuv)
+        mpp_log("ref yuv    : %s\n", cmd->file_ref_yuv);
 }
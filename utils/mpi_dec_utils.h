@@ -65,6 +65,9 @@ typedef struct MpiDecTestCmd_t {
     RK_U32          quiet;
     RK_U32          trace_fps;
     char            *file_slt;
+    /* reference xxh64 hash file and yuv file to check decoded frames */
+    char            *file_ref_hash;
+    char            *file_ref_yuv;
 } MpiDecTestCmd;
 
 // extern OptionInfo mpi_dec_cmd[];
@@ -17,9 +17,27 @@
 #define MODULE_TAG "utils"
 
 #include <ctype.h>
+#include <math.h>
 #include <limits.h>
 #include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* vector path only when word size matches CAL_BYTE like the legacy loop */
+#if (__SIZEOF_POINTER__ == __SIZEOF_LONG__)
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define CRC_SIMD_NEON
+#include <arm_neon.h>
+#elif defined(__AVX2__) && (LONG_MAX != INT_MAX)
+#define CRC_SIMD_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#define CRC_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#endif
 
+#include "mpp_env.h"
 #include "mpp_mem.h"
 #include "mpp_log.h"
 #include "mpp_lock.h"
@@ -192,27 +210,401 @@ void dump_mpp_frame_to_file(MppFrame frame, FILE *fp)
     }
 }
 
-void wide_bit_sum(RK_U8 *data, RK_U32 len, RK_ULONG *sum)
+#if LONG_MAX == INT_MAX
+typedef RK_U16 CrcWord;
+#else
+typedef RK_U32 CrcWord;
+#endif
+
+/* large plane is split by line to multiple threads */
+#define CRC_THREAD_MAX          8
+#define CRC_THREAD_AUTO_MAX     4
+#define CRC_THREAD_MIN_SIZE     (3840 * 1080)
+
+/* line count per band for frame hash */
+#define FRM_HASH_BAND_LINES     64
+
+/* sum of CAL_BYTE wide words and the tail bytes in one line */
+static RK_ULONG crc_line_sum(const RK_U8 *data, RK_U32 len)
 {
-    RK_U8   *data8 = NULL;
-    RK_U32  loop;
-    data8 = data;
+    const CrcWord *data_rk = (const CrcWord *)data;
+    RK_U32 words = len / CAL_BYTE;
+    RK_ULONG sum = 0;
+    RK_U32 loop = 0;
+
+#if defined(CRC_SIMD_NEON)
+#if LONG_MAX == INT_MAX
+    {
+        uint32x4_t acc = vdupq_n_u32(0);
+
+        for (; loop + 8 <= words; loop += 8)
+            acc = vpadalq_u16(acc, vreinterpretq_u16_u8(vld1q_u8(data + loop * 2)));
+
+        sum = vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1) +
+              vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+    }
+#else
+    {
+        uint64x2_t acc = vdupq_n_u64(0);
+
+        for (; loop + 4 <= words; loop += 4)
+            acc = vpadalq_u32(acc, vreinterpretq_u32_u8(vld1q_u8(data + loop * 4)));
+
+        sum = vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1);
+    }
+#endif
+#elif defined(CRC_SIMD_AVX2)
+    {
+        __m256i acc = _mm256_setzero_si256();
+        __m256i zero = _mm256_setzero_si256();
+        RK_U64 val[4];
+
+        for (; loop + 8 <= words; loop += 8) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(data + loop * 4));
+
+            acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(v, zero));
+            acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi32(v, zero));
+        }
+
+        _mm256_storeu_si256((__m256i *)val, acc);
+        sum = val[0] + val[1] + val[2] + val[3];
+    }
+#elif defined(CRC_SIMD_SSE2)
 #if LONG_MAX == INT_MAX
-    RK_U16 *data_rk = NULL;
-    data_rk = (RK_U16 *)data;
+    {
+        __m128i acc = _mm_setzero_si128();
+        __m128i zero = _mm_setzero_si128();
+        RK_U32 val[4];
+
+        for (; loop + 8 <= words; loop += 8) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(data + loop * 2));
+
+            acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+            acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+        }
+
+        _mm_storeu_si128((__m128i *)val, acc);
+        sum = val[0] + val[1] + val[2] + val[3];
+    }
 #else
-    RK_U32 *data_rk = NULL;
-    data_rk = (RK_U32 *)data;
+    {
+        __m128i acc = _mm_setzero_si128();
+        __m128i zero = _mm_setzero_si128();
+        RK_U64 val[2];
+
+        for (; loop + 4 <= words; loop += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(data + loop * 4));
+
+            acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, zero));
+            acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, zero));
+        }
+
+        _mm_storeu_si128((__m128i *)val, acc);
+        sum = val[0] + val[1];
+    }
+#endif
 #endif
 
-    for (loop = 0; loop < len / CAL_BYTE; loop++) {
-        *sum += data_rk[loop];
+    for (; loop < words; loop++)
+        sum += data_rk[loop];
+
+    for (loop = words * CAL_BYTE; loop < len; loop++)
+        sum += data[loop];
+
+    return sum;
+}
+
+/* xor of 32bit words */
+static RK_U32 crc_line_xor(const RK_U8 *data, RK_U32 words)
+{
+    const RK_U32 *dat32 = (const RK_U32 *)data;
+    RK_U32 xor = 0;
+    RK_U32 loop = 0;
+
+#if defined(CRC_SIMD_NEON)
+    {
+        uint32x4_t acc = vdupq_n_u32(0);
+
+        for (; loop + 4 <= words; loop += 4)
+            acc = veorq_u32(acc, vreinterpretq_u32_u8(vld1q_u8(data + loop * 4)));
+
+        xor = vgetq_lane_u32(acc, 0) ^ vgetq_lane_u32(acc, 1) ^
+              vgetq_lane_u32(acc, 2) ^ vgetq_lane_u32(acc, 3);
+    }
+#elif defined(CRC_SIMD_AVX2)
+    {
+        __m256i acc = _mm256_setzero_si256();
+        RK_U32 val[8];
+        RK_U32 i;
+
+        for (; loop + 8 <= words; loop += 8)
+            acc = _mm256_xor_si256(acc, _mm256_loadu_si256((const __m256i *)(data + loop * 4)));
+
+        _mm256_storeu_si256((__m256i *)val, acc);
+        for (i = 0; i < 8; i++)
+            xor ^= val[i];
     }
-    for (loop = len / CAL_BYTE * CAL_BYTE; loop < len; loop++) {
-        *sum += data8[loop];
+#elif defined(CRC_SIMD_SSE2)
+    {
+        __m128i acc = _mm_setzero_si128();
+        RK_U32 val[4];
+
+        for (; loop + 4 <= words; loop += 4)
+            acc = _mm_xor_si128(acc, _mm_loadu_si128((const __m128i *)(data + loop * 4)));
+
+        _mm_storeu_si128((__m128i *)val, acc);
+        xor = val[0] ^ val[1] ^ val[2] ^ val[3];
     }
+#endif
+
+    for (; loop < words; loop++)
+        xor ^= dat32[loop];
 
-    return;
+    return xor;
+}
+
+typedef void *(*CrcJobFunc)(void *job);
+
+/* workers are created on first use and reused until frm_check_deinit */
+typedef struct CrcWorker_t {
+    pthread_t       thd;
+    pthread_cond_t  cond;
+    CrcJobFunc      func;
+    void            *job;
+} CrcWorker;
+
+static pthread_mutex_t crc_pool_run = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t crc_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t crc_pool_done = PTHREAD_COND_INITIALIZER;
+static CrcWorker crc_workers[CRC_THREAD_MAX - 1];
+static RK_S32 crc_worker_cnt = 0;
+static RK_S32 crc_pending = 0;
+static RK_U32 crc_pool_inited = 0;
+static RK_U32 crc_pool_quit = 0;
+/* thread count from env, 0 - auto select by plane size */
+static RK_U32 crc_env_cnt = 0;
+static RK_S32 crc_auto_cnt = 1;
+
+static void *crc_worker_thread(void *arg)
+{
+    CrcWorker *w = (CrcWorker *)arg;
+
+    pthread_mutex_lock(&crc_pool_lock);
+    while (1) {
+        void *job;
+
+        while (NULL == w->job && !crc_pool_quit)
+            pthread_cond_wait(&w->cond, &crc_pool_lock);
+
+        if (crc_pool_quit)
+            break;
+
+        job = w->job;
+        pthread_mutex_unlock(&crc_pool_lock);
+
+        w->func(job);
+
+        pthread_mutex_lock(&crc_pool_lock);
+        w->job = NULL;
+        if (!--crc_pending)
+            pthread_cond_signal(&crc_pool_done);
+    }
+    pthread_mutex_unlock(&crc_pool_lock);
+
+    return NULL;
+}
+
+/* called with crc_pool_run locked */
+static void crc_pool_init(void)
+{
+    long val;
+    RK_S32 max_cnt;
+    RK_S32 i;
+
+    if (crc_pool_inited)
+        return;
+
+    val = sysconf(_SC_NPROCESSORS_ONLN);
+    mpp_env_get_u32("frm_crc_thread", &crc_env_cnt, 0);
+
+    crc_auto_cnt = MPP_MIN((val > 0) ? (RK_S32)val : 1, CRC_THREAD_AUTO_MAX);
+    max_cnt = crc_env_cnt ? (RK_S32)MPP_MIN(crc_env_cnt, CRC_THREAD_MAX) : crc_auto_cnt;
+
+    for (i = 0; i < max_cnt - 1; i++) {
+        CrcWorker *w = &crc_workers[crc_worker_cnt];
+
+        pthread_cond_init(&w->cond, NULL);
+        if (pthread_create(&w->thd, NULL, crc_worker_thread, w)) {
+            pthread_cond_destroy(&w->cond);
+            break;
+        }
+        crc_worker_cnt++;
+    }
+
+    crc_pool_inited = 1;
+}
+
+void frm_check_deinit(void)
+{
+    RK_S32 i;
+
+    /* wait for the running caller */
+    pthread_mutex_lock(&crc_pool_run);
+
+    pthread_mutex_lock(&crc_pool_lock);
+    crc_pool_quit = 1;
+    for (i = 0; i < crc_worker_cnt; i++)
+        pthread_cond_signal(&crc_workers[i].cond);
+    pthread_mutex_unlock(&crc_pool_lock);
+
+    for (i = 0; i < crc_worker_cnt; i++) {
+        pthread_join(crc_workers[i].thd, NULL);
+        pthread_cond_destroy(&crc_workers[i].cond);
+    }
+
+    crc_worker_cnt = 0;
+    crc_pool_quit = 0;
+    crc_pool_inited = 0;
+
+    pthread_mutex_unlock(&crc_pool_run);
+}
+
+static RK_S32 crc_thread_count(RK_U32 size, RK_S32 unit_cnt)
+{
+    RK_S32 cnt;
+
+    if (!crc_pool_inited) {
+        pthread_mutex_lock(&crc_pool_run);
+        crc_pool_init();
+        pthread_mutex_unlock(&crc_pool_run);
+    }
+
+    if (!crc_env_cnt && size < CRC_THREAD_MIN_SIZE)
+        return 1;
+
+    cnt = crc_env_cnt ? (RK_S32)MPP_MIN(crc_env_cnt, CRC_THREAD_MAX) : crc_auto_cnt;
+    cnt = MPP_MIN(cnt, crc_worker_cnt + 1);
+    cnt = MPP_MIN(cnt, unit_cnt);
+
+    return MPP_MAX(cnt, 1);
+}
+
+/* run jobs with job[0] on caller thread */
+static void crc_run_jobs(CrcJobFunc func, void *jobs, size_t job_size, RK_S32 cnt)
+{
+    RK_S32 i;
+
+    /* workers are busy with another caller, run all jobs here */
+    if (cnt > 1 && pthread_mutex_trylock(&crc_pool_run)) {
+        for (i = 0; i < cnt; i++)
+            func((RK_U8 *)jobs + job_size * i);
+        return;
+    }
+
+    if (cnt > 1) {
+        pthread_mutex_lock(&crc_pool_lock);
+        for (i = 1; i < cnt; i++) {
+            CrcWorker *w = &crc_workers[i - 1];
+
+            w->func = func;
+            w->job = (RK_U8 *)jobs + job_size * i;
+            crc_pending++;
+            pthread_cond_signal(&w->cond);
+        }
+        pthread_mutex_unlock(&crc_pool_lock);
+    }
+
+    func(jobs);
+
+    if (cnt > 1) {
+        pthread_mutex_lock(&crc_pool_lock);
+        while (crc_pending)
+            pthread_cond_wait(&crc_pool_done, &crc_pool_lock);
+        pthread_mutex_unlock(&crc_pool_lock);
+
+        pthread_mutex_unlock(&crc_pool_run);
+    }
+}
+
+typedef struct CrcJob_t {
+    const RK_U8     *base;
+    RK_U32          stride;
+    RK_U32          width;
+    RK_U32          y_start;
+    RK_U32          y_end;
+    RK_U32          grp_line_cnt;
+    RK_ULONG        *sum;
+    RK_U32          xor;
+} CrcJob;
+
+static void *crc_plane_job(void *arg)
+{
+    CrcJob *job = (CrcJob *)arg;
+    RK_U32 y;
+
+    for (y = job->y_start; y < job->y_end; y++) {
+        const RK_U8 *line = job->base + (size_t)y * job->stride;
+
+        job->sum[y / job->grp_line_cnt] += crc_line_sum(line, job->width);
+        job->xor ^= crc_line_xor(line, job->width / 4);
+    }
+
+    return NULL;
+}
+
+/* accumulate plane line sums into crc->sum and return xor of the plane */
+static RK_U32 calc_plane_crc(const RK_U8 *base, RK_U32 width, RK_U32 height,
+                             RK_U32 stride, RK_U32 grp_line_cnt, DataCrc *crc)
+{
+    CrcJob jobs[CRC_THREAD_MAX];
+    RK_U32 grp_cnt = (height + grp_line_cnt - 1) / grp_line_cnt;
+    RK_S32 cnt = crc_thread_count(width * height, height);
+    RK_ULONG *sums = NULL;
+    RK_U32 xor = 0;
+    RK_S32 i;
+
+    crc->sum_cnt = grp_cnt;
+
+    if (cnt > 1) {
+        sums = mpp_calloc(RK_ULONG, grp_cnt * cnt);
+        if (NULL == sums)
+            cnt = 1;
+    }
+
+    memset(jobs, 0, sizeof(jobs));
+    for (i = 0; i < cnt; i++) {
+        CrcJob *job = &jobs[i];
+
+        job->base = base;
+        job->stride = stride;
+        job->width = width;
+        job->y_start = height * i / cnt;
+        job->y_end = height * (i + 1) / cnt;
+        job->grp_line_cnt = grp_line_cnt;
+        job->sum = sums ? sums + grp_cnt * i : crc->sum;
+    }
+
+    crc_run_jobs(crc_plane_job, jobs, sizeof(jobs[0]), cnt);
+
+    for (i = 0; i < cnt; i++) {
+        xor ^= jobs[i].xor;
+
+        if (sums) {
+            RK_U32 j;
+
+            for (j = 0; j < grp_cnt; j++)
+                crc->sum[j] += jobs[i].sum[j];
+        }
+    }
+
+    MPP_FREE(sums);
+
+    return xor;
+}
+
+void wide_bit_sum(RK_U8 *data, RK_U32 len, RK_ULONG *sum)
+{
+    *sum += crc_line_sum(data, len);
 }
 
 void calc_data_crc(RK_U8 *dat, RK_U32 len, DataCrc *crc)
@@ -220,7 +612,6 @@ void calc_data_crc(RK_U8 *dat, RK_U32 len, DataCrc *crc)
     RK_ULONG data_grp_byte_cnt = MAX_HALF_WORD_SUM_CNT * CAL_BYTE;
     RK_U32 i = 0, grp_loop = 0;
     RK_U8 *dat8 = NULL;
-    RK_U32 *dat32 = NULL;
     RK_U32 xor = 0;
 
     /*calc sum */
@@ -233,9 +624,7 @@ void calc_data_crc(RK_U8 *dat, RK_U32 len, DataCrc *crc)
     }
 
     /*calc xor */
-    dat32 = (RK_U32 *)dat;
-    for (i = 0; i < len / 4; i++)
-        xor ^= dat32[i];
+    xor = crc_line_xor(dat, len / 4);
 
     if (len % 4) {
         RK_U32 val = 0;
@@ -283,11 +672,6 @@ void calc_frm_crc(MppFrame frame, FrmCrc *crc)
 {
     RK_ULONG data_grp_byte_cnt = MAX_HALF_WORD_SUM_CNT * CAL_BYTE;
     RK_U32 grp_line_cnt = 0;
-    RK_U32 grp_cnt = 0;
-
-    RK_U32 y = 0, x = 0;
-    RK_U8 *dat8 = NULL;
-    RK_U32 *dat32 = NULL;
     RK_U32 xor = 0;
 
     RK_U32 width  = mpp_frame_get_width(frame);
@@ -296,50 +680,16 @@ void calc_frm_crc(MppFrame frame, FrmCrc *crc)
     RK_U8 *buf = (RK_U8 *)mpp_buffer_get_ptr(mpp_frame_get_buffer(frame));
 
     grp_line_cnt = data_grp_byte_cnt / ((width + CAL_BYTE - 1) / CAL_BYTE * CAL_BYTE);
+    grp_line_cnt = MPP_MAX(grp_line_cnt, 1);
 
     /* luma */
-    grp_cnt = (height + grp_line_cnt - 1) / grp_line_cnt;
-    crc->luma.sum_cnt = grp_cnt;
-
-    dat8 = buf;
-    for (y = 0; y <  height / grp_line_cnt * grp_line_cnt; y++) {
-        wide_bit_sum(&dat8[y * stride], width, &crc->luma.sum[y / grp_line_cnt]);
-    }
-    if (height % grp_line_cnt) {
-        for (y = height / grp_line_cnt * grp_line_cnt; y < height; y++) {
-            wide_bit_sum(&dat8[y * stride], width, &crc->luma.sum[y / grp_line_cnt]);
-        }
-    }
-
-    dat8 = buf;
-    for (y = 0; y < height; y++) {
-        dat32 = (RK_U32 *)&dat8[y * stride];
-        for (x = 0; x < width / 4; x++)
-            xor ^= dat32[x];
-    }
+    xor = calc_plane_crc(buf, width, height, stride, grp_line_cnt, &crc->luma);
     crc->luma.len = height * width;
     crc->luma.vor = xor;
 
-    /* chroma */
-    grp_cnt = (height / 2 + grp_line_cnt - 1) / grp_line_cnt;
-    crc->chroma.sum_cnt = grp_cnt;
-
-    dat8 = buf + height * stride;
-    for (y = 0; y <  height / 2 / grp_line_cnt * grp_line_cnt; y++) {
-        wide_bit_sum(&dat8[y * stride], width, &crc->chroma.sum[y / grp_line_cnt]);
-    }
-    if (height / 2 % grp_line_cnt) {
-        for (y = height / 2 / grp_line_cnt * grp_line_cnt; y < height / 2; y++) {
-            wide_bit_sum(&dat8[y * stride], width, &crc->chroma.sum[y / grp_line_cnt]);
-        }
-    }
-
-    dat8 = buf + height * stride;
-    for (y = 0; y < height / 2; y++) {
-        dat32 = (RK_U32 *)&dat8[y * stride];
-        for (x = 0; x < width / 4; x++)
-            xor ^= dat32[x];
-    }
+    /* chroma xor keeps accumulating on luma xor as the legacy format */
+    xor ^= calc_plane_crc(buf + height * stride, width, height / 2, stride,
+                          grp_line_cnt, &crc->chroma);
     crc->chroma.len = height * width / 2;
     crc->chroma.vor = xor;
 }
@@ -391,6 +741,456 @@ void read_frm_crc(FILE *fp, FrmCrc *crc)
     }
 }
 
+/* xxh64 for fast frame hash */
+#define XXH_PRIME64_1   0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2   0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3   0x165667B19E3779F9ULL
+#define XXH_PRIME64_4   0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5   0x27D4EB2F165667C5ULL
+
+#define XXH_ROTL64(x, r)    (((x) << (r)) | ((x) >> (64 - (r))))
+
+typedef struct Xxh64State_t {
+    RK_U64          total;
+    RK_U64          v[4];
+    RK_U8           mem[32];
+    RK_U32          mem_size;
+    RK_U64          seed;
+} Xxh64State;
+
+static RK_U64 xxh_read64(const RK_U8 *p)
+{
+    RK_U64 val;
+
+    memcpy(&val, p, sizeof(val));
+    return val;
+}
+
+static RK_U32 xxh_read32(const RK_U8 *p)
+{
+    RK_U32 val;
+
+    memcpy(&val, p, sizeof(val));
+    return val;
+}
+
+static RK_U64 xxh64_round(RK_U64 acc, RK_U64 input)
+{
+    acc += input * XXH_PRIME64_2;
+    acc = XXH_ROTL64(acc, 31);
+    return acc * XXH_PRIME64_1;
+}
+
+static RK_U64 xxh64_merge(RK_U64 acc, RK_U64 val)
+{
+    acc ^= xxh64_round(0, val);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+static void xxh64_init(Xxh64State *s, RK_U64 seed)
+{
+    memset(s, 0, sizeof(*s));
+    s->seed = seed;
+    s->v[0] = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+    s->v[1] = seed + XXH_PRIME64_2;
+    s->v[2] = seed;
+    s->v[3] = seed - XXH_PRIME64_1;
+}
+
+static void xxh64_update(Xxh64State *s, const RK_U8 *p, size_t len)
+{
+    const RK_U8 *end = p + len;
+
+    s->total += len;
+
+    if (s->mem_size + len < 32) {
+        memcpy(s->mem + s->mem_size, p, len);
+        s->mem_size += len;
+        return;
+    }
+
+    if (s->mem_size) {
+        RK_U32 fill = 32 - s->mem_size;
+
+        memcpy(s->mem + s->mem_size, p, fill);
+        s->v[0] = xxh64_round(s->v[0], xxh_read64(s->mem));
+        s->v[1] = xxh64_round(s->v[1], xxh_read64(s->mem + 8));
+        s->v[2] = xxh64_round(s->v[2], xxh_read64(s->mem + 16));
+        s->v[3] = xxh64_round(s->v[3], xxh_read64(s->mem + 24));
+        p += fill;
+        s->mem_size = 0;
+    }
+
+    while (p + 32 <= end) {
+        s->v[0] = xxh64_round(s->v[0], xxh_read64(p));
+        s->v[1] = xxh64_round(s->v[1], xxh_read64(p + 8));
+        s->v[2] = xxh64_round(s->v[2], xxh_read64(p + 16));
+        s->v[3] = xxh64_round(s->v[3], xxh_read64(p + 24));
+        p += 32;
+    }
+
+    if (p < end) {
+        memcpy(s->mem, p, end - p);
+        s->mem_size = end - p;
+    }
+}
+
+static RK_U64 xxh64_digest(Xxh64State *s)
+{
+    const RK_U8 *p = s->mem;
+    const RK_U8 *end = s->mem + s->mem_size;
+    RK_U64 h;
+
+    if (s->total >= 32) {
+        h = XXH_ROTL64(s->v[0], 1) + XXH_ROTL64(s->v[1], 7) +
+            XXH_ROTL64(s->v[2], 12) + XXH_ROTL64(s->v[3], 18);
+        h = xxh64_merge(h, s->v[0]);
+        h = xxh64_merge(h, s->v[1]);
+        h = xxh64_merge(h, s->v[2]);
+        h = xxh64_merge(h, s->v[3]);
+    } else {
+        h = s->seed + XXH_PRIME64_5;
+    }
+
+    h += s->total;
+
+    while (p + 8 <= end) {
+        h ^= xxh64_round(0, xxh_read64(p));
+        h = XXH_ROTL64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+        p += 8;
+    }
+
+    if (p + 4 <= end) {
+        h ^= (RK_U64)xxh_read32(p) * XXH_PRIME64_1;
+        h = XXH_ROTL64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
+    }
+
+    while (p < end) {
+        h ^= (*p) * XXH_PRIME64_5;
+        h = XXH_ROTL64(h, 11) * XXH_PRIME64_1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+typedef struct HashJob_t {
+    const RK_U8     *base;
+    RK_U32          stride;
+    RK_U32          width;
+    RK_U32          height;
+    RK_U32          band_start;
+    RK_U32          band_end;
+    RK_U64          *bands;
+} HashJob;
+
+static void *hash_plane_job(void *arg)
+{
+    HashJob *job = (HashJob *)arg;
+    RK_U32 band;
+
+    for (band = job->band_start; band < job->band_end; band++) {
+        RK_U32 y_end = MPP_MIN((band + 1) * FRM_HASH_BAND_LINES, job->height);
+        RK_U32 y = band * FRM_HASH_BAND_LINES;
+        Xxh64State s;
+
+        xxh64_init(&s, band);
+        for (; y < y_end; y++)
+            xxh64_update(&s, job->base + (size_t)y * job->stride, job->width);
+
+        job->bands[band] = xxh64_digest(&s);
+    }
+
+    return NULL;
+}
+
+/*
+ * Each FRM_HASH_BAND_LINES lines band is hashed with band index as seed and
+ * the plane hash is the hash of all band hashes. So the result does not
+ * depend on the thread count.
+ */
+static RK_U64 calc_plane_hash(const RK_U8 *base, RK_U32 width, RK_U32 height, RK_U32 stride)
+{
+    HashJob jobs[CRC_THREAD_MAX];
+    RK_U32 band_cnt = (height + FRM_HASH_BAND_LINES - 1) / FRM_HASH_BAND_LINES;
+    RK_S32 cnt = crc_thread_count(width * height, band_cnt);
+    RK_U64 *bands = mpp_calloc(RK_U64, band_cnt + 1);
+    Xxh64State s;
+    RK_U64 hash;
+    RK_S32 i;
+
+    if (NULL == bands)
+        return 0;
+
+    for (i = 0; i < cnt; i++) {
+        HashJob *job = &jobs[i];
+
+        job->base = base;
+        job->stride = stride;
+        job->width = width;
+        job->height = height;
+        job->band_start = band_cnt * i / cnt;
+        job->band_end = band_cnt * (i + 1) / cnt;
+        job->bands = bands;
+    }
+
+    crc_run_jobs(hash_plane_job, jobs, sizeof(jobs[0]), cnt);
+
+    xxh64_init(&s, 0);
+    xxh64_update(&s, (RK_U8 *)bands, sizeof(RK_U64) * band_cnt);
+    hash = xxh64_digest(&s);
+
+    MPP_FREE(bands);
+
+    return hash;
+}
+
+void calc_frm_hash(MppFrame frame, FrmHash *hash)
+{
+    RK_U32 width  = mpp_frame_get_width(frame);
+    RK_U32 height = mpp_frame_get_height(frame);
+    RK_U32 stride = mpp_frame_get_hor_stride(frame);
+    RK_U32 ver_stride = mpp_frame_get_ver_stride(frame);
+    RK_U8 *buf = (RK_U8 *)mpp_buffer_get_ptr(mpp_frame_get_buffer(frame));
+
+    /* yuv420sp layout, chroma starts after the aligned luma plane */
+    hash->luma = calc_plane_hash(buf, width, height, stride);
+    hash->chroma = calc_plane_hash(buf + MPP_MAX(ver_stride, height) * stride,
+                                   width, height / 2, stride);
+}
+
+void write_frm_hash(FILE *fp, FrmHash *hash)
+{
+    if (fp) {
+        fprintf(fp, "xxh64 %016llx %016llx\n",
+                (unsigned long long)hash->luma, (unsigned long long)hash->chroma);
+        fflush(fp);
+    }
+}
+
+void read_frm_hash(FILE *fp, FrmHash *hash)
+{
+    if (fp) {
+        unsigned long long luma = 0;
+        unsigned long long chroma = 0;
+
+        if (fscanf(fp, " xxh64 %llx %llx", &luma, &chroma) != 2)
+            mpp_err_f("unexpected EOF found\n");
+
+        hash->luma = luma;
+        hash->chroma = chroma;
+    }
+}
+
+/* one component of a 8bit yuv frame */
+typedef struct FrmComp_t {
+    RK_U32          offset;
+    RK_U32          step;
+    RK_U32          width;
+    RK_U32          height;
+    RK_U32          stride;
+} FrmComp;
+
+static RK_U32 get_frm_comps(MppFrame frame, FrmComp *comps)
+{
+    MppFrameFormat fmt = (MppFrameFormat)(mpp_frame_get_fmt(frame) & MPP_FRAME_FMT_MASK);
+    RK_U32 width  = mpp_frame_get_width(frame);
+    RK_U32 height = mpp_frame_get_height(frame);
+    RK_U32 hor_stride = mpp_frame_get_hor_stride(frame);
+    RK_U32 ver_stride = mpp_frame_get_ver_stride(frame);
+    RK_U32 luma_size = hor_stride * ver_stride;
+    RK_U32 swap = 0;
+    RK_U32 c_height = height / 2;
+
+    comps[0].offset = 0;
+    comps[0].step = 1;
+    comps[0].width = width;
+    comps[0].height = height;
+    comps[0].stride = hor_stride;
+
+    switch (fmt) {
+    case MPP_FMT_YUV400 : {
+        return 1;
+    } break;
+    case MPP_FMT_YUV422SP_VU :
+        swap = 1;
+        /* fall through */
+    case MPP_FMT_YUV422SP :
+        c_height = height;
+        /* fall through */
+    case MPP_FMT_YUV420SP :
+    case MPP_FMT_YUV420SP_VU : {
+        if (fmt == MPP_FMT_YUV420SP_VU)
+            swap = 1;
+
+        comps[1].offset = luma_size + swap;
+        comps[2].offset = luma_size + !swap;
+        comps[1].step = comps[2].step = 2;
+        comps[1].width = comps[2].width = width / 2;
+        comps[1].height = comps[2].height = c_height;
+        comps[1].stride = comps[2].stride = hor_stride;
+    } break;
+    case MPP_FMT_YUV420P : {
+        comps[1].offset = luma_size;
+        comps[2].offset = luma_size + luma_size / 4;
+        comps[1].step = comps[2].step = 1;
+        comps[1].width = comps[2].width = width / 2;
+        comps[1].height = comps[2].height = height / 2;
+        comps[1].stride = comps[2].stride = hor_stride / 2;
+    } break;
+    default : {
+        return 0;
+    } break;
+    }
+
+    return 3;
+}
+
+typedef struct DiffJob_t {
+    const RK_U8     *ref;
+    const RK_U8     *dst;
+    FrmComp         *ref_comp;
+    FrmComp         *dst_comp;
+    RK_U32          y_start;
+    RK_U32          y_end;
+    RK_U64          sse;
+    RK_U64          diff_cnt;
+    RK_U32          max_diff;
+} DiffJob;
+
+static void *diff_comp_job(void *arg)
+{
+    DiffJob *job = (DiffJob *)arg;
+    RK_U32 step_r = job->ref_comp->step;
+    RK_U32 step_d = job->dst_comp->step;
+    RK_U32 width = job->ref_comp->width;
+    RK_U32 y, x;
+
+    for (y = job->y_start; y < job->y_end; y++) {
+        const RK_U8 *r = job->ref + job->ref_comp->offset + (size_t)y * job->ref_comp->stride;
+        const RK_U8 *d = job->dst + job->dst_comp->offset + (size_t)y * job->dst_comp->stride;
+        RK_U32 sse = 0;
+
+        /* 4K line with max diff still fits 32bit */
+        for (x = 0; x < width; x++) {
+            RK_S32 diff = r[x * step_r] - d[x * step_d];
+            RK_U32 abs_diff = (diff < 0) ? -diff : diff;
+
+            sse += abs_diff * abs_diff;
+            if (abs_diff) {
+                job->diff_cnt++;
+                if (abs_diff > job->max_diff)
+                    job->max_diff = abs_diff;
+            }
+        }
+        job->sse += sse;
+    }
+
+    return NULL;
+}
+
+MPP_RET calc_frm_diff(MppFrame ref, MppFrame dst, FrmDiff *diff)
+{
+    FrmComp ref_comps[3];
+    FrmComp dst_comps[3];
+    RK_U8 *ref_buf;
+    RK_U8 *dst_buf;
+    RK_U64 sse_total = 0;
+    RK_U64 pixel_total = 0;
+    RK_U32 comp_cnt;
+    RK_U32 i;
+
+    if (NULL == ref || NULL == dst || NULL == diff) {
+        mpp_err_f("invalid input ref %p dst %p diff %p\n", ref, dst, diff);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    memset(diff, 0, sizeof(*diff));
+
+    if (mpp_frame_get_width(ref) != mpp_frame_get_width(dst) ||
+        mpp_frame_get_height(ref) != mpp_frame_get_height(dst) ||
+        mpp_frame_get_fmt(ref) != mpp_frame_get_fmt(dst)) {
+        mpp_err_f("mismatch frame ref %dx%d fmt %x dst %dx%d fmt %x\n",
+                  mpp_frame_get_width(ref), mpp_frame_get_height(ref), mpp_frame_get_fmt(ref),
+                  mpp_frame_get_width(dst), mpp_frame_get_height(dst), mpp_frame_get_fmt(dst));
+        return MPP_NOK;
+    }
+
+    comp_cnt = get_frm_comps(ref, ref_comps);
+    get_frm_comps(dst, dst_comps);
+    if (!comp_cnt) {
+        mpp_err_f("unsupported format %x\n", mpp_frame_get_fmt(ref));
+        return MPP_NOK;
+    }
+
+    ref_buf = (RK_U8 *)mpp_buffer_get_ptr(mpp_frame_get_buffer(ref));
+    dst_buf = (RK_U8 *)mpp_buffer_get_ptr(mpp_frame_get_buffer(dst));
+    if (NULL == ref_buf || NULL == dst_buf) {
+        mpp_err_f("invalid frame buffer ref %p dst %p\n", ref_buf, dst_buf);
+        return MPP_NOK;
+    }
+
+    diff->comp_cnt = comp_cnt;
+
+    for (i = 0; i < comp_cnt; i++) {
+        DiffJob jobs[CRC_THREAD_MAX];
+        FrmComp *comp = &ref_comps[i];
+        RK_U64 pixels = (RK_U64)comp->width * comp->height;
+        RK_S32 cnt = crc_thread_count(comp->width * comp->height, comp->height);
+        RK_S32 j;
+
+        memset(jobs, 0, sizeof(jobs));
+        for (j = 0; j < cnt; j++) {
+            jobs[j].ref = ref_buf;
+            jobs[j].dst = dst_buf;
+            jobs[j].ref_comp = &ref_comps[i];
+            jobs[j].dst_comp = &dst_comps[i];
+            jobs[j].y_start = comp->height * j / cnt;
+            jobs[j].y_end = comp->height * (j + 1) / cnt;
+        }
+
+        crc_run_jobs(diff_comp_job, jobs, sizeof(jobs[0]), cnt);
+
+        for (j = 0; j < cnt; j++) {
+            diff->sse[i] += jobs[j].sse;
+            diff->diff_cnt[i] += jobs[j].diff_cnt;
+            diff->max_diff[i] = MPP_MAX(diff->max_diff[i], jobs[j].max_diff);
+        }
+
+        diff->pixel_cnt[i] = pixels;
+        diff->psnr[i] = (diff->sse[i] && pixels) ?
+                        10.0 * log10(65025.0 * pixels / diff->sse[i]) : 100.0;
+
+        sse_total += diff->sse[i];
+        pixel_total += pixels;
+    }
+
+    diff->psnr_avg = (sse_total && pixel_total) ?
+                     10.0 * log10(65025.0 * pixel_total / sse_total) : 100.0;
+
+    return MPP_OK;
+}
+
+void show_frm_diff(FrmDiff *diff)
+{
+    static const char *comp_name[3] = { "y", "u", "v" };
+    RK_U32 i;
+
+    for (i = 0; i < diff->comp_cnt; i++) {
+        mpp_log("%s psnr %6.2f sse %lld max diff %3d diff pixel %lld / %lld\n",
+                comp_name[i], diff->psnr[i], (long long)diff->sse[i], diff->max_diff[i],
+                (long long)diff->diff_cnt[i], (long long)diff->pixel_cnt[i]);
+    }
+    mpp_log("avg psnr %6.2f\n", diff->psnr_avg);
+}
+
 static MPP_RET read_with_pixel_width(RK_U8 *buf, RK_S32 width, RK_S32 height,
                                      RK_S32 hor_stride, RK_S32 pix_w, FILE *fp)
 {
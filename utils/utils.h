@@ -40,6 +40,23 @@ typedef struct frame_crc_t {
     DataCrc         chroma;
 } FrmCrc;
 
+/* fast frame hash, not compatible with FrmCrc */
+typedef struct frame_hash_t {
+    RK_U64          luma;
+    RK_U64          chroma;
+} FrmHash;
+
+/* difference of two 8bit yuv frames in y / u / v order */
+typedef struct frame_diff_t {
+    RK_U32          comp_cnt;
+    RK_U64          sse[3];
+    RK_U64          pixel_cnt[3];
+    RK_U64          diff_cnt[3];
+    RK_U32          max_diff[3];
+    double          psnr[3];
+    double          psnr_avg;
+} FrmDiff;
+
 #define show_options(opt) \
     do { \
         _show_options(sizeof(opt)/sizeof(OptionInfo), opt); \
@@ -65,6 +82,15 @@ void calc_frm_crc(MppFrame frame, FrmCrc *crc);
 void write_frm_crc(FILE *fp, FrmCrc *crc);
 void read_frm_crc(FILE *fp, FrmCrc *crc);
 
+void calc_frm_hash(MppFrame frame, FrmHash *hash);
+void write_frm_hash(FILE *fp, FrmHash *hash);
+void read_frm_hash(FILE *fp, FrmHash *hash);
+
+MPP_RET calc_frm_diff(MppFrame ref, MppFrame dst, FrmDiff *diff);
+void show_frm_diff(FrmDiff *diff);
+/* join crc / hash / diff worker threads, call when no check is running */
+void frm_check_deinit(void);
+
 MPP_RET read_image(RK_U8 *buf, FILE *fp, RK_U32 width, RK_U32 height,
                    RK_U32 hor_stride, RK_U32 ver_stride,
                    MppFrameFormat fmt);